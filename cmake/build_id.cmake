@@ -0,0 +1,18 @@
+# Writes OUTPUT, a header defining RDMETER_BUILD_ID: a digest of every source file under
+# SOURCE_DIR/src and of TOOLCHAIN (compiler and flags), so any change to how scores are
+# computed changes it, version bump or not. Run at build time with cmake -P; the header is
+# only rewritten when the digest changes, so an unchanged tree rebuilds nothing
+file(GLOB_RECURSE sources "${SOURCE_DIR}/src/*.cpp" "${SOURCE_DIR}/src/*.hpp")
+list(SORT sources)
+set(identity "${TOOLCHAIN}")
+foreach(source IN LISTS sources)
+  file(SHA256 "${source}" digest)
+  file(RELATIVE_PATH name "${SOURCE_DIR}" "${source}")
+  string(APPEND identity "\n${name} ${digest}")
+endforeach()
+string(SHA256 build_id "${identity}")
+string(SUBSTRING "${build_id}" 0 16 build_id)
+
+file(WRITE "${OUTPUT}.tmp" "#pragma once\n\n#define RDMETER_BUILD_ID \"${build_id}\"\n")
+execute_process(COMMAND "${CMAKE_COMMAND}" -E copy_if_different "${OUTPUT}.tmp" "${OUTPUT}")
+file(REMOVE "${OUTPUT}.tmp")
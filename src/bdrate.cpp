@@ -1,2 +1,520 @@
-// Placeholder for BD-Rate implementation
-// To be implemented later
\ No newline at end of file
+#include "bdrate.hpp"
+#include "sampling.hpp"
+#include "threading.hpp"
+#include "third_party/json.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace rdmeter {
+
+namespace {
+
+// y as a function of x through the points of one RD curve
+class Interpolant {
+public:
+    Interpolant(std::vector<std::pair<double, double>> points, BdInterpolation interpolation)
+        : interpolation_(interpolation) {
+        std::sort(points.begin(), points.end());
+        for (size_t i = 1; i < points.size(); ++i) {
+            if (points[i].first == points[i - 1].first) {
+                throw std::invalid_argument("RD curve has two points at the same rate or quality");
+            }
+        }
+        size_t needed = interpolation == BdInterpolation::Cubic ? 4 : 2;
+        if (points.size() < needed) {
+            throw std::invalid_argument("RD curve needs at least " + std::to_string(needed) + " points");
+        }
+        for (const auto& p : points) {
+            x_.push_back(p.first);
+            y_.push_back(p.second);
+        }
+        if (interpolation == BdInterpolation::Cubic) {
+            fit_cubic();
+        } else {
+            fit_pchip();
+        }
+    }
+
+    double min_x() const { return x_.front(); }
+    double max_x() const { return x_.back(); }
+
+    double operator()(double x) const {
+        if (interpolation_ == BdInterpolation::Cubic) {
+            double t = (x - center_) / scale_;
+            return ((coefficients_[3] * t + coefficients_[2]) * t + coefficients_[1]) * t + coefficients_[0];
+        }
+        size_t k = segment(x);
+        double h = x_[k + 1] - x_[k];
+        double t = (x - x_[k]) / h;
+        double t2 = t * t, t3 = t2 * t;
+        return (2 * t3 - 3 * t2 + 1) * y_[k] + (t3 - 2 * t2 + t) * h * slopes_[k] + (-2 * t3 + 3 * t2) * y_[k + 1] +
+               (t3 - t2) * h * slopes_[k + 1];
+    }
+
+    // Simpson's rule is exact for cubics, so integrate each cubic piece with it
+    double integral(double a, double b) const {
+        auto simpson = [&](double lo, double hi) {
+            return (hi - lo) / 6.0 * ((*this)(lo) + 4.0 * (*this)(0.5 * (lo + hi)) + (*this)(hi));
+        };
+        if (interpolation_ == BdInterpolation::Cubic) {
+            return simpson(a, b);
+        }
+        double total = 0.0;
+        for (size_t k = segment(a); k + 1 < x_.size() && x_[k] < b; ++k) {
+            double lo = std::max(a, x_[k]);
+            double hi = std::min(b, x_[k + 1]);
+            if (hi > lo) {
+                total += simpson(lo, hi);
+            }
+        }
+        return total;
+    }
+
+private:
+    size_t segment(double x) const {
+        auto above = std::upper_bound(x_.begin() + 1, x_.end() - 1, x);
+        return static_cast<size_t>(above - x_.begin()) - 1;
+    }
+
+    // Least squares on centred, scaled x keeps the normal equations well conditioned
+    void fit_cubic() {
+        size_t n = x_.size();
+        center_ = std::accumulate(x_.begin(), x_.end(), 0.0) / n;
+        scale_ = 0.0;
+        for (double x : x_) {
+            scale_ = std::max(scale_, std::abs(x - center_));
+        }
+        std::array<std::array<double, 5>, 4> system{};  // Augmented normal equations
+        for (size_t i = 0; i < n; ++i) {
+            double t = (x_[i] - center_) / scale_;
+            std::array<double, 7> powers{};
+            powers[0] = 1.0;
+            for (int p = 1; p < 7; ++p) {
+                powers[p] = powers[p - 1] * t;
+            }
+            for (int r = 0; r < 4; ++r) {
+                for (int c = 0; c < 4; ++c) {
+                    system[r][c] += powers[r + c];
+                }
+                system[r][4] += powers[r] * y_[i];
+            }
+        }
+        // Gaussian elimination with partial pivoting
+        for (int col = 0; col < 4; ++col) {
+            int pivot = col;
+            for (int r = col + 1; r < 4; ++r) {
+                if (std::abs(system[r][col]) > std::abs(system[pivot][col])) {
+                    pivot = r;
+                }
+            }
+            std::swap(system[col], system[pivot]);
+            if (std::abs(system[col][col]) < 1e-12) {
+                throw std::invalid_argument("RD curve points are degenerate for a cubic fit");
+            }
+            for (int r = 0; r < 4; ++r) {
+                if (r != col) {
+                    double factor = system[r][col] / system[col][col];
+                    for (int c = col; c < 5; ++c) {
+                        system[r][c] -= factor * system[col][c];
+                    }
+                }
+            }
+        }
+        for (int r = 0; r < 4; ++r) {
+            coefficients_[r] = system[r][4] / system[r][r];
+        }
+    }
+
+    // Fritsch-Carlson slopes, with the same end conditions as SciPy's PchipInterpolator
+    void fit_pchip() {
+        size_t n = x_.size();
+        std::vector<double> h(n - 1), delta(n - 1);
+        for (size_t k = 0; k + 1 < n; ++k) {
+            h[k] = x_[k + 1] - x_[k];
+            delta[k] = (y_[k + 1] - y_[k]) / h[k];
+        }
+        slopes_.assign(n, 0.0);
+        if (n == 2) {
+            slopes_[0] = slopes_[1] = delta[0];
+            return;
+        }
+        for (size_t k = 1; k + 1 < n; ++k) {
+            if (delta[k - 1] * delta[k] > 0.0) {
+                double w1 = 2 * h[k] + h[k - 1];
+                double w2 = h[k] + 2 * h[k - 1];
+                slopes_[k] = (w1 + w2) / (w1 / delta[k - 1] + w2 / delta[k]);
+            }
+        }
+        auto end_slope = [](double h0, double h1, double d0, double d1) {
+            double d = ((2 * h0 + h1) * d0 - h0 * d1) / (h0 + h1);
+            if (std::signbit(d) != std::signbit(d0) || d0 == 0.0) {
+                return 0.0;
+            }
+            if (std::signbit(d0) != std::signbit(d1) && std::abs(d) > 3 * std::abs(d0)) {
+                return 3 * d0;
+            }
+            return d;
+        };
+        slopes_[0] = end_slope(h[0], h[1], delta[0], delta[1]);
+        slopes_[n - 1] = end_slope(h[n - 2], h[n - 3], delta[n - 2], delta[n - 3]);
+    }
+
+    BdInterpolation interpolation_;
+    std::vector<double> x_, y_;
+    std::vector<double> slopes_;
+    std::array<double, 4> coefficients_{};
+    double center_ = 0.0;
+    double scale_ = 1.0;
+};
+
+// Average of test minus ref over the x range both curves cover
+double average_difference(const Interpolant& ref, const Interpolant& test) {
+    double lo = std::max(ref.min_x(), test.min_x());
+    double hi = std::min(ref.max_x(), test.max_x());
+    if (!(hi > lo)) {
+        throw std::invalid_argument("RD curves do not overlap");
+    }
+    return (test.integral(lo, hi) - ref.integral(lo, hi)) / (hi - lo);
+}
+
+// Points of a curve with every frame statistic taken over the drawn frames
+std::vector<BdPoint> resample_frames(const std::vector<BdPoint>& curve, const std::vector<size_t>& frames) {
+    std::vector<BdPoint> resampled(curve.size());
+    for (size_t p = 0; p < curve.size(); ++p) {
+        const BdPoint& point = curve[p];
+        double quality = 0.0;
+        for (size_t f : frames) {
+            quality += point.frame_quality[f];
+        }
+        resampled[p].quality = quality / frames.size();
+        resampled[p].bitrate = point.bitrate;
+        if (!point.frame_bits.empty()) {
+            // The drawn frames scale the measured bitrate by their share of the bits
+            double drawn = 0.0;
+            for (size_t f : frames) {
+                drawn += point.frame_bits[f];
+            }
+            double all = std::accumulate(point.frame_bits.begin(), point.frame_bits.end(), 0.0);
+            resampled[p].bitrate = all > 0.0 ? point.bitrate * (drawn / frames.size()) / (all / point.frame_bits.size())
+                                             : point.bitrate;
+        }
+    }
+    return resampled;
+}
+
+// Frames of a sequence, checked to be the same for every encode of it
+size_t sequence_frames(const BdSequence& sequence) {
+    size_t frames = 0;
+    for (const auto* curve : {&sequence.ref, &sequence.test}) {
+        for (const auto& point : *curve) {
+            if (point.frame_quality.empty()) {
+                throw std::invalid_argument("Frame resampling needs per-frame data for every point of " + sequence.name);
+            }
+            if (frames == 0) {
+                frames = point.frame_quality.size();
+            }
+            if (point.frame_quality.size() != frames ||
+                (!point.frame_bits.empty() && point.frame_bits.size() != frames)) {
+                throw std::invalid_argument("Encodes of " + sequence.name + " have different frame counts");
+            }
+        }
+    }
+    return frames;
+}
+
+} // namespace
+
+BdInterpolation parse_bd_interpolation(const std::string& name) {
+    if (name == "cubic") return BdInterpolation::Cubic;
+    if (name == "pchip") return BdInterpolation::Pchip;
+    throw std::invalid_argument("Unknown interpolation: " + name + " (expected cubic or pchip)");
+}
+
+BootstrapMode parse_bootstrap_mode(const std::string& name) {
+    if (name == "none") return BootstrapMode::None;
+    if (name == "sequences") return BootstrapMode::Sequences;
+    if (name == "frames") return BootstrapMode::Frames;
+    if (name == "both") return BootstrapMode::Both;
+    throw std::invalid_argument("Unknown bootstrap mode: " + name + " (expected none, sequences, frames or both)");
+}
+
+BdResult bd_rate(const std::vector<BdPoint>& ref, const std::vector<BdPoint>& test, BdInterpolation interpolation) {
+    auto curve = [&](const std::vector<BdPoint>& points, bool rate_of_quality) {
+        std::vector<std::pair<double, double>> xy;
+        for (const auto& p : points) {
+            if (!(p.bitrate > 0.0) || !std::isfinite(p.quality)) {
+                throw std::invalid_argument("RD points need a positive bitrate and a finite quality");
+            }
+            double log_rate = std::log10(p.bitrate);
+            xy.push_back(rate_of_quality ? std::make_pair(p.quality, log_rate) : std::make_pair(log_rate, p.quality));
+        }
+        return Interpolant(std::move(xy), interpolation);
+    };
+
+    BdResult result;
+    double log_rate_difference = average_difference(curve(ref, true), curve(test, true));
+    result.bd_rate = (std::pow(10.0, log_rate_difference) - 1.0) * 100.0;
+    result.bd_quality = average_difference(curve(ref, false), curve(test, false));
+    return result;
+}
+
+BootstrapInterval percentile_interval(std::vector<double>& values, double confidence) {
+    if (values.empty()) {
+        throw std::runtime_error("No bootstrap replicate could be refitted");
+    }
+    std::sort(values.begin(), values.end());
+    auto quantile = [&](double q) {
+        double position = q * (values.size() - 1);
+        size_t below = static_cast<size_t>(position);
+        size_t above = std::min(below + 1, values.size() - 1);
+        return values[below] + (position - below) * (values[above] - values[below]);
+    };
+    double tail = (1.0 - confidence) / 2.0;
+    BootstrapInterval interval;
+    interval.low = quantile(tail);
+    interval.high = quantile(1.0 - tail);
+    double mean = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+    double squares = 0.0;
+    for (double v : values) {
+        squares += (v - mean) * (v - mean);
+    }
+    interval.std_dev = values.size() > 1 ? std::sqrt(squares / (values.size() - 1)) : 0.0;
+    return interval;
+}
+
+BdSummary bd_rate_summary(const std::vector<BdSequence>& sequences, BdInterpolation interpolation,
+                          const BootstrapOptions& options, ThreadPool* pool) {
+    if (sequences.empty()) {
+        throw std::invalid_argument("No sequences to compare");
+    }
+    BdSummary summary;
+    for (const auto& sequence : sequences) {
+        try {
+            summary.sequences.push_back(bd_rate(sequence.ref, sequence.test, interpolation));
+        } catch (const std::invalid_argument& e) {
+            throw std::invalid_argument(sequence.name + ": " + e.what());
+        }
+        summary.mean.bd_rate += summary.sequences.back().bd_rate / sequences.size();
+        summary.mean.bd_quality += summary.sequences.back().bd_quality / sequences.size();
+    }
+    if (options.mode == BootstrapMode::None) {
+        return summary;
+    }
+    if (options.samples < 2 || !(options.confidence > 0.0 && options.confidence < 1.0)) {
+        throw std::invalid_argument("Bootstrap needs at least 2 samples and a confidence in (0, 1)");
+    }
+
+    const bool resample_sequences = options.mode == BootstrapMode::Sequences || options.mode == BootstrapMode::Both;
+    const bool frame_resampling = options.mode == BootstrapMode::Frames || options.mode == BootstrapMode::Both;
+    if (options.mode == BootstrapMode::Sequences && sequences.size() < 2) {
+        throw std::invalid_argument("Sequence resampling needs at least two sequences");
+    }
+    std::vector<size_t> frame_counts(sequences.size(), 0);
+    if (frame_resampling) {
+        for (size_t s = 0; s < sequences.size(); ++s) {
+            frame_counts[s] = sequence_frames(sequences[s]);
+        }
+    }
+
+    const size_t samples = static_cast<size_t>(options.samples);
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<double> rate_replicates(samples, nan), quality_replicates(samples, nan);
+    const uint64_t base_seed = SplitMix64(options.seed).next();
+    auto replicate = [&](size_t b, unsigned) {
+        SplitMix64 rng(base_seed ^ (static_cast<uint64_t>(b) * 0xD6E8FEB86659FD93ull));
+        const size_t n = sequences.size();
+        double rate = 0.0, quality = 0.0;
+        std::vector<size_t> frames;
+        for (size_t i = 0; i < n; ++i) {
+            size_t s = resample_sequences ? static_cast<size_t>(rng.below(n)) : i;
+            BdResult result = summary.sequences[s];
+            if (frame_resampling) {
+                // The same frames for every encode, so the curves stay paired
+                frames.resize(frame_counts[s]);
+                for (auto& f : frames) {
+                    f = static_cast<size_t>(rng.below(frame_counts[s]));
+                }
+                try {
+                    result = bd_rate(resample_frames(sequences[s].ref, frames),
+                                     resample_frames(sequences[s].test, frames), interpolation);
+                } catch (const std::invalid_argument&) {
+                    return;  // E.g. the resampled curves no longer overlap; the replicate is dropped
+                }
+            }
+            rate += result.bd_rate;
+            quality += result.bd_quality;
+        }
+        rate_replicates[b] = rate / n;
+        quality_replicates[b] = quality / n;
+    };
+    if (pool) {
+        pool->parallel_for(samples, replicate);
+    } else {
+        for (size_t b = 0; b < samples; ++b) {
+            replicate(b, 0);
+        }
+    }
+
+    auto completed = [](const std::vector<double>& values) {
+        std::vector<double> kept;
+        for (double v : values) {
+            if (!std::isnan(v)) {
+                kept.push_back(v);
+            }
+        }
+        return kept;
+    };
+    auto rates = completed(rate_replicates);
+    auto qualities = completed(quality_replicates);
+    summary.replicates = static_cast<int>(rates.size());
+    summary.bd_rate_interval = percentile_interval(rates, options.confidence);
+    summary.bd_quality_interval = percentile_interval(qualities, options.confidence);
+    return summary;
+}
+
+BdMatrix bd_matrix(const BdTable& table, const std::string& anchor, BdInterpolation interpolation,
+                   ThreadPool* pool) {
+    BdMatrix matrix;
+    matrix.metrics = table.metrics;
+    const size_t rows = table.bitrates.size();
+    if (table.configs.size() != rows || table.sequences.size() != rows || table.qualities.size() != table.metrics.size()) {
+        throw std::invalid_argument("BD table columns have different lengths");
+    }
+
+    // Rows of each (config, sequence) curve; the anchor's config index is kept apart
+    std::unordered_map<std::string, size_t> config_index, sequence_index;
+    const size_t none = std::numeric_limits<size_t>::max();
+    bool has_anchor = false;
+    std::vector<size_t> row_config(rows), row_sequence(rows);
+    for (size_t r = 0; r < rows; ++r) {
+        const std::string& config = table.configs[r];
+        if (config == anchor) {
+            row_config[r] = none;
+            has_anchor = true;
+        } else {
+            auto inserted = config_index.emplace(config, matrix.configs.size());
+            if (inserted.second) {
+                matrix.configs.push_back(config);
+            }
+            row_config[r] = inserted.first->second;
+        }
+        auto inserted = sequence_index.emplace(table.sequences[r], matrix.sequences.size());
+        if (inserted.second) {
+            matrix.sequences.push_back(table.sequences[r]);
+        }
+        row_sequence[r] = inserted.first->second;
+    }
+    if (!has_anchor) {
+        throw std::invalid_argument("Anchor config " + anchor + " has no rows");
+    }
+    const size_t configs = matrix.configs.size();
+    const size_t sequences = matrix.sequences.size();
+    const size_t metrics = matrix.metrics.size();
+    std::vector<std::vector<size_t>> anchor_curves(sequences), curves(configs * sequences);
+    for (size_t r = 0; r < rows; ++r) {
+        if (row_config[r] == none) {
+            anchor_curves[row_sequence[r]].push_back(r);
+        } else {
+            curves[row_config[r] * sequences + row_sequence[r]].push_back(r);
+        }
+    }
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    matrix.cells.assign(configs * sequences * metrics, BdResult{nan, nan});
+    matrix.errors.assign(matrix.cells.size(), std::string());
+    auto fit = [&](size_t i, unsigned) {
+        size_t metric = i % metrics;
+        size_t curve = i / metrics;
+        const auto& ref_rows = anchor_curves[curve % sequences];
+        const auto& test_rows = curves[curve];
+        if (ref_rows.empty() || test_rows.empty()) {
+            matrix.errors[i] = ref_rows.empty() ? "Not in the anchor" : "Not in this config";
+            return;
+        }
+        auto points = [&](const std::vector<size_t>& curve_rows) {
+            std::vector<BdPoint> result(curve_rows.size());
+            for (size_t p = 0; p < curve_rows.size(); ++p) {
+                result[p].bitrate = table.bitrates[curve_rows[p]];
+                result[p].quality = table.qualities[metric][curve_rows[p]];
+            }
+            return result;
+        };
+        try {
+            matrix.cells[i] = bd_rate(points(ref_rows), points(test_rows), interpolation);
+        } catch (const std::invalid_argument& e) {
+            matrix.errors[i] = e.what();
+        }
+    };
+    if (pool) {
+        pool->parallel_for(matrix.cells.size(), fit);
+    } else {
+        for (size_t i = 0; i < matrix.cells.size(); ++i) {
+            fit(i, 0);
+        }
+    }
+
+    matrix.averages.assign(configs * metrics, BdResult{nan, nan});
+    matrix.counts.assign(configs * metrics, 0);
+    for (size_t c = 0; c < configs; ++c) {
+        for (size_t m = 0; m < metrics; ++m) {
+            BdResult sum;
+            int count = 0;
+            for (size_t s = 0; s < sequences; ++s) {
+                size_t i = matrix.cell_index(c, s, m);
+                if (matrix.errors[i].empty()) {
+                    sum.bd_rate += matrix.cells[i].bd_rate;
+                    sum.bd_quality += matrix.cells[i].bd_quality;
+                    ++count;
+                }
+            }
+            if (count > 0) {
+                matrix.averages[c * metrics + m] = {sum.bd_rate / count, sum.bd_quality / count};
+            }
+            matrix.counts[c * metrics + m] = count;
+        }
+    }
+    return matrix;
+}
+
+void load_per_frame(const std::string& path, const std::string& metric_key, std::vector<double>& bits,
+                    std::vector<double>& quality) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open per-frame file: " + path);
+    }
+    bits.clear();
+    quality.clear();
+    bool all_bits = true;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        auto row = nlohmann::json::parse(line);
+        if (row.contains("skipped")) {
+            continue;
+        }
+        if (!row.contains(metric_key)) {
+            throw std::runtime_error("Per-frame file " + path + " has no " + metric_key);
+        }
+        quality.push_back(row[metric_key].get<double>());
+        if (row.contains("bits")) {
+            bits.push_back(row["bits"].get<double>());
+        } else {
+            all_bits = false;
+        }
+    }
+    // Bits are only usable when every frame has them
+    if (!all_bits) {
+        bits.clear();
+    }
+}
+
+} // namespace rdmeter
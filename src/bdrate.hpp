@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rdmeter {
+
+class ThreadPool;
+
+// How each RD curve is interpolated between its points
+enum class BdInterpolation {
+    Cubic,  // Least-squares cubic, as in VCEG-M33 (needs 4 points)
+    Pchip   // Piecewise cubic Hermite (monotone), as in the JVET and AOM reporting tools
+};
+
+BdInterpolation parse_bd_interpolation(const std::string& name);
+
+// One encode of a sequence. frame_bits and frame_quality optionally hold its per-frame
+// values (e.g. from compute --per-frame with --bitstream) for frame resampling
+struct BdPoint {
+    double bitrate = 0.0;
+    double quality = 0.0;
+    std::vector<double> frame_bits;
+    std::vector<double> frame_quality;
+};
+
+struct BdResult {
+    double bd_rate = 0.0;     // Average bitrate difference of test against ref at equal quality, in %
+    double bd_quality = 0.0;  // Average quality difference at equal bitrate, in metric units
+};
+
+// Bjontegaard deltas between two RD curves, each integrated over the range both cover.
+// Throws std::invalid_argument when a curve has too few distinct points or the curves do
+// not overlap
+BdResult bd_rate(const std::vector<BdPoint>& ref, const std::vector<BdPoint>& test,
+                 BdInterpolation interpolation = BdInterpolation::Pchip);
+
+// The ref and test curves of one sequence
+struct BdSequence {
+    std::string name;
+    std::vector<BdPoint> ref;
+    std::vector<BdPoint> test;
+};
+
+enum class BootstrapMode {
+    None,
+    Sequences,  // Resample whole sequences with replacement
+    Frames,     // Resample the frames of every sequence (the same frames for all its encodes)
+    Both        // Resample sequences, then frames within each drawn sequence
+};
+
+BootstrapMode parse_bootstrap_mode(const std::string& name);
+
+struct BootstrapOptions {
+    BootstrapMode mode = BootstrapMode::None;
+    int samples = 1000;
+    double confidence = 0.95;
+    uint64_t seed = 1;
+};
+
+// Percentile interval of a bootstrapped statistic
+struct BootstrapInterval {
+    double low = 0.0;
+    double high = 0.0;
+    double std_dev = 0.0;
+};
+
+struct BdSummary {
+    BdResult mean;  // Average of the per-sequence deltas
+    std::vector<BdResult> sequences;
+    BootstrapInterval bd_rate_interval;
+    BootstrapInterval bd_quality_interval;
+    int replicates = 0;  // Bootstrap replicates whose refits all succeeded
+};
+
+// Per-sequence deltas, their average and, unless options.mode is None, bootstrap intervals
+// of the average. Replicate b draws from its own generator seeded from (seed, b), so
+// results do not depend on the thread count or scheduling. pool may be null
+BdSummary bd_rate_summary(const std::vector<BdSequence>& sequences, BdInterpolation interpolation,
+                          const BootstrapOptions& options, ThreadPool* pool = nullptr);
+
+// RD points in long format: one row per encode, naming its config and sequence, with its
+// bitrate and one quality column per metric
+struct BdTable {
+    std::vector<std::string> configs;
+    std::vector<std::string> sequences;
+    std::vector<double> bitrates;
+    std::vector<std::string> metrics;
+    std::vector<std::vector<double>> qualities;  // [metric][row]
+};
+
+// Deltas of every other config against an anchor config, per sequence and metric
+struct BdMatrix {
+    std::vector<std::string> configs;    // Every config but the anchor, in first-seen order
+    std::vector<std::string> sequences;  // In first-seen order
+    std::vector<std::string> metrics;
+    // Cell (c, s, m) is at (c * sequences.size() + s) * metrics.size() + m. A cell whose
+    // sequence is missing from either config, or whose curves cannot be compared, holds
+    // NaN deltas and the reason in errors
+    std::vector<BdResult> cells;
+    std::vector<std::string> errors;
+    // Average over the sequences with a result, and their count, at c * metrics.size() + m
+    std::vector<BdResult> averages;
+    std::vector<int> counts;
+
+    size_t cell_index(size_t config, size_t sequence, size_t metric) const {
+        return (config * sequences.size() + sequence) * metrics.size() + metric;
+    }
+};
+
+// Fits every (config, sequence, metric) cell of table against anchor, spread over pool when
+// it is not null. Throws std::invalid_argument when the anchor config has no rows
+BdMatrix bd_matrix(const BdTable& table, const std::string& anchor, BdInterpolation interpolation,
+                   ThreadPool* pool = nullptr);
+
+// Percentile interval of values at the given two-sided confidence (values are reordered)
+BootstrapInterval percentile_interval(std::vector<double>& values, double confidence);
+
+// Per-frame bits (from "bits") and quality (from metric_key) of a compute --per-frame
+// JSON lines file, skipping frames marked as skipped
+void load_per_frame(const std::string& path, const std::string& metric_key, std::vector<double>& bits,
+                    std::vector<double>& quality);
+
+} // namespace rdmeter
@@ -0,0 +1,786 @@
+#include "bitstream.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace rdmeter {
+
+namespace {
+
+// Exp-Golomb reader over a NAL unit payload, dropping emulation prevention bytes. Reads
+// past the end return zero bits, so a truncated header cannot stop the scan
+class RbspReader {
+public:
+    RbspReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    uint32_t bits(int count) {
+        uint32_t value = 0;
+        for (int i = 0; i < count; ++i) {
+            value = (value << 1) | bit();
+        }
+        return value;
+    }
+
+    uint32_t bit() {
+        if (bit_ == 0) {
+            current_ = next_byte();
+            bit_ = 8;
+        }
+        return (current_ >> --bit_) & 1;
+    }
+
+    uint32_t ue() {
+        int zeros = 0;
+        while (bit() == 0 && zeros < 32) {
+            ++zeros;
+        }
+        if (zeros >= 32) {
+            return 0;
+        }
+        return ((1u << zeros) - 1) + bits(zeros);
+    }
+
+    int32_t se() {
+        uint32_t code = ue();
+        return code & 1 ? static_cast<int32_t>((code + 1) / 2) : -static_cast<int32_t>(code / 2);
+    }
+
+    void skip(int count) {
+        for (int i = 0; i < count; ++i) {
+            bit();
+        }
+    }
+
+private:
+    uint8_t next_byte() {
+        if (pos_ >= size_) {
+            return 0;
+        }
+        // 0x000003 carries two zero bytes; the 3 is not part of the payload
+        if (zeros_ >= 2 && data_[pos_] == 3) {
+            zeros_ = 0;
+            if (++pos_ >= size_) {
+                return 0;
+            }
+        }
+        uint8_t byte = data_[pos_++];
+        zeros_ = byte == 0 ? zeros_ + 1 : 0;
+        return byte;
+    }
+
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ = 0;
+    int zeros_ = 0;
+    uint8_t current_ = 0;
+    int bit_ = 0;
+};
+
+struct NalUnit {
+    const uint8_t* payload;  // After the start code
+    size_t payload_size;
+    size_t bytes;  // Including the start code and trailing zeros
+};
+
+// Split an Annex-B stream at its 0x000001 start codes. Every byte belongs to exactly one
+// unit: a leading zero of a 4-byte start code goes with the unit it introduces
+std::vector<NalUnit> split_annex_b(const uint8_t* data, size_t size) {
+    std::vector<size_t> starts;  // Offsets of the 0x01 of each start code
+    for (size_t pos = 2; pos < size;) {
+        const void* one = std::memchr(data + pos, 1, size - pos);
+        if (!one) {
+            break;
+        }
+        pos = static_cast<size_t>(static_cast<const uint8_t*>(one) - data);
+        if (data[pos - 1] == 0 && data[pos - 2] == 0) {
+            starts.push_back(pos);
+        }
+        pos += 3;  // A payload is at least one byte, so the next start code cannot overlap
+    }
+    if (starts.empty()) {
+        throw std::runtime_error("No Annex-B start codes found");
+    }
+
+    std::vector<NalUnit> units;
+    units.reserve(starts.size());
+    auto unit_begin = [&](size_t k) {
+        if (k == 0) {
+            return size_t{0};  // Leading bytes before the first start code count towards it
+        }
+        size_t begin = starts[k] - 2;
+        return begin > 0 && data[begin - 1] == 0 ? begin - 1 : begin;
+    };
+    for (size_t k = 0; k < starts.size(); ++k) {
+        size_t payload = starts[k] + 1;
+        size_t end = k + 1 < starts.size() ? unit_begin(k + 1) : size;
+        // Trailing zeros before the next start code are not payload
+        size_t payload_end = end;
+        while (payload_end > payload && data[payload_end - 1] == 0) {
+            --payload_end;
+        }
+        units.push_back({data + payload, payload_end - payload, end - unit_begin(k)});
+    }
+    return units;
+}
+
+// A picture in decode order, with what is needed to put it in display order
+struct DecodedPicture {
+    CodedPicture coded;
+    int64_t period = 0;  // Increments at each IDR, where the order count restarts
+    int64_t order = 0;   // Picture order count within the period
+    bool has_slice = false;
+    // H.264 field pairs are coded as two pictures and displayed as one frame
+    bool field = false;
+    bool bottom_field = false;
+    uint32_t frame_num = 0;
+};
+
+PictureType max_type(PictureType a, PictureType b) {
+    return static_cast<int>(a) > static_cast<int>(b) ? a : b;
+}
+
+// Picture order count MSB from the LSB of this picture and of the previous anchor (8.2.1.1
+// in H.264, 8.3.1 in HEVC)
+int64_t order_msb(uint32_t lsb, uint32_t prev_lsb, int64_t prev_msb, uint32_t max_lsb) {
+    if (lsb < prev_lsb && prev_lsb - lsb >= max_lsb / 2) {
+        return prev_msb + max_lsb;
+    }
+    if (lsb > prev_lsb && lsb - prev_lsb > max_lsb / 2) {
+        return prev_msb - max_lsb;
+    }
+    return prev_msb;
+}
+
+std::vector<CodedPicture> display_order(std::vector<DecodedPicture>& pictures) {
+    std::stable_sort(pictures.begin(), pictures.end(), [](const DecodedPicture& a, const DecodedPicture& b) {
+        return a.period != b.period ? a.period < b.period : a.order < b.order;
+    });
+    std::vector<CodedPicture> result;
+    result.reserve(pictures.size());
+    for (const auto& picture : pictures) {
+        result.push_back(picture.coded);
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// H.264
+
+struct H264Sps {
+    bool valid = false;
+    bool separate_colour_plane = false;
+    int log2_max_frame_num = 4;
+    uint32_t poc_type = 0;
+    int log2_max_poc_lsb = 4;
+    bool frame_mbs_only = true;
+};
+
+void skip_scaling_list(RbspReader& reader, int size) {
+    int last = 8, next = 8;
+    for (int j = 0; j < size; ++j) {
+        if (next != 0) {
+            next = (last + reader.se() + 256) % 256;
+        }
+        last = next == 0 ? last : next;
+    }
+}
+
+H264Sps parse_h264_sps(RbspReader& reader, uint32_t& id) {
+    H264Sps sps;
+    uint32_t profile = reader.bits(8);
+    reader.skip(16);  // Constraint flags and level
+    id = reader.ue();
+    static const std::array<uint32_t, 13> high_profiles = {100, 110, 122, 244, 44, 83, 86, 118, 128, 138, 139, 134, 135};
+    if (std::find(high_profiles.begin(), high_profiles.end(), profile) != high_profiles.end()) {
+        uint32_t chroma_format = reader.ue();
+        if (chroma_format == 3) {
+            sps.separate_colour_plane = reader.bit();
+        }
+        reader.ue();  // Luma bit depth
+        reader.ue();  // Chroma bit depth
+        reader.bit();
+        if (reader.bit()) {
+            for (int i = 0; i < (chroma_format == 3 ? 12 : 8); ++i) {
+                if (reader.bit()) {
+                    skip_scaling_list(reader, i < 6 ? 16 : 64);
+                }
+            }
+        }
+    }
+    sps.log2_max_frame_num = static_cast<int>(reader.ue()) + 4;
+    sps.poc_type = reader.ue();
+    if (sps.poc_type == 0) {
+        sps.log2_max_poc_lsb = static_cast<int>(reader.ue()) + 4;
+    } else if (sps.poc_type == 1) {
+        reader.bit();
+        reader.se();
+        reader.se();
+        uint32_t cycle = reader.ue();
+        for (uint32_t i = 0; i < cycle && i < 256; ++i) {
+            reader.se();
+        }
+    }
+    reader.ue();   // max_num_ref_frames
+    reader.bit();  // gaps_in_frame_num_value_allowed_flag
+    reader.ue();   // Width in macroblocks
+    reader.ue();   // Height in map units
+    sps.frame_mbs_only = reader.bit();
+    sps.valid = sps.log2_max_frame_num <= 16 && sps.log2_max_poc_lsb <= 16;
+    return sps;
+}
+
+std::vector<DecodedPicture> parse_h264(const std::vector<NalUnit>& units) {
+    std::array<H264Sps, 32> sps_table{};
+    std::array<int, 256> pps_sps{};  // SPS id of each PPS, -1 when not seen
+    pps_sps.fill(-1);
+
+    std::vector<DecodedPicture> pictures;
+    DecodedPicture current;
+    int64_t period = -1;
+    int64_t prev_msb = 0;
+    uint32_t prev_lsb = 0;
+    int64_t decode_index = 0;
+
+    auto finish_picture = [&]() {
+        if (current.has_slice) {
+            pictures.push_back(current);
+        }
+        current = DecodedPicture();
+    };
+
+    for (const auto& unit : units) {
+        if (unit.payload_size == 0) {
+            current.coded.bytes += unit.bytes;
+            continue;
+        }
+        uint8_t header = unit.payload[0];
+        int type = header & 0x1f;
+        int ref_idc = (header >> 5) & 3;
+        RbspReader reader(unit.payload + 1, unit.payload_size - 1);
+
+        if (type == 1 || type == 5) {
+            uint32_t first_mb = reader.ue();
+            uint32_t slice_type = reader.ue() % 5;
+            uint32_t pps_id = reader.ue();
+            PictureType picture_type = slice_type == 1 ? PictureType::B
+                                       : slice_type == 2 || slice_type == 4 ? PictureType::I
+                                                                            : PictureType::P;
+            if (first_mb == 0 && current.has_slice) {
+                finish_picture();
+            }
+            if (current.has_slice) {
+                current.coded.type = max_type(current.coded.type, picture_type);
+                current.coded.bytes += unit.bytes;
+                continue;
+            }
+
+            // First slice of a picture: its header gives the display position
+            current.has_slice = true;
+            current.coded.type = picture_type;
+            current.coded.bytes += unit.bytes;
+            const H264Sps* sps = pps_id < pps_sps.size() && pps_sps[pps_id] >= 0 ? &sps_table[pps_sps[pps_id]] : nullptr;
+            if (type == 5 || period < 0) {
+                ++period;
+                prev_msb = 0;
+                prev_lsb = 0;
+            }
+            current.period = period;
+            current.order = decode_index++;
+            if (!sps || !sps->valid) {
+                continue;  // Without parameter sets, decode order stands in for display order
+            }
+            if (sps->separate_colour_plane) {
+                reader.skip(2);
+            }
+            current.frame_num = reader.bits(sps->log2_max_frame_num);
+            if (!sps->frame_mbs_only) {
+                current.field = reader.bit();
+                if (current.field) {
+                    current.bottom_field = reader.bit();
+                }
+            }
+            if (type == 5) {
+                reader.ue();  // idr_pic_id
+            }
+            // Order count types 1 and 2 cannot reorder frames against frame_num, so
+            // decode order is display order
+            if (sps->poc_type == 0) {
+                uint32_t lsb = reader.bits(sps->log2_max_poc_lsb);
+                int64_t msb = order_msb(lsb, prev_lsb, prev_msb, 1u << sps->log2_max_poc_lsb);
+                current.order = msb + lsb;
+                if (ref_idc != 0) {
+                    prev_msb = msb;
+                    prev_lsb = lsb;
+                }
+            }
+            continue;
+        }
+
+        // SEI, parameter sets, delimiters and prefix units open the next access unit
+        if ((type >= 6 && type <= 9) || (type >= 14 && type <= 18)) {
+            if (current.has_slice) {
+                finish_picture();
+            }
+            if (type == 7) {
+                uint32_t id = 0;
+                H264Sps sps = parse_h264_sps(reader, id);
+                if (id < sps_table.size()) {
+                    sps_table[id] = sps;
+                }
+            } else if (type == 8) {
+                uint32_t pps_id = reader.ue();
+                uint32_t sps_id = reader.ue();
+                if (pps_id < pps_sps.size() && sps_id < sps_table.size()) {
+                    pps_sps[pps_id] = static_cast<int>(sps_id);
+                }
+            }
+        }
+        current.coded.bytes += unit.bytes;
+    }
+    finish_picture();
+    if (!pictures.empty()) {
+        pictures.back().coded.bytes += current.coded.bytes;  // Trailing end-of-stream units
+    }
+
+    // Second fields join the first field of their frame
+    std::vector<DecodedPicture> frames;
+    frames.reserve(pictures.size());
+    for (const auto& picture : pictures) {
+        if (!frames.empty()) {
+            auto& last = frames.back();
+            if (picture.field && last.field && last.frame_num == picture.frame_num &&
+                last.bottom_field != picture.bottom_field) {
+                last.coded.bytes += picture.coded.bytes;
+                last.coded.type = max_type(last.coded.type, picture.coded.type);
+                last.field = false;  // Paired
+                continue;
+            }
+        }
+        frames.push_back(picture);
+    }
+    return frames;
+}
+
+// ---------------------------------------------------------------------------
+// HEVC
+
+struct HevcSps {
+    bool valid = false;
+    bool separate_colour_plane = false;
+    int log2_max_poc_lsb = 4;
+};
+
+struct HevcPps {
+    int sps_id = -1;
+    bool output_flag_present = false;
+    int extra_slice_header_bits = 0;
+};
+
+void skip_profile_tier_level(RbspReader& reader, int max_sub_layers_minus1) {
+    reader.skip(88);  // General profile space, tier, profile, compatibility and constraint flags
+    reader.skip(8);   // general_level_idc
+    std::array<bool, 8> profile_present{}, level_present{};
+    for (int i = 0; i < max_sub_layers_minus1; ++i) {
+        profile_present[i] = reader.bit();
+        level_present[i] = reader.bit();
+    }
+    if (max_sub_layers_minus1 > 0) {
+        reader.skip(2 * (8 - max_sub_layers_minus1));
+    }
+    for (int i = 0; i < max_sub_layers_minus1; ++i) {
+        reader.skip((profile_present[i] ? 88 : 0) + (level_present[i] ? 8 : 0));
+    }
+}
+
+HevcSps parse_hevc_sps(RbspReader& reader, uint32_t& id) {
+    HevcSps sps;
+    reader.skip(4);  // sps_video_parameter_set_id
+    int max_sub_layers_minus1 = static_cast<int>(reader.bits(3));
+    reader.bit();
+    skip_profile_tier_level(reader, max_sub_layers_minus1);
+    id = reader.ue();
+    if (reader.ue() == 3) {
+        sps.separate_colour_plane = reader.bit();
+    }
+    reader.ue();  // Width
+    reader.ue();  // Height
+    if (reader.bit()) {
+        for (int i = 0; i < 4; ++i) {
+            reader.ue();  // Conformance window offsets
+        }
+    }
+    reader.ue();  // Luma bit depth
+    reader.ue();  // Chroma bit depth
+    sps.log2_max_poc_lsb = static_cast<int>(reader.ue()) + 4;
+    sps.valid = max_sub_layers_minus1 < 7 && sps.log2_max_poc_lsb <= 16;
+    return sps;
+}
+
+std::vector<DecodedPicture> parse_hevc(const std::vector<NalUnit>& units) {
+    std::array<HevcSps, 16> sps_table{};
+    std::array<HevcPps, 64> pps_table{};
+
+    std::vector<DecodedPicture> pictures;
+    DecodedPicture current;
+    int64_t period = -1;
+    int64_t prev_msb = 0;
+    uint32_t prev_lsb = 0;
+    int64_t decode_index = 0;
+
+    auto finish_picture = [&]() {
+        if (current.has_slice) {
+            pictures.push_back(current);
+        }
+        current = DecodedPicture();
+    };
+
+    for (const auto& unit : units) {
+        if (unit.payload_size < 2) {
+            current.coded.bytes += unit.bytes;
+            continue;
+        }
+        int type = (unit.payload[0] >> 1) & 0x3f;
+        int temporal_id = (unit.payload[1] & 7) - 1;
+        RbspReader reader(unit.payload + 2, unit.payload_size - 2);
+
+        if (type < 32) {
+            bool first_slice = reader.bit();
+            if (first_slice && current.has_slice) {
+                finish_picture();
+            }
+            current.coded.bytes += unit.bytes;
+            if (!first_slice) {
+                continue;  // Later segments need the picture size to parse; the first decides the type
+            }
+
+            bool irap = type >= 16 && type <= 23;
+            bool idr = type == 19 || type == 20;
+            if (irap) {
+                reader.bit();  // no_output_of_prior_pics_flag
+            }
+            uint32_t pps_id = reader.ue();
+            current.has_slice = true;
+            current.coded.type = irap ? PictureType::I : PictureType::P;
+            // IDR and BLA pictures restart the order count; so does the first picture
+            bool restart = idr || (type >= 16 && type <= 18) || period < 0;
+            if (restart) {
+                ++period;
+                prev_msb = 0;
+                prev_lsb = 0;
+            }
+            current.period = period;
+            current.order = decode_index++;
+
+            const HevcPps* pps = pps_id < pps_table.size() && pps_table[pps_id].sps_id >= 0 ? &pps_table[pps_id] : nullptr;
+            const HevcSps* sps = pps ? &sps_table[pps->sps_id] : nullptr;
+            if (!sps || !sps->valid) {
+                continue;
+            }
+            reader.skip(pps->extra_slice_header_bits);
+            uint32_t slice_type = reader.ue();
+            current.coded.type = slice_type == 0 ? PictureType::B : slice_type == 1 ? PictureType::P : PictureType::I;
+            if (pps->output_flag_present) {
+                reader.bit();
+            }
+            if (sps->separate_colour_plane) {
+                reader.skip(2);
+            }
+            uint32_t lsb = idr ? 0 : reader.bits(sps->log2_max_poc_lsb);
+            int64_t msb = restart ? 0 : order_msb(lsb, prev_lsb, prev_msb, 1u << sps->log2_max_poc_lsb);
+            current.order = msb + lsb;
+            // Sub-layer non-reference, RADL and RASL pictures are not anchors (8.3.1)
+            bool anchor = temporal_id == 0 && !(type <= 14 && type % 2 == 0) && !(type >= 6 && type <= 9);
+            if (anchor) {
+                prev_msb = msb;
+                prev_lsb = lsb;
+            }
+            continue;
+        }
+
+        // Parameter sets, delimiters and prefix SEI open the next access unit
+        if ((type >= 32 && type <= 35) || type == 39 || (type >= 41 && type <= 44) || (type >= 48 && type <= 55)) {
+            if (current.has_slice) {
+                finish_picture();
+            }
+            if (type == 33) {
+                uint32_t id = 0;
+                HevcSps sps = parse_hevc_sps(reader, id);
+                if (id < sps_table.size()) {
+                    sps_table[id] = sps;
+                }
+            } else if (type == 34) {
+                uint32_t pps_id = reader.ue();
+                uint32_t sps_id = reader.ue();
+                if (pps_id < pps_table.size() && sps_id < sps_table.size()) {
+                    HevcPps& pps = pps_table[pps_id];
+                    pps.sps_id = static_cast<int>(sps_id);
+                    reader.bit();  // dependent_slice_segments_enabled_flag
+                    pps.output_flag_present = reader.bit();
+                    pps.extra_slice_header_bits = static_cast<int>(reader.bits(3));
+                }
+            }
+        }
+        current.coded.bytes += unit.bytes;
+    }
+    finish_picture();
+    if (!pictures.empty()) {
+        pictures.back().coded.bytes += current.coded.bytes;
+    }
+    return pictures;
+}
+
+// ---------------------------------------------------------------------------
+// AV1, VP8 and VP9
+
+uint64_t read_leb128(const uint8_t* data, size_t size, size_t& pos) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        if (pos >= size) {
+            throw std::runtime_error("Truncated OBU size");
+        }
+        uint8_t byte = data[pos++];
+        value |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    return value;
+}
+
+struct Av1State {
+    bool reduced_still_picture_header = false;
+};
+
+// Walk the OBUs of data, calling on_delimiter with the offset of each temporal delimiter.
+// type becomes that of the first frame since the last delimiter that is not a repeat of an
+// earlier frame (show_existing_frame); it stays P when there is none
+template <typename OnDelimiter>
+void scan_obus(const uint8_t* data, size_t size, Av1State& state, OnDelimiter on_delimiter,
+               bool& have_type, PictureType& type) {
+    size_t pos = 0;
+    while (pos < size) {
+        size_t start = pos;
+        uint8_t header = data[pos++];
+        if (header & 0x80) {
+            throw std::runtime_error("OBU forbidden bit set");
+        }
+        int obu_type = (header >> 3) & 0xf;
+        if (header & 0x04) {
+            ++pos;  // Extension header
+        }
+        uint64_t payload_size = header & 0x02 ? read_leb128(data, size, pos) : size - std::min(pos, size);
+        if (pos > size || payload_size > size - pos) {
+            throw std::runtime_error("Truncated OBU");
+        }
+        const uint8_t* payload = data + pos;
+        pos += static_cast<size_t>(payload_size);
+
+        if (obu_type == 2) {
+            on_delimiter(start);
+            have_type = false;
+            type = PictureType::P;
+        } else if (obu_type == 1) {
+            RbspReader reader(payload, static_cast<size_t>(payload_size));
+            reader.skip(4);  // seq_profile and still_picture
+            state.reduced_still_picture_header = reader.bit();
+        } else if ((obu_type == 3 || obu_type == 6) && !have_type) {
+            // OBU payloads have no emulation prevention, so plain bits follow the header
+            if (state.reduced_still_picture_header) {
+                type = PictureType::I;
+                have_type = true;
+                continue;
+            }
+            uint8_t first = payload_size > 0 ? payload[0] : 0;
+            bool show_existing_frame = first & 0x80;
+            if (!show_existing_frame) {
+                int frame_type = (first >> 5) & 3;
+                type = frame_type == 0 || frame_type == 2 ? PictureType::I : PictureType::P;
+                have_type = true;
+            }
+        }
+    }
+}
+
+BitstreamSummary parse_obu_stream(const uint8_t* data, size_t size) {
+    BitstreamSummary summary;
+    summary.codec = "av1";
+    Av1State state;
+    std::vector<size_t> unit_starts;
+    std::vector<PictureType> unit_types;
+    bool have_type = false;
+    PictureType type = PictureType::P;
+    scan_obus(data, size, state, [&](size_t start) {
+        if (!unit_starts.empty()) {
+            unit_types.push_back(type);
+        }
+        unit_starts.push_back(start);
+    }, have_type, type);
+    if (unit_starts.empty()) {
+        throw std::runtime_error("No AV1 temporal delimiters found");
+    }
+    unit_types.push_back(type);
+    for (size_t k = 0; k < unit_starts.size(); ++k) {
+        size_t begin = k == 0 ? 0 : unit_starts[k];
+        size_t end = k + 1 < unit_starts.size() ? unit_starts[k + 1] : size;
+        summary.pictures.push_back({end - begin, unit_types[k]});
+    }
+    summary.total_bytes = size;
+    return summary;
+}
+
+uint32_t read_le32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 | static_cast<uint32_t>(p[2]) << 16 |
+           static_cast<uint32_t>(p[3]) << 24;
+}
+
+BitstreamSummary parse_ivf(const uint8_t* data, size_t size) {
+    if (size < 32 || std::memcmp(data, "DKIF", 4) != 0) {
+        throw std::runtime_error("Not an IVF file");
+    }
+    size_t header_size = static_cast<size_t>(data[6]) | static_cast<size_t>(data[7]) << 8;
+    std::string fourcc(reinterpret_cast<const char*>(data + 8), 4);
+    uint32_t rate = read_le32(data + 16);
+    uint32_t scale = read_le32(data + 20);
+
+    BitstreamSummary summary;
+    if (fourcc == "AV01") {
+        summary.codec = "av1";
+    } else if (fourcc == "VP80") {
+        summary.codec = "vp8";
+    } else if (fourcc == "VP90") {
+        summary.codec = "vp9";
+    } else {
+        throw std::runtime_error("Unsupported IVF codec " + fourcc);
+    }
+
+    Av1State av1;
+    uint64_t first_pts = 0, last_pts = 0;
+    for (size_t pos = std::max<size_t>(header_size, 32); pos + 12 <= size;) {
+        uint32_t frame_size = read_le32(data + pos);
+        uint64_t pts = read_le32(data + pos + 4) | static_cast<uint64_t>(read_le32(data + pos + 8)) << 32;
+        pos += 12;
+        if (frame_size > size - pos) {
+            throw std::runtime_error("Truncated IVF frame");
+        }
+        const uint8_t* frame = data + pos;
+        pos += frame_size;
+
+        // Each IVF frame is one displayed frame (a temporal unit, or a VP9 superframe)
+        PictureType type = PictureType::P;
+        if (summary.codec == "av1") {
+            bool have_type = false;
+            scan_obus(frame, frame_size, av1, [](size_t) {}, have_type, type);
+        } else if (summary.codec == "vp8") {
+            type = frame_size > 0 && !(frame[0] & 1) ? PictureType::I : PictureType::P;
+        } else if (frame_size > 0) {
+            RbspReader reader(frame, 1);  // The VP9 fields needed all sit in the first byte
+            reader.skip(2);  // frame_marker
+            int profile = static_cast<int>(reader.bit());
+            profile |= static_cast<int>(reader.bit()) << 1;
+            if (profile == 3) {
+                reader.bit();
+            }
+            if (!reader.bit() && reader.bit() == 0) {  // Not show_existing_frame, and frame_type KEY_FRAME
+                type = PictureType::I;
+            }
+        }
+        summary.pictures.push_back({frame_size, type});
+        summary.total_bytes += frame_size;
+        if (summary.pictures.size() == 1) {
+            first_pts = pts;
+        }
+        last_pts = pts;
+    }
+
+    // Timestamps give the rate even when the time base is a generic 1/1000
+    size_t frames = summary.pictures.size();
+    if (frames >= 2 && last_pts > first_pts && scale > 0) {
+        summary.frame_rate = static_cast<double>(frames - 1) * rate / (static_cast<double>(last_pts - first_pts) * scale);
+    } else if (scale > 0) {
+        summary.frame_rate = static_cast<double>(rate) / scale;
+    }
+    return summary;
+}
+
+} // namespace
+
+BitstreamFormat parse_bitstream_format(const std::string& name) {
+    if (name == "h264" || name == "avc") return BitstreamFormat::H264;
+    if (name == "hevc" || name == "h265") return BitstreamFormat::HEVC;
+    if (name == "ivf") return BitstreamFormat::IVF;
+    if (name == "obu" || name == "av1") return BitstreamFormat::OBU;
+    throw std::invalid_argument("Unknown bitstream format: " + name + " (expected h264, hevc, ivf or obu)");
+}
+
+BitstreamFormat detect_bitstream_format(const std::string& path) {
+    std::string extension = fs::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    if (extension == ".264" || extension == ".h264" || extension == ".avc") {
+        return BitstreamFormat::H264;
+    }
+    if (extension == ".265" || extension == ".h265" || extension == ".hevc") {
+        return BitstreamFormat::HEVC;
+    }
+    if (extension == ".ivf") {
+        return BitstreamFormat::IVF;
+    }
+    if (extension == ".obu") {
+        return BitstreamFormat::OBU;
+    }
+    char signature[4] = {};
+    std::ifstream file(path, std::ios::binary);
+    file.read(signature, 4);
+    if (file && std::memcmp(signature, "DKIF", 4) == 0) {
+        return BitstreamFormat::IVF;
+    }
+    throw std::runtime_error("Cannot tell the bitstream format of " + path + "; use --bitstream-format");
+}
+
+const char* picture_type_name(PictureType type) {
+    switch (type) {
+        case PictureType::I: return "I";
+        case PictureType::P: return "P";
+        default: return "B";
+    }
+}
+
+BitstreamSummary parse_bitstream(const uint8_t* data, size_t size, BitstreamFormat format) {
+    switch (format) {
+        case BitstreamFormat::H264:
+        case BitstreamFormat::HEVC: {
+            auto units = split_annex_b(data, size);
+            auto pictures = format == BitstreamFormat::H264 ? parse_h264(units) : parse_hevc(units);
+            BitstreamSummary summary;
+            summary.codec = format == BitstreamFormat::H264 ? "h264" : "hevc";
+            summary.pictures = display_order(pictures);
+            summary.total_bytes = size;
+            return summary;
+        }
+        case BitstreamFormat::IVF:
+            return parse_ivf(data, size);
+        default:
+            return parse_obu_stream(data, size);
+    }
+}
+
+BitstreamSummary parse_bitstream_file(const std::string& path, BitstreamFormat format) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("Failed to open bitstream: " + path);
+    }
+    std::vector<uint8_t> bytes(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to read bitstream: " + path);
+    }
+    return parse_bitstream(bytes.data(), bytes.size(), format);
+}
+
+} // namespace rdmeter
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rdmeter {
+
+// Compressed stream layouts whose frame sizes can be read without decoding
+enum class BitstreamFormat {
+    H264,  // Annex-B H.264/AVC elementary stream
+    HEVC,  // Annex-B H.265/HEVC elementary stream
+    IVF,   // IVF container of VP8, VP9 or AV1 frames
+    OBU    // AV1 low-overhead OBU stream (Section 5)
+};
+
+BitstreamFormat parse_bitstream_format(const std::string& name);
+
+// Format from the file extension (.264/.h264/.avc, .265/.h265/.hevc, .ivf, .obu),
+// falling back to the IVF signature
+BitstreamFormat detect_bitstream_format(const std::string& path);
+
+enum class PictureType { I, P, B };
+
+const char* picture_type_name(PictureType type);
+
+struct CodedPicture {
+    uint64_t bytes = 0;  // Including start codes, parameter sets and hidden frames it carries
+    PictureType type = PictureType::P;
+};
+
+struct BitstreamSummary {
+    std::string codec;  // h264, hevc, vp8, vp9 or av1
+    std::vector<CodedPicture> pictures;  // One per displayed frame, in display order
+    uint64_t total_bytes = 0;  // Coded bytes, excluding container headers
+    double frame_rate = 0.0;  // From IVF timestamps, 0 when the stream does not carry timing
+};
+
+// Split a whole stream into displayed pictures in one pass over the data. Only the few
+// header fields needed for picture boundaries, type and order are parsed:
+// - H.264/HEVC pictures are reordered from decode to display order by picture order
+//   count. An H.264 picture is B if any slice is B, else P if any is P; an HEVC picture
+//   takes the type of its first slice segment
+// - AV1 temporal units are one displayed frame each (hidden frames count towards the
+//   unit that carries them); key and intra-only frames are I, the rest P
+// Throws std::runtime_error on data that is not in the given format
+BitstreamSummary parse_bitstream(const uint8_t* data, size_t size, BitstreamFormat format);
+
+BitstreamSummary parse_bitstream_file(const std::string& path, BitstreamFormat format);
+
+} // namespace rdmeter
@@ -0,0 +1,104 @@
+#include "checkpoint.hpp"
+#include "third_party/json.hpp"
+#include <stdexcept>
+#include <fstream>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace rdmeter {
+
+namespace {
+
+constexpr int kCheckpointVersion = 2;
+
+} // namespace
+
+void save_checkpoint(const std::string& path, const ComputeCheckpoint& checkpoint) {
+    nlohmann::json j = {
+        {"version", kCheckpointVersion},
+        {"ref_file", checkpoint.ref_file},
+        {"dist_file", checkpoint.dist_file},
+        {"ref_size", checkpoint.ref_size},
+        {"dist_size", checkpoint.dist_size},
+        {"width", checkpoint.width},
+        {"height", checkpoint.height},
+        {"max_frames", checkpoint.max_frames},
+        {"metrics", checkpoint.metrics},
+        {"input_format", checkpoint.input_format},
+        {"frame_index", checkpoint.frame_index},
+        {"valid_frames", checkpoint.valid_frames},
+        {"sums", checkpoint.sums},
+        {"per_frame_offset", checkpoint.per_frame_offset}
+    };
+
+    fs::path target(path);
+    if (target.has_parent_path()) {
+        fs::create_directories(target.parent_path());
+    }
+
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Failed to open checkpoint file: " + temp_path);
+        }
+        // Doubles are serialised with round-trip precision, so resumed sums are bit-identical
+        out << j.dump(4);
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("Failed to write checkpoint file: " + temp_path);
+        }
+    }
+    fs::rename(temp_path, target);
+}
+
+ComputeCheckpoint load_checkpoint(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Failed to open checkpoint file: " + path);
+    }
+
+    ComputeCheckpoint checkpoint;
+    try {
+        auto j = nlohmann::json::parse(in);
+        if (j.at("version").get<int>() != kCheckpointVersion) {
+            throw std::runtime_error("unsupported version");
+        }
+        checkpoint.ref_file = j.at("ref_file").get<std::string>();
+        checkpoint.dist_file = j.at("dist_file").get<std::string>();
+        checkpoint.ref_size = j.at("ref_size").get<uintmax_t>();
+        checkpoint.dist_size = j.at("dist_size").get<uintmax_t>();
+        checkpoint.width = j.at("width").get<int>();
+        checkpoint.height = j.at("height").get<int>();
+        checkpoint.max_frames = j.at("max_frames").get<int>();
+        checkpoint.metrics = j.at("metrics").get<std::vector<std::string>>();
+        checkpoint.input_format = j.at("input_format").get<std::string>();
+        checkpoint.frame_index = j.at("frame_index").get<int>();
+        checkpoint.valid_frames = j.at("valid_frames").get<int>();
+        checkpoint.sums = j.at("sums").get<std::map<std::string, double>>();
+        checkpoint.per_frame_offset = j.at("per_frame_offset").get<int64_t>();
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Invalid checkpoint file " + path + ": " + e.what());
+    }
+    return checkpoint;
+}
+
+void check_resumable(const ComputeCheckpoint& saved, const ComputeCheckpoint& current) {
+    auto mismatch = [](const std::string& what) {
+        throw std::runtime_error("Checkpoint does not match this run (" + what + " differs)");
+    };
+
+    if (saved.ref_file != current.ref_file) mismatch("reference file");
+    if (saved.dist_file != current.dist_file) mismatch("distorted file");
+    if (saved.ref_size != current.ref_size) mismatch("reference file size");
+    if (saved.dist_size != current.dist_size) mismatch("distorted file size");
+    if (saved.width != current.width || saved.height != current.height) mismatch("resolution");
+    if (saved.max_frames != current.max_frames) mismatch("frame limit");
+    if (saved.metrics != current.metrics) mismatch("metric set");
+    if (saved.input_format != current.input_format) mismatch("input format");
+    if ((saved.per_frame_offset < 0) != (current.per_frame_offset < 0)) mismatch("per-frame output");
+    if (saved.per_frame_offset > current.per_frame_offset) mismatch("per-frame file length");
+}
+
+} // namespace rdmeter
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace rdmeter {
+
+// Snapshot of a compute run taken between frame batches
+// Holds enough to continue at frame_index and finish with the same totals as an uninterrupted run
+struct ComputeCheckpoint {
+    // Run configuration; a checkpoint is only resumable by an identical run
+    std::string ref_file;
+    std::string dist_file;
+    uintmax_t ref_size = 0;
+    uintmax_t dist_size = 0;
+    int width = 0;
+    int height = 0;
+    int max_frames = -1;
+    std::vector<std::string> metrics;
+    std::string input_format;  // Pixel formats and colour conversion of the inputs
+
+    // Streaming accumulators after frame_index frames
+    int frame_index = 0;                 // Next frame to read
+    int valid_frames = 0;                // Frames that contributed to the sums
+    std::map<std::string, double> sums;  // Per-metric running totals, e.g. "psnr_y"
+    int64_t per_frame_offset = -1;       // Bytes of per-frame output covering those frames; -1 without a per-frame file
+};
+
+// Write a checkpoint atomically (temporary file then rename), so a crash
+// mid-write leaves the previous checkpoint intact
+void save_checkpoint(const std::string& path, const ComputeCheckpoint& checkpoint);
+
+// Read a checkpoint written by save_checkpoint. Throws std::runtime_error if missing or malformed
+ComputeCheckpoint load_checkpoint(const std::string& path);
+
+// Throw std::runtime_error describing the first difference if saved was taken from a different run than current.
+// current.per_frame_offset is the size of the per-frame file now, which must still hold what saved covers
+void check_resumable(const ComputeCheckpoint& saved, const ComputeCheckpoint& current);
+
+} // namespace rdmeter
@@ -0,0 +1,361 @@
+#include "ciede.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+namespace rdmeter {
+
+namespace {
+
+// Pixels converted per block; the planar staging arrays stay in L1
+constexpr int kBlock = 64;
+constexpr int kEotfSteps = 4096;
+constexpr double kPi = 3.14159265358979323846;
+constexpr float kDegToRad = static_cast<float>(kPi / 180.0);
+constexpr float kPow25To7 = 6103515625.0f;
+
+// Everything below is branch-free float arithmetic (selects, sqrt and division only),
+// so the per-pixel loops vectorise without a vector math library
+
+// Lab f(t): cube root above (6/29)^3, linear below. The cube root starts from
+// t^(1/4 + 1/16 + 1/64) (within 2.5% of t^(1/3) on [0.0088, 1.1]) and takes two Newton steps
+inline float lab_f(float t) {
+    const float epsilon = 216.0f / 24389.0f;
+    float tc = std::max(t, epsilon);
+    float s4 = std::sqrt(std::sqrt(tc));
+    float s16 = std::sqrt(std::sqrt(s4));
+    float s64 = std::sqrt(std::sqrt(s16));
+    float y = s4 * s16 * s64;
+    y = (2.0f * y + tc / (y * y)) * (1.0f / 3.0f);
+    y = (2.0f * y + tc / (y * y)) * (1.0f / 3.0f);
+    float linear = t * (24389.0f / 27.0f / 116.0f) + 16.0f / 116.0f;
+    return t > epsilon ? y : linear;
+}
+
+// atan2 in degrees in [0, 360) with a cubic-in-a^2 minimax polynomial, error about 1e-5 radians
+inline float atan2_deg(float y, float x) {
+    float ax = std::abs(x);
+    float ay = std::abs(y);
+    float a = std::min(ax, ay) / std::max(std::max(ax, ay), 1e-30f);
+    float s = a * a;
+    float r = ((-0.0464964749f * s + 0.15931422f) * s - 0.327622764f) * s * a + a;
+    r = ay > ax ? 1.57079637f - r : r;
+    r = x < 0.0f ? 3.14159274f - r : r;
+    r = y < 0.0f ? -r : r;
+    float degrees = r * (180.0f / 3.14159274f);
+    return degrees < 0.0f ? degrees + 360.0f : degrees;
+}
+
+// exp(-z) for z >= 0: Taylor series of exp(-z/64) squared six times (relative error < 1e-5);
+// z is clamped at 20, where the result is already below 3e-9
+inline float exp_neg(float z) {
+    float x = -std::min(z, 20.0f) * (1.0f / 64.0f);
+    float e = 1.0f + x * (1.0f + x * (0.5f + x * (1.0f / 6.0f + x * (1.0f / 24.0f + x * (1.0f / 120.0f + x * (1.0f / 720.0f))))));
+    e *= e;
+    e *= e;
+    e *= e;
+    e *= e;
+    e *= e;
+    e *= e;
+    return e;
+}
+
+// sin(x) for |x| <= pi/3 by Taylor series to x^9
+inline float sin_small(float x) {
+    float s = x * x;
+    return x * (1.0f - s * (1.0f / 6.0f - s * (1.0f / 120.0f - s * (1.0f / 5040.0f - s * (1.0f / 362880.0f)))));
+}
+
+inline float pow7(float x) {
+    float x2 = x * x;
+    return x2 * x2 * x2 * x;
+}
+
+double srgb_eotf(double x) {
+    return x <= 0.04045 ? x / 12.92 : std::pow((x + 0.055) / 1.055, 2.4);
+}
+
+} // namespace
+
+double ciede2000(const Lab& x, const Lab& y) {
+    const double deg = 180.0 / kPi;
+    double c1 = std::hypot(x.a, x.b);
+    double c2 = std::hypot(y.a, y.b);
+    double c_mean7 = std::pow((c1 + c2) / 2.0, 7.0);
+    double g = 0.5 * (1.0 - std::sqrt(c_mean7 / (c_mean7 + std::pow(25.0, 7.0))));
+    double a1 = (1.0 + g) * x.a;
+    double a2 = (1.0 + g) * y.a;
+    double cp1 = std::hypot(a1, x.b);
+    double cp2 = std::hypot(a2, y.b);
+    double h1 = (a1 == 0.0 && x.b == 0.0) ? 0.0 : std::atan2(x.b, a1) * deg;
+    double h2 = (a2 == 0.0 && y.b == 0.0) ? 0.0 : std::atan2(y.b, a2) * deg;
+    if (h1 < 0.0) h1 += 360.0;
+    if (h2 < 0.0) h2 += 360.0;
+
+    double dl = y.L - x.L;
+    double dc = cp2 - cp1;
+    double dh = 0.0;
+    if (cp1 * cp2 != 0.0) {
+        dh = h2 - h1;
+        if (dh > 180.0) dh -= 360.0;
+        if (dh < -180.0) dh += 360.0;
+    }
+    double d_big_h = 2.0 * std::sqrt(cp1 * cp2) * std::sin(dh / 2.0 / deg);
+
+    double l_mean = (x.L + y.L) / 2.0;
+    double cp_mean = (cp1 + cp2) / 2.0;
+    double h_mean = h1 + h2;
+    if (cp1 * cp2 != 0.0) {
+        if (std::abs(h1 - h2) <= 180.0) {
+            h_mean = (h1 + h2) / 2.0;
+        } else {
+            h_mean = (h1 + h2 < 360.0) ? (h1 + h2 + 360.0) / 2.0 : (h1 + h2 - 360.0) / 2.0;
+        }
+    }
+
+    double t = 1.0 - 0.17 * std::cos((h_mean - 30.0) / deg) + 0.24 * std::cos(2.0 * h_mean / deg) +
+               0.32 * std::cos((3.0 * h_mean + 6.0) / deg) - 0.20 * std::cos((4.0 * h_mean - 63.0) / deg);
+    double d_theta = 30.0 * std::exp(-std::pow((h_mean - 275.0) / 25.0, 2.0));
+    double cp_mean7 = std::pow(cp_mean, 7.0);
+    double rc = 2.0 * std::sqrt(cp_mean7 / (cp_mean7 + std::pow(25.0, 7.0)));
+    double l50 = (l_mean - 50.0) * (l_mean - 50.0);
+    double sl = 1.0 + 0.015 * l50 / std::sqrt(20.0 + l50);
+    double sc = 1.0 + 0.045 * cp_mean;
+    double sh = 1.0 + 0.015 * cp_mean * t;
+    double rt = -std::sin(2.0 * d_theta / deg) * rc;
+
+    double tl = dl / sl;
+    double tc = dc / sc;
+    double th = d_big_h / sh;
+    return std::sqrt(tl * tl + tc * tc + th * th + rt * tc * th);
+}
+
+void ciede2000_block(const float* __restrict L1, const float* __restrict a1, const float* __restrict b1,
+                     const float* __restrict L2, const float* __restrict a2, const float* __restrict b2,
+                     int count, float* __restrict out) {
+    const float cos6 = 0.994521895f, sin6 = 0.104528463f;
+    const float cos30 = 0.866025404f, sin30 = 0.5f;
+    const float cos63 = 0.453990500f, sin63 = 0.891006524f;
+
+    for (int i = 0; i < count; ++i) {
+        float c1 = std::sqrt(a1[i] * a1[i] + b1[i] * b1[i]);
+        float c2 = std::sqrt(a2[i] * a2[i] + b2[i] * b2[i]);
+        float c_mean7 = pow7(0.5f * (c1 + c2));
+        float g = 0.5f * (1.0f - std::sqrt(c_mean7 / (c_mean7 + kPow25To7)));
+        float ap1 = (1.0f + g) * a1[i];
+        float ap2 = (1.0f + g) * a2[i];
+        float cp1 = std::sqrt(ap1 * ap1 + b1[i] * b1[i]);
+        float cp2 = std::sqrt(ap2 * ap2 + b2[i] * b2[i]);
+
+        // dH' = 2 sqrt(C1'C2') sin(dh'/2) without angles: its square is 2 (C1'C2' - a1'a2' - b1 b2),
+        // evaluated as da'^2 + db^2 - dC'^2 so it stays exact for close colours, and its sign
+        // is the sign of the cross product
+        float cross = ap1 * b2[i] - ap2 * b1[i];
+        float da = ap2 - ap1;
+        float db = b2[i] - b1[i];
+        float dc = cp2 - cp1;
+        float dh = std::sqrt(std::max(0.0f, da * da + db * db - dc * dc));
+        dh = cross < 0.0f ? -dh : dh;
+
+        // The mean hue bisects the shorter arc, i.e. it points along the sum of the unit hue
+        // vectors; a zero-chroma colour contributes nothing, matching the h1' + h2' rule
+        float r1 = 1.0f / std::max(cp1, 1e-30f);
+        float r2 = 1.0f / std::max(cp2, 1e-30f);
+        float inv1 = cp1 > 0.0f ? r1 : 0.0f;
+        float inv2 = cp2 > 0.0f ? r2 : 0.0f;
+        float sx = ap1 * inv1 + ap2 * inv2;
+        float sy = b1[i] * inv1 + b2[i] * inv2;
+        float norm = std::sqrt(sx * sx + sy * sy);
+        float inv_norm = 1.0f / std::max(norm, 1e-30f);
+        float ch = norm > 0.0f ? sx * inv_norm : 1.0f;
+        float sh = sy * inv_norm;
+
+        // Multiple-angle terms of T from cos/sin of the mean hue
+        float c2h = 2.0f * ch * ch - 1.0f;
+        float s2h = 2.0f * sh * ch;
+        float c3h = ch * (4.0f * ch * ch - 3.0f);
+        float s3h = sh * (3.0f - 4.0f * sh * sh);
+        float c4h = 2.0f * c2h * c2h - 1.0f;
+        float s4h = 2.0f * s2h * c2h;
+        float t = 1.0f - 0.17f * (ch * cos30 + sh * sin30) + 0.24f * c2h +
+                  0.32f * (c3h * cos6 - s3h * sin6) - 0.20f * (c4h * cos63 + s4h * sin63);
+
+        float z = (atan2_deg(sh, ch) - 275.0f) * (1.0f / 25.0f);
+        float d_theta = 30.0f * exp_neg(z * z);
+        float cp_mean = 0.5f * (cp1 + cp2);
+        float cp_mean7 = pow7(cp_mean);
+        float rc = 2.0f * std::sqrt(cp_mean7 / (cp_mean7 + kPow25To7));
+        float rt = -sin_small(2.0f * d_theta * kDegToRad) * rc;
+
+        float l50 = 0.5f * (L1[i] + L2[i]) - 50.0f;
+        l50 *= l50;
+        float sl = 1.0f + 0.015f * l50 / std::sqrt(20.0f + l50);
+        float sc = 1.0f + 0.045f * cp_mean;
+        float shue = 1.0f + 0.015f * cp_mean * t;
+
+        float tl = (L2[i] - L1[i]) / sl;
+        float tc = dc / sc;
+        float th = dh / shue;
+        out[i] = std::sqrt(std::max(0.0f, tl * tl + tc * tc + th * th + rt * tc * th));
+    }
+}
+
+YuvToLab make_yuv_to_lab(ColorMatrix matrix, ColorRange range, int bit_depth) {
+    if (bit_depth < 8 || bit_depth > 16) {
+        throw std::invalid_argument("CIEDE2000 needs a bit depth between 8 and 16");
+    }
+    double kr, kb;
+    matrix_coefficients(matrix, kr, kb);
+    double kg = 1.0 - kr - kb;
+
+    YuvToLab k;
+    k.bit_depth = bit_depth;
+    double scale = static_cast<double>(1 << (bit_depth - 8));
+    double max_code = static_cast<double>((1 << bit_depth) - 1);
+    if (range == ColorRange::Limited) {
+        k.y_offset = static_cast<float>(16.0 * scale);
+        k.y_scale = static_cast<float>(1.0 / (219.0 * scale));
+        k.c_scale = static_cast<float>(1.0 / (224.0 * scale));
+    } else {
+        k.y_offset = 0.0f;
+        k.y_scale = static_cast<float>(1.0 / max_code);
+        k.c_scale = static_cast<float>(1.0 / max_code);
+    }
+    k.c_offset = static_cast<float>(128.0 * scale);
+    k.r_cr = static_cast<float>(2.0 * (1.0 - kr));
+    k.b_cb = static_cast<float>(2.0 * (1.0 - kb));
+    k.g_cb = static_cast<float>(-2.0 * (1.0 - kb) * kb / kg);
+    k.g_cr = static_cast<float>(-2.0 * (1.0 - kr) * kr / kg);
+
+    // Linear RGB to XYZ for the primaries that go with each matrix, D65 white
+    static const double smpte170m[9] = {0.3935891, 0.3652497, 0.1916313,
+                                        0.2124132, 0.7010437, 0.0865432,
+                                        0.0187423, 0.1119313, 0.9581563};
+    static const double bt709[9] = {0.4124564, 0.3575761, 0.1804375,
+                                    0.2126729, 0.7151522, 0.0721750,
+                                    0.0193339, 0.1191920, 0.9503041};
+    static const double bt2020[9] = {0.6369580, 0.1446169, 0.1688810,
+                                     0.2627002, 0.6779981, 0.0593017,
+                                     0.0000000, 0.0280727, 1.0609851};
+    const double* primaries = matrix == ColorMatrix::BT601 ? smpte170m : matrix == ColorMatrix::BT709 ? bt709 : bt2020;
+    for (int row = 0; row < 3; ++row) {
+        // Each row sums to the white point, so dividing by it normalises white to (1, 1, 1)
+        double white = primaries[row * 3] + primaries[row * 3 + 1] + primaries[row * 3 + 2];
+        for (int col = 0; col < 3; ++col) {
+            k.xyz[row * 3 + col] = static_cast<float>(primaries[row * 3 + col] / white);
+        }
+    }
+
+    k.eotf.resize(kEotfSteps + 2);
+    for (int i = 0; i <= kEotfSteps; ++i) {
+        k.eotf[i] = static_cast<float>(srgb_eotf(static_cast<double>(i) / kEotfSteps));
+    }
+    k.eotf[kEotfSteps + 1] = k.eotf[kEotfSteps];  // Guard entry for interpolation at exactly 1.0
+    return k;
+}
+
+template <typename Sample>
+void yuv_row_to_lab(const Sample* y, const Sample* u, const Sample* v, int width, const YuvToLab& k,
+                    float* L, float* a, float* b) {
+    float r[kBlock], g[kBlock], bl[kBlock];
+    float cb[kBlock], cr[kBlock];
+    const float* eotf = k.eotf.data();
+    const int chroma_last = std::max(0, width / 2 - 1);
+
+    for (int x0 = 0; x0 < width; x0 += kBlock) {
+        int n = std::min(kBlock, width - x0);
+
+        // Gather luma and nearest-neighbour chroma
+        for (int i = 0; i < n; ++i) {
+            int cx = std::min((x0 + i) >> 1, chroma_last);
+            r[i] = static_cast<float>(y[x0 + i]);
+            cb[i] = static_cast<float>(u[cx]);
+            cr[i] = static_cast<float>(v[cx]);
+        }
+
+        // Y'CbCr to R'G'B', clamped to the displayable range
+        for (int i = 0; i < n; ++i) {
+            float luma = (r[i] - k.y_offset) * k.y_scale;
+            float pb = (cb[i] - k.c_offset) * k.c_scale;
+            float pr = (cr[i] - k.c_offset) * k.c_scale;
+            r[i] = std::min(1.0f, std::max(0.0f, luma + k.r_cr * pr));
+            g[i] = std::min(1.0f, std::max(0.0f, luma + k.g_cb * pb + k.g_cr * pr));
+            bl[i] = std::min(1.0f, std::max(0.0f, luma + k.b_cb * pb));
+        }
+
+        // Display light by table lookup with linear interpolation
+        for (int i = 0; i < n; ++i) {
+            float* channel[3] = {&r[i], &g[i], &bl[i]};
+            for (float* c : channel) {
+                float pos = *c * kEotfSteps;
+                int index = static_cast<int>(pos);
+                float frac = pos - static_cast<float>(index);
+                *c = eotf[index] + (eotf[index + 1] - eotf[index]) * frac;
+            }
+        }
+
+        // XYZ relative to white, then Lab
+        for (int i = 0; i < n; ++i) {
+            float fx = lab_f(k.xyz[0] * r[i] + k.xyz[1] * g[i] + k.xyz[2] * bl[i]);
+            float fy = lab_f(k.xyz[3] * r[i] + k.xyz[4] * g[i] + k.xyz[5] * bl[i]);
+            float fz = lab_f(k.xyz[6] * r[i] + k.xyz[7] * g[i] + k.xyz[8] * bl[i]);
+            L[x0 + i] = 116.0f * fy - 16.0f;
+            a[x0 + i] = 500.0f * (fx - fy);
+            b[x0 + i] = 200.0f * (fy - fz);
+        }
+    }
+}
+
+template void yuv_row_to_lab<uint8_t>(const uint8_t*, const uint8_t*, const uint8_t*, int, const YuvToLab&,
+                                      float*, float*, float*);
+template void yuv_row_to_lab<uint16_t>(const uint16_t*, const uint16_t*, const uint16_t*, int, const YuvToLab&,
+                                       float*, float*, float*);
+
+double ciede2000_frame(const YUVFrame& ref, const YUVFrame& dist, const YuvToLab& k) {
+    if (ref.width != dist.width || ref.height != dist.height || ref.bit_depth != dist.bit_depth) {
+        throw std::invalid_argument("Frame sizes do not match or invalid dimensions");
+    }
+    if (ref.bit_depth != k.bit_depth) {
+        throw std::invalid_argument("CIEDE2000 constants do not match the input bit depth");
+    }
+    const int width = ref.width;
+    const int height = ref.height;
+    if (width < 2 || height < 2) {
+        throw std::invalid_argument("Image too small for CIEDE2000 calculation (minimum 2x2 required)");
+    }
+    const int chroma_width = width / 2;
+    const int chroma_last = height / 2 - 1;
+
+    // Planar Lab rows of both frames plus the per-pixel differences
+    std::vector<float> scratch(7 * static_cast<size_t>(width));
+    float* lab1[3] = {scratch.data(), scratch.data() + width, scratch.data() + 2 * width};
+    float* lab2[3] = {scratch.data() + 3 * width, scratch.data() + 4 * width, scratch.data() + 5 * width};
+    float* delta = scratch.data() + 6 * width;
+
+    double total = 0.0;
+    for (int row = 0; row < height; ++row) {
+        size_t luma = static_cast<size_t>(row) * width;
+        size_t chroma = static_cast<size_t>(std::min(row / 2, chroma_last)) * chroma_width;
+        if (ref.bit_depth > 8) {
+            yuv_row_to_lab(ref.y16.data() + luma, ref.u16.data() + chroma, ref.v16.data() + chroma, width, k,
+                           lab1[0], lab1[1], lab1[2]);
+            yuv_row_to_lab(dist.y16.data() + luma, dist.u16.data() + chroma, dist.v16.data() + chroma, width, k,
+                           lab2[0], lab2[1], lab2[2]);
+        } else {
+            yuv_row_to_lab(ref.y.data() + luma, ref.u.data() + chroma, ref.v.data() + chroma, width, k,
+                           lab1[0], lab1[1], lab1[2]);
+            yuv_row_to_lab(dist.y.data() + luma, dist.u.data() + chroma, dist.v.data() + chroma, width, k,
+                           lab2[0], lab2[1], lab2[2]);
+        }
+        ciede2000_block(lab1[0], lab1[1], lab1[2], lab2[0], lab2[1], lab2[2], width, delta);
+
+        double row_total = 0.0;
+        for (int x = 0; x < width; ++x) {
+            row_total += delta[x];
+        }
+        total += row_total;
+    }
+    return total / (static_cast<double>(width) * height);
+}
+
+} // namespace rdmeter
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "color.hpp"
+#include "yuv_reader.hpp"
+#include <vector>
+
+namespace rdmeter {
+
+// CIE L*a*b* colour (D65 white)
+struct Lab {
+    double L = 0.0;
+    double a = 0.0;
+    double b = 0.0;
+};
+
+// CIEDE2000 colour difference (Sharma, Wu and Dalal 2005), double precision reference
+double ciede2000(const Lab& x, const Lab& y);
+
+// Per-frame YCbCr to Lab conversion constants, built once per run
+struct YuvToLab {
+    int bit_depth = 8;
+    float y_offset, y_scale;    // Y' = (Y - y_offset) * y_scale
+    float c_offset, c_scale;    // Cb', Cr' = (C - c_offset) * c_scale
+    float r_cr, g_cb, g_cr, b_cb;
+    float xyz[9];               // Linear RGB to XYZ / white point, row-major
+    std::vector<float> eotf;    // sRGB EOTF sampled at kEotfSteps + 1 points, linearly interpolated
+};
+
+// Decoding uses the matrix and range of the input; RGB primaries follow the matrix
+// (SMPTE 170M, BT.709 or BT.2020) and the sRGB EOTF is used for display light
+YuvToLab make_yuv_to_lab(ColorMatrix matrix, ColorRange range, int bit_depth);
+
+// Convert one row of 4:2:0 YCbCr (nearest-neighbour chroma) to planar Lab
+// Sample is uint8_t or uint16_t to match bit_depth
+template <typename Sample>
+void yuv_row_to_lab(const Sample* y, const Sample* u, const Sample* v, int width, const YuvToLab& k,
+                    float* L, float* a, float* b);
+
+// Vectorisable float CIEDE2000 over count pairs in planar arrays
+void ciede2000_block(const float* L1, const float* a1, const float* b1,
+                     const float* L2, const float* a2, const float* b2, int count, float* out);
+
+// Mean CIEDE2000 of two frames
+double ciede2000_frame(const YUVFrame& ref, const YUVFrame& dist, const YuvToLab& k);
+
+} // namespace rdmeter
@@ -0,0 +1,134 @@
+#include "color.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+namespace rdmeter {
+
+ColorMatrix parse_color_matrix(const std::string& name) {
+    if (name == "bt601" || name == "601") return ColorMatrix::BT601;
+    if (name == "bt709" || name == "709") return ColorMatrix::BT709;
+    if (name == "bt2020" || name == "2020") return ColorMatrix::BT2020;
+    throw std::invalid_argument("Unknown colour matrix: " + name + " (expected bt601, bt709 or bt2020)");
+}
+
+ColorRange parse_color_range(const std::string& name) {
+    if (name == "limited" || name == "tv") return ColorRange::Limited;
+    if (name == "full" || name == "pc") return ColorRange::Full;
+    throw std::invalid_argument("Unknown colour range: " + name + " (expected limited or full)");
+}
+
+void matrix_coefficients(ColorMatrix matrix, double& kr, double& kb) {
+    switch (matrix) {
+        case ColorMatrix::BT601: kr = 0.299; kb = 0.114; break;
+        case ColorMatrix::BT709: kr = 0.2126; kb = 0.0722; break;
+        case ColorMatrix::BT2020: kr = 0.2627; kb = 0.0593; break;
+        default: throw std::invalid_argument("Unknown colour matrix");
+    }
+}
+
+RgbToYuv make_rgb_to_yuv(ColorMatrix matrix, ColorRange range, int input_bits) {
+    double kr, kb;
+    matrix_coefficients(matrix, kr, kb);
+    if (input_bits != 8 && input_bits != 16) {
+        throw std::invalid_argument("RGB input must be 8 or 16 bits per sample");
+    }
+    double kg = 1.0 - kr - kb;
+
+    // Output scale per unit of normalised input
+    double in_max = input_bits == 8 ? 255.0 : 65535.0;
+    double y_scale = (range == ColorRange::Full ? 255.0 : 219.0) / in_max;
+    double c_scale = (range == ColorRange::Full ? 255.0 : 224.0) / in_max;
+    double y_base = range == ColorRange::Full ? 0.0 : 16.0;
+
+    RgbToYuv k{};
+    k.shift = input_bits == 8 ? 16 : 20;
+    double one = static_cast<double>(1 << k.shift);
+
+    const double y_row[3] = {kr, kg, kb};
+    const double cb_row[3] = {-kr / (2.0 * (1.0 - kb)), -kg / (2.0 * (1.0 - kb)), 0.5};
+    const double cr_row[3] = {0.5, -kg / (2.0 * (1.0 - kr)), -kb / (2.0 * (1.0 - kr))};
+    for (int i = 0; i < 3; ++i) {
+        k.y[i] = static_cast<int32_t>(std::lround(y_row[i] * y_scale * one));
+        k.cb[i] = static_cast<int32_t>(std::lround(cb_row[i] * c_scale * one));
+        k.cr[i] = static_cast<int32_t>(std::lround(cr_row[i] * c_scale * one));
+    }
+    k.y_offset = static_cast<int32_t>(std::lround((y_base + 0.5) * one));
+    k.c_offset = static_cast<int32_t>(std::lround((128.0 + 0.5) * one * 4.0));
+    return k;
+}
+
+namespace {
+
+// Pixels converted per block; the planar staging arrays stay in L1
+constexpr int kBlock = 64;
+
+// Fixed-point multiply-accumulate over planar int32 lanes. Unit-stride and branch-free,
+// so it vectorises on SSE2/AVX and NEON alike without platform intrinsics
+inline void apply_row(const int32_t* __restrict r, const int32_t* __restrict g, const int32_t* __restrict b, int n,
+                      int32_t k0, int32_t k1, int32_t k2, int32_t offset, int shift, uint8_t* __restrict out) {
+    for (int i = 0; i < n; ++i) {
+        int32_t value = (k0 * r[i] + k1 * g[i] + k2 * b[i] + offset) >> shift;
+        out[i] = static_cast<uint8_t>(std::min(255, std::max(0, value)));
+    }
+}
+
+// Deinterleave one block of RGB into planar lanes
+template <typename Sample>
+inline void gather_row(const Sample* __restrict row, int n, int32_t* __restrict r, int32_t* __restrict g,
+                       int32_t* __restrict b) {
+    for (int i = 0; i < n; ++i) {
+        r[i] = row[3 * i];
+        g[i] = row[3 * i + 1];
+        b[i] = row[3 * i + 2];
+    }
+}
+
+template <typename Sample>
+void rgb_rows_to_yuv420p(const Sample* row0, const Sample* row1, int width, const RgbToYuv& k,
+                         uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v) {
+    alignas(64) int32_t r[2][kBlock], g[2][kBlock], b[2][kBlock];
+    alignas(64) int32_t rs[kBlock / 2], gs[kBlock / 2], bs[kBlock / 2];
+
+    const int chroma_width = width / 2;
+
+    for (int x0 = 0; x0 < width; x0 += kBlock) {
+        int n = std::min(kBlock, width - x0);
+
+        gather_row(row0 + 3 * x0, n, r[0], g[0], b[0]);
+        apply_row(r[0], g[0], b[0], n, k.y[0], k.y[1], k.y[2], k.y_offset, k.shift, y0 + x0);
+        if (row1) {
+            gather_row(row1 + 3 * x0, n, r[1], g[1], b[1]);
+            apply_row(r[1], g[1], b[1], n, k.y[0], k.y[1], k.y[2], k.y_offset, k.shift, y1 + x0);
+        }
+
+        // 2x2 sums for chroma; an odd last column has no chroma sample
+        int cx0 = x0 / 2;
+        int cn = std::min(kBlock / 2, chroma_width - cx0);
+        // Odd height: chroma of the last row pair comes from one row
+        const int32_t* const r1 = row1 ? r[1] : r[0];
+        const int32_t* const g1 = row1 ? g[1] : g[0];
+        const int32_t* const b1 = row1 ? b[1] : b[0];
+        for (int i = 0; i < cn; ++i) {
+            rs[i] = r[0][2 * i] + r[0][2 * i + 1] + r1[2 * i] + r1[2 * i + 1];
+            gs[i] = g[0][2 * i] + g[0][2 * i + 1] + g1[2 * i] + g1[2 * i + 1];
+            bs[i] = b[0][2 * i] + b[0][2 * i + 1] + b1[2 * i] + b1[2 * i + 1];
+        }
+        apply_row(rs, gs, bs, cn, k.cb[0], k.cb[1], k.cb[2], k.c_offset, k.shift + 2, u + cx0);
+        apply_row(rs, gs, bs, cn, k.cr[0], k.cr[1], k.cr[2], k.c_offset, k.shift + 2, v + cx0);
+    }
+}
+
+} // namespace
+
+void rgb24_rows_to_yuv420p(const uint8_t* row0, const uint8_t* row1, int width, const RgbToYuv& k,
+                           uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v) {
+    rgb_rows_to_yuv420p(row0, row1, width, k, y0, y1, u, v);
+}
+
+void rgb48_rows_to_yuv420p(const uint16_t* row0, const uint16_t* row1, int width, const RgbToYuv& k,
+                           uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v) {
+    rgb_rows_to_yuv420p(row0, row1, width, k, y0, y1, u, v);
+}
+
+} // namespace rdmeter
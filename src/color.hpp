@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace rdmeter {
+
+// YCbCr matrix coefficients (Kr, Kb) of the RGB to YCbCr conversion
+enum class ColorMatrix { BT601, BT709, BT2020 };
+
+// Limited ("TV", Y in 16-235) or full ("PC", 0-255) output range
+enum class ColorRange { Limited, Full };
+
+ColorMatrix parse_color_matrix(const std::string& name);
+ColorRange parse_color_range(const std::string& name);
+
+// Luma weights of a matrix: Y = Kr*R + (1 - Kr - Kb)*G + Kb*B
+void matrix_coefficients(ColorMatrix matrix, double& kr, double& kb);
+
+// Fixed-point RGB to 8-bit YCbCr conversion: out = (k0*R + k1*G + k2*B + offset) >> shift
+// Offsets include the range offset (16 or 128) and the rounding term
+struct RgbToYuv {
+    int32_t y[3];
+    int32_t cb[3];
+    int32_t cr[3];
+    int32_t y_offset;
+    int32_t c_offset;       // For chroma computed from a 2x2 sum, i.e. pre-scaled by 4
+    int shift;              // Luma shift; chroma uses shift + 2 to average the 2x2 sum
+};
+
+// Coefficients for input_bits-deep RGB (8 or 16). The shift is chosen so every intermediate,
+// including a 2x2 chroma sum of 16-bit samples, fits in int32
+RgbToYuv make_rgb_to_yuv(ColorMatrix matrix, ColorRange range, int input_bits);
+
+// Convert two rows of interleaved RGB into two luma rows and one row of 4:2:0 chroma
+// Chroma is taken from the 2x2 average; an odd last column only contributes to luma.
+// row1/y1 may be null for the last row of an odd-height frame (chroma then uses row0 alone)
+void rgb24_rows_to_yuv420p(const uint8_t* row0, const uint8_t* row1, int width, const RgbToYuv& k,
+                           uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v);
+void rgb48_rows_to_yuv420p(const uint16_t* row0, const uint16_t* row1, int width, const RgbToYuv& k,
+                           uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v);
+
+} // namespace rdmeter
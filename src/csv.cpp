@@ -0,0 +1,482 @@
+#include "csv.hpp"
+#include "threading.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace rdmeter {
+
+namespace {
+
+// A private, writable map of a whole file. Pages are copied only where the tokenizer
+// unescapes a quoted field; the file itself is never written
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open CSV file: " + path);
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Failed to stat CSV file: " + path);
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            void* base = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (base == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Failed to map CSV file " + path + ": " + std::strerror(errno));
+            }
+            madvise(base, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<char*>(base);
+        }
+        ::close(fd);
+    }
+    ~MappedFile() {
+        if (data_) {
+            munmap(data_, size_);
+        }
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    char* begin() const { return data_; }
+    char* end() const { return data_ + size_; }
+
+private:
+    char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Tab-separated if the first non-blank line has tabs and no commas
+char detect_separator(const char* begin, const char* end) {
+    bool tab = false;
+    bool blank = true;
+    for (const char* p = begin; p < end; ++p) {
+        if (*p == ',') {
+            return ',';
+        }
+        if (*p == '\n') {
+            if (!blank) {
+                break;
+            }
+            tab = false;
+        } else if (*p == '\t') {
+            tab = true;
+        } else if (*p != ' ' && *p != '\r') {
+            blank = false;
+        }
+    }
+    return tab ? '\t' : ',';
+}
+
+std::string_view trim(const char* begin, const char* end) {
+    while (begin < end && (*begin == ' ' || *begin == '\t' || *begin == '\r')) {
+        ++begin;
+    }
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) {
+        --end;
+    }
+    return std::string_view(begin, static_cast<size_t>(end - begin));
+}
+
+std::string column_list(const std::vector<std::string>& header) {
+    std::string columns;
+    for (const auto& h : header) {
+        columns += (columns.empty() ? "" : ", ") + h;
+    }
+    return columns;
+}
+
+// Below this, splitting a file across threads costs more than it saves
+constexpr size_t kParallelBytes = size_t{4} << 20;
+
+size_t count_lines(const char* begin, const char* end) {
+    size_t lines = 0;
+    for (const char* p = begin; p < end; ++lines) {
+        p = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (!p) {
+            break;
+        }
+        ++p;
+    }
+    return lines;
+}
+
+// The schema's columns from one stretch of a file, text interned within the stretch
+struct ColumnStretch {
+    size_t rows = 0;
+    std::vector<std::vector<double>> numeric;
+    std::vector<CsvTextColumn> text;
+};
+
+void parse_stretch(CsvTokenizer& tokenizer, const CsvSchema& schema, const std::vector<int>& numeric_at,
+                   const std::vector<int>& text_at, size_t expected_rows, const std::string& path,
+                   ColumnStretch& stretch) {
+    stretch.numeric.resize(numeric_at.size());
+    for (size_t k = 0; k < numeric_at.size(); ++k) {
+        if (numeric_at[k] >= 0) {
+            stretch.numeric[k].reserve(expected_rows);
+        }
+    }
+    stretch.text.resize(text_at.size());
+    for (size_t k = 0; k < text_at.size(); ++k) {
+        if (text_at[k] >= 0) {
+            stretch.text[k].codes.reserve(expected_rows);
+        }
+    }
+    // Views into the map stay valid while it does, so lookups copy nothing. Sweeps list
+    // a config's rows together, so most rows repeat the previous row's value
+    std::vector<std::unordered_map<std::string_view, uint32_t>> interned(text_at.size());
+    std::vector<std::string_view> last_value(text_at.size());
+    std::vector<uint32_t> last_code(text_at.size(), UINT32_MAX);
+
+    std::vector<std::string_view> fields;
+    auto field_at = [&](int position) {
+        return static_cast<size_t>(position) < fields.size() ? fields[position] : std::string_view();
+    };
+    while (tokenizer.next(fields)) {
+        for (size_t k = 0; k < numeric_at.size(); ++k) {
+            if (numeric_at[k] < 0) {
+                continue;
+            }
+            std::string_view field = field_at(numeric_at[k]);
+            double value;
+            if (!parse_csv_number(field, value)) {
+                throw std::runtime_error("Column " + schema.numeric[k] + " on line " + std::to_string(tokenizer.line()) +
+                                         " of " + path + " is not a number: " + std::string(field));
+            }
+            stretch.numeric[k].push_back(value);
+        }
+        for (size_t k = 0; k < text_at.size(); ++k) {
+            if (text_at[k] < 0) {
+                continue;
+            }
+            std::string_view field = field_at(text_at[k]);
+            CsvTextColumn& column = stretch.text[k];
+            if (last_code[k] == UINT32_MAX || field != last_value[k]) {
+                auto inserted = interned[k].emplace(field, static_cast<uint32_t>(column.values.size()));
+                if (inserted.second) {
+                    column.values.emplace_back(field);
+                }
+                last_value[k] = field;
+                last_code[k] = inserted.first->second;
+            }
+            column.codes.push_back(last_code[k]);
+        }
+        ++stretch.rows;
+    }
+}
+
+} // namespace
+
+CsvTokenizer::CsvTokenizer(char* begin, char* end, char separator, size_t first_line)
+    : pos_(begin), end_(end), separator_(separator), line_(first_line) {
+    stops_[static_cast<unsigned char>(separator)] = true;
+    stops_['\n'] = true;
+    stops_['"'] = true;
+}
+
+bool CsvTokenizer::next(std::vector<std::string_view>& fields) {
+    while (pos_ < end_) {
+        fields.clear();
+        row_line_ = line_;
+        bool quoted_any = false;
+        for (;;) {
+            char* start = pos_;
+            char* p = pos_;
+            while (p < end_ && !stops_[static_cast<unsigned char>(*p)]) {
+                ++p;
+            }
+            char* field_end = p;
+            if (p < end_ && *p == '"') {
+                // Unescape in place; the text only shrinks, so writes never overtake reads
+                quoted_any = true;
+                char* out = p;
+                bool quoted = false;
+                while (p < end_) {
+                    char c = *p;
+                    if (quoted) {
+                        if (c == '"') {
+                            if (p + 1 < end_ && p[1] == '"') {
+                                *out++ = '"';
+                                p += 2;
+                            } else {
+                                quoted = false;
+                                ++p;
+                            }
+                            continue;
+                        }
+                        if (c == '\n') {
+                            ++line_;
+                        }
+                    } else if (c == '"') {
+                        quoted = true;
+                        ++p;
+                        continue;
+                    } else if (c == separator_ || c == '\n') {
+                        break;
+                    }
+                    *out++ = c;
+                    ++p;
+                }
+                field_end = out;
+            }
+            fields.push_back(trim(start, field_end));
+            if (p < end_ && *p == separator_) {
+                pos_ = p + 1;
+                continue;
+            }
+            pos_ = p < end_ ? p + 1 : end_;
+            ++line_;
+            break;
+        }
+        if (fields.size() == 1 && fields[0].empty() && !quoted_any) {
+            continue;  // Blank line
+        }
+        return true;
+    }
+    return false;
+}
+
+bool parse_csv_number(std::string_view field, double& value) {
+    if (field.empty()) {
+        value = std::nan("");
+        return true;
+    }
+    const char* begin = field.data();
+    const char* end = begin + field.size();
+    if (*begin == '+') {
+        ++begin;
+    }
+    auto result = std::from_chars(begin, end, value);
+    if (result.ec == std::errc::result_out_of_range && result.ptr == end) {
+        // Under- or overflow: strtod gives the nearest representable value
+        value = std::strtod(std::string(field).c_str(), nullptr);
+        return true;
+    }
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+int CsvTable::column(const std::string& name) const {
+    for (size_t i = 0; i < header.size(); ++i) {
+        if (header[i] == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+int CsvTable::require_column(const std::string& name) const {
+    int index = column(name);
+    if (index < 0) {
+        throw std::runtime_error("No column " + name + " (columns: " + column_list(header) + ")");
+    }
+    return index;
+}
+
+std::vector<double> CsvTable::numbers(int column) const {
+    std::vector<double> values;
+    values.reserve(rows.size());
+    for (size_t r = 0; r < rows.size(); ++r) {
+        const std::string& field = rows[r][column];
+        double value;
+        if (!parse_csv_number(field, value)) {
+            throw std::runtime_error("Column " + header[column] + " row " + std::to_string(r + 1) +
+                                     " is not a number: " + field);
+        }
+        values.push_back(value);
+    }
+    return values;
+}
+
+CsvTable read_csv(const std::string& path) {
+    MappedFile file(path);
+    CsvTokenizer tokenizer(file.begin(), file.end(), detect_separator(file.begin(), file.end()));
+    CsvTable table;
+    std::vector<std::string_view> fields;
+    if (!tokenizer.next(fields)) {
+        throw std::runtime_error("CSV file has no header: " + path);
+    }
+    table.header.assign(fields.begin(), fields.end());
+    while (tokenizer.next(fields)) {
+        fields.resize(table.header.size());
+        table.rows.emplace_back(fields.begin(), fields.end());
+    }
+    return table;
+}
+
+void append_rows(CsvTable& table, CsvTable&& other, const std::string& other_name) {
+    if (table.header.empty()) {
+        table = std::move(other);
+        return;
+    }
+    if (other.header != table.header) {
+        throw std::runtime_error("Columns of " + other_name + " differ from the first input");
+    }
+    table.rows.insert(table.rows.end(), std::make_move_iterator(other.rows.begin()),
+                      std::make_move_iterator(other.rows.end()));
+}
+
+std::vector<std::vector<std::string>> read_csv_rows(const std::string& path, const std::vector<size_t>& rows) {
+    MappedFile file(path);
+    CsvTokenizer tokenizer(file.begin(), file.end(), detect_separator(file.begin(), file.end()));
+    std::vector<std::string_view> fields;
+    if (!tokenizer.next(fields)) {
+        throw std::runtime_error("CSV file has no header: " + path);
+    }
+    const size_t columns = fields.size();
+    std::vector<std::vector<std::string>> picked;
+    picked.reserve(rows.size());
+    size_t row = 0;
+    for (size_t wanted : rows) {
+        for (;;) {
+            if (!tokenizer.next(fields)) {
+                throw std::runtime_error("CSV file " + path + " has no row " + std::to_string(wanted + 1));
+            }
+            if (row++ == wanted) {
+                break;
+            }
+        }
+        fields.resize(columns);
+        picked.emplace_back(fields.begin(), fields.end());
+    }
+    return picked;
+}
+
+bool CsvColumns::has_column(const std::string& name) const {
+    for (const auto& h : header) {
+        if (h == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+CsvColumns read_csv_columns(const std::string& path, const CsvSchema& schema, ThreadPool* pool) {
+    MappedFile file(path);
+    const char separator = detect_separator(file.begin(), file.end());
+    CsvTokenizer header_tokenizer(file.begin(), file.end(), separator);
+    CsvColumns columns;
+    std::vector<std::string_view> fields;
+    if (!header_tokenizer.next(fields)) {
+        throw std::runtime_error("CSV file has no header: " + path);
+    }
+    columns.header.assign(fields.begin(), fields.end());
+
+    // Header position of each schema column, or -1 for a missing optional one
+    auto locate = [&](const std::vector<std::string>& names) {
+        std::vector<int> positions;
+        for (const auto& name : names) {
+            int position = -1;
+            for (size_t c = 0; c < columns.header.size(); ++c) {
+                if (columns.header[c] == name) {
+                    position = static_cast<int>(c);
+                    break;
+                }
+            }
+            if (position < 0 &&
+                std::find(schema.optional.begin(), schema.optional.end(), name) == schema.optional.end()) {
+                throw std::runtime_error("No column " + name + " in " + path + " (columns: " +
+                                         column_list(columns.header) + ")");
+            }
+            positions.push_back(position);
+        }
+        return positions;
+    };
+    const auto numeric_at = locate(schema.numeric);
+    const auto text_at = locate(schema.text);
+
+    // Stretches cut at line ends parse independently, unless a quoted field may span lines
+    char* body = header_tokenizer.position();
+    const size_t body_bytes = static_cast<size_t>(file.end() - body);
+    size_t stretches = 1;
+    if (pool && pool->size() > 1 && body_bytes >= kParallelBytes && !std::memchr(body, '"', body_bytes)) {
+        stretches = pool->size();
+    }
+    std::vector<char*> bounds = {body};
+    for (size_t k = 1; k < stretches; ++k) {
+        char* target = std::max(body + body_bytes / stretches * k, bounds.back());
+        auto* newline = static_cast<char*>(std::memchr(target, '\n', static_cast<size_t>(file.end() - target)));
+        bounds.push_back(newline ? newline + 1 : file.end());
+    }
+    bounds.push_back(file.end());
+    std::vector<size_t> lines(stretches);
+    for (size_t k = 0; k < stretches; ++k) {
+        lines[k] = count_lines(bounds[k], bounds[k + 1]);
+    }
+
+    std::vector<ColumnStretch> parsed(stretches);
+    auto parse = [&](size_t k, unsigned) {
+        size_t first_line = header_tokenizer.next_line();
+        for (size_t j = 0; j < k; ++j) {
+            first_line += lines[j];
+        }
+        CsvTokenizer tokenizer(bounds[k], bounds[k + 1], separator, first_line);
+        parse_stretch(tokenizer, schema, numeric_at, text_at, lines[k] + 1, path, parsed[k]);
+    };
+    if (stretches > 1) {
+        pool->parallel_for(stretches, parse);
+    } else {
+        parse(0, 0);
+    }
+
+    // Concatenate the stretches, re-interning text across them
+    columns.numeric.resize(schema.numeric.size());
+    columns.text.resize(schema.text.size());
+    if (stretches == 1) {
+        columns.rows = parsed[0].rows;
+        columns.numeric = std::move(parsed[0].numeric);
+        columns.text = std::move(parsed[0].text);
+        return columns;
+    }
+    for (const auto& stretch : parsed) {
+        columns.rows += stretch.rows;
+    }
+    for (size_t k = 0; k < numeric_at.size(); ++k) {
+        if (numeric_at[k] < 0) {
+            continue;
+        }
+        columns.numeric[k].reserve(columns.rows);
+        for (const auto& stretch : parsed) {
+            columns.numeric[k].insert(columns.numeric[k].end(), stretch.numeric[k].begin(), stretch.numeric[k].end());
+        }
+    }
+    for (size_t k = 0; k < text_at.size(); ++k) {
+        if (text_at[k] < 0) {
+            continue;
+        }
+        CsvTextColumn& column = columns.text[k];
+        column.codes.reserve(columns.rows);
+        std::unordered_map<std::string_view, uint32_t> interned;
+        for (const auto& stretch : parsed) {
+            const CsvTextColumn& part = stretch.text[k];
+            std::vector<uint32_t> remap(part.values.size());
+            for (size_t v = 0; v < part.values.size(); ++v) {
+                auto inserted = interned.emplace(part.values[v], static_cast<uint32_t>(column.values.size()));
+                if (inserted.second) {
+                    column.values.push_back(part.values[v]);
+                }
+                remap[v] = inserted.first->second;
+            }
+            for (uint32_t code : part.codes) {
+                column.codes.push_back(remap[code]);
+            }
+        }
+    }
+    return columns;
+}
+
+} // namespace rdmeter
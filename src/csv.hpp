@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rdmeter {
+
+class ThreadPool;
+
+// A CSV file with a header row, such as the RD rows written by compute --rd-csv
+struct CsvTable {
+    std::vector<std::string> header;
+    std::vector<std::vector<std::string>> rows;  // Each padded or cut to header.size() fields
+
+    // Index of the named column, or -1
+    int column(const std::string& name) const;
+
+    // Like column(), but throws std::runtime_error naming the file's columns when absent
+    int require_column(const std::string& name) const;
+
+    // Every value of a column as a number. Empty fields become NaN; anything else that
+    // is not a number throws std::runtime_error
+    std::vector<double> numbers(int column) const;
+};
+
+// Read a comma-separated file (tab-separated if the header has tabs and no commas).
+// Fields may be double-quoted; blank lines are skipped
+CsvTable read_csv(const std::string& path);
+
+// Append the rows of other, whose header must match, to table
+void append_rows(CsvTable& table, CsvTable&& other, const std::string& other_name);
+
+// Rows of a CSV file by index (0 is the first row after the header, blank lines skipped
+// as read_csv skips them), in increasing order, each padded or cut to the header. Only
+// these rows are copied, so picking a few rows out of a large file costs one scan.
+// Throws std::runtime_error for an index past the last row
+std::vector<std::vector<std::string>> read_csv_rows(const std::string& path, const std::vector<size_t>& rows);
+
+// Splits CSV text into rows of fields in place: quoted fields are unescaped within the
+// buffer, so fields are views into it and no field is copied. Fields are trimmed of
+// spaces and tabs, quoted fields may span lines, and blank lines are skipped
+class CsvTokenizer {
+public:
+    // first_line numbers the lines of a buffer that starts partway through a file
+    CsvTokenizer(char* begin, char* end, char separator = ',', size_t first_line = 1);
+
+    // The fields of the next row, or false after the last. The views stay valid as long
+    // as the buffer does
+    bool next(std::vector<std::string_view>& fields);
+
+    // 1-based line of the row last returned, for error messages
+    size_t line() const { return row_line_; }
+
+    // Where the next row starts, and its line
+    char* position() const { return pos_; }
+    size_t next_line() const { return line_; }
+
+private:
+    char* pos_;
+    char* end_;
+    char separator_;
+    std::array<bool, 256> stops_{};  // The separator, newline and quote end a plain run
+    size_t line_ = 1;
+    size_t row_line_ = 0;
+};
+
+// A field as a number, as CsvTable::numbers reads it: empty is NaN; false if it is not a number
+bool parse_csv_number(std::string_view field, double& value);
+
+// Columns to pull out of a CSV file by header name. Numeric columns are parsed while
+// the file is tokenized; text columns are interned, so the names repeated down a sweep
+// (configs, sequences) are stored once. Columns named in optional may be missing
+struct CsvSchema {
+    std::vector<std::string> numeric;
+    std::vector<std::string> text;
+    std::vector<std::string> optional;
+};
+
+// An interned text column: row r holds values[codes[r]]
+struct CsvTextColumn {
+    std::vector<std::string> values;  // Distinct values in first-seen order
+    std::vector<uint32_t> codes;
+
+    const std::string& operator[](size_t row) const { return values[codes[row]]; }
+};
+
+// The schema's columns of a CSV file, in schema order. A missing optional column is empty
+struct CsvColumns {
+    std::vector<std::string> header;  // Every column of the file
+    size_t rows = 0;
+    std::vector<std::vector<double>> numeric;
+    std::vector<CsvTextColumn> text;
+
+    bool has_column(const std::string& name) const;
+};
+
+// Memory-maps path and extracts only the schema's columns, without a string per field.
+// With a pool, a large file without quotes is split at line ends and its stretches are
+// parsed in parallel. Throws std::runtime_error for a missing required column or a field
+// that is not a number
+CsvColumns read_csv_columns(const std::string& path, const CsvSchema& schema, ThreadPool* pool = nullptr);
+
+} // namespace rdmeter
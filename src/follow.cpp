@@ -0,0 +1,118 @@
+#include "follow.hpp"
+#include <filesystem>
+#include <thread>
+#include <system_error>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace rdmeter {
+
+namespace {
+
+uintmax_t size_or_zero(const std::string& path) {
+    std::error_code ec;
+    auto size = fs::file_size(path, ec);
+    return ec ? 0 : size;
+}
+
+} // namespace
+
+FileWatcher::FileWatcher(const std::vector<std::string>& paths, bool force_polling)
+    : paths_(paths), closed_(paths.size(), false) {
+    for (const auto& path : paths_) {
+        last_sizes_.push_back(size_or_zero(path));
+    }
+
+#ifdef __linux__
+    if (!force_polling) {
+        inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        for (const auto& path : paths_) {
+            if (inotify_fd_ < 0) {
+                break;
+            }
+            int watch = inotify_add_watch(inotify_fd_, path.c_str(), IN_MODIFY | IN_CLOSE_WRITE);
+            if (watch < 0) {
+                // e.g. watch limit reached or unsupported filesystem: fall back to polling
+                close(inotify_fd_);
+                inotify_fd_ = -1;
+            }
+            watches_.push_back(watch);
+        }
+    }
+#else
+    (void)force_polling;
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+#ifdef __linux__
+    if (inotify_fd_ >= 0) {
+        close(inotify_fd_);
+    }
+#endif
+}
+
+FileWatcher::Event FileWatcher::wait(std::chrono::milliseconds timeout) {
+#ifdef __linux__
+    if (inotify_fd_ >= 0) {
+        struct pollfd pfd = {inotify_fd_, POLLIN, 0};
+        int ready = poll(&pfd, 1, static_cast<int>(timeout.count()));
+        if (ready <= 0) {
+            return Event::Timeout;
+        }
+
+        // Drain every queued event in order, so a write after a close reopens the file; a
+        // close outranks plain modifications. The same file may be watched under two paths
+        alignas(struct inotify_event) char buffer[4096];
+        bool closed = false;
+        ssize_t length;
+        while ((length = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + length;) {
+                auto* event = reinterpret_cast<struct inotify_event*>(p);
+                for (size_t i = 0; i < watches_.size(); ++i) {
+                    if (watches_[i] != event->wd) {
+                        continue;
+                    }
+                    if (event->mask & IN_MODIFY) {
+                        closed_[i] = false;
+                    }
+                    if (event->mask & IN_CLOSE_WRITE) {
+                        closed_[i] = true;
+                        closed = true;
+                    }
+                }
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+        return closed ? Event::Closed : Event::Modified;
+    }
+#endif
+
+    // Polling fallback: a writer closing cannot be observed, only growth
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+        bool grew = false;
+        for (size_t i = 0; i < paths_.size(); ++i) {
+            auto size = size_or_zero(paths_[i]);
+            if (size != last_sizes_[i]) {
+                last_sizes_[i] = size;
+                grew = true;
+            }
+        }
+        if (grew) {
+            return Event::Modified;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return Event::Timeout;
+        }
+        std::this_thread::sleep_for(kPollInterval);
+    }
+}
+
+} // namespace rdmeter
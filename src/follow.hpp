@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rdmeter {
+
+// Watches files that another process is still writing
+// Uses inotify where available and falls back to polling file sizes elsewhere
+class FileWatcher {
+public:
+    enum class Event {
+        Modified,  // A watched file grew or was written
+        Closed,    // A writer closed a watched file; see closed() for which
+        Timeout    // Nothing happened within the timeout
+    };
+
+    explicit FileWatcher(const std::vector<std::string>& paths, bool force_polling = false);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Block until a watched file changes or timeout elapses
+    Event wait(std::chrono::milliseconds timeout);
+
+    // Whether the writer of paths[index] closed it and has not written it since. Polling
+    // cannot observe a close, so this is always false without inotify
+    bool closed(size_t index) const { return closed_[index]; }
+
+    bool using_inotify() const { return inotify_fd_ >= 0; }
+
+    // Interval between size checks when polling
+    static constexpr std::chrono::milliseconds kPollInterval{20};
+
+private:
+    std::vector<std::string> paths_;
+    std::vector<uintmax_t> last_sizes_;
+    std::vector<int> watches_;  // inotify watch descriptor of each path
+    std::vector<bool> closed_;
+    int inotify_fd_ = -1;
+};
+
+} // namespace rdmeter
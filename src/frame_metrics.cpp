@@ -0,0 +1,376 @@
+#include "frame_metrics.hpp"
+#include "metrics.hpp"
+#include "sampling.hpp"
+#include "psnr_hvs.hpp"
+#include "ciede.hpp"
+#include "noref.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <memory>
+#include <cmath>
+
+namespace rdmeter {
+
+namespace {
+
+bool requested(const std::vector<std::string>& names, const std::string& name) {
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+// Round high bit depth samples to 8 bits for metrics that only have an 8-bit implementation
+std::vector<uint8_t> plane_8bit(const std::vector<uint16_t>& plane, int bit_depth) {
+    int shift = bit_depth - 8;
+    std::vector<uint8_t> out(plane.size());
+    for (size_t i = 0; i < out.size(); ++i) {
+        out[i] = static_cast<uint8_t>(std::min(255, (plane[i] + (1 << (shift - 1))) >> shift));
+    }
+    return out;
+}
+
+std::vector<uint8_t> luma_8bit(const YUVFrame& frame) {
+    return frame.bit_depth <= 8 ? frame.y : plane_8bit(frame.y16, frame.bit_depth);
+}
+
+YUVFrame frame_8bit(const YUVFrame& frame) {
+    YUVFrame out(frame.width, frame.height);
+    out.y = plane_8bit(frame.y16, frame.bit_depth);
+    out.u = plane_8bit(frame.u16, frame.bit_depth);
+    out.v = plane_8bit(frame.v16, frame.bit_depth);
+    return out;
+}
+
+// Luma rows [first_row, first_row + rows) as 8-bit samples; deeper input is rounded into scratch
+const uint8_t* rows_8bit(const YUVFrame& frame, int first_row, int rows, std::vector<uint8_t>& scratch) {
+    size_t offset = static_cast<size_t>(first_row) * frame.width;
+    if (frame.bit_depth <= 8) {
+        return frame.y.data() + offset;
+    }
+    int shift = frame.bit_depth - 8;
+    scratch.resize(static_cast<size_t>(rows) * frame.width);
+    const uint16_t* in = frame.y16.data() + offset;
+    for (size_t i = 0; i < scratch.size(); ++i) {
+        scratch[i] = static_cast<uint8_t>(std::min(255, (in[i] + (1 << (shift - 1))) >> shift));
+    }
+    return scratch.data();
+}
+
+// PSNR from the squared error of each band, at the input's own bit depth
+class PsnrBands : public BandScorer {
+public:
+    explicit PsnrBands(int bit_depth) : bit_depth_(bit_depth) {}
+
+    void add_rows(const YUVFrame& ref, const YUVFrame& dist, int first_row, int rows) override {
+        size_t offset = static_cast<size_t>(first_row) * ref.width;
+        LumaMoments band = bit_depth_ > 8
+            ? luma_moments(ref.y16.data() + offset, dist.y16.data() + offset, ref.width, rows, nullptr, nullptr)
+            : luma_moments(ref.y.data() + offset, dist.y.data() + offset, ref.width, rows, nullptr, nullptr);
+        moments_.count += band.count;
+        moments_.sse += band.sse;
+    }
+
+    double finish() override {
+        LumaMoments moments = moments_;
+        reset();
+        if (bit_depth_ <= 8) {
+            return psnr_from_moments(moments);
+        }
+        // As psnr_y16
+        double mse = static_cast<double>(moments.sse) / static_cast<double>(moments.count);
+        if (mse == 0.0) {
+            return 100.0;
+        }
+        return 20.0 * std::log10(static_cast<double>((1 << bit_depth_) - 1) / std::sqrt(mse));
+    }
+
+    void reset() override { moments_ = LumaMoments(); }
+
+private:
+    int bit_depth_;
+    LumaMoments moments_;
+};
+
+class SsimBands : public BandScorer {
+public:
+    SsimBands(int width, int height) : rows_(width, height) {}
+
+    void add_rows(const YUVFrame& ref, const YUVFrame& dist, int first_row, int rows) override {
+        const uint8_t* a = rows_8bit(ref, first_row, rows, ref_scratch_);
+        const uint8_t* b = rows_8bit(dist, first_row, rows, dist_scratch_);
+        rows_.add_rows(a, b, rows);
+    }
+
+    double finish() override {
+        return static_cast<double>(rows_.finish()) / static_cast<double>(int64_t{1} << kSsimFixedBits);
+    }
+
+    void reset() override { rows_.reset(); }
+
+private:
+    SsimFixedRows rows_;
+    std::vector<uint8_t> ref_scratch_, dist_scratch_;
+};
+
+class MsssimBands : public BandScorer {
+public:
+    MsssimBands(int width, int height) : rows_(width, height) {}
+
+    void add_rows(const YUVFrame& ref, const YUVFrame& dist, int first_row, int rows) override {
+        const uint8_t* a = rows_8bit(ref, first_row, rows, ref_scratch_);
+        const uint8_t* b = rows_8bit(dist, first_row, rows, dist_scratch_);
+        rows_.add_rows(a, b, rows);
+    }
+
+    double finish() override { return rows_.finish(); }
+
+    void reset() override { rows_.reset(); }
+
+private:
+    MsssimRows rows_;
+    std::vector<uint8_t> ref_scratch_, dist_scratch_;
+};
+
+} // namespace
+
+const std::vector<std::string>& frame_metric_names() {
+    static const std::vector<std::string> names = {"psnr", "ssim", "msssim", "psnr_hvs", "psnr_hvs_m", "ciede2000", "wpsnr", "psnr_linear", "psnr_pq", "ssim_pq", "blockiness", "blur", "banding"};
+    return names;
+}
+
+std::vector<FrameMetric> make_frame_metrics(const std::vector<std::string>& names, const FrameMetricOptions& options) {
+    for (const auto& name : names) {
+        if (!requested(frame_metric_names(), name)) {
+            throw std::invalid_argument("Unknown metric: " + name);
+        }
+    }
+
+    const int width = options.width;
+    const int height = options.height;
+    const int bit_depth = options.bit_depth;
+    size_t pixels = static_cast<size_t>(width) * height;
+    std::vector<FrameMetric> metrics;
+
+    if (requested(names, "psnr")) {
+        FrameMetric metric{"psnr", "psnr_y", "PSNR (Y)", " dB", 0, nullptr};
+        metric.compute = [=](const YUVFrame& ref, const YUVFrame& dist, int) {
+            return bit_depth > 8 ? psnr_y16(ref.y16, dist.y16, width, height, bit_depth)
+                                 : psnr_y(ref.y, dist.y, width, height);
+        };
+        if (bit_depth <= 8) {
+            metric.from_luma_moments = psnr_from_moments;
+        }
+        metric.make_band_scorer = [=]() { return std::unique_ptr<BandScorer>(new PsnrBands(bit_depth)); };
+        metrics.push_back(std::move(metric));
+    }
+
+    if (requested(names, "ssim")) {
+        if (width < 8 || height < 8) {
+            throw std::invalid_argument("Image too small for SSIM calculation (minimum 8x8 required)");
+        }
+        // Integer-only, so golden results are bit-identical across compilers and ISAs
+        FrameMetric metric{"ssim", "ssim_y", "SSIM (Y)", "", static_cast<size_t>(width) * 24, nullptr};
+        if (bit_depth > 8) {
+            metric.scratch_bytes += 2 * pixels;
+        }
+        metric.compute = [=](const YUVFrame& ref, const YUVFrame& dist, int) {
+            if (bit_depth > 8) {
+                return ssim_y_int(luma_8bit(ref), luma_8bit(dist), width, height);
+            }
+            return ssim_y_int(ref.y, dist.y, width, height);
+        };
+        metric.make_band_scorer = [=]() { return std::unique_ptr<BandScorer>(new SsimBands(width, height)); };
+        metrics.push_back(std::move(metric));
+    }
+
+    if (requested(names, "msssim")) {
+        // Check if the image is large enough for MS-SSIM
+        if (width < 32 || height < 32) {
+            throw std::invalid_argument("Image too small for MS-SSIM calculation (minimum 32x32 required)");
+        }
+        FrameMetric metric{"msssim", "msssim_y", "MS-SSIM (Y)", "", msssim_scratch_bytes(width, height), nullptr};
+        if (bit_depth > 8) {
+            metric.scratch_bytes += 2 * pixels;
+        }
+        double fraction = options.window_fraction;
+        uint64_t seed = options.seed;
+        metric.compute = [=](const YUVFrame& ref, const YUVFrame& dist, int frame_index) {
+            if (bit_depth > 8) {
+                auto ref_y = luma_8bit(ref);
+                auto dist_y = luma_8bit(dist);
+                return fraction < 1.0 ? msssim_y_sampled(ref_y, dist_y, width, height, fraction, seed ^ frame_index)
+                                      : msssim_y(ref_y, dist_y, width, height);
+            }
+            return fraction < 1.0 ? msssim_y_sampled(ref.y, dist.y, width, height, fraction, seed ^ frame_index)
+                                  : msssim_y(ref.y, dist.y, width, height);
+        };
+        if (fraction >= 1.0) {
+            metric.make_band_scorer = [=]() { return std::unique_ptr<BandScorer>(new MsssimBands(width, height)); };
+        }
+        // Sampled windows and deeper input do not sweep the planes PSNR reads
+        if (fraction >= 1.0 && bit_depth <= 8) {
+            metric.sweep_luma = [=](const YUVFrame& ref, const YUVFrame& dist, LumaMoments& moments) {
+                return msssim_y(ref.y, dist.y, width, height, &moments);
+            };
+        }
+        metrics.push_back(std::move(metric));
+    }
+
+    for (bool masked : {false, true}) {
+        std::string name = masked ? "psnr_hvs_m" : "psnr_hvs";
+        if (!requested(names, name)) {
+            continue;
+        }
+        if (width < 8 || height < 8) {
+            throw std::invalid_argument("Image too small for PSNR-HVS calculation (minimum 8x8 required)");
+        }
+        FrameMetric metric{name, name, masked ? "PSNR-HVS-M (YUV)" : "PSNR-HVS (YUV)", " dB", 0, nullptr};
+        if (bit_depth > 8) {
+            metric.scratch_bytes = 2 * (pixels + pixels / 2);
+        }
+        metric.hvs_error = [=](const YUVFrame& ref, const YUVFrame& dist) {
+            if (bit_depth > 8) {
+                return hvs_frame_error(frame_8bit(ref), frame_8bit(dist));
+            }
+            return hvs_frame_error(ref, dist);
+        };
+        metric.from_hvs_error = [=](const HvsError& error) {
+            return psnr_hvs_from_error(masked ? error.hvs_m : error.hvs);
+        };
+        auto hvs_error = metric.hvs_error;
+        auto from_hvs_error = metric.from_hvs_error;
+        metric.compute = [=](const YUVFrame& ref, const YUVFrame& dist, int) {
+            return from_hvs_error(hvs_error(ref, dist));
+        };
+        metrics.push_back(std::move(metric));
+    }
+
+    if (requested(names, "ciede2000")) {
+        if (width < 2 || height < 2) {
+            throw std::invalid_argument("Image too small for CIEDE2000 calculation (minimum 2x2 required)");
+        }
+        auto constants = std::make_shared<YuvToLab>(make_yuv_to_lab(options.matrix, options.range, bit_depth));
+        FrameMetric metric{"ciede2000", "ciede2000", "CIEDE2000 (mean dE00)", "", 7 * sizeof(float) * width, nullptr};
+        metric.compute = [=](const YUVFrame& ref, const YUVFrame& dist, int) {
+            return ciede2000_frame(ref, dist, *constants);
+        };
+        metrics.push_back(std::move(metric));
+    }
+
+    // HDR metrics share one set of code-value tables
+    const std::vector<std::string> hdr_names = {"wpsnr", "psnr_linear", "psnr_pq", "ssim_pq"};
+    bool any_hdr = std::any_of(hdr_names.begin(), hdr_names.end(), [&](const std::string& n) { return requested(names, n); });
+    if (any_hdr) {
+        if (bit_depth <= 8) {
+            throw std::invalid_argument("HDR metrics need 10-bit or deeper input (e.g. --pix-fmt yuv420p10le)");
+        }
+        auto tables = std::make_shared<HdrTables>(make_hdr_tables(options.transfer, bit_depth));
+
+        if (requested(names, "wpsnr")) {
+            FrameMetric metric{"wpsnr", "wpsnr_y", "wPSNR (Y)", " dB", (size_t{1} << bit_depth) * sizeof(uint64_t), nullptr};
+            metric.compute = [=](const YUVFrame& ref, const YUVFrame& dist, int) {
+                return wpsnr_y(ref.y16, dist.y16, width, height, *tables);
+            };
+            metrics.push_back(std::move(metric));
+        }
+        if (requested(names, "psnr_linear")) {
+            FrameMetric metric{"psnr_linear", "psnr_linear_y", "PSNR linear light (Y)", " dB", 0, nullptr};
+            metric.compute = [=](const YUVFrame& ref, const YUVFrame& dist, int) {
+                return psnr_linear_y(ref.y16, dist.y16, width, height, *tables);
+            };
+            metrics.push_back(std::move(metric));
+        }
+        if (requested(names, "psnr_pq")) {
+            FrameMetric metric{"psnr_pq", "psnr_pq_y", "PSNR PQ domain (Y)", " dB", 0, nullptr};
+            metric.compute = [=](const YUVFrame& ref, const YUVFrame& dist, int) {
+                return psnr_pq_y(ref.y16, dist.y16, width, height, *tables);
+            };
+            metrics.push_back(std::move(metric));
+        }
+        if (requested(names, "ssim_pq")) {
+            FrameMetric metric{"ssim_pq", "ssim_pq_y", "SSIM PQ domain (Y)", "", 0, nullptr};
+            metric.compute = [=](const YUVFrame& ref, const YUVFrame& dist, int) {
+                return ssim_pq_y(ref.y16, dist.y16, width, height, *tables);
+            };
+            metrics.push_back(std::move(metric));
+        }
+    }
+
+    // No-reference detectors score the distorted frame already in the ring
+    if (requested(names, "blockiness")) {
+        int block_size = options.block_size;
+        if (block_size < 2) {
+            throw std::invalid_argument("Block size must be at least 2");
+        }
+        if (width < 2 * block_size || height < 2 * block_size) {
+            throw std::invalid_argument("Image too small for blockiness calculation (minimum two blocks in each direction)");
+        }
+        std::string grid = std::to_string(block_size) + "x" + std::to_string(block_size);
+        FrameMetric metric{"blockiness", "blockiness", "Blockiness (" + grid + " grid)", "", 0, nullptr, true};
+        metric.compute = [=](const YUVFrame&, const YUVFrame& dist, int) {
+            return blockiness_y(dist, block_size);
+        };
+        metrics.push_back(std::move(metric));
+    }
+    if (requested(names, "blur")) {
+        FrameMetric metric{"blur", "blur", "Blur (mean edge width)", " px", static_cast<size_t>(width) * sizeof(int32_t), nullptr, true};
+        metric.compute = [](const YUVFrame&, const YUVFrame& dist, int) {
+            return blur_y(dist);
+        };
+        metrics.push_back(std::move(metric));
+    }
+    if (requested(names, "banding")) {
+        FrameMetric metric{"banding", "banding", "Banding (contour pixels)", "%", static_cast<size_t>(width) * 5, nullptr, true};
+        metric.compute = [](const YUVFrame&, const YUVFrame& dist, int) {
+            return banding_y(dist);
+        };
+        metrics.push_back(std::move(metric));
+    }
+
+    return metrics;
+}
+
+void score_frame(const std::vector<FrameMetric>& metrics, const YUVFrame& ref, const YUVFrame& dist,
+                 int frame_index, std::vector<double>& values,
+                 const std::vector<std::unique_ptr<BandScorer>>* bands) {
+    auto banded = [&](size_t m) { return bands && (*bands)[m]; };
+
+    // Sweep luma once when some metric can be derived from it
+    size_t sweep = metrics.size();
+    bool derived = false;
+    for (size_t m = 0; m < metrics.size(); ++m) {
+        if (banded(m)) {
+            continue;
+        }
+        if (metrics[m].sweep_luma && sweep == metrics.size()) {
+            sweep = m;
+        }
+        derived = derived || metrics[m].from_luma_moments;
+    }
+    values.assign(metrics.size(), 0.0);
+    LumaMoments moments;
+    const bool shared = sweep < metrics.size() && derived;
+    if (shared) {
+        values[sweep] = metrics[sweep].sweep_luma(ref, dist, moments);
+    }
+
+    // The HVS pass runs on first use and serves every metric derived from it
+    HvsError hvs;
+    bool have_hvs = false;
+
+    for (size_t m = 0; m < metrics.size(); ++m) {
+        if (banded(m)) {
+            values[m] = (*bands)[m]->finish();
+        } else if (shared && metrics[m].from_luma_moments) {
+            values[m] = metrics[m].from_luma_moments(moments);
+        } else if (metrics[m].hvs_error && metrics[m].from_hvs_error) {
+            if (!have_hvs) {
+                hvs = metrics[m].hvs_error(ref, dist);
+                have_hvs = true;
+            }
+            values[m] = metrics[m].from_hvs_error(hvs);
+        } else if (!shared || m != sweep) {
+            values[m] = metrics[m].compute(ref, dist, frame_index);
+        }
+    }
+}
+
+} // namespace rdmeter
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "yuv_reader.hpp"
+#include "hdr.hpp"
+#include "color.hpp"
+#include "metrics.hpp"
+#include "psnr_hvs.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace rdmeter {
+
+// Settings shared by every frame of a compute run
+struct FrameMetricOptions {
+    int width = 0;
+    int height = 0;
+    int bit_depth = 8;
+    TransferFunction transfer = TransferFunction::PQ;  // For HDR metrics
+    ColorMatrix matrix = ColorMatrix::BT709;           // For metrics that convert YCbCr to RGB
+    ColorRange range = ColorRange::Limited;
+    double window_fraction = 1.0;                      // Fraction of MS-SSIM windows scored (--sample-windows)
+    uint64_t seed = 1;                                 // Seed for window sampling
+    int block_size = 8;                                // Coding block grid of the blockiness detector
+};
+
+// Scores one frame from luma rows delivered top to bottom, for row-band streaming
+class BandScorer {
+public:
+    virtual ~BandScorer() = default;
+
+    // Luma rows [first_row, first_row + rows) of both frames are filled; rows arrive in order
+    virtual void add_rows(const YUVFrame& ref, const YUVFrame& dist, int first_row, int rows) = 0;
+
+    // Value of the frame once every row has been added (equal to FrameMetric::compute);
+    // resets for the next frame
+    virtual double finish() = 0;
+
+    // Drop a partly scored frame
+    virtual void reset() = 0;
+};
+
+// One per-frame metric of a compute run
+struct FrameMetric {
+    std::string name;          // Name accepted by -m, e.g. "psnr"
+    std::string key;           // Key in the results JSON, e.g. "psnr_y"
+    std::string label;         // Human-readable label, e.g. "PSNR (Y)"
+    std::string unit;          // Printed after values, e.g. " dB"
+    size_t scratch_bytes = 0;  // Heap bytes one evaluation allocates, for memory planning
+
+    // Score one frame pair; frame_index seeds any per-frame sampling
+    // Throws std::invalid_argument for frames that cannot be scored
+    std::function<double(const YUVFrame& ref, const YUVFrame& dist, int frame_index)> compute;
+
+    // No-reference metrics only look at dist, so they can run without a reference input
+    bool reference_free = false;
+
+    // Row-band form for streaming input, or null when the metric needs whole frames
+    std::function<std::unique_ptr<BandScorer>()> make_band_scorer{};
+
+    // Luma sharing, used by score_frame: a metric whose full-resolution sweep also yields
+    // the luma moments sets sweep_luma, and one that needs nothing more than those moments
+    // sets from_luma_moments. Either is null where the metric reads the planes its own way
+    std::function<double(const YUVFrame& ref, const YUVFrame& dist, LumaMoments& moments)> sweep_luma{};
+    std::function<double(const LumaMoments& moments)> from_luma_moments{};
+
+    // HVS sharing, used by score_frame: psnr_hvs and psnr_hvs_m both read one DCT pass,
+    // which score_frame runs once per frame through the first metric's hvs_error
+    std::function<HvsError(const YUVFrame& ref, const YUVFrame& dist)> hvs_error{};
+    std::function<double(const HvsError& error)> from_hvs_error{};
+};
+
+// Names accepted by make_frame_metrics, in output order
+const std::vector<std::string>& frame_metric_names();
+
+// Build the requested metrics in canonical order
+// Throws std::invalid_argument for unknown names or inputs a metric cannot handle
+std::vector<FrameMetric> make_frame_metrics(const std::vector<std::string>& names, const FrameMetricOptions& options);
+
+// Score one frame pair with every metric into values, values[m] being metrics[m]. When one
+// metric sweeps luma that others only need the moments of (psnr with full-resolution 8-bit
+// msssim), the planes are read once for all of them. A metric with a scorer in bands takes
+// its finish() instead, as row-band streaming has already scored the frame
+// Throws std::invalid_argument for frames that cannot be scored
+void score_frame(const std::vector<FrameMetric>& metrics, const YUVFrame& ref, const YUVFrame& dist,
+                 int frame_index, std::vector<double>& values,
+                 const std::vector<std::unique_ptr<BandScorer>>* bands = nullptr);
+
+} // namespace rdmeter
@@ -0,0 +1,181 @@
+#include "hdr.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+namespace rdmeter {
+
+namespace {
+
+// ST 2084 constants
+constexpr double kPqM1 = 2610.0 / 16384.0;
+constexpr double kPqM2 = 2523.0 / 4096.0 * 128.0;
+constexpr double kPqC1 = 3424.0 / 4096.0;
+constexpr double kPqC2 = 2413.0 / 4096.0 * 32.0;
+constexpr double kPqC3 = 2392.0 / 4096.0 * 32.0;
+
+// BT.2100 HLG constants
+constexpr double kHlgA = 0.17883277;
+constexpr double kHlgB = 0.28466892;
+constexpr double kHlgC = 0.55991073;
+
+void check_planes(const std::vector<uint16_t>& ref_y, const std::vector<uint16_t>& dist_y, int width, int height,
+                  const HdrTables& tables) {
+    if (ref_y.size() != dist_y.size() || ref_y.size() != static_cast<size_t>(width) * height) {
+        throw std::invalid_argument("Frame sizes do not match or invalid dimensions");
+    }
+    if (tables.linear.size() != (size_t{1} << tables.bit_depth)) {
+        throw std::invalid_argument("HDR tables are not initialised");
+    }
+}
+
+double psnr_from_mse(double mse, double max_value) {
+    if (mse == 0.0) {
+        // Frames are identical, return a high value
+        return 100.0;
+    }
+    return 10.0 * std::log10(max_value * max_value / mse);
+}
+
+} // namespace
+
+TransferFunction parse_transfer_function(const std::string& name) {
+    if (name == "pq" || name == "st2084") return TransferFunction::PQ;
+    if (name == "hlg" || name == "arib-std-b67") return TransferFunction::HLG;
+    throw std::invalid_argument("Unknown transfer function: " + name + " (expected pq or hlg)");
+}
+
+double pq_eotf(double signal) {
+    double e = std::pow(std::clamp(signal, 0.0, 1.0), 1.0 / kPqM2);
+    return std::pow(std::max(e - kPqC1, 0.0) / (kPqC2 - kPqC3 * e), 1.0 / kPqM1);
+}
+
+double pq_inverse_eotf(double light) {
+    double y = std::pow(std::clamp(light, 0.0, 1.0), kPqM1);
+    return std::pow((kPqC1 + kPqC2 * y) / (1.0 + kPqC3 * y), kPqM2);
+}
+
+double hlg_to_display(double signal) {
+    signal = std::clamp(signal, 0.0, 1.0);
+    double scene = signal <= 0.5 ? signal * signal / 3.0 : (std::exp((signal - kHlgC) / kHlgA) + kHlgB) / 12.0;
+    // 1000 cd/m2 peak is 0.1 of the PQ range
+    return 0.1 * std::pow(scene, 1.2);
+}
+
+HdrTables make_hdr_tables(TransferFunction transfer, int bit_depth) {
+    if (bit_depth < 8 || bit_depth > 16) {
+        throw std::invalid_argument("HDR tables need a bit depth between 8 and 16");
+    }
+
+    HdrTables tables;
+    tables.bit_depth = bit_depth;
+    size_t codes = size_t{1} << bit_depth;
+    tables.wpsnr_weight.resize(codes);
+    tables.linear.resize(codes);
+    tables.pq_code.resize(codes);
+
+    // Limited-range luma: black at 16 and nominal peak at 235, scaled to the bit depth
+    double scale = static_cast<double>(1 << (bit_depth - 8));
+    double black = 16.0 * scale;
+    double range = 219.0 * scale;
+
+    for (size_t code = 0; code < codes; ++code) {
+        double y10 = static_cast<double>(code) * 1024.0 / static_cast<double>(codes);
+        double db = std::clamp(0.015 * y10 - 1.5 - 6.0, -3.0, 6.0);
+        tables.wpsnr_weight[code] = std::pow(2.0, db / 3.0);
+
+        double signal = std::clamp((static_cast<double>(code) - black) / range, 0.0, 1.0);
+        double light = transfer == TransferFunction::PQ ? pq_eotf(signal) : hlg_to_display(signal);
+        tables.linear[code] = light;
+
+        // PQ input is already in the PQ domain, including any codes outside the nominal range
+        tables.pq_code[code] = transfer == TransferFunction::PQ
+                                   ? static_cast<uint16_t>(code)
+                                   : static_cast<uint16_t>(std::lround(black + pq_inverse_eotf(light) * range));
+    }
+    return tables;
+}
+
+double wpsnr_y(const std::vector<uint16_t>& ref_y, const std::vector<uint16_t>& dist_y, int width, int height,
+               const HdrTables& tables) {
+    check_planes(ref_y, dist_y, width, height, tables);
+
+    // Integer SSE binned by reference code value; the weights are applied once per bin
+    const uint32_t mask = (1u << tables.bit_depth) - 1;
+    std::vector<uint64_t> sse_by_code(size_t{1} << tables.bit_depth, 0);
+    for (size_t i = 0; i < ref_y.size(); ++i) {
+        int64_t diff = static_cast<int64_t>(ref_y[i]) - static_cast<int64_t>(dist_y[i]);
+        sse_by_code[ref_y[i] & mask] += static_cast<uint64_t>(diff * diff);
+    }
+
+    double weighted = 0.0;
+    for (size_t code = 0; code < sse_by_code.size(); ++code) {
+        weighted += tables.wpsnr_weight[code] * static_cast<double>(sse_by_code[code]);
+    }
+    return psnr_from_mse(weighted / ref_y.size(), static_cast<double>(mask));
+}
+
+double psnr_linear_y(const std::vector<uint16_t>& ref_y, const std::vector<uint16_t>& dist_y, int width, int height,
+                     const HdrTables& tables) {
+    check_planes(ref_y, dist_y, width, height, tables);
+
+    const uint32_t mask = (1u << tables.bit_depth) - 1;
+    const double* linear = tables.linear.data();
+    double sse = 0.0;
+    for (size_t i = 0; i < ref_y.size(); ++i) {
+        double diff = linear[ref_y[i] & mask] - linear[dist_y[i] & mask];
+        sse += diff * diff;
+    }
+    return psnr_from_mse(sse / ref_y.size(), 1.0);
+}
+
+double psnr_pq_y(const std::vector<uint16_t>& ref_y, const std::vector<uint16_t>& dist_y, int width, int height,
+                 const HdrTables& tables) {
+    check_planes(ref_y, dist_y, width, height, tables);
+
+    const uint32_t mask = (1u << tables.bit_depth) - 1;
+    const uint16_t* pq = tables.pq_code.data();
+    uint64_t sse = 0;
+    for (size_t i = 0; i < ref_y.size(); ++i) {
+        int64_t diff = static_cast<int64_t>(pq[ref_y[i] & mask]) - static_cast<int64_t>(pq[dist_y[i] & mask]);
+        sse += static_cast<uint64_t>(diff * diff);
+    }
+    return psnr_from_mse(static_cast<double>(sse) / ref_y.size(), static_cast<double>(mask));
+}
+
+double ssim_pq_y(const std::vector<uint16_t>& ref_y, const std::vector<uint16_t>& dist_y, int width, int height,
+                 const HdrTables& tables) {
+    check_planes(ref_y, dist_y, width, height, tables);
+
+    const uint32_t mask = (1u << tables.bit_depth) - 1;
+    const uint16_t* pq = tables.pq_code.data();
+    const double L = static_cast<double>(mask);
+    const double C1 = (0.01 * L) * (0.01 * L);
+    const double C2 = (0.03 * L) * (0.03 * L);
+
+    // Per-pixel products are exact in 64-bit integers before they are accumulated
+    uint64_t s1 = 0, s2 = 0;
+    double s11 = 0.0, s22 = 0.0, s12 = 0.0;
+    for (size_t i = 0; i < ref_y.size(); ++i) {
+        uint64_t a = pq[ref_y[i] & mask];
+        uint64_t b = pq[dist_y[i] & mask];
+        s1 += a;
+        s2 += b;
+        s11 += static_cast<double>(a * a);
+        s22 += static_cast<double>(b * b);
+        s12 += static_cast<double>(a * b);
+    }
+
+    double n = static_cast<double>(ref_y.size());
+    double mean1 = s1 / n;
+    double mean2 = s2 / n;
+    double var1 = n > 1.0 ? (s11 - n * mean1 * mean1) / (n - 1.0) : 0.0;
+    double var2 = n > 1.0 ? (s22 - n * mean2 * mean2) / (n - 1.0) : 0.0;
+    double covar = n > 1.0 ? (s12 - n * mean1 * mean2) / (n - 1.0) : 0.0;
+
+    double numerator = (2 * mean1 * mean2 + C1) * (2 * covar + C2);
+    double denominator = (mean1 * mean1 + mean2 * mean2 + C1) * (var1 + var2 + C2);
+    return denominator == 0.0 ? 1.0 : numerator / denominator;
+}
+
+} // namespace rdmeter
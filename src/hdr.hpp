@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rdmeter {
+
+// Transfer function of HDR input
+enum class TransferFunction {
+    PQ,   // SMPTE ST 2084
+    HLG   // ARIB STD-B67 / BT.2100 HLG, displayed at 1000 cd/m2
+};
+
+TransferFunction parse_transfer_function(const std::string& name);
+
+// Lookup tables indexed by luma code value, built once per run
+// Each metric then costs one table lookup per pixel on top of the integer SSE loop
+struct HdrTables {
+    int bit_depth = 10;
+    std::vector<double> wpsnr_weight;  // JVET wPSNR weight applied to the squared error at each reference code
+    std::vector<double> linear;        // Display light normalised to 10000 cd/m2 (1.0)
+    std::vector<uint16_t> pq_code;     // Equivalent PQ code value at the same bit depth
+};
+
+// Build tables for limited-range luma of the given bit depth (8-16)
+HdrTables make_hdr_tables(TransferFunction transfer, int bit_depth);
+
+// PQ EOTF: non-linear signal in [0, 1] to display light normalised to 10000 cd/m2
+double pq_eotf(double signal);
+
+// Inverse PQ EOTF: normalised display light to non-linear signal in [0, 1]
+double pq_inverse_eotf(double light);
+
+// HLG inverse OETF followed by the BT.2100 OOTF for a 1000 cd/m2 display (system gamma 1.2),
+// applied to luma: non-linear signal in [0, 1] to display light normalised to 10000 cd/m2
+double hlg_to_display(double signal);
+
+// Weighted PSNR (JVET HDR CTC): squared errors are weighted by 2^(dB/3) with
+// dB = clip(0.015 * Y10 - 7.5, -3, 6), where Y10 is the reference luma on a 10-bit scale
+double wpsnr_y(const std::vector<uint16_t>& ref_y, const std::vector<uint16_t>& dist_y, int width, int height,
+               const HdrTables& tables);
+
+// PSNR of linear display light with a peak of 10000 cd/m2
+double psnr_linear_y(const std::vector<uint16_t>& ref_y, const std::vector<uint16_t>& dist_y, int width, int height,
+                     const HdrTables& tables);
+
+// PSNR of luma mapped to PQ code values (identical to plain PSNR for PQ input)
+double psnr_pq_y(const std::vector<uint16_t>& ref_y, const std::vector<uint16_t>& dist_y, int width, int height,
+                 const HdrTables& tables);
+
+// Global-statistics SSIM (as ssim_y) of luma mapped to PQ code values
+double ssim_pq_y(const std::vector<uint16_t>& ref_y, const std::vector<uint16_t>& dist_y, int width, int height,
+                 const HdrTables& tables);
+
+} // namespace rdmeter
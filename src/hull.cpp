@@ -0,0 +1,101 @@
+#include "hull.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace rdmeter {
+
+namespace {
+
+// Drop unusable points, then sort by bitrate with the best quality first among equal bitrates
+void sort_points(std::vector<RdPoint>& points, bool log_bitrate) {
+    points.erase(std::remove_if(points.begin(), points.end(), [&](const RdPoint& p) {
+        return !std::isfinite(p.bitrate) || !std::isfinite(p.quality) || (log_bitrate && p.bitrate <= 0.0);
+    }), points.end());
+    std::sort(points.begin(), points.end(), [](const RdPoint& a, const RdPoint& b) {
+        return a.bitrate != b.bitrate ? a.bitrate < b.bitrate : a.quality > b.quality;
+    });
+}
+
+} // namespace
+
+std::vector<RdPoint> upper_convex_hull(std::vector<RdPoint> points, bool log_bitrate) {
+    sort_points(points, log_bitrate);
+    auto x = [&](const RdPoint& p) { return log_bitrate ? std::log(p.bitrate) : p.bitrate; };
+
+    // Andrew's monotone chain: keep only clockwise turns; collinear middle points go too
+    std::vector<RdPoint> hull;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (i > 0 && points[i].bitrate == points[i - 1].bitrate) {
+            continue;  // Dominated by the better encode at the same bitrate
+        }
+        const RdPoint& c = points[i];
+        while (hull.size() >= 2) {
+            const RdPoint& a = hull[hull.size() - 2];
+            const RdPoint& b = hull.back();
+            double cross = (x(b) - x(a)) * (c.quality - a.quality) - (b.quality - a.quality) * (x(c) - x(a));
+            if (cross < 0.0) {
+                break;
+            }
+            hull.pop_back();
+        }
+        hull.push_back(c);
+    }
+
+    // Past the best quality the hull falls; those points only cost bits
+    auto best = std::max_element(hull.begin(), hull.end(), [](const RdPoint& a, const RdPoint& b) {
+        return a.quality < b.quality;
+    });
+    if (best != hull.end()) {
+        hull.erase(best + 1, hull.end());
+    }
+    return hull;
+}
+
+std::vector<RdPoint> pareto_front(std::vector<RdPoint> points) {
+    sort_points(points, false);
+    std::vector<RdPoint> front;
+    for (const auto& p : points) {
+        if (front.empty() || p.quality > front.back().quality) {
+            front.push_back(p);
+        }
+    }
+    return front;
+}
+
+std::vector<RdPoint> select_ladder(const std::vector<RdPoint>& hull, const std::vector<double>& targets) {
+    std::vector<double> sorted_targets = targets;
+    std::sort(sorted_targets.begin(), sorted_targets.end());
+    std::vector<RdPoint> ladder;
+    size_t last = hull.size();
+    for (double target : sorted_targets) {
+        auto above = std::upper_bound(hull.begin(), hull.end(), target, [](double t, const RdPoint& p) {
+            return t < p.bitrate;
+        });
+        if (above == hull.begin()) {
+            continue;
+        }
+        size_t index = static_cast<size_t>(above - hull.begin()) - 1;
+        if (index != last) {
+            ladder.push_back(hull[index]);
+            last = index;
+        }
+    }
+    return ladder;
+}
+
+std::vector<double> log_spaced_bitrates(double min_bitrate, double max_bitrate, int count) {
+    if (!(min_bitrate > 0.0) || !(max_bitrate >= min_bitrate) || count <= 0) {
+        throw std::invalid_argument("Ladder needs 0 < min bitrate <= max bitrate and at least one rung");
+    }
+    std::vector<double> bitrates;
+    for (int i = 0; i < count; ++i) {
+        double t = count == 1 ? 1.0 : static_cast<double>(i) / (count - 1);
+        bitrates.push_back(min_bitrate * std::pow(max_bitrate / min_bitrate, t));
+    }
+    // Exact endpoints, so the top target always reaches the top point
+    bitrates.back() = max_bitrate;
+    return bitrates;
+}
+
+} // namespace rdmeter
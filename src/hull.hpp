@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace rdmeter {
+
+// One encode of a sweep: its bitrate, a quality score, and its row in the input
+struct RdPoint {
+    double bitrate;
+    double quality;
+    size_t row;
+};
+
+// Upper convex hull of quality against bitrate, in increasing bitrate. Only the part
+// where quality still rises is kept, so every hull point is worth its extra bits. With
+// log_bitrate, convexity is judged against log(bitrate), the usual axis of RD curves.
+// Points with a non-finite coordinate (or a non-positive bitrate on the log axis) are
+// ignored. O(n log n)
+std::vector<RdPoint> upper_convex_hull(std::vector<RdPoint> points, bool log_bitrate = false);
+
+// Points no other point beats on both bitrate and quality, in increasing bitrate. O(n log n)
+std::vector<RdPoint> pareto_front(std::vector<RdPoint> points);
+
+// For each target bitrate, the hull point of highest quality at or below it. Targets below
+// the cheapest point select nothing, and a point chosen by several targets appears once.
+// hull must be in increasing bitrate, as upper_convex_hull returns it. O(t log n)
+std::vector<RdPoint> select_ladder(const std::vector<RdPoint>& hull, const std::vector<double>& targets);
+
+// count bitrates spaced evenly on a log scale from min_bitrate to max_bitrate
+std::vector<double> log_spaced_bitrates(double min_bitrate, double max_bitrate, int count);
+
+} // namespace rdmeter
@@ -0,0 +1,622 @@
+#include "image_io.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace rdmeter {
+
+namespace {
+
+std::vector<uint8_t> read_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("Failed to open image file: " + path);
+    }
+    std::vector<uint8_t> bytes(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to read image file: " + path);
+    }
+    return bytes;
+}
+
+// Scale a sample in [0, max_value] to [0, 255] with rounding
+inline uint8_t scale_to_8bit(uint32_t value, uint32_t max_value) {
+    if (max_value == 255) {
+        return static_cast<uint8_t>(value);
+    }
+    return static_cast<uint8_t>((std::min(value, max_value) * 255 + max_value / 2) / max_value);
+}
+
+// ---------------------------------------------------------------------------
+// PNM
+
+class PnmTokenizer {
+public:
+    explicit PnmTokenizer(const std::vector<uint8_t>& bytes) : bytes_(bytes) {}
+
+    // Next whitespace-separated header token, skipping '#' comments
+    unsigned long next_number() {
+        skip_space_and_comments();
+        size_t start = pos_;
+        while (pos_ < bytes_.size() && std::isdigit(bytes_[pos_])) {
+            ++pos_;
+        }
+        if (start == pos_) {
+            throw std::runtime_error("Malformed PNM header");
+        }
+        return std::strtoul(std::string(bytes_.begin() + start, bytes_.begin() + pos_).c_str(), nullptr, 10);
+    }
+
+    // Binary raster starts after exactly one whitespace byte following maxval
+    size_t raster_offset() const { return pos_ + 1; }
+
+private:
+    void skip_space_and_comments() {
+        while (pos_ < bytes_.size()) {
+            if (bytes_[pos_] == '#') {
+                while (pos_ < bytes_.size() && bytes_[pos_] != '\n') ++pos_;
+            } else if (std::isspace(bytes_[pos_])) {
+                ++pos_;
+            } else {
+                break;
+            }
+        }
+    }
+
+    const std::vector<uint8_t>& bytes_;
+    size_t pos_ = 2;  // after the magic number
+};
+
+// ---------------------------------------------------------------------------
+// Inflate
+
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    // Ensure at least n (<= 25) bits are buffered; past the end, zero bits are supplied
+    void refill(int n) {
+        while (count_ < n) {
+            uint32_t byte = pos_ < size_ ? data_[pos_] : 0;
+            if (pos_ >= size_) ++overrun_;
+            ++pos_;
+            buffer_ |= byte << count_;
+            count_ += 8;
+        }
+    }
+
+    uint32_t peek(int n) {
+        refill(n);
+        return buffer_ & ((1u << n) - 1);
+    }
+
+    void consume(int n) {
+        buffer_ >>= n;
+        count_ -= n;
+    }
+
+    uint32_t bits(int n) {
+        if (n == 0) return 0;
+        uint32_t value = peek(n);
+        consume(n);
+        return value;
+    }
+
+    // Drop bits up to the next byte boundary (stored blocks)
+    void align() { consume(count_ % 8); }
+
+    // Byte position of the next unread whole byte
+    size_t byte_position() const { return pos_ - count_ / 8; }
+
+    void skip_to(size_t position) {
+        pos_ = position;
+        buffer_ = 0;
+        count_ = 0;
+    }
+
+    // More than a couple of padding bytes means the stream was truncated
+    bool overrun() const { return overrun_ > 4; }
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ = 0;
+    uint32_t buffer_ = 0;
+    int count_ = 0;
+    int overrun_ = 0;
+};
+
+// Canonical Huffman decoder with a direct lookup table for codes up to kFastBits
+class Huffman {
+public:
+    static constexpr int kFastBits = 10;
+
+    void build(const uint8_t* lengths, int count) {
+        std::fill(std::begin(counts_), std::end(counts_), 0);
+        for (int i = 0; i < count; ++i) counts_[lengths[i]]++;
+        counts_[0] = 0;
+
+        // Symbols sorted by (code length, symbol value), as canonical codes are assigned
+        int index[16];
+        int running = 0;
+        for (int len = 1; len < 16; ++len) {
+            index[len] = running;
+            running += counts_[len];
+        }
+        for (int i = 0; i < count; ++i) {
+            if (lengths[i]) symbols_[index[lengths[i]]++] = static_cast<uint16_t>(i);
+        }
+
+        // Fill the fast table with bit-reversed canonical codes
+        std::fill(std::begin(fast_), std::end(fast_), 0);
+        int code = 0;
+        int symbol_index = 0;
+        for (int len = 1; len <= kFastBits; ++len) {
+            for (int k = 0; k < counts_[len]; ++k, ++code, ++symbol_index) {
+                int reversed = 0;
+                for (int b = 0; b < len; ++b) {
+                    if (code & (1 << b)) reversed |= 1 << (len - 1 - b);
+                }
+                for (int fill = reversed; fill < (1 << kFastBits); fill += 1 << len) {
+                    fast_[fill] = static_cast<uint16_t>((symbols_[symbol_index] << 4) | len);
+                }
+            }
+            code <<= 1;
+        }
+    }
+
+    int decode(BitReader& reader) const {
+        uint16_t entry = fast_[reader.peek(kFastBits)];
+        if (entry != 0) {
+            reader.consume(entry & 15);
+            return entry >> 4;
+        }
+
+        // Slow path for long codes: walk the canonical code one bit at a time
+        int code = 0;
+        int first = 0;
+        int index = 0;
+        for (int len = 1; len < 16; ++len) {
+            code |= static_cast<int>(reader.bits(1));
+            int count = counts_[len];
+            if (code - first < count) {
+                return symbols_[index + (code - first)];
+            }
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+        }
+        throw std::runtime_error("Invalid Huffman code in deflate stream");
+    }
+
+private:
+    uint16_t counts_[16] = {};
+    uint16_t symbols_[288] = {};
+    uint16_t fast_[1 << kFastBits] = {};
+};
+
+constexpr uint16_t kLengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                      35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr uint8_t kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                      3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr uint16_t kDistBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+                                    193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                                    6145, 8193, 12289, 16385, 24577};
+constexpr uint8_t kDistExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+void inflate_codes(BitReader& reader, const Huffman& literals, const Huffman& distances, std::vector<uint8_t>& out) {
+    while (true) {
+        int symbol = literals.decode(reader);
+        if (symbol < 256) {
+            out.push_back(static_cast<uint8_t>(symbol));
+        } else if (symbol == 256) {
+            return;
+        } else {
+            symbol -= 257;
+            if (symbol >= 29) {
+                throw std::runtime_error("Invalid length symbol in deflate stream");
+            }
+            size_t length = kLengthBase[symbol] + reader.bits(kLengthExtra[symbol]);
+            int dist_symbol = distances.decode(reader);
+            if (dist_symbol >= 30) {
+                throw std::runtime_error("Invalid distance symbol in deflate stream");
+            }
+            size_t distance = kDistBase[dist_symbol] + reader.bits(kDistExtra[dist_symbol]);
+            if (distance > out.size()) {
+                throw std::runtime_error("Deflate distance too far back");
+            }
+            size_t from = out.size() - distance;
+            for (size_t i = 0; i < length; ++i) {
+                out.push_back(out[from + i]);
+            }
+        }
+        if (reader.overrun()) {
+            throw std::runtime_error("Truncated deflate stream");
+        }
+    }
+}
+
+void inflate_dynamic_tables(BitReader& reader, Huffman& literals, Huffman& distances) {
+    static constexpr uint8_t kOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+    int num_literals = static_cast<int>(reader.bits(5)) + 257;
+    int num_distances = static_cast<int>(reader.bits(5)) + 1;
+    int num_code_lengths = static_cast<int>(reader.bits(4)) + 4;
+    if (num_literals > 286 || num_distances > 30) {
+        throw std::runtime_error("Invalid dynamic Huffman header");
+    }
+
+    uint8_t code_length_lengths[19] = {};
+    for (int i = 0; i < num_code_lengths; ++i) {
+        code_length_lengths[kOrder[i]] = static_cast<uint8_t>(reader.bits(3));
+    }
+    Huffman code_lengths;
+    code_lengths.build(code_length_lengths, 19);
+
+    uint8_t lengths[286 + 30] = {};
+    int index = 0;
+    while (index < num_literals + num_distances) {
+        int symbol = code_lengths.decode(reader);
+        if (symbol < 16) {
+            lengths[index++] = static_cast<uint8_t>(symbol);
+            continue;
+        }
+        uint8_t value = 0;
+        int repeat;
+        if (symbol == 16) {
+            if (index == 0) throw std::runtime_error("Invalid code length repeat");
+            value = lengths[index - 1];
+            repeat = 3 + static_cast<int>(reader.bits(2));
+        } else if (symbol == 17) {
+            repeat = 3 + static_cast<int>(reader.bits(3));
+        } else {
+            repeat = 11 + static_cast<int>(reader.bits(7));
+        }
+        if (index + repeat > num_literals + num_distances) {
+            throw std::runtime_error("Code length repeat overflows table");
+        }
+        while (repeat--) lengths[index++] = value;
+        if (reader.overrun()) {
+            throw std::runtime_error("Truncated deflate stream");
+        }
+    }
+
+    literals.build(lengths, num_literals);
+    distances.build(lengths + num_literals, num_distances);
+}
+
+// ---------------------------------------------------------------------------
+// PNG
+
+uint32_t read_be32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+inline uint8_t paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+    if (pb <= pc) return static_cast<uint8_t>(b);
+    return static_cast<uint8_t>(c);
+}
+
+// Reverse the per-scanline filters in place; raw holds height rows of (1 + stride) bytes
+void unfilter_png(std::vector<uint8_t>& raw, int height, size_t stride, size_t bpp) {
+    std::vector<uint8_t> zero_row(stride, 0);
+    const uint8_t* prev = zero_row.data();
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = raw.data() + y * (stride + 1);
+        uint8_t filter = row[0];
+        uint8_t* cur = row + 1;
+        switch (filter) {
+            case 0:
+                break;
+            case 1:
+                for (size_t i = bpp; i < stride; ++i) cur[i] = static_cast<uint8_t>(cur[i] + cur[i - bpp]);
+                break;
+            case 2:
+                for (size_t i = 0; i < stride; ++i) cur[i] = static_cast<uint8_t>(cur[i] + prev[i]);
+                break;
+            case 3:
+                for (size_t i = 0; i < stride; ++i) {
+                    int left = i >= bpp ? cur[i - bpp] : 0;
+                    cur[i] = static_cast<uint8_t>(cur[i] + ((left + prev[i]) >> 1));
+                }
+                break;
+            case 4:
+                for (size_t i = 0; i < stride; ++i) {
+                    int left = i >= bpp ? cur[i - bpp] : 0;
+                    int up_left = i >= bpp ? prev[i - bpp] : 0;
+                    cur[i] = static_cast<uint8_t>(cur[i] + paeth(left, prev[i], up_left));
+                }
+                break;
+            default:
+                throw std::runtime_error("Invalid PNG filter type");
+        }
+        prev = cur;
+    }
+}
+
+} // namespace
+
+std::vector<uint8_t> inflate_zlib(const uint8_t* data, size_t size, size_t expected_size) {
+    if (size < 6) {
+        throw std::runtime_error("zlib stream too short");
+    }
+    uint8_t cmf = data[0];
+    uint8_t flg = data[1];
+    if ((cmf & 0x0F) != 8 || ((cmf << 8) | flg) % 31 != 0) {
+        throw std::runtime_error("Invalid zlib header");
+    }
+    if (flg & 0x20) {
+        throw std::runtime_error("zlib preset dictionaries are not supported");
+    }
+
+    std::vector<uint8_t> out;
+    out.reserve(expected_size);
+
+    BitReader reader(data + 2, size - 2);
+    bool final_block = false;
+    while (!final_block) {
+        final_block = reader.bits(1) != 0;
+        uint32_t type = reader.bits(2);
+        if (type == 0) {
+            reader.align();
+            size_t pos = reader.byte_position();
+            if (pos + 4 > reader.size()) {
+                throw std::runtime_error("Truncated stored block");
+            }
+            const uint8_t* p = reader.data() + pos;
+            uint16_t len = static_cast<uint16_t>(p[0] | (p[1] << 8));
+            uint16_t nlen = static_cast<uint16_t>(p[2] | (p[3] << 8));
+            if (len != static_cast<uint16_t>(~nlen) || pos + 4 + len > reader.size()) {
+                throw std::runtime_error("Corrupt stored block");
+            }
+            out.insert(out.end(), p + 4, p + 4 + len);
+            reader.skip_to(pos + 4 + len);
+        } else if (type == 1) {
+            static const auto fixed = [] {
+                std::array<Huffman, 2> tables;
+                uint8_t lengths[288];
+                std::fill(lengths, lengths + 144, 8);
+                std::fill(lengths + 144, lengths + 256, 9);
+                std::fill(lengths + 256, lengths + 280, 7);
+                std::fill(lengths + 280, lengths + 288, 8);
+                tables[0].build(lengths, 288);
+                uint8_t dist_lengths[30];
+                std::fill(dist_lengths, dist_lengths + 30, 5);
+                tables[1].build(dist_lengths, 30);
+                return tables;
+            }();
+            inflate_codes(reader, fixed[0], fixed[1], out);
+        } else if (type == 2) {
+            Huffman literals, distances;
+            inflate_dynamic_tables(reader, literals, distances);
+            inflate_codes(reader, literals, distances, out);
+        } else {
+            throw std::runtime_error("Invalid deflate block type");
+        }
+    }
+
+    // Adler-32 trailer
+    reader.align();
+    size_t pos = reader.byte_position();
+    if (pos + 4 <= reader.size()) {
+        uint32_t a = 1, b = 0;
+        for (uint8_t byte : out) {
+            a = (a + byte) % 65521;
+            b = (b + a) % 65521;
+        }
+        if (read_be32(reader.data() + pos) != ((b << 16) | a)) {
+            throw std::runtime_error("zlib checksum mismatch");
+        }
+    }
+    return out;
+}
+
+Image decode_pnm(const std::vector<uint8_t>& bytes) {
+    if (bytes.size() < 2 || bytes[0] != 'P' || (bytes[1] != '2' && bytes[1] != '3' && bytes[1] != '5' && bytes[1] != '6')) {
+        throw std::runtime_error("Unsupported PNM type (expected P2, P3, P5 or P6)");
+    }
+    bool ascii = bytes[1] == '2' || bytes[1] == '3';
+    bool color = bytes[1] == '3' || bytes[1] == '6';
+
+    PnmTokenizer tokens(bytes);
+    Image image;
+    image.width = static_cast<int>(tokens.next_number());
+    image.height = static_cast<int>(tokens.next_number());
+    unsigned long max_value = tokens.next_number();
+    if (image.width <= 0 || image.height <= 0 || max_value == 0 || max_value > 65535) {
+        throw std::runtime_error("Invalid PNM dimensions or maxval");
+    }
+    image.channels = color ? 3 : 1;
+
+    size_t samples = static_cast<size_t>(image.width) * image.height * image.channels;
+    image.pixels.resize(samples);
+    uint32_t max = static_cast<uint32_t>(max_value);
+
+    if (ascii) {
+        for (size_t i = 0; i < samples; ++i) {
+            image.pixels[i] = scale_to_8bit(static_cast<uint32_t>(tokens.next_number()), max);
+        }
+        return image;
+    }
+
+    size_t offset = tokens.raster_offset();
+    size_t bytes_per_sample = max > 255 ? 2 : 1;
+    if (offset + samples * bytes_per_sample > bytes.size()) {
+        throw std::runtime_error("Truncated PNM raster");
+    }
+    const uint8_t* raster = bytes.data() + offset;
+    if (bytes_per_sample == 1) {
+        for (size_t i = 0; i < samples; ++i) image.pixels[i] = scale_to_8bit(raster[i], max);
+    } else {
+        for (size_t i = 0; i < samples; ++i) {
+            image.pixels[i] = scale_to_8bit((uint32_t(raster[2 * i]) << 8) | raster[2 * i + 1], max);
+        }
+    }
+    return image;
+}
+
+Image decode_png(const std::vector<uint8_t>& bytes) {
+    static const uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    if (bytes.size() < 8 || std::memcmp(bytes.data(), kSignature, 8) != 0) {
+        throw std::runtime_error("Not a PNG file");
+    }
+
+    int width = 0, height = 0, bit_depth = 0, color_type = -1, interlace = 0;
+    std::vector<uint8_t> palette;
+    std::vector<uint8_t> compressed;
+
+    size_t pos = 8;
+    while (pos + 8 <= bytes.size()) {
+        uint32_t length = read_be32(&bytes[pos]);
+        const uint8_t* type = &bytes[pos + 4];
+        const uint8_t* chunk = &bytes[pos + 8];
+        if (pos + 12 + static_cast<size_t>(length) > bytes.size()) {
+            throw std::runtime_error("Truncated PNG chunk");
+        }
+        if (std::memcmp(type, "IHDR", 4) == 0) {
+            if (length < 13) throw std::runtime_error("Invalid PNG IHDR");
+            width = static_cast<int>(read_be32(chunk));
+            height = static_cast<int>(read_be32(chunk + 4));
+            bit_depth = chunk[8];
+            color_type = chunk[9];
+            interlace = chunk[12];
+        } else if (std::memcmp(type, "PLTE", 4) == 0) {
+            palette.assign(chunk, chunk + length);
+        } else if (std::memcmp(type, "IDAT", 4) == 0) {
+            compressed.insert(compressed.end(), chunk, chunk + length);
+        } else if (std::memcmp(type, "IEND", 4) == 0) {
+            break;
+        }
+        pos += 12 + length;
+    }
+
+    if (width <= 0 || height <= 0) {
+        throw std::runtime_error("PNG is missing IHDR");
+    }
+    if (interlace != 0) {
+        throw std::runtime_error("Interlaced PNG is not supported");
+    }
+
+    int samples_per_pixel;
+    switch (color_type) {
+        case 0: samples_per_pixel = 1; break;  // gray
+        case 2: samples_per_pixel = 3; break;  // RGB
+        case 3: samples_per_pixel = 1; break;  // palette
+        case 4: samples_per_pixel = 2; break;  // gray + alpha
+        case 6: samples_per_pixel = 4; break;  // RGBA
+        default: throw std::runtime_error("Invalid PNG colour type");
+    }
+    bool valid_depth = (color_type == 0 && (bit_depth == 1 || bit_depth == 2 || bit_depth == 4 || bit_depth == 8 || bit_depth == 16)) ||
+                       (color_type == 3 && (bit_depth == 1 || bit_depth == 2 || bit_depth == 4 || bit_depth == 8)) ||
+                       ((color_type == 2 || color_type == 4 || color_type == 6) && (bit_depth == 8 || bit_depth == 16));
+    if (!valid_depth) {
+        throw std::runtime_error("Invalid PNG bit depth");
+    }
+    if (color_type == 3 && palette.empty()) {
+        throw std::runtime_error("Palette PNG is missing PLTE");
+    }
+
+    size_t stride = (static_cast<size_t>(width) * samples_per_pixel * bit_depth + 7) / 8;
+    size_t bpp = std::max<size_t>(1, static_cast<size_t>(samples_per_pixel) * bit_depth / 8);
+    size_t raw_size = (stride + 1) * height;
+
+    auto raw = inflate_zlib(compressed.data(), compressed.size(), raw_size);
+    if (raw.size() < raw_size) {
+        throw std::runtime_error("PNG image data is truncated");
+    }
+    unfilter_png(raw, height, stride, bpp);
+
+    Image image;
+    image.width = width;
+    image.height = height;
+    image.channels = (color_type == 2 || color_type == 3 || color_type == 6) ? 3 : 1;
+    image.pixels.resize(static_cast<size_t>(width) * height * image.channels);
+
+    uint32_t max_value = (1u << bit_depth) - 1;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* row = raw.data() + y * (stride + 1) + 1;
+        uint8_t* out = image.pixels.data() + static_cast<size_t>(y) * width * image.channels;
+        for (int x = 0; x < width; ++x) {
+            // Fetch sample s of pixel x at any bit depth
+            auto sample = [&](int s) -> uint32_t {
+                size_t index = static_cast<size_t>(x) * samples_per_pixel + s;
+                if (bit_depth == 8) return row[index];
+                if (bit_depth == 16) return (uint32_t(row[2 * index]) << 8) | row[2 * index + 1];
+                size_t bit = index * bit_depth;
+                return (row[bit / 8] >> (8 - bit_depth - bit % 8)) & max_value;
+            };
+
+            if (color_type == 3) {
+                uint32_t entry = sample(0);
+                if (3 * entry + 2 >= palette.size()) {
+                    throw std::runtime_error("PNG palette index out of range");
+                }
+                out[3 * x] = palette[3 * entry];
+                out[3 * x + 1] = palette[3 * entry + 1];
+                out[3 * x + 2] = palette[3 * entry + 2];
+            } else {
+                for (int c = 0; c < image.channels; ++c) {
+                    out[image.channels * x + c] = scale_to_8bit(sample(c), max_value);
+                }
+            }
+        }
+    }
+    return image;
+}
+
+Image read_image(const std::string& path) {
+    auto bytes = read_file(path);
+    try {
+        if (bytes.size() >= 8 && bytes[0] == 0x89 && bytes[1] == 'P' && bytes[2] == 'N' && bytes[3] == 'G') {
+            return decode_png(bytes);
+        }
+        if (bytes.size() >= 2 && bytes[0] == 'P') {
+            return decode_pnm(bytes);
+        }
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error(path + ": " + e.what());
+    }
+    throw std::runtime_error("Unrecognised image format: " + path);
+}
+
+std::vector<uint8_t> image_luma(const Image& image) {
+    size_t pixels = static_cast<size_t>(image.width) * image.height;
+    if (image.channels == 1) {
+        return image.pixels;
+    }
+
+    // Y = 0.299 R + 0.587 G + 0.114 B in 16-bit fixed point, rounded
+    std::vector<uint8_t> luma(pixels);
+    for (size_t i = 0; i < pixels; ++i) {
+        const uint8_t* p = &image.pixels[3 * i];
+        luma[i] = static_cast<uint8_t>((19595 * p[0] + 38470 * p[1] + 7471 * p[2] + 32768) >> 16);
+    }
+    return luma;
+}
+
+bool is_image_file(const std::string& path) {
+    std::string ext = fs::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext == ".pgm" || ext == ".ppm" || ext == ".pnm" || ext == ".png";
+}
+
+} // namespace rdmeter
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rdmeter {
+
+// Decoded still image with interleaved 8-bit samples
+// channels is 1 (gray) or 3 (RGB); alpha is dropped and 16-bit samples are rounded to 8 bits
+struct Image {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::vector<uint8_t> pixels;
+};
+
+// Read a PGM/PPM (P2, P3, P5, P6) or PNG file, detected from its leading bytes
+// Throws std::runtime_error on I/O errors or unsupported/corrupt data
+Image read_image(const std::string& path);
+
+// Decode binary or ASCII PGM/PPM data
+Image decode_pnm(const std::vector<uint8_t>& bytes);
+
+// Decode non-interlaced PNG data of any colour type and bit depth
+Image decode_png(const std::vector<uint8_t>& bytes);
+
+// Decompress a zlib stream (RFC 1950/1951). expected_size is only a capacity hint
+std::vector<uint8_t> inflate_zlib(const uint8_t* data, size_t size, size_t expected_size = 0);
+
+// Luma plane of an image: gray images are copied, RGB uses full-range BT.601 weights
+std::vector<uint8_t> image_luma(const Image& image);
+
+// True if the file name has an extension read_image understands
+bool is_image_file(const std::string& path);
+
+} // namespace rdmeter
@@ -3,6 +3,21 @@
 #include "yuv_reader.hpp"
 #include "metrics.hpp"
 #include "threading.hpp"
+#include "memory_budget.hpp"
+#include "checkpoint.hpp"
+#include "follow.hpp"
+#include "shm_ring.hpp"
+#include "sampling.hpp"
+#include "image_io.hpp"
+#include "frame_metrics.hpp"
+#include "ssimulacra2.hpp"
+#include "bitstream.hpp"
+#include "csv.hpp"
+#include "hull.hpp"
+#include "bdrate.hpp"
+#include "sweep.hpp"
+#include "results_cache.hpp"
+#include "synthetic.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -12,50 +27,399 @@
 #include <stdexcept>
 #include <chrono>
 #include <algorithm>
+#include <memory>
+#include <map>
+#include <set>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <iterator>
 
 namespace fs = std::filesystem;
 
+namespace {
+
+// A field as read_csv expects it: quoted when it holds a separator, quote or line break
+std::string csv_field(const std::string& field) {
+    if (field.find_first_of(",\"\r\n") == std::string::npos) {
+        return field;
+    }
+    std::string quoted = "\"";
+    for (char c : field) {
+        quoted += c;
+        if (c == '"') {
+            quoted += '"';
+        }
+    }
+    return quoted + "\"";
+}
+
+// Expand comma-separated metrics ("psnr,msssim" or repeated -m options) into a flat list
+std::vector<std::string> expand_metrics(const std::vector<std::string>& metrics) {
+    std::vector<std::string> expanded_metrics;
+    for (const auto& metric : metrics) {
+        if (metric.find(',') != std::string::npos) {
+            // Split by comma
+            size_t start = 0;
+            size_t end = metric.find(',');
+            while (end != std::string::npos) {
+                expanded_metrics.push_back(metric.substr(start, end - start));
+                start = end + 1;
+                end = metric.find(',', start);
+            }
+            expanded_metrics.push_back(metric.substr(start));
+        } else {
+            expanded_metrics.push_back(metric);
+        }
+    }
+    return expanded_metrics;
+}
+
+bool has_metric(const std::vector<std::string>& metrics, const std::string& name) {
+    return std::find(metrics.begin(), metrics.end(), name) != metrics.end();
+}
+
+// Open an RD CSV for appending rows, writing the header to a new or empty file. An existing
+// file must have exactly this header, so rows from different runs stay in their columns
+std::ofstream open_rd_csv(const std::string& path, const std::string& header) {
+    bool fresh = !fs::exists(path) || fs::file_size(path) == 0;
+    if (!fresh) {
+        std::ifstream existing(path);
+        std::string existing_header;
+        std::getline(existing, existing_header);
+        if (existing_header != header) {
+            throw std::runtime_error("RD CSV " + path + " has columns " + existing_header + ", not " + header);
+        }
+    }
+    fs::path csv_path(path);
+    if (csv_path.has_parent_path()) {
+        fs::create_directories(csv_path.parent_path());
+    }
+    std::ofstream stream(path, std::ios::app);
+    if (!stream) {
+        throw std::runtime_error("Failed to open RD CSV file: " + path);
+    }
+    if (fresh) {
+        stream << header << '\n';
+    }
+    stream.precision(17);
+    return stream;
+}
+
+// Write a results JSON file, creating its directory
+void write_results_json(const std::string& path, const nlohmann::json& results) {
+    fs::path output_path(path);
+    if (output_path.has_parent_path()) {
+        fs::create_directories(output_path.parent_path());
+    }
+    std::ofstream out_stream(path);
+    if (!out_stream) {
+        throw std::runtime_error("Failed to open output file: " + path);
+    }
+    out_stream << results.dump(4);
+}
+
+// Append compute's RD row for one encode, named after its bitstream. A per-frame file
+// adds a column pointing at it, so bdrate --bootstrap frames can resample this encode
+void append_rd_row(const std::string& rd_csv, const std::vector<rdmeter::FrameMetric>& metrics,
+                   const std::string& bitstream_file, double bitrate_kbps, const std::vector<double>& averages,
+                   const std::string& per_frame_file) {
+    std::string header = "name,bitrate_kbps";
+    for (const auto& metric : metrics) {
+        header += "," + metric.key;
+    }
+    const bool per_frame_column = !per_frame_file.empty() && per_frame_file != "-";
+    if (per_frame_column) {
+        header += ",per_frame";
+    }
+    auto rd_stream = open_rd_csv(rd_csv, header);
+    rd_stream << fs::path(bitstream_file).stem().string() << ',' << bitrate_kbps;
+    for (double average : averages) {
+        rd_stream << ',' << average;
+    }
+    if (per_frame_column) {
+        // Relative to the CSV, so a sweep directory can be moved as a whole
+        fs::path rd_dir = fs::absolute(rd_csv).parent_path();
+        rd_stream << ',' << fs::proximate(fs::absolute(per_frame_file), rd_dir).generic_string();
+    }
+    rd_stream << '\n';
+}
+
+// Bootstrap settings and intervals of a BD summary, as bdrate and sweep report them
+nlohmann::json bootstrap_json(const std::string& mode, const rdmeter::BootstrapOptions& options,
+                              const rdmeter::BdSummary& summary) {
+    auto interval_json = [](const rdmeter::BootstrapInterval& interval) {
+        return nlohmann::json{{"low", interval.low}, {"high", interval.high}, {"std_dev", interval.std_dev}};
+    };
+    return {
+        {"mode", mode},
+        {"samples", options.samples},
+        {"replicates", summary.replicates},
+        {"confidence", options.confidence},
+        {"seed", options.seed},
+        {"bd_rate", interval_json(summary.bd_rate_interval)},
+        {"bd_quality", interval_json(summary.bd_quality_interval)}
+    };
+}
+
+} // namespace
+
 int main(int argc, char** argv) {
     CLI::App app{"rdmeter: High-performance video codec analysis tool for computing RD metrics"};
 
     bool verbose = false;
     app.add_flag("-v,--verbose", verbose, "Enable verbose output");
+    app.set_version_flag("--version", RDMETER_VERSION);
 
     auto compute_cmd = app.add_subcommand("compute", "Compute RD metrics between reference and distorted videos");
     std::string ref_file;
     std::string dist_file;
+    std::string dist_shm;  // shared-memory ring name, instead of dist_file
     std::string output_file = "results/results.json";
     int width = 0;
     int height = 0;
     int max_frames = -1;  // all frames
     std::vector<std::string> metrics = {"psnr"};  // default to PSNR only
+    std::string max_memory;  // empty for no budget
+    int threads = 0;  // 0 for all hardware threads
+    std::string checkpoint_file;  // empty to disable checkpointing
+    int checkpoint_interval = 60;  // seconds between checkpoints
+    bool resume = false;
+    std::string per_frame_file;  // empty for no per-frame output, "-" for stdout
+    bool follow = false;
+    double follow_timeout = 10.0;  // seconds without a new frame before giving up
+    int band_rows = 0;  // rows per band when streaming followed input, 0 for whole frames
+    bool sample = false;
+    double sample_tolerance = 0.002;  // relative CI half-width at which sampling stops
+    double sample_confidence = 0.95;
+    uint64_t sample_seed = 1;
+    double sample_windows = 1.0;  // fraction of MS-SSIM windows scored per frame
+    std::string pix_fmt = "yuv420p";
+    std::string ref_pix_fmt;   // empty to use pix_fmt
+    std::string dist_pix_fmt;  // empty to use pix_fmt
+    std::string color_matrix = "bt709";
+    std::string color_range = "limited";
+    std::string transfer = "pq";
+    int block_size = 8;
+    std::string bitstream_file;  // compressed stream the distorted frames were decoded from
+    std::string bitstream_format;  // empty to detect from the file
+    double fps = 0.0;  // 0 for the frame rate carried by the bitstream
+    std::string rd_csv;  // empty for no RD row
+    std::string cache_dir;  // empty for no results cache
+    bool cache_trust_mtime = false;
 
-    compute_cmd->add_option("-r,--ref", ref_file, "Path to reference YUV file")->required();
-    compute_cmd->add_option("-d,--dist", dist_file, "Path to distorted YUV file")->required();
+    compute_cmd->add_option("-r,--ref", ref_file, "Path to reference YUV file (may be omitted when only no-reference metrics are requested)");
+    auto dist_opt = compute_cmd->add_option("-d,--dist", dist_file, "Path to distorted YUV file");
     compute_cmd->add_option("-o,--output", output_file, "Output JSON file path");
     compute_cmd->add_option("--width", width, "Video width in pixels")->required();
     compute_cmd->add_option("--height", height, "Video height in pixels")->required();
     compute_cmd->add_option("-f,--frames", max_frames, "Maximum number of frames to process (-1 for all)");
-    compute_cmd->add_option("-m,--metrics", metrics, "Metrics to compute (psnr, msssim)")->expected(-1);
+    compute_cmd->add_option("-m,--metrics", metrics, "Metrics to compute (psnr, ssim, msssim, psnr_hvs, psnr_hvs_m, ciede2000, wpsnr, psnr_linear, psnr_pq, ssim_pq, blockiness, blur, banding)")->expected(-1);
+    compute_cmd->add_option("--max-memory", max_memory, "Memory budget for frame ring and scratch buffers (e.g. 512M, 4G)");
+    compute_cmd->add_option("-j,--threads", threads, "Maximum worker threads (0 for all hardware threads)");
+    compute_cmd->add_option("--checkpoint", checkpoint_file, "Periodically save progress to this file so the run can be resumed");
+    compute_cmd->add_option("--checkpoint-interval", checkpoint_interval, "Seconds between checkpoints");
+    auto resume_flag = compute_cmd->add_flag("--resume", resume, "Continue from the --checkpoint file instead of frame 0")->needs("--checkpoint");
+    compute_cmd->add_option("--per-frame", per_frame_file, "Write one JSON line per frame to this file (- for stdout)");
+    compute_cmd->add_flag("--follow", follow, "Score files that are still being written, waiting for new frames")->excludes(resume_flag);
+    compute_cmd->add_option("--follow-timeout", follow_timeout, "Seconds to wait for a new frame in --follow or --dist-shm mode before finishing");
+    compute_cmd->add_option("--band-rows", band_rows, "In --follow mode, score luma in bands of this many rows as they arrive (0 waits for whole frames)")
+        ->needs("--follow");
+    compute_cmd->add_flag("--sample", sample, "Estimate metrics from a stratified random subset of frames")
+        ->excludes("--follow")->excludes("--checkpoint");
+    compute_cmd->add_option("--sample-tolerance", sample_tolerance, "Stop sampling once every confidence interval half-width is below this fraction of its mean");
+    compute_cmd->add_option("--sample-confidence", sample_confidence, "Confidence level of the reported intervals");
+    compute_cmd->add_option("--sample-seed", sample_seed, "Seed for frame and window selection");
+    compute_cmd->add_option("--pix-fmt", pix_fmt, "Input pixel format of both files (yuv420p, yuv420p10le, yuv420p12le, rgb24, rgb48le)");
+    compute_cmd->add_option("--ref-pix-fmt", ref_pix_fmt, "Pixel format of the reference file, overriding --pix-fmt");
+    compute_cmd->add_option("--dist-pix-fmt", dist_pix_fmt, "Pixel format of the distorted file, overriding --pix-fmt");
+    compute_cmd->add_option("--color-matrix", color_matrix, "YCbCr matrix of RGB input conversion and of colour metrics (bt601, bt709, bt2020)");
+    compute_cmd->add_option("--color-range", color_range, "YCbCr range of RGB input conversion and of colour metrics (limited, full)");
+    compute_cmd->add_option("--transfer", transfer, "Transfer function of high bit depth input for HDR metrics (pq, hlg)");
+    compute_cmd->add_option("--sample-windows", sample_windows, "Fraction of 8x8 MS-SSIM windows scored within each frame (0-1], with or without --sample");
+    compute_cmd->add_option("--block-size", block_size, "Block grid of the blockiness detector (8 for DCT blocks, 64 for CTUs)");
+    compute_cmd->add_option("--dist-shm", dist_shm, "Read distorted frames from the POSIX shared-memory frame ring of this name instead of -d")
+        ->excludes(dist_opt)->excludes("--follow")->excludes("--sample")->excludes("--checkpoint");
+    compute_cmd->add_option("--bitstream", bitstream_file, "Compressed stream of the distorted video (Annex-B H.264/HEVC, IVF or AV1 OBU) for bitrate and per-picture-type results")
+        ->excludes("--follow")->excludes(resume_flag);
+    compute_cmd->add_option("--bitstream-format", bitstream_format, "Format of --bitstream (h264, hevc, ivf, obu); detected from the file by default")
+        ->needs("--bitstream");
+    compute_cmd->add_option("--fps", fps, "Frame rate for the bitrate (0 to use the rate stored in IVF files)")->needs("--bitstream");
+    compute_cmd->add_option("--rd-csv", rd_csv, "Append a bitrate/metrics row for BD-rate to this CSV file")->needs("--bitstream");
+    compute_cmd->add_option("--cache-dir", cache_dir, "Reuse the results of identical earlier runs kept in this directory")
+        ->envname("RDMETER_CACHE_DIR");
+    compute_cmd->add_flag("--cache-trust-mtime", cache_trust_mtime, "Identify cached inputs by path, size and modification time instead of hashing them");
 
-    auto bdrate_cmd = app.add_subcommand("bdrate", "Calculate BD-Rate from two CSV files");
+    auto images_cmd = app.add_subcommand("images", "Compute metrics for pairs of still images (PGM/PPM/PNG) in two directories");
+    std::string ref_dir;
+    std::string dist_dir;
+    std::string images_output = "results/images.json";
+    std::vector<std::string> image_metrics = {"psnr"};
+    int image_threads = 0;
+
+    images_cmd->add_option("--ref-dir", ref_dir, "Directory of reference images")->required();
+    images_cmd->add_option("--dist-dir", dist_dir, "Directory of distorted images, paired with references by file stem")->required();
+    images_cmd->add_option("-o,--output", images_output, "Output file (.json, or .csv for one row per image)");
+    images_cmd->add_option("-m,--metrics", image_metrics, "Metrics to compute (psnr, msssim, ssimulacra2)")->expected(-1);
+    images_cmd->add_option("-j,--threads", image_threads, "Worker threads (0 for all hardware threads)");
+
+    auto hull_cmd = app.add_subcommand("hull", "Compute the RD convex hull of a sweep of encodes and pick ladder rungs from it");
+    std::vector<std::string> hull_inputs;
+    std::vector<std::string> hull_metrics;
+    std::string hull_output = "results/hull.json";
+    std::string bitrate_column = "bitrate_kbps";
+    std::string group_column;  // empty for one hull over all rows
+    bool log_bitrate = false;
+    std::vector<double> ladder_targets;
+    int ladder_rungs = 0;
+    double ladder_min_bitrate = 0.0;  // 0 for the cheapest hull point
+    double ladder_max_bitrate = 0.0;  // 0 for the best hull point
+    int hull_threads = 0;
+
+    hull_cmd->add_option("-i,--input", hull_inputs, "CSV files of RD points with matching columns, e.g. from compute --rd-csv")->required()->expected(-1);
+    hull_cmd->add_option("-m,--metrics", hull_metrics, "Quality columns to build hulls for (e.g. psnr_y,msssim_y)")->required()->expected(-1);
+    hull_cmd->add_option("-o,--output", hull_output, "Output JSON file path");
+    hull_cmd->add_option("--bitrate-column", bitrate_column, "Column holding the bitrate");
+    hull_cmd->add_option("--group-by", group_column, "Build a separate hull for each value of this column (e.g. the title)");
+    hull_cmd->add_flag("--log-bitrate", log_bitrate, "Judge convexity against log bitrate instead of bitrate");
+    auto targets_opt = hull_cmd->add_option("--targets", ladder_targets, "Ladder bitrate caps; each selects the best hull point at or below it")->expected(-1)->delimiter(',');
+    hull_cmd->add_option("--rungs", ladder_rungs, "Number of ladder rungs with log-spaced bitrate caps")->excludes(targets_opt);
+    hull_cmd->add_option("--min-bitrate", ladder_min_bitrate, "Lowest rung cap for --rungs")->needs("--rungs");
+    hull_cmd->add_option("--max-bitrate", ladder_max_bitrate, "Highest rung cap for --rungs")->needs("--rungs");
+    hull_cmd->add_option("-j,--threads", hull_threads, "Worker threads (0 for all hardware threads)");
+
+    auto bdrate_cmd = app.add_subcommand("bdrate", "Calculate BD-Rate from two CSV files, or for every config of a sweep against an anchor");
     std::string ref_csv;
     std::string test_csv;
     std::string bdrate_output = "results/bdrate_results.json";
 
-    bdrate_cmd->add_option("--ref-csv", ref_csv, "Path to reference CSV file")->required();
-    bdrate_cmd->add_option("--test-csv", test_csv, "Path to test CSV file")->required();
+    std::vector<std::string> bdrate_metrics = {"psnr_y"};
+    std::string bdrate_bitrate_column = "bitrate_kbps";
+    std::string sequence_column;  // empty for "sequence" when present, else one sequence
+    std::string interpolation_name = "pchip";
+    std::string bootstrap_name = "none";
+    rdmeter::BootstrapOptions bootstrap;
+    int bdrate_threads = 0;
+
+    std::string matrix_csv;  // empty to compare --ref-csv against --test-csv
+    std::string anchor;
+    std::string config_column = "config";
+    std::string summary_csv;
+
+    auto ref_csv_opt = bdrate_cmd->add_option("--ref-csv", ref_csv, "Path to reference CSV file");
+    auto test_csv_opt = bdrate_cmd->add_option("--test-csv", test_csv, "Path to test CSV file");
     bdrate_cmd->add_option("-o,--output", bdrate_output, "Output JSON file path");
+    bdrate_cmd->add_option("-m,--metrics", bdrate_metrics, "Quality columns to compare (e.g. psnr_y,msssim_y)")->expected(-1);
+    bdrate_cmd->add_option("--bitrate-column", bdrate_bitrate_column, "Column holding the bitrate");
+    bdrate_cmd->add_option("--sequence-column", sequence_column, "Column naming the sequence of each row (default: sequence, if present)");
+    bdrate_cmd->add_option("--interpolation", interpolation_name, "RD curve interpolation (pchip, cubic)");
+    bdrate_cmd->add_option("--bootstrap", bootstrap_name, "Bootstrap confidence intervals by resampling (none, sequences, frames, both)");
+    bdrate_cmd->add_option("--bootstrap-samples", bootstrap.samples, "Bootstrap replicates");
+    bdrate_cmd->add_option("--confidence", bootstrap.confidence, "Two-sided confidence of the bootstrap intervals");
+    bdrate_cmd->add_option("--seed", bootstrap.seed, "Seed of the bootstrap resampling");
+    bdrate_cmd->add_option("-j,--threads", bdrate_threads, "Worker threads (0 for all hardware threads)");
+    auto matrix_opt = bdrate_cmd->add_option("--matrix", matrix_csv, "Long-format CSV of every config's RD points; compares each config against --anchor")
+        ->excludes(ref_csv_opt)->excludes(test_csv_opt)->excludes("--bootstrap");
+    bdrate_cmd->add_option("--anchor", anchor, "Config the others are compared against in --matrix mode")->needs(matrix_opt);
+    bdrate_cmd->add_option("--config-column", config_column, "Column naming the config of each row in --matrix mode")->needs(matrix_opt);
+    bdrate_cmd->add_option("--summary-csv", summary_csv, "Write one row of average deltas per config to this CSV file")->needs(matrix_opt);
+
+    auto sweep_cmd = app.add_subcommand("sweep", "Score the encodes of an anchor and a test codec against one reference, then compare them by BD-rate");
+    std::string sweep_ref;
+    std::vector<std::string> anchor_encodes, test_encodes;
+    std::vector<std::string> anchor_bitstreams, test_bitstreams;
+    std::vector<double> anchor_kbps, test_kbps;
+    std::string anchor_name = "anchor";
+    std::string test_name = "test";
+    std::string sweep_sequence;  // empty for the reference's file stem
+    std::string sweep_output = "results/sweep.json";
+    std::string sweep_rd_csv;
+    std::vector<std::string> sweep_metrics = {"psnr"};
+    int sweep_width = 0;
+    int sweep_height = 0;
+    int sweep_frames = -1;
+    double sweep_fps = 0.0;
+    std::string sweep_pix_fmt = "yuv420p";
+    std::string sweep_ref_pix_fmt;
+    std::string sweep_color_matrix = "bt709";
+    std::string sweep_color_range = "limited";
+    std::string sweep_transfer = "pq";
+    std::string sweep_max_memory;
+    int sweep_threads = 0;
+    std::string sweep_interpolation = "pchip";
+    std::string sweep_bootstrap = "none";
+    rdmeter::BootstrapOptions sweep_bootstrap_options;
+
+    sweep_cmd->add_option("-r,--ref", sweep_ref, "Path to the reference video")->required();
+    sweep_cmd->add_option("--anchor", anchor_encodes, "Decoded anchor encodes, one per rate point")->required()->expected(-1);
+    sweep_cmd->add_option("--test", test_encodes, "Decoded test encodes, one per rate point")->required()->expected(-1);
+    auto anchor_bitstreams_opt = sweep_cmd->add_option("--anchor-bitstreams", anchor_bitstreams, "Compressed streams of the anchor encodes, in the same order")->expected(-1);
+    auto test_bitstreams_opt = sweep_cmd->add_option("--test-bitstreams", test_bitstreams, "Compressed streams of the test encodes, in the same order")->expected(-1);
+    sweep_cmd->add_option("--anchor-kbps", anchor_kbps, "Bitrates of the anchor encodes, instead of --anchor-bitstreams")->expected(-1)->delimiter(',')->excludes(anchor_bitstreams_opt);
+    sweep_cmd->add_option("--test-kbps", test_kbps, "Bitrates of the test encodes, instead of --test-bitstreams")->expected(-1)->delimiter(',')->excludes(test_bitstreams_opt);
+    sweep_cmd->add_option("--anchor-name", anchor_name, "Config name of the anchor in the report and --rd-csv");
+    sweep_cmd->add_option("--test-name", test_name, "Config name of the test in the report and --rd-csv");
+    sweep_cmd->add_option("--sequence", sweep_sequence, "Sequence name in the report and --rd-csv (default: the reference's file stem)");
+    sweep_cmd->add_option("-o,--output", sweep_output, "Output JSON file path");
+    sweep_cmd->add_option("--rd-csv", sweep_rd_csv, "Append every encode's RD point to this long-format CSV (input of bdrate --matrix)");
+    sweep_cmd->add_option("-m,--metrics", sweep_metrics, "Metrics to compute (as for compute)")->expected(-1);
+    sweep_cmd->add_option("--width", sweep_width, "Video width in pixels")->required();
+    sweep_cmd->add_option("--height", sweep_height, "Video height in pixels")->required();
+    sweep_cmd->add_option("-f,--frames", sweep_frames, "Maximum number of frames to score (-1 for all)");
+    sweep_cmd->add_option("--fps", sweep_fps, "Frame rate for bitrates (0 to use the rate stored in IVF files)");
+    sweep_cmd->add_option("--pix-fmt", sweep_pix_fmt, "Pixel format of the encodes (and of the reference unless --ref-pix-fmt)");
+    sweep_cmd->add_option("--ref-pix-fmt", sweep_ref_pix_fmt, "Pixel format of the reference, overriding --pix-fmt");
+    sweep_cmd->add_option("--color-matrix", sweep_color_matrix, "YCbCr matrix of RGB input conversion and of colour metrics (bt601, bt709, bt2020)");
+    sweep_cmd->add_option("--color-range", sweep_color_range, "YCbCr range of RGB input conversion and of colour metrics (limited, full)");
+    sweep_cmd->add_option("--transfer", sweep_transfer, "Transfer function of high bit depth input for HDR metrics (pq, hlg)");
+    sweep_cmd->add_option("--max-memory", sweep_max_memory, "Memory budget for frame batches and scratch buffers (e.g. 512M, 4G)");
+    sweep_cmd->add_option("-j,--threads", sweep_threads, "Maximum worker threads (0 for all hardware threads)");
+    sweep_cmd->add_option("--interpolation", sweep_interpolation, "RD curve interpolation (pchip, cubic)");
+    sweep_cmd->add_option("--bootstrap", sweep_bootstrap, "Bootstrap confidence intervals by resampling frames (none, frames)");
+    sweep_cmd->add_option("--bootstrap-samples", sweep_bootstrap_options.samples, "Bootstrap replicates");
+    sweep_cmd->add_option("--confidence", sweep_bootstrap_options.confidence, "Two-sided confidence of the bootstrap intervals");
+    sweep_cmd->add_option("--seed", sweep_bootstrap_options.seed, "Seed of the bootstrap resampling");
+
+    auto gen_cmd = app.add_subcommand("gen", "Generate a synthetic reference and distorted sequence for benchmarks and tests");
+    std::string gen_ref;
+    std::string gen_dist;
+    int gen_width = 0;
+    int gen_height = 0;
+    int gen_frames = 30;
+    std::string gen_pix_fmt = "yuv420p";
+    rdmeter::SynthDistortion gen_distortion;
+    uint64_t gen_seed = 1;
+    int gen_threads = 0;
+    gen_cmd->add_option("-r,--ref", gen_ref, "Write the reference sequence to this file");
+    gen_cmd->add_option("-d,--dist", gen_dist, "Write the distorted sequence to this file");
+    gen_cmd->add_option("--width", gen_width, "Video width in pixels")->required();
+    gen_cmd->add_option("--height", gen_height, "Video height in pixels")->required();
+    gen_cmd->add_option("-f,--frames", gen_frames, "Number of frames");
+    gen_cmd->add_option("--pix-fmt", gen_pix_fmt, "Pixel format of both files (yuv420p, yuv420p10le, yuv420p12le, rgb24, rgb48le)");
+    gen_cmd->add_option("--noise", gen_distortion.noise, "Standard deviation of noise added to the distorted sequence, in 8-bit code values");
+    gen_cmd->add_option("--blur", gen_distortion.blur_radius, "Box blur radius of the distorted sequence in pixels");
+    gen_cmd->add_option("--blockiness", gen_distortion.blockiness, "Largest DC offset of each block of the distorted sequence, in 8-bit code values");
+    gen_cmd->add_option("--block-size", gen_distortion.block_size, "Block grid of --blockiness");
+    gen_cmd->add_option("--drop-rate", gen_distortion.drop_rate, "Fraction of distorted frames replaced by a repeat of the frame before");
+    gen_cmd->add_option("--seed", gen_seed, "Seed of the content and the distortions");
+    gen_cmd->add_option("-j,--threads", gen_threads, "Maximum worker threads (0 for all hardware threads)");
 
     CLI11_PARSE(app, argc, argv);
 
     try {
         if (*compute_cmd) {
             // Validate
-            if (!fs::exists(ref_file)) {
+            // Without a reference only no-reference metrics can run; dist then stands in for ref
+            const bool has_ref = !ref_file.empty();
+            if (has_ref && !fs::exists(ref_file)) {
                 throw std::runtime_error("Reference file does not exist: " + ref_file);
             }
-            if (!fs::exists(dist_file)) {
+            const bool dist_from_shm = !dist_shm.empty();
+            if (!dist_from_shm && dist_file.empty()) {
+                throw std::runtime_error("Either -d or --dist-shm is required");
+            }
+            if (!dist_from_shm && !fs::exists(dist_file)) {
                 throw std::runtime_error("Distorted file does not exist: " + dist_file);
             }
             if (width <= 0 || height <= 0) {
@@ -63,102 +427,656 @@ int main(int argc, char** argv) {
             }
 
             // Open files
-            std::ifstream ref_stream(ref_file, std::ios::binary);
-            std::ifstream dist_stream(dist_file, std::ios::binary);
-            if (!ref_stream) {
+            std::ifstream ref_stream;
+            if (has_ref) {
+                ref_stream.open(ref_file, std::ios::binary);
+            }
+            std::ifstream dist_stream;
+            if (!dist_from_shm) {
+                dist_stream.open(dist_file, std::ios::binary);
+            }
+            if (has_ref && !ref_stream) {
                 throw std::runtime_error("Failed to open reference file: " + ref_file);
             }
-            if (!dist_stream) {
+            if (!dist_from_shm && !dist_stream) {
                 throw std::runtime_error("Failed to open distorted file: " + dist_file);
             }
 
+            // RGB inputs are converted to YCbCr row by row as they are read
+            auto ref_format = rdmeter::parse_pixel_format(ref_pix_fmt.empty() ? pix_fmt : ref_pix_fmt);
+            auto dist_format = rdmeter::parse_pixel_format(dist_pix_fmt.empty() ? pix_fmt : dist_pix_fmt);
+            auto matrix = rdmeter::parse_color_matrix(color_matrix);
+            auto range = rdmeter::parse_color_range(color_range);
+            // A co-located decoder can instead publish distorted frames through shared memory;
+            // the ring's header gives their bit depth
+            auto shm_timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::duration<double>(follow_timeout));
+            std::unique_ptr<rdmeter::FrameReader> dist_reader;
+            std::unique_ptr<rdmeter::ShmFrameRing> dist_ring_source;
+            if (dist_from_shm) {
+                dist_ring_source = rdmeter::ShmFrameRing::open(dist_shm, shm_timeout);
+                if (dist_ring_source->width() != width || dist_ring_source->height() != height) {
+                    throw std::runtime_error("Shared-memory ring " + dist_shm + " holds " +
+                                             std::to_string(dist_ring_source->width()) + "x" +
+                                             std::to_string(dist_ring_source->height()) + " frames");
+                }
+            } else {
+                dist_reader = std::make_unique<rdmeter::FrameReader>(dist_stream, width, height, dist_format, matrix, range);
+            }
+            int bit_depth = dist_reader ? dist_reader->bit_depth() : dist_ring_source->bit_depth();
+            std::unique_ptr<rdmeter::FrameReader> ref_reader;
+            if (has_ref) {
+                ref_reader = std::make_unique<rdmeter::FrameReader>(ref_stream, width, height, ref_format, matrix, range);
+                if (ref_reader->bit_depth() != bit_depth) {
+                    throw std::runtime_error("Reference and distorted inputs must have the same bit depth");
+                }
+            }
+
             // for printing processing time
             auto start_time = std::chrono::high_resolution_clock::now();
 
-            // Read the frames
-            std::vector<rdmeter::YUVFrame> ref_frames;
-            std::vector<rdmeter::YUVFrame> dist_frames;
+            // Determine which metrics to compute
+            if (!(sample_windows > 0.0 && sample_windows <= 1.0)) {
+                throw std::runtime_error("--sample-windows must be in (0, 1]");
+            }
+            rdmeter::FrameMetricOptions metric_options;
+            metric_options.width = width;
+            metric_options.height = height;
+            metric_options.bit_depth = bit_depth;
+            metric_options.transfer = rdmeter::parse_transfer_function(transfer);
+            metric_options.matrix = matrix;
+            metric_options.range = range;
+            metric_options.window_fraction = sample_windows;
+            metric_options.seed = sample_seed;
+            metric_options.block_size = block_size;
+            auto frame_metrics = rdmeter::make_frame_metrics(expand_metrics(metrics), metric_options);
+            const size_t metric_count = frame_metrics.size();
+            for (const auto& metric : frame_metrics) {
+                if (!has_ref && !metric.reference_free) {
+                    throw std::runtime_error("Metric " + metric.name + " needs a reference (-r)");
+                }
+            }
+
+            const bool has_bitstream = !bitstream_file.empty();
+
+            // Size the frame ring and worker count so the working set stays bounded
+            // regardless of sequence length (and within --max-memory if given)
+            size_t budget_bytes = max_memory.empty() ? 0 : rdmeter::parse_memory_size(max_memory);
+            size_t frame_pair_bytes = (has_ref ? 2 : 1) * rdmeter::yuv420_storage_bytes(width, height, bit_depth);
+            size_t scratch_bytes = 0;
+            for (const auto& metric : frame_metrics) {
+                scratch_bytes += metric.scratch_bytes;
+            }
+            int max_threads = threads > 0 ? threads : static_cast<int>(rdmeter::hardware_threads());
+            auto plan = rdmeter::plan_memory(budget_bytes, frame_pair_bytes, scratch_bytes, max_threads);
+            if (verbose) {
+                std::cout << "Using " << plan.threads << " threads and a ring of " << plan.ring_frames
+                          << " frame pairs (~" << (plan.estimated_bytes >> 20) << " MiB planned)" << std::endl;
+            }
+            // Reported by every run, cached or not, so it is never replayed from the cache
+            auto memory_json = [&]() {
+                return nlohmann::json{
+                    {"budget_bytes", budget_bytes},
+                    {"threads", plan.threads},
+                    {"ring_frames", plan.ring_frames},
+                    {"estimated_bytes", plan.estimated_bytes},
+                    {"peak_rss_bytes", rdmeter::peak_rss_bytes()}
+                };
+            };
+
+            // A run is looked up in the results cache by the content of its inputs and every
+            // setting that can change a score. Inputs still being written are never cached, nor
+            // are runs printing per-frame lines, which could not be replayed
+            std::unique_ptr<rdmeter::ResultsCache> cache;
+            std::string cache_key;
+            if (!cache_dir.empty() && (follow || dist_from_shm || per_frame_file == "-")) {
+                if (verbose) {
+                    std::cout << "Not using the results cache for live input or per-frame output to stdout" << std::endl;
+                }
+            } else if (!cache_dir.empty()) {
+                auto trust = cache_trust_mtime ? rdmeter::CacheTrust::SizeMtime : rdmeter::CacheTrust::Content;
+                std::vector<std::string> metric_names;
+                for (const auto& metric : frame_metrics) {
+                    metric_names.push_back(metric.name);
+                }
+                nlohmann::json key = {
+                    {"ref", has_ref ? rdmeter::file_fingerprint(ref_file, trust) : ""},
+                    {"dist", rdmeter::file_fingerprint(dist_file, trust)},
+                    {"bitstream", has_bitstream ? rdmeter::file_fingerprint(bitstream_file, trust) : ""},
+                    {"bitstream_format", bitstream_format},
+                    {"fps", fps},
+                    {"width", width},
+                    {"height", height},
+                    {"max_frames", max_frames},
+                    {"metrics", metric_names},
+                    {"ref_pix_fmt", ref_pix_fmt.empty() ? pix_fmt : ref_pix_fmt},
+                    {"dist_pix_fmt", dist_pix_fmt.empty() ? pix_fmt : dist_pix_fmt},
+                    {"color_matrix", color_matrix},
+                    {"color_range", color_range},
+                    {"transfer", transfer},
+                    {"block_size", block_size},
+                    {"sample_windows", sample_windows},
+                    {"sample_seed", sample_seed},
+                    {"sample", sample ? nlohmann::json{{"tolerance", sample_tolerance}, {"confidence", sample_confidence}}
+                                      : nlohmann::json()},
+                    {"per_frame", !per_frame_file.empty()}
+                };
+                cache_key = key.dump();
+                cache = std::make_unique<rdmeter::ResultsCache>(cache_dir);
+
+                rdmeter::CachedResults cached;
+                if (cache->load(cache_key, cached)) {
+                    auto results = nlohmann::json::parse(cached.results);
+                    results["memory"] = memory_json();
+                    if (has_bitstream) {
+                        results["bitstream"]["file"] = bitstream_file;
+                    }
+                    if (!per_frame_file.empty()) {
+                        std::ofstream per_frame_stream(per_frame_file, std::ios::binary | std::ios::trunc);
+                        if (!per_frame_stream) {
+                            throw std::runtime_error("Failed to open per-frame output file: " + per_frame_file);
+                        }
+                        per_frame_stream << cached.per_frame;
+                    }
+
+                    std::cout << "Loaded cached results of " << results["frame_count"].get<int>() << " frames" << std::endl;
+                    std::vector<double> averages(metric_count);
+                    for (size_t m = 0; m < metric_count; ++m) {
+                        averages[m] = results["metrics"][frame_metrics[m].key].get<double>();
+                        std::cout << "Average " << frame_metrics[m].label << ": " << averages[m] << frame_metrics[m].unit;
+                        if (sample) {
+                            const auto& interval = results["sampling"][frame_metrics[m].key];
+                            std::cout << " +/- " << (interval["ci_high"].get<double>() - interval["ci_low"].get<double>()) / 2.0;
+                        }
+                        std::cout << std::endl;
+                    }
+                    double bitrate_kbps = 0.0;
+                    if (has_bitstream) {
+                        const auto& stream_json = results["bitstream"];
+                        bitrate_kbps = stream_json["bitrate_kbps"].get<double>();
+                        std::cout << "Bitrate: " << bitrate_kbps << " kbps (" << stream_json["codec"].get<std::string>()
+                                  << ", " << stream_json["frame_rate"].get<double>() << " fps)" << std::endl;
+                    }
+                    if (verbose) {
+                        std::cout << "Cache entry " << cache->entry_path(cache_key) << std::endl;
+                    }
+
+                    write_results_json(output_file, results);
+                    if (verbose) {
+                        std::cout << "Results written to " << output_file << std::endl;
+                    }
+                    if (!rd_csv.empty()) {
+                        append_rd_row(rd_csv, frame_metrics, bitstream_file, bitrate_kbps, averages, per_frame_file);
+                    }
+                    return 0;
+                }
+            }
+
+            // Frame sizes and picture types come from one scan of the compressed stream,
+            // in display order so they line up with the decoded frames
+            rdmeter::BitstreamSummary bitstream;
+            double frame_rate = fps;
+            if (has_bitstream) {
+                auto format = bitstream_format.empty() ? rdmeter::detect_bitstream_format(bitstream_file)
+                                                       : rdmeter::parse_bitstream_format(bitstream_format);
+                bitstream = rdmeter::parse_bitstream_file(bitstream_file, format);
+                if (frame_rate <= 0.0) {
+                    frame_rate = bitstream.frame_rate;
+                }
+                if (frame_rate <= 0.0) {
+                    throw std::runtime_error("--fps is required for " + bitstream.codec + " elementary streams");
+                }
+            }
+            // Metric sums, frames and coded bytes per picture type (I, P, B)
+            std::array<std::vector<double>, 3> type_totals;
+            type_totals.fill(std::vector<double>(metric_count, 0.0));
+            std::array<int, 3> type_frames{};
+            std::array<uint64_t, 3> type_bytes{};
+
+            // Identify this run so a checkpoint is only resumed by the same inputs and settings
+            rdmeter::ComputeCheckpoint checkpoint;
+            checkpoint.ref_file = has_ref ? fs::absolute(ref_file).string() : "";
+            checkpoint.dist_file = dist_from_shm ? "shm:" + dist_shm : fs::absolute(dist_file).string();
+            checkpoint.ref_size = has_ref ? fs::file_size(ref_file) : 0;
+            checkpoint.dist_size = dist_from_shm ? 0 : fs::file_size(dist_file);
+            checkpoint.width = width;
+            checkpoint.height = height;
+            checkpoint.max_frames = max_frames;
+            for (const auto& metric : frame_metrics) {
+                checkpoint.metrics.push_back(metric.name);
+            }
+            checkpoint.input_format = (ref_pix_fmt.empty() ? pix_fmt : ref_pix_fmt) + "/" +
+                                      (dist_pix_fmt.empty() ? pix_fmt : dist_pix_fmt) + "/" + color_matrix + "/" + color_range;
+            if (bit_depth > 8) {
+                checkpoint.input_format += "/" + transfer;
+            }
+            if (has_metric(checkpoint.metrics, "blockiness")) {
+                checkpoint.input_format += "/block" + std::to_string(block_size);
+            }
+            // Window sampling changes msssim whether or not frames are sampled too
+            if (has_metric(checkpoint.metrics, "msssim") && sample_windows < 1.0) {
+                checkpoint.input_format += "/windows" + nlohmann::json(sample_windows).dump() + "/seed" + std::to_string(sample_seed);
+            }
+
+            std::vector<double> totals(metric_count, 0.0);
+            int valid_frames = 0;
             int frame_count = 0;
 
-            while ((max_frames == -1 || frame_count < max_frames) &&
-                   ref_stream && dist_stream) {
-                try {
-                    auto ref_frame = rdmeter::read_yuv420p_frame(ref_stream, width, height);
-                    auto dist_frame = rdmeter::read_yuv420p_frame(dist_stream, width, height);
-                    ref_frames.push_back(std::move(ref_frame));
-                    dist_frames.push_back(std::move(dist_frame));
-                    ++frame_count;
-                } catch (const std::runtime_error&) {
-                    break;
+            // Per-frame lines written after the last checkpoint are cut off on resume, so no
+            // frame appears twice
+            const bool per_frame_to_file = !per_frame_file.empty() && per_frame_file != "-";
+            int64_t per_frame_offset = 0;
+            const bool resuming = resume && fs::exists(checkpoint_file);
+            if (resuming) {
+                auto saved = rdmeter::load_checkpoint(checkpoint_file);
+                checkpoint.per_frame_offset = !per_frame_to_file ? -1
+                                              : fs::exists(per_frame_file) ? static_cast<int64_t>(fs::file_size(per_frame_file))
+                                                                           : 0;
+                rdmeter::check_resumable(saved, checkpoint);
+                per_frame_offset = saved.per_frame_offset;
+                frame_count = saved.frame_index;
+                valid_frames = saved.valid_frames;
+                for (size_t m = 0; m < metric_count; ++m) {
+                    totals[m] = saved.sums[frame_metrics[m].key];
+                }
+
+                // Seek straight past the frames already scored
+                if (ref_reader) {
+                    ref_reader->seek(frame_count);
+                }
+                dist_reader->seek(frame_count);
+                if (verbose) {
+                    std::cout << "Resuming at frame " << frame_count << " from " << checkpoint_file << std::endl;
+                }
+            } else if (resume && verbose) {
+                std::cout << "No checkpoint at " << checkpoint_file << ", starting from frame 0" << std::endl;
+            }
+
+            std::ofstream per_frame_stream;
+            auto save_progress = [&]() {
+                checkpoint.frame_index = frame_count;
+                checkpoint.valid_frames = valid_frames;
+                for (size_t m = 0; m < metric_count; ++m) {
+                    checkpoint.sums[frame_metrics[m].key] = totals[m];
+                }
+                checkpoint.per_frame_offset = -1;
+                if (per_frame_stream.is_open()) {
+                    // Flushed first, so the file on disk holds every line the checkpoint covers
+                    per_frame_stream.flush();
+                    checkpoint.per_frame_offset = static_cast<int64_t>(per_frame_stream.tellp());
+                }
+                rdmeter::save_checkpoint(checkpoint_file, checkpoint);
+            };
+            auto last_checkpoint_time = std::chrono::steady_clock::now();
+
+            // Per-frame results are streamed as JSON lines; follow mode defaults to stdout
+            if (follow && per_frame_file.empty()) {
+                per_frame_file = "-";
+            }
+            std::ostream* per_frame_out = nullptr;
+            if (per_frame_file == "-") {
+                per_frame_out = &std::cout;
+            } else if (!per_frame_file.empty()) {
+                if (resuming && fs::exists(per_frame_file)) {
+                    fs::resize_file(per_frame_file, static_cast<uintmax_t>(per_frame_offset));
                 }
+                per_frame_stream.open(per_frame_file, resuming ? std::ios::app : std::ios::trunc);
+                if (!per_frame_stream) {
+                    throw std::runtime_error("Failed to open per-frame output file: " + per_frame_file);
+                }
+                per_frame_out = &per_frame_stream;
             }
 
-            // Expand comma-separated metrics
-            std::vector<std::string> expanded_metrics;
-            for (const auto& metric : metrics) {
-                if (metric.find(',') != std::string::npos) {
-                    // Split by comma
-                    size_t start = 0;
-                    size_t end = metric.find(',');
-                    while (end != std::string::npos) {
-                        expanded_metrics.push_back(metric.substr(start, end - start));
-                        start = end + 1;
-                        end = metric.find(',', start);
+            // In follow mode a frame is only read once both files hold it completely
+            std::unique_ptr<rdmeter::FileWatcher> watcher;
+            if (follow) {
+                std::vector<std::string> watched = {dist_file};
+                if (has_ref) {
+                    watched.push_back(ref_file);
+                }
+                watcher = std::make_unique<rdmeter::FileWatcher>(watched);
+                if (verbose) {
+                    std::cerr << "Following inputs using " << (watcher->using_inotify() ? "inotify" : "polling") << std::endl;
+                }
+            }
+            // Inputs in the watcher's order: dist, then ref
+            std::vector<std::pair<std::string, const rdmeter::FrameReader*>> inputs = {{dist_file, dist_reader.get()}};
+            if (ref_reader) {
+                inputs.emplace_back(ref_file, ref_reader.get());
+            }
+            auto complete_frames = [&]() {
+                auto frames = std::numeric_limits<uintmax_t>::max();
+                for (const auto& [file, reader] : inputs) {
+                    frames = std::min(frames, fs::file_size(file) / reader->frame_bytes());
+                }
+                return static_cast<int>(frames);
+            };
+            // Block until has(input) holds for every input. Returns false once nothing new
+            // arrived within follow_timeout, or the writer of an input still short of data has
+            // closed it and a re-check after the close finds the file has not grown
+            auto wait_until = [&](auto has) {
+                auto deadline = std::chrono::steady_clock::now() +
+                                std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                    std::chrono::duration<double>(follow_timeout));
+                std::vector<uintmax_t> closed_sizes(inputs.size(), std::numeric_limits<uintmax_t>::max());
+                while (true) {
+                    size_t lacking = 0;
+                    while (lacking < inputs.size() && has(lacking)) {
+                        ++lacking;
                     }
-                    expanded_metrics.push_back(metric.substr(start));
-                } else {
-                    expanded_metrics.push_back(metric);
+                    if (lacking == inputs.size()) {
+                        return true;
+                    }
+                    // A close of an input that already has enough, or one written again since,
+                    // says nothing about the input still short
+                    if (watcher->closed(lacking)) {
+                        auto size = fs::file_size(inputs[lacking].first);
+                        if (size == closed_sizes[lacking]) {
+                            return false;
+                        }
+                        closed_sizes[lacking] = size;
+                        continue;
+                    }
+                    auto remaining = deadline - std::chrono::steady_clock::now();
+                    if (remaining <= std::chrono::steady_clock::duration::zero()) {
+                        return false;
+                    }
+                    watcher->wait(std::chrono::duration_cast<std::chrono::milliseconds>(remaining) +
+                                  std::chrono::milliseconds(1));
+                }
+            };
+            auto wait_for_frame = [&](int frame_index) {
+                return wait_until([&](size_t input) {
+                    const auto& [file, reader] = inputs[input];
+                    return fs::file_size(file) / reader->frame_bytes() > static_cast<uintmax_t>(frame_index);
+                });
+            };
+
+            // Row-band streaming: with --band-rows, luma is scored band by band as it lands, so
+            // only the last band and whole-frame metrics are left once a frame completes
+            const bool stream_bands = follow && band_rows > 0;
+            std::vector<std::unique_ptr<rdmeter::BandScorer>> band_scorers(metric_count);
+            for (size_t m = 0; m < metric_count && stream_bands; ++m) {
+                if (frame_metrics[m].make_band_scorer) {
+                    band_scorers[m] = frame_metrics[m].make_band_scorer();
                 }
             }
-            
-            // Determine which metrics to compute
-            bool compute_psnr = std::find(expanded_metrics.begin(), expanded_metrics.end(), "psnr") != expanded_metrics.end();
-            bool compute_msssim = std::find(expanded_metrics.begin(), expanded_metrics.end(), "msssim") != expanded_metrics.end();
-            
-            // Check if the image is large enough for MS-SSIM if requested
-            if (compute_msssim && (width < 32 || height < 32)) {
-                throw std::runtime_error("Image too small for MS-SSIM calculation (minimum 32x32 required)");
+            // Luma rows of frame_index complete on disk in one input, or in all of them
+            auto rows_in = [&](size_t input, int frame_index) {
+                const auto& [file, reader] = inputs[input];
+                size_t start = static_cast<size_t>(frame_index) * reader->frame_bytes();
+                size_t size = fs::file_size(file);
+                return reader->rows_available(size > start ? size - start : 0);
+            };
+            auto rows_on_disk = [&](int frame_index) {
+                int rows = rows_in(0, frame_index);
+                for (size_t input = 1; input < inputs.size(); ++input) {
+                    rows = std::min(rows, rows_in(input, frame_index));
+                }
+                return rows;
+            };
+
+            // Sampling seeks straight to a stratified random subset of frames and stops once
+            // the confidence interval of every metric is narrow enough
+            std::unique_ptr<rdmeter::StratifiedSampler> sampler;
+            std::vector<rdmeter::RunningEstimate> estimates(metric_count);
+            int population = 0;
+            bool converged = false;
+            if (sample) {
+                population = complete_frames();
+                if (max_frames != -1) {
+                    population = std::min(population, max_frames);
+                }
+                sampler = std::make_unique<rdmeter::StratifiedSampler>(population, sample_seed);
             }
+            auto estimate_converged = [&](const rdmeter::RunningEstimate& estimate) {
+                // Require a few samples so a lucky run of similar frames cannot stop early
+                const int min_samples = 8;
+                return estimate.count >= std::min(min_samples, population) &&
+                       estimate.ci_half_width(sample_confidence, population) <= sample_tolerance * std::abs(estimate.mean);
+            };
 
-            // Compute metrics for each frame
-            double total_psnr = 0.0;
-            double total_msssim = 0.0;
-            int valid_frames = 0;
-            
-            for (int i = 0; i < frame_count; ++i) {
-                try {
-                    if (compute_psnr) {
-                        double psnr = rdmeter::psnr_y(ref_frames[i].y, dist_frames[i].y, width, height);
-                        total_psnr += psnr;
+            rdmeter::ThreadPool pool(static_cast<unsigned>(plan.threads));
+            std::vector<int> frame_indices(plan.ring_frames);
+            std::vector<rdmeter::YUVFrame> ref_ring(has_ref ? plan.ring_frames : 0, rdmeter::YUVFrame(width, height, bit_depth));
+            std::vector<rdmeter::YUVFrame> dist_ring(plan.ring_frames, rdmeter::YUVFrame(width, height, bit_depth));
+            // values[m][i] is metric m of ring slot i
+            std::vector<std::vector<double>> values(metric_count, std::vector<double>(plan.ring_frames));
+            std::vector<std::string> skip_reasons(plan.ring_frames);
+
+            // Read frame_index into ring slot band by band, feeding the band scorers. Returns
+            // false if the input ends first; whole-frame metrics run once it is complete
+            auto stream_frame = [&](int slot, int frame_index) {
+                rdmeter::YUVFrame& dist_frame = dist_ring[slot];
+                rdmeter::YUVFrame& ref_frame = has_ref ? ref_ring[slot] : dist_frame;
+                int ref_rows = 0, dist_rows = 0, scored = 0;
+                while (scored < height) {
+                    // Even row counts, so RGB input (read in row pairs) always makes progress
+                    int wanted = std::min(height, (scored + band_rows + 1) & ~1);
+                    if (!wait_until([&](size_t input) { return rows_in(input, frame_index) >= wanted; })) {
+                        return false;
                     }
-                    
-                    if (compute_msssim) {
-                        double msssim = rdmeter::msssim_y(ref_frames[i].y, dist_frames[i].y, width, height);
-                        total_msssim += msssim;
+                    int available = rows_on_disk(frame_index);
+                    if (ref_reader) {
+                        ref_rows = ref_reader->read_rows(ref_frame, available - ref_rows);
+                    }
+                    dist_rows = dist_reader->read_rows(dist_frame, available - dist_rows);
+                    int ready = ref_reader ? std::min(ref_rows, dist_rows) : dist_rows;
+                    for (auto& scorer : band_scorers) {
+                        if (scorer && ready > scored) {
+                            scorer->add_rows(ref_frame, dist_frame, scored, ready - scored);
+                        }
+                    }
+                    scored = std::max(scored, ready);
+                }
+                // Chroma follows the luma plane in planar input
+                if (!wait_for_frame(frame_index)) {
+                    return false;
+                }
+                if (ref_reader) {
+                    ref_reader->finish_frame(ref_frame);
+                }
+                dist_reader->finish_frame(dist_frame);
+                return true;
+            };
+            auto reset_bands = [&]() {
+                for (auto& scorer : band_scorers) {
+                    if (scorer) {
+                        scorer->reset();
+                    }
+                }
+            };
+
+            // Read a ring's worth of frames, score them in parallel, then accumulate
+            // in frame order so totals do not depend on thread scheduling
+            bool end_of_input = false;
+
+            while (!end_of_input && (max_frames == -1 || frame_count < max_frames)) {
+                int batch = 0;
+                if (sample) {
+                    auto indices = sampler->next_batch(plan.ring_frames);
+                    for (int index : indices) {
+                        if (ref_reader) {
+                            ref_reader->seek(index);
+                            ref_reader->read(ref_ring[batch]);
+                        }
+                        dist_reader->seek(index);
+                        dist_reader->read(dist_ring[batch]);
+                        frame_indices[batch++] = index;
+                    }
+                    end_of_input = sampler->exhausted();
+                }
+                while (!sample && batch < plan.ring_frames && (max_frames == -1 || frame_count + batch < max_frames)) {
+                    if (stream_bands) {
+                        // One frame at a time, so its score is ready as soon as its last byte lands
+                        bool complete = false;
+                        try {
+                            complete = stream_frame(batch, frame_count + batch);
+                        } catch (const std::runtime_error&) {
+                        }
+                        if (!complete) {
+                            reset_bands();
+                            end_of_input = true;
+                            break;
+                        }
+                        frame_indices[batch] = frame_count + batch;
+                        ++batch;
+                        break;
+                    }
+                    if (follow && complete_frames() <= frame_count + batch) {
+                        // Score what has already arrived rather than waiting to fill the ring
+                        if (batch > 0) {
+                            break;
+                        }
+                        if (!wait_for_frame(frame_count)) {
+                            end_of_input = true;
+                            break;
+                        }
+                    }
+                    try {
+                        if (ref_reader) {
+                            ref_reader->read(ref_ring[batch]);
+                        }
+                        if (dist_ring_source) {
+                            // Copied out so the slot goes straight back to the producer
+                            if (!dist_ring_source->read(dist_ring[batch], shm_timeout)) {
+                                end_of_input = true;
+                                break;
+                            }
+                        } else {
+                            dist_reader->read(dist_ring[batch]);
+                        }
+                        frame_indices[batch] = frame_count + batch;
+                        ++batch;
+                    } catch (const std::runtime_error&) {
+                        end_of_input = true;
+                        break;
+                    }
+                }
+                if (batch == 0) {
+                    break;
+                }
+
+                pool.parallel_for(batch, [&](size_t i, unsigned) {
+                    skip_reasons[i].clear();
+                    try {
+                        const rdmeter::YUVFrame& ref_frame = has_ref ? ref_ring[i] : dist_ring[i];
+                        std::vector<double> scored;
+                        rdmeter::score_frame(frame_metrics, ref_frame, dist_ring[i], frame_indices[i], scored, &band_scorers);
+                        for (size_t m = 0; m < metric_count; ++m) {
+                            values[m][i] = scored[m];
+                        }
+                    } catch (const std::invalid_argument& e) {
+                        skip_reasons[i] = e.what();
+                        reset_bands();
+                    }
+                });
+
+                for (int i = 0; i < batch; ++i) {
+                    const rdmeter::CodedPicture* picture =
+                        has_bitstream && static_cast<size_t>(frame_indices[i]) < bitstream.pictures.size()
+                            ? &bitstream.pictures[frame_indices[i]]
+                            : nullptr;
+                    if (per_frame_out) {
+                        nlohmann::json row = {{"frame", frame_indices[i]}};
+                        if (picture) {
+                            row["bits"] = picture->bytes * 8;
+                            row["type"] = rdmeter::picture_type_name(picture->type);
+                        }
+                        if (!skip_reasons[i].empty()) {
+                            row["skipped"] = skip_reasons[i];
+                        } else {
+                            for (size_t m = 0; m < metric_count; ++m) {
+                                row[frame_metrics[m].key] = values[m][i];
+                            }
+                        }
+                        *per_frame_out << row.dump() << '\n';
+                    }
+                    if (!skip_reasons[i].empty()) {
+                        if (verbose) {
+                            std::cerr << "Skipping frame " << frame_indices[i] << ": " << skip_reasons[i] << std::endl;
+                        }
+                        continue;
+                    }
+                    for (size_t m = 0; m < metric_count; ++m) {
+                        totals[m] += values[m][i];
+                        estimates[m].add(values[m][i]);
                     }
-                    
                     ++valid_frames;
-                } catch (const std::invalid_argument& e) {
-                    if (verbose) {
-                        std::cerr << "Skipping frame " << i << ": " << e.what() << std::endl;
+                    if (picture) {
+                        int type = static_cast<int>(picture->type);
+                        for (size_t m = 0; m < metric_count; ++m) {
+                            type_totals[type][m] += values[m][i];
+                        }
+                        ++type_frames[type];
+                        type_bytes[type] += picture->bytes;
                     }
                 }
+                frame_count += batch;
+                if (per_frame_out) {
+                    per_frame_out->flush();
+                }
+
+                if (sample) {
+                    converged = std::all_of(estimates.begin(), estimates.end(), estimate_converged);
+                    if (converged) {
+                        break;
+                    }
+                }
+
+                // Checkpoints are only taken between batches, where the sums cover exactly frame_count frames
+                if (!checkpoint_file.empty() &&
+                    std::chrono::steady_clock::now() - last_checkpoint_time >= std::chrono::seconds(checkpoint_interval)) {
+                    save_progress();
+                    last_checkpoint_time = std::chrono::steady_clock::now();
+                }
+            }
+
+            std::vector<double> averages(metric_count, 0.0);
+            for (size_t m = 0; m < metric_count && valid_frames > 0; ++m) {
+                averages[m] = totals[m] / valid_frames;
+            }
+
+            // Bitrate of the pictures the run covered: the scored prefix, or the whole
+            // stream when sampling
+            double bitrate_kbps = 0.0;
+            size_t covered_pictures = 0;
+            if (has_bitstream) {
+                covered_pictures = sample ? bitstream.pictures.size()
+                                          : std::min(bitstream.pictures.size(), static_cast<size_t>(frame_count));
+                uint64_t covered_bytes = 0;
+                for (size_t i = 0; i < covered_pictures; ++i) {
+                    covered_bytes += bitstream.pictures[i].bytes;
+                }
+                if (covered_pictures > 0) {
+                    bitrate_kbps = covered_bytes * 8.0 * frame_rate / covered_pictures / 1000.0;
+                }
+                if (!sample && max_frames == -1 && static_cast<size_t>(frame_count) != bitstream.pictures.size()) {
+                    std::cerr << "Warning: " << bitstream_file << " holds " << bitstream.pictures.size()
+                              << " frames but " << frame_count << " were scored" << std::endl;
+                }
             }
 
-            double avg_psnr = (valid_frames > 0 && compute_psnr) ? total_psnr / valid_frames : 0.0;
-            double avg_msssim = (valid_frames > 0 && compute_msssim) ? total_msssim / valid_frames : 0.0;
-            
 
             // end timer and print results
             auto end_time = std::chrono::high_resolution_clock::now();
             auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
             std::cout << "Processed " << frame_count << " frames" << std::endl;
             
-            if (compute_psnr) {
-                std::cout << "Average PSNR (Y): " << avg_psnr << " dB" << std::endl;
+            for (size_t m = 0; m < metric_count; ++m) {
+                std::cout << "Average " << frame_metrics[m].label << ": " << averages[m] << frame_metrics[m].unit;
+                if (sample) {
+                    std::cout << " +/- " << estimates[m].ci_half_width(sample_confidence, population);
+                }
+                std::cout << std::endl;
             }
-            if (compute_msssim) {
-                std::cout << "Average MS-SSIM (Y): " << avg_msssim << std::endl;
+            if (sample) {
+                std::cout << "Sampled " << frame_count << " of " << population << " frames ("
+                          << (converged ? "converged" : "tolerance not reached") << ")" << std::endl;
+            }
+            if (has_bitstream) {
+                std::cout << "Bitrate: " << bitrate_kbps << " kbps (" << bitstream.codec << ", "
+                          << frame_rate << " fps)" << std::endl;
             }
             
             std::cout << "Processing time: " << duration.count() << " ms" << std::endl;
@@ -168,48 +1086,715 @@ int main(int argc, char** argv) {
 
             // Build metrics JSON object
             nlohmann::json metrics_json;
-            if (compute_psnr) {
-                metrics_json["psnr_y"] = avg_psnr;
-            }
-            if (compute_msssim) {
-                metrics_json["msssim_y"] = avg_msssim;
+            for (size_t m = 0; m < metric_count; ++m) {
+                metrics_json[frame_metrics[m].key] = averages[m];
             }
 
             nlohmann::json results = {
                 {"frame_count", frame_count},
                 {"width", width},
                 {"height", height},
-                {"metrics", metrics_json}
+                {"bit_depth", bit_depth},
+                {"metrics", metrics_json},
+                {"memory", memory_json()}
             };
 
-            // Create output directory and write output
-            fs::path output_path(output_file);
+            if (sample) {
+                auto interval = [&](const rdmeter::RunningEstimate& estimate) {
+                    double half = estimate.ci_half_width(sample_confidence, population);
+                    return nlohmann::json{
+                        {"mean", estimate.mean},
+                        {"ci_low", estimate.mean - half},
+                        {"ci_high", estimate.mean + half},
+                        {"std_dev", std::sqrt(estimate.variance())}
+                    };
+                };
+                nlohmann::json sampling_json = {
+                    {"frames_sampled", frame_count},
+                    {"total_frames", population},
+                    {"confidence", sample_confidence},
+                    {"tolerance", sample_tolerance},
+                    {"window_fraction", sample_windows},
+                    {"seed", sample_seed},
+                    {"converged", converged}
+                };
+                for (size_t m = 0; m < metric_count; ++m) {
+                    sampling_json[frame_metrics[m].key] = interval(estimates[m]);
+                }
+                results["sampling"] = sampling_json;
+            }
+
+            if (has_bitstream) {
+                nlohmann::json types_json = nlohmann::json::object();
+                for (int type = 0; type < 3; ++type) {
+                    if (type_frames[type] == 0) {
+                        continue;
+                    }
+                    nlohmann::json type_metrics;
+                    for (size_t m = 0; m < metric_count; ++m) {
+                        type_metrics[frame_metrics[m].key] = type_totals[type][m] / type_frames[type];
+                    }
+                    types_json[rdmeter::picture_type_name(static_cast<rdmeter::PictureType>(type))] = {
+                        {"frames", type_frames[type]},
+                        {"mean_bits", type_bytes[type] * 8.0 / type_frames[type]},
+                        {"metrics", type_metrics}
+                    };
+                }
+                results["bitstream"] = {
+                    {"file", bitstream_file},
+                    {"codec", bitstream.codec},
+                    {"frames", bitstream.pictures.size()},
+                    {"bytes", bitstream.total_bytes},
+                    {"frame_rate", frame_rate},
+                    {"bitrate_kbps", bitrate_kbps},
+                    {"picture_types", types_json}
+                };
+            }
+
+            write_results_json(output_file, results);
+            if (verbose) {
+                std::cout << "Results written to " << output_file << std::endl;
+            }
+
+            // One RD point per run, appended so a sweep of encodes builds up the bdrate input
+            if (!rd_csv.empty()) {
+                append_rd_row(rd_csv, frame_metrics, bitstream_file, bitrate_kbps, averages, per_frame_file);
+            }
+
+            if (cache) {
+                rdmeter::CachedResults entry;
+                auto scores = results;
+                scores.erase("memory");
+                entry.results = scores.dump();
+                if (!per_frame_file.empty()) {
+                    per_frame_stream.close();
+                    std::ifstream written(per_frame_file, std::ios::binary);
+                    entry.per_frame.assign(std::istreambuf_iterator<char>(written), std::istreambuf_iterator<char>());
+                }
+                cache->store(cache_key, entry);
+            }
+
+            // The run completed, so its checkpoint is no longer needed
+            if (!checkpoint_file.empty()) {
+                fs::remove(checkpoint_file);
+            }
+
+        } else if (*images_cmd) {
+            if (!fs::is_directory(ref_dir)) {
+                throw std::runtime_error("Reference directory does not exist: " + ref_dir);
+            }
+            if (!fs::is_directory(dist_dir)) {
+                throw std::runtime_error("Distorted directory does not exist: " + dist_dir);
+            }
+
+            auto start_time = std::chrono::high_resolution_clock::now();
+
+            auto expanded_metrics = expand_metrics(image_metrics);
+            bool compute_psnr = has_metric(expanded_metrics, "psnr");
+            bool compute_msssim = has_metric(expanded_metrics, "msssim");
+            bool compute_ssimulacra2 = has_metric(expanded_metrics, "ssimulacra2");
+
+            // Pair files by stem so ref/kodim01.png matches dist/kodim01.ppm. Two images sharing
+            // a stem on either side would pair by directory order, so they are an error
+            auto images_by_stem = [](const std::string& dir) {
+                std::map<std::string, std::string> by_stem;
+                for (const auto& entry : fs::directory_iterator(dir)) {
+                    if (!entry.is_regular_file() || !rdmeter::is_image_file(entry.path().string())) {
+                        continue;
+                    }
+                    auto [existing, inserted] = by_stem.emplace(entry.path().stem().string(), entry.path().string());
+                    if (!inserted) {
+                        auto first = std::min(existing->second, entry.path().string());
+                        auto second = std::max(existing->second, entry.path().string());
+                        throw std::invalid_argument("Images " + first + " and " + second + " share a stem");
+                    }
+                }
+                return by_stem;
+            };
+            auto dist_by_stem = images_by_stem(dist_dir);
+            std::vector<std::pair<std::string, std::string>> pairs;
+            for (const auto& [stem, ref_path] : images_by_stem(ref_dir)) {
+                auto match = dist_by_stem.find(stem);
+                if (match != dist_by_stem.end()) {
+                    pairs.emplace_back(ref_path, match->second);
+                } else if (verbose) {
+                    std::cerr << "No distorted image for " << ref_path << std::endl;
+                }
+            }
+            std::sort(pairs.begin(), pairs.end());
+            if (pairs.empty()) {
+                throw std::runtime_error("No matching image pairs found");
+            }
+
+            // Each worker decodes and scores one pair at a time; rows keep directory order
+            struct ImageRow {
+                int width = 0;
+                int height = 0;
+                double psnr = 0.0;
+                double msssim = 0.0;
+                double ssimulacra2 = 0.0;
+                std::string error;
+            };
+            std::vector<ImageRow> rows(pairs.size());
+            rdmeter::ThreadPool pool(image_threads > 0 ? static_cast<unsigned>(image_threads) : 0);
+
+            auto score_pair = [&](size_t i, rdmeter::ThreadPool* inner_pool) {
+                auto& row = rows[i];
+                try {
+                    auto ref_image = rdmeter::read_image(pairs[i].first);
+                    auto dist_image = rdmeter::read_image(pairs[i].second);
+                    if (ref_image.width != dist_image.width || ref_image.height != dist_image.height) {
+                        throw std::invalid_argument("Image dimensions do not match");
+                    }
+                    row.width = ref_image.width;
+                    row.height = ref_image.height;
+                    auto ref_y = rdmeter::image_luma(ref_image);
+                    auto dist_y = rdmeter::image_luma(dist_image);
+                    if (compute_msssim) {
+                        // PSNR comes from MS-SSIM's full-resolution sweep
+                        rdmeter::LumaMoments moments;
+                        row.msssim = rdmeter::msssim_y(ref_y, dist_y, row.width, row.height, &moments);
+                        row.psnr = rdmeter::psnr_from_moments(moments);
+                    } else if (compute_psnr) {
+                        row.psnr = rdmeter::psnr_y(ref_y, dist_y, row.width, row.height);
+                    }
+                    if (compute_ssimulacra2) {
+                        row.ssimulacra2 = rdmeter::ssimulacra2(ref_image, dist_image, inner_pool);
+                    }
+                } catch (const std::exception& e) {
+                    row.error = e.what();
+                }
+            };
+            // With fewer pairs than threads, score one pair at a time and spread SSIMULACRA2's
+            // scales and channels over the pool instead
+            if (compute_ssimulacra2 && pairs.size() < pool.size()) {
+                for (size_t i = 0; i < pairs.size(); ++i) {
+                    score_pair(i, &pool);
+                }
+            } else {
+                pool.parallel_for(pairs.size(), [&](size_t i, unsigned) { score_pair(i, nullptr); });
+            }
+
+            double total_psnr = 0.0;
+            double total_msssim = 0.0;
+            double total_ssimulacra2 = 0.0;
+            int valid_images = 0;
+            for (size_t i = 0; i < rows.size(); ++i) {
+                if (!rows[i].error.empty()) {
+                    if (verbose) {
+                        std::cerr << "Skipping " << pairs[i].first << ": " << rows[i].error << std::endl;
+                    }
+                    continue;
+                }
+                total_psnr += rows[i].psnr;
+                total_msssim += rows[i].msssim;
+                total_ssimulacra2 += rows[i].ssimulacra2;
+                ++valid_images;
+            }
+            double avg_psnr = (valid_images > 0 && compute_psnr) ? total_psnr / valid_images : 0.0;
+            double avg_msssim = (valid_images > 0 && compute_msssim) ? total_msssim / valid_images : 0.0;
+            double avg_ssimulacra2 = (valid_images > 0 && compute_ssimulacra2) ? total_ssimulacra2 / valid_images : 0.0;
+
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+            std::cout << "Processed " << valid_images << " of " << pairs.size() << " image pairs" << std::endl;
+            if (compute_psnr) {
+                std::cout << "Average PSNR (Y): " << avg_psnr << " dB" << std::endl;
+            }
+            if (compute_msssim) {
+                std::cout << "Average MS-SSIM (Y): " << avg_msssim << std::endl;
+            }
+            if (compute_ssimulacra2) {
+                std::cout << "Average SSIMULACRA2: " << avg_ssimulacra2 << std::endl;
+            }
+            std::cout << "Processing time: " << duration.count() << " ms" << std::endl;
+
+            fs::path output_path(images_output);
             if (output_path.has_parent_path()) {
                 fs::create_directories(output_path.parent_path());
             }
-
-            std::ofstream out_stream(output_file);
+            std::ofstream out_stream(images_output);
             if (!out_stream) {
-                throw std::runtime_error("Failed to open output file: " + output_file);
+                throw std::runtime_error("Failed to open output file: " + images_output);
+            }
+
+            if (output_path.extension() == ".csv") {
+                out_stream << "name,width,height";
+                if (compute_psnr) out_stream << ",psnr_y";
+                if (compute_msssim) out_stream << ",msssim_y";
+                if (compute_ssimulacra2) out_stream << ",ssimulacra2";
+                out_stream << ",error\n";
+                out_stream.precision(17);
+                for (size_t i = 0; i < rows.size(); ++i) {
+                    out_stream << fs::path(pairs[i].first).stem().string() << ',' << rows[i].width << ',' << rows[i].height;
+                    bool ok = rows[i].error.empty();
+                    if (compute_psnr) {
+                        out_stream << ',';
+                        if (ok) out_stream << rows[i].psnr;
+                    }
+                    if (compute_msssim) {
+                        out_stream << ',';
+                        if (ok) out_stream << rows[i].msssim;
+                    }
+                    if (compute_ssimulacra2) {
+                        out_stream << ',';
+                        if (ok) out_stream << rows[i].ssimulacra2;
+                    }
+                    std::string error = rows[i].error;
+                    std::replace(error.begin(), error.end(), ',', ';');
+                    out_stream << ',' << error << '\n';
+                }
+            } else {
+                nlohmann::json images_json = nlohmann::json::array();
+                for (size_t i = 0; i < rows.size(); ++i) {
+                    nlohmann::json row = {
+                        {"name", fs::path(pairs[i].first).stem().string()},
+                        {"ref", pairs[i].first},
+                        {"dist", pairs[i].second}
+                    };
+                    if (!rows[i].error.empty()) {
+                        row["error"] = rows[i].error;
+                    } else {
+                        row["width"] = rows[i].width;
+                        row["height"] = rows[i].height;
+                        if (compute_psnr) row["psnr_y"] = rows[i].psnr;
+                        if (compute_msssim) row["msssim_y"] = rows[i].msssim;
+                        if (compute_ssimulacra2) row["ssimulacra2"] = rows[i].ssimulacra2;
+                    }
+                    images_json.push_back(row);
+                }
+
+                nlohmann::json metrics_json;
+                if (compute_psnr) metrics_json["psnr_y"] = avg_psnr;
+                if (compute_msssim) metrics_json["msssim_y"] = avg_msssim;
+                if (compute_ssimulacra2) metrics_json["ssimulacra2"] = avg_ssimulacra2;
+
+                nlohmann::json results = {
+                    {"image_count", valid_images},
+                    {"metrics", metrics_json},
+                    {"images", images_json}
+                };
+                out_stream << results.dump(4);
             }
-            out_stream << results.dump(4);
             if (verbose) {
-                std::cout << "Results written to " << output_file << std::endl;
+                std::cout << "Results written to " << images_output << std::endl;
             }
 
-        } else if (*bdrate_cmd) {
-            // BD-Rate calculation (implement later)
-            if (!fs::exists(ref_csv)) {
-                throw std::runtime_error("Reference CSV does not exist: " + ref_csv);
+        } else if (*hull_cmd) {
+            auto start_time = std::chrono::high_resolution_clock::now();
+
+            // Only the bitrate, metric and group columns are loaded; the full rows of the few
+            // points that are written out are read again at the end
+            auto metric_names = expand_metrics(hull_metrics);
+            const size_t metric_count = metric_names.size();
+            rdmeter::CsvSchema schema;
+            schema.numeric.push_back(bitrate_column);
+            schema.numeric.insert(schema.numeric.end(), metric_names.begin(), metric_names.end());
+            if (!group_column.empty()) {
+                schema.text.push_back(group_column);
             }
-            if (!fs::exists(test_csv)) {
-                throw std::runtime_error("Test CSV does not exist: " + test_csv);
+            rdmeter::ThreadPool pool(hull_threads > 0 ? static_cast<unsigned>(hull_threads) : 0);
+            std::vector<std::string> header;
+            std::vector<size_t> input_rows = {0};  // Input i holds rows [input_rows[i], input_rows[i + 1])
+            std::vector<double> bitrates;
+            std::vector<std::vector<double>> qualities(metric_count);
+            // Rows of each group, in first-seen order
+            std::vector<std::string> group_names;
+            std::vector<std::vector<size_t>> group_rows;
+            std::map<std::string, size_t> group_index;
+            if (group_column.empty()) {
+                group_names.push_back("all");
+                group_rows.emplace_back();
             }
+            for (const auto& input : hull_inputs) {
+                auto columns = rdmeter::read_csv_columns(input, schema, &pool);
+                if (header.empty()) {
+                    header = columns.header;
+                } else if (columns.header != header) {
+                    throw std::runtime_error("Columns of " + input + " differ from the first input");
+                }
+                const size_t first_row = input_rows.back();
+                bitrates.insert(bitrates.end(), columns.numeric[0].begin(), columns.numeric[0].end());
+                for (size_t m = 0; m < metric_count; ++m) {
+                    qualities[m].insert(qualities[m].end(), columns.numeric[m + 1].begin(), columns.numeric[m + 1].end());
+                }
+                if (group_column.empty()) {
+                    for (size_t r = 0; r < columns.rows; ++r) {
+                        group_rows[0].push_back(first_row + r);
+                    }
+                } else {
+                    const auto& groups = columns.text[0];
+                    std::vector<size_t> group_of(groups.values.size());
+                    for (size_t v = 0; v < groups.values.size(); ++v) {
+                        auto inserted = group_index.emplace(groups.values[v], group_names.size());
+                        if (inserted.second) {
+                            group_names.push_back(groups.values[v]);
+                            group_rows.emplace_back();
+                        }
+                        group_of[v] = inserted.first->second;
+                    }
+                    for (size_t r = 0; r < columns.rows; ++r) {
+                        group_rows[group_of[groups.codes[r]]].push_back(first_row + r);
+                    }
+                }
+                input_rows.push_back(first_row + columns.rows);
+            }
+            const size_t row_count = input_rows.back();
 
-            nlohmann::json bdrate_results = {
-                {"bd_rate", 0.0},  // Placeholder
-                {"bd_psnr", 0.0}   // Placeholder
+            // Every (group, metric) hull is independent
+            struct HullResult {
+                std::vector<rdmeter::RdPoint> hull;
+                std::vector<rdmeter::RdPoint> ladder;
+                size_t points = 0;
+                size_t pareto_points = 0;
             };
+            std::vector<HullResult> hulls(group_names.size() * metric_count);
+            pool.parallel_for(hulls.size(), [&](size_t i, unsigned) {
+                const auto& rows = group_rows[i / metric_count];
+                const auto& quality = qualities[i % metric_count];
+                std::vector<rdmeter::RdPoint> points;
+                points.reserve(rows.size());
+                for (size_t r : rows) {
+                    points.push_back({bitrates[r], quality[r], r});
+                }
+                HullResult& result = hulls[i];
+                result.points = points.size();
+                result.pareto_points = rdmeter::pareto_front(points).size();
+                result.hull = rdmeter::upper_convex_hull(std::move(points), log_bitrate);
+                if (!result.hull.empty()) {
+                    std::vector<double> targets = ladder_targets;
+                    if (ladder_rungs > 0) {
+                        double low = ladder_min_bitrate > 0.0 ? ladder_min_bitrate : result.hull.front().bitrate;
+                        double high = ladder_max_bitrate > 0.0 ? ladder_max_bitrate : result.hull.back().bitrate;
+                        targets = rdmeter::log_spaced_bitrates(low, high, ladder_rungs);
+                    }
+                    result.ladder = rdmeter::select_ladder(result.hull, targets);
+                }
+            });
+
+            // Hull points carry their whole input row, numbers as numbers
+            std::set<size_t> emitted;
+            for (const auto& result : hulls) {
+                for (const auto& point : result.hull) {
+                    emitted.insert(point.row);
+                }
+                for (const auto& point : result.ladder) {
+                    emitted.insert(point.row);
+                }
+            }
+            std::map<size_t, std::vector<std::string>> full_rows;
+            for (size_t i = 0; i < hull_inputs.size(); ++i) {
+                std::vector<size_t> local;
+                for (auto it = emitted.lower_bound(input_rows[i]); it != emitted.end() && *it < input_rows[i + 1]; ++it) {
+                    local.push_back(*it - input_rows[i]);
+                }
+                if (local.empty()) {
+                    continue;
+                }
+                auto fields = rdmeter::read_csv_rows(hull_inputs[i], local);
+                for (size_t k = 0; k < local.size(); ++k) {
+                    full_rows[input_rows[i] + local[k]] = std::move(fields[k]);
+                }
+            }
+            auto point_json = [&](const rdmeter::RdPoint& point) {
+                nlohmann::json row;
+                const auto& fields = full_rows.at(point.row);
+                for (size_t c = 0; c < header.size(); ++c) {
+                    const std::string& field = fields[c];
+                    char* end = nullptr;
+                    double value = std::strtod(field.c_str(), &end);
+                    if (!field.empty() && end == field.c_str() + field.size()) {
+                        row[header[c]] = value;
+                    } else {
+                        row[header[c]] = field;
+                    }
+                }
+                return row;
+            };
+            nlohmann::json groups_json;
+            size_t hull_points = 0;
+            for (size_t g = 0; g < group_names.size(); ++g) {
+                nlohmann::json group_json;
+                for (size_t m = 0; m < metric_count; ++m) {
+                    const HullResult& result = hulls[g * metric_count + m];
+                    nlohmann::json hull_json = nlohmann::json::array();
+                    for (const auto& point : result.hull) {
+                        hull_json.push_back(point_json(point));
+                    }
+                    nlohmann::json metric_json = {
+                        {"points", result.points},
+                        {"pareto_points", result.pareto_points},
+                        {"hull", hull_json}
+                    };
+                    if (!ladder_targets.empty() || ladder_rungs > 0) {
+                        nlohmann::json ladder_json = nlohmann::json::array();
+                        for (const auto& point : result.ladder) {
+                            ladder_json.push_back(point_json(point));
+                        }
+                        metric_json["ladder"] = ladder_json;
+                    }
+                    group_json[metric_names[m]] = metric_json;
+                    hull_points += result.hull.size();
+                }
+                groups_json[group_names[g]] = group_json;
+            }
+            nlohmann::json hull_results = {
+                {"rows", row_count},
+                {"bitrate_column", bitrate_column},
+                {"log_bitrate", log_bitrate},
+                {"groups", groups_json}
+            };
+
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+            std::cout << "Read " << row_count << " RD points in " << group_names.size() << " group(s)" << std::endl;
+            std::cout << "Hull points: " << hull_points << " across " << metric_count << " metric(s)" << std::endl;
+            std::cout << "Processing time: " << duration.count() << " ms" << std::endl;
+
+            fs::path hull_path(hull_output);
+            if (hull_path.has_parent_path()) {
+                fs::create_directories(hull_path.parent_path());
+            }
+            std::ofstream out_stream(hull_output);
+            if (!out_stream) {
+                throw std::runtime_error("Failed to open output file: " + hull_output);
+            }
+            out_stream << hull_results.dump(4);
+            if (verbose) {
+                std::cout << "Hull written to " << hull_output << std::endl;
+            }
+
+        } else if (*bdrate_cmd) {
+            auto start_time = std::chrono::high_resolution_clock::now();
+            auto interpolation = rdmeter::parse_bd_interpolation(interpolation_name);
+            rdmeter::ThreadPool pool(bdrate_threads > 0 ? static_cast<unsigned>(bdrate_threads) : 0);
+            nlohmann::json bdrate_results;
+            if (!matrix_csv.empty()) {
+                if (anchor.empty()) {
+                    throw std::runtime_error("--matrix needs the --anchor config");
+                }
+                rdmeter::CsvSchema schema;
+                schema.text = {config_column, sequence_column.empty() ? "sequence" : sequence_column};
+                schema.numeric.push_back(bdrate_bitrate_column);
+                auto metric_names = expand_metrics(bdrate_metrics);
+                schema.numeric.insert(schema.numeric.end(), metric_names.begin(), metric_names.end());
+                auto table = rdmeter::read_csv_columns(matrix_csv, schema, &pool);
+
+                rdmeter::BdTable rd;
+                rd.configs.reserve(table.rows);
+                rd.sequences.reserve(table.rows);
+                for (size_t r = 0; r < table.rows; ++r) {
+                    rd.configs.push_back(table.text[0][r]);
+                    rd.sequences.push_back(table.text[1][r]);
+                }
+                rd.bitrates = std::move(table.numeric[0]);
+                rd.metrics = metric_names;
+                rd.qualities.assign(std::make_move_iterator(table.numeric.begin() + 1),
+                                    std::make_move_iterator(table.numeric.end()));
+                auto matrix = rdmeter::bd_matrix(rd, anchor, interpolation, &pool);
+
+                // NaN deltas become null
+                auto delta_json = [](const rdmeter::BdResult& result) {
+                    nlohmann::json delta = {{"bd_rate", nullptr}, {"bd_quality", nullptr}};
+                    if (!std::isnan(result.bd_rate)) {
+                        delta = {{"bd_rate", result.bd_rate}, {"bd_quality", result.bd_quality}};
+                    }
+                    return delta;
+                };
+                const size_t metric_count = matrix.metrics.size();
+                nlohmann::json summary_json = nlohmann::json::array();
+                nlohmann::json configs_json;
+                size_t fitted = 0;
+                for (size_t c = 0; c < matrix.configs.size(); ++c) {
+                    nlohmann::json config_json;
+                    nlohmann::json summary_row = {{"config", matrix.configs[c]}};
+                    for (size_t m = 0; m < metric_count; ++m) {
+                        nlohmann::json sequences_json;
+                        for (size_t s = 0; s < matrix.sequences.size(); ++s) {
+                            size_t i = matrix.cell_index(c, s, m);
+                            nlohmann::json cell = delta_json(matrix.cells[i]);
+                            if (!matrix.errors[i].empty()) {
+                                cell["error"] = matrix.errors[i];
+                            } else {
+                                ++fitted;
+                            }
+                            sequences_json[matrix.sequences[s]] = cell;
+                        }
+                        nlohmann::json metric_json = delta_json(matrix.averages[c * metric_count + m]);
+                        metric_json["sequences_compared"] = matrix.counts[c * metric_count + m];
+                        summary_row[matrix.metrics[m]] = metric_json;
+                        metric_json["sequences"] = sequences_json;
+                        config_json[matrix.metrics[m]] = metric_json;
+                    }
+                    summary_json.push_back(summary_row);
+                    configs_json[matrix.configs[c]] = config_json;
+                }
+                bdrate_results = {
+                    {"interpolation", interpolation_name},
+                    {"anchor", anchor},
+                    {"sequences", matrix.sequences.size()},
+                    {"summary", summary_json},
+                    {"configs", configs_json}
+                };
+
+                // One row per config: the average deltas of each metric and how many sequences they cover
+                if (!summary_csv.empty()) {
+                    fs::path summary_path(summary_csv);
+                    if (summary_path.has_parent_path()) {
+                        fs::create_directories(summary_path.parent_path());
+                    }
+                    std::ofstream summary_stream(summary_csv);
+                    if (!summary_stream) {
+                        throw std::runtime_error("Failed to open summary CSV file: " + summary_csv);
+                    }
+                    summary_stream << "config";
+                    for (const auto& metric : matrix.metrics) {
+                        summary_stream << ',' << metric << "_bd_rate," << metric << "_bd_quality," << metric << "_sequences";
+                    }
+                    summary_stream << '\n';
+                    summary_stream.precision(17);
+                    for (size_t c = 0; c < matrix.configs.size(); ++c) {
+                        summary_stream << csv_field(matrix.configs[c]);
+                        for (size_t m = 0; m < metric_count; ++m) {
+                            const auto& average = matrix.averages[c * metric_count + m];
+                            if (std::isnan(average.bd_rate)) {
+                                summary_stream << ",,";
+                            } else {
+                                summary_stream << ',' << average.bd_rate << ',' << average.bd_quality;
+                            }
+                            summary_stream << ',' << matrix.counts[c * metric_count + m];
+                        }
+                        summary_stream << '\n';
+                    }
+                }
+
+                std::cout << "Compared " << matrix.configs.size() << " config(s) x " << matrix.sequences.size()
+                          << " sequence(s) x " << metric_count << " metric(s) against " << anchor << ": " << fitted
+                          << " of " << matrix.cells.size() << " cells fitted" << std::endl;
+                if (verbose) {
+                    for (size_t c = 0; c < matrix.configs.size(); ++c) {
+                        std::cout << "  " << matrix.configs[c];
+                        for (size_t m = 0; m < metric_count; ++m) {
+                            std::cout << "  " << matrix.metrics[m] << " " << matrix.averages[c * metric_count + m].bd_rate << " %";
+                        }
+                        std::cout << std::endl;
+                    }
+                }
+            } else {
+                if (ref_csv.empty() || test_csv.empty()) {
+                    throw std::runtime_error("Either --matrix or both --ref-csv and --test-csv are required");
+                }
+                if (!fs::exists(ref_csv)) {
+                    throw std::runtime_error("Reference CSV does not exist: " + ref_csv);
+                }
+                if (!fs::exists(test_csv)) {
+                    throw std::runtime_error("Test CSV does not exist: " + test_csv);
+                }
+                bootstrap.mode = rdmeter::parse_bootstrap_mode(bootstrap_name);
+                const bool frame_data = bootstrap.mode == rdmeter::BootstrapMode::Frames ||
+                                        bootstrap.mode == rdmeter::BootstrapMode::Both;
+
+                auto metric_names = expand_metrics(bdrate_metrics);
+                rdmeter::CsvSchema schema;
+                schema.numeric.push_back(bdrate_bitrate_column);
+                schema.numeric.insert(schema.numeric.end(), metric_names.begin(), metric_names.end());
+                schema.text.push_back(sequence_column.empty() ? "sequence" : sequence_column);
+                if (sequence_column.empty()) {
+                    schema.optional.push_back("sequence");
+                }
+                if (frame_data) {
+                    schema.text.push_back("per_frame");
+                }
+                auto ref_table = rdmeter::read_csv_columns(ref_csv, schema, &pool);
+                auto test_table = rdmeter::read_csv_columns(test_csv, schema, &pool);
+                const bool by_sequence = !sequence_column.empty() ||
+                                         (ref_table.has_column("sequence") && test_table.has_column("sequence"));
+
+                // RD points of one table for a metric, by sequence in first-seen order
+                using Curves = std::vector<std::pair<std::string, std::vector<rdmeter::BdPoint>>>;
+                auto curves = [&](const rdmeter::CsvColumns& table, const std::string& path, size_t metric) {
+                    const auto& bitrates = table.numeric[0];
+                    const auto& quality = table.numeric[metric + 1];
+                    fs::path table_dir = fs::path(path).parent_path();
+                    Curves result;
+                    std::vector<size_t> curve_of(by_sequence ? table.text[0].values.size() : 1, SIZE_MAX);
+                    for (size_t r = 0; r < table.rows; ++r) {
+                        size_t code = by_sequence ? table.text[0].codes[r] : 0;
+                        if (curve_of[code] == SIZE_MAX) {
+                            curve_of[code] = result.size();
+                            result.emplace_back(by_sequence ? table.text[0].values[code] : "all",
+                                                std::vector<rdmeter::BdPoint>());
+                        }
+                        rdmeter::BdPoint point;
+                        point.bitrate = bitrates[r];
+                        point.quality = quality[r];
+                        if (frame_data) {
+                            rdmeter::load_per_frame((table_dir / table.text[1][r]).string(), metric_names[metric],
+                                                    point.frame_bits, point.frame_quality);
+                        }
+                        result[curve_of[code]].second.push_back(std::move(point));
+                    }
+                    return result;
+                };
+
+                nlohmann::json metrics_json;
+                size_t sequence_count = 0;
+                for (size_t m = 0; m < metric_names.size(); ++m) {
+                    const std::string& metric = metric_names[m];
+                    // Sequences are matched by name; one missing from either side is left out
+                    auto ref_curves = curves(ref_table, ref_csv, m);
+                    auto test_curves = curves(test_table, test_csv, m);
+                    std::vector<rdmeter::BdSequence> sequences;
+                    for (auto& ref : ref_curves) {
+                        for (auto& test : test_curves) {
+                            if (test.first == ref.first) {
+                                sequences.push_back({ref.first, std::move(ref.second), std::move(test.second)});
+                                break;
+                            }
+                        }
+                    }
+                    if (sequences.empty()) {
+                        throw std::runtime_error("No sequence appears in both " + ref_csv + " and " + test_csv);
+                    }
+                    sequence_count = sequences.size();
+
+                    auto summary = rdmeter::bd_rate_summary(sequences, interpolation, bootstrap, &pool);
+                    nlohmann::json sequences_json;
+                    for (size_t s = 0; s < sequences.size(); ++s) {
+                        sequences_json[sequences[s].name] = {
+                            {"bd_rate", summary.sequences[s].bd_rate},
+                            {"bd_quality", summary.sequences[s].bd_quality}
+                        };
+                    }
+                    nlohmann::json metric_json = {
+                        {"bd_rate", summary.mean.bd_rate},
+                        {"bd_quality", summary.mean.bd_quality},
+                        {"sequences", sequences_json}
+                    };
+                    if (bootstrap.mode != rdmeter::BootstrapMode::None) {
+                        metric_json["bootstrap"] = bootstrap_json(bootstrap_name, bootstrap, summary);
+                    }
+                    metrics_json[metric] = metric_json;
+
+                    std::cout << metric << ": BD-Rate " << summary.mean.bd_rate << " %, BD-quality "
+                              << summary.mean.bd_quality;
+                    if (bootstrap.mode != rdmeter::BootstrapMode::None) {
+                        std::cout << " (" << bootstrap.confidence * 100.0 << "% CI " << summary.bd_rate_interval.low
+                                  << " to " << summary.bd_rate_interval.high << " %)";
+                    }
+                    std::cout << std::endl;
+                }
+
+                bdrate_results = {
+                    {"interpolation", interpolation_name},
+                    {"sequences", sequence_count},
+                    {"metrics", metrics_json}
+                };
+            }
+
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+            std::cout << "Processing time: " << duration.count() << " ms" << std::endl;
 
             // Create output directory and write output
             fs::path bdrate_path(bdrate_output);
@@ -226,6 +1811,336 @@ int main(int argc, char** argv) {
                 std::cout << "BD-Rate results written to " << bdrate_output << std::endl;
             }
 
+        } else if (*sweep_cmd) {
+            auto start_time = std::chrono::high_resolution_clock::now();
+            if (!fs::exists(sweep_ref)) {
+                throw std::runtime_error("Reference file does not exist: " + sweep_ref);
+            }
+            auto interpolation = rdmeter::parse_bd_interpolation(sweep_interpolation);
+            sweep_bootstrap_options.mode = rdmeter::parse_bootstrap_mode(sweep_bootstrap);
+            if (sweep_bootstrap_options.mode != rdmeter::BootstrapMode::None &&
+                sweep_bootstrap_options.mode != rdmeter::BootstrapMode::Frames) {
+                throw std::runtime_error("A sweep compares one sequence, so --bootstrap is none or frames");
+            }
+
+            // Anchor encodes first, then test encodes; each needs a bitstream or a bitrate
+            struct SweepEncode {
+                std::string config;
+                std::string path;
+                std::string bitstream;
+                double bitrate_kbps = 0.0;
+                std::vector<double> frame_bits;
+            };
+            std::vector<SweepEncode> encodes;
+            auto add_encodes = [&](const std::string& config, const std::string& option, const std::vector<std::string>& paths,
+                                   const std::vector<std::string>& bitstreams, const std::vector<double>& kbps) {
+                if (bitstreams.size() != paths.size() && kbps.size() != paths.size()) {
+                    throw std::runtime_error("--" + option + " needs one bitstream (--" + option + "-bitstreams) or bitrate (--" +
+                                             option + "-kbps) per encode");
+                }
+                for (size_t i = 0; i < paths.size(); ++i) {
+                    SweepEncode encode;
+                    encode.config = config;
+                    encode.path = paths[i];
+                    if (!bitstreams.empty()) {
+                        encode.bitstream = bitstreams[i];
+                    } else {
+                        encode.bitrate_kbps = kbps[i];
+                    }
+                    encodes.push_back(std::move(encode));
+                }
+            };
+            add_encodes(anchor_name, "anchor", anchor_encodes, anchor_bitstreams, anchor_kbps);
+            add_encodes(test_name, "test", test_encodes, test_bitstreams, test_kbps);
+            if (anchor_name == test_name) {
+                throw std::runtime_error("--anchor-name and --test-name must differ");
+            }
+
+            // One reader per input; the reference is read once for every encode
+            auto matrix = rdmeter::parse_color_matrix(sweep_color_matrix);
+            auto range = rdmeter::parse_color_range(sweep_color_range);
+            auto dist_format = rdmeter::parse_pixel_format(sweep_pix_fmt);
+            auto ref_format = sweep_ref_pix_fmt.empty() ? dist_format : rdmeter::parse_pixel_format(sweep_ref_pix_fmt);
+            std::ifstream ref_stream(sweep_ref, std::ios::binary);
+            if (!ref_stream) {
+                throw std::runtime_error("Failed to open reference file: " + sweep_ref);
+            }
+            rdmeter::FrameReader ref_reader(ref_stream, sweep_width, sweep_height, ref_format, matrix, range);
+            int frames = static_cast<int>(fs::file_size(sweep_ref) / ref_reader.frame_bytes());
+            std::vector<std::unique_ptr<std::ifstream>> encode_streams;
+            std::vector<std::unique_ptr<rdmeter::FrameReader>> encode_readers;
+            std::vector<rdmeter::FrameReader*> readers;
+            for (const auto& encode : encodes) {
+                encode_streams.push_back(std::make_unique<std::ifstream>(encode.path, std::ios::binary));
+                if (!*encode_streams.back()) {
+                    throw std::runtime_error("Failed to open distorted file: " + encode.path);
+                }
+                encode_readers.push_back(std::make_unique<rdmeter::FrameReader>(*encode_streams.back(), sweep_width, sweep_height,
+                                                                                dist_format, matrix, range));
+                readers.push_back(encode_readers.back().get());
+                if (readers.back()->bit_depth() != ref_reader.bit_depth()) {
+                    throw std::runtime_error("Reference and distorted inputs must have the same bit depth");
+                }
+                frames = std::min(frames, static_cast<int>(fs::file_size(encode.path) / readers.back()->frame_bytes()));
+            }
+            if (sweep_frames >= 0) {
+                frames = std::min(frames, sweep_frames);
+            }
+            if (frames <= 0) {
+                throw std::runtime_error("The reference and every encode need at least one whole frame");
+            }
+
+            rdmeter::FrameMetricOptions metric_options;
+            metric_options.width = sweep_width;
+            metric_options.height = sweep_height;
+            metric_options.bit_depth = ref_reader.bit_depth();
+            metric_options.transfer = rdmeter::parse_transfer_function(sweep_transfer);
+            metric_options.matrix = matrix;
+            metric_options.range = range;
+            auto frame_metrics = rdmeter::make_frame_metrics(expand_metrics(sweep_metrics), metric_options);
+            const size_t metric_count = frame_metrics.size();
+
+            // A batch slot holds a reference frame and one frame of every encode
+            size_t budget_bytes = sweep_max_memory.empty() ? 0 : rdmeter::parse_memory_size(sweep_max_memory);
+            size_t slot_bytes = (encodes.size() + 1) *
+                                rdmeter::yuv420_storage_bytes(sweep_width, sweep_height, ref_reader.bit_depth());
+            size_t scratch_bytes = 0;
+            for (const auto& metric : frame_metrics) {
+                scratch_bytes += metric.scratch_bytes;
+            }
+            int max_threads = sweep_threads > 0 ? sweep_threads : static_cast<int>(rdmeter::hardware_threads());
+            auto plan = rdmeter::plan_memory(budget_bytes, slot_bytes, scratch_bytes, max_threads);
+            if (verbose) {
+                std::cout << "Using " << plan.threads << " threads and batches of " << plan.ring_frames << " frames of "
+                          << encodes.size() << " encodes (~" << (plan.estimated_bytes >> 20) << " MiB planned)" << std::endl;
+            }
+            rdmeter::ThreadPool pool(static_cast<unsigned>(plan.threads));
+            auto scores = rdmeter::score_sweep(ref_reader, readers, frame_metrics, frames, plan.ring_frames, pool);
+
+            // Bitrates over the scored frames, from each bitstream's picture sizes
+            for (auto& encode : encodes) {
+                if (encode.bitstream.empty()) {
+                    continue;
+                }
+                auto stream = rdmeter::parse_bitstream_file(encode.bitstream, rdmeter::detect_bitstream_format(encode.bitstream));
+                double frame_rate = sweep_fps > 0.0 ? sweep_fps : stream.frame_rate;
+                if (frame_rate <= 0.0) {
+                    throw std::runtime_error("--fps is required for " + stream.codec + " elementary streams");
+                }
+                size_t covered = std::min(stream.pictures.size(), static_cast<size_t>(frames));
+                if (covered == 0) {
+                    throw std::runtime_error("Bitstream " + encode.bitstream + " holds no pictures");
+                }
+                uint64_t bytes = 0;
+                for (size_t f = 0; f < covered; ++f) {
+                    bytes += stream.pictures[f].bytes;
+                    encode.frame_bits.push_back(stream.pictures[f].bytes * 8.0);
+                }
+                encode.bitrate_kbps = bytes * 8.0 * frame_rate / covered / 1000.0;
+                if (covered < static_cast<size_t>(frames)) {
+                    std::cerr << "Warning: " << encode.bitstream << " holds " << covered << " of the " << frames
+                              << " scored frames" << std::endl;
+                    encode.frame_bits.clear();
+                }
+            }
+
+            // Averages skip the frames an encode could not score; frame resampling draws
+            // from the frames every encode scored, so all its curves stay paired
+            std::vector<std::vector<double>> averages(encodes.size(), std::vector<double>(metric_count, 0.0));
+            std::vector<int> skipped(encodes.size(), 0);
+            std::vector<int> common_frames;
+            for (int f = 0; f < frames; ++f) {
+                bool everywhere = true;
+                for (size_t e = 0; e < encodes.size(); ++e) {
+                    everywhere = everywhere && !std::isnan(scores.values[e][0][f]);
+                }
+                if (everywhere) {
+                    common_frames.push_back(f);
+                }
+            }
+            for (size_t e = 0; e < encodes.size(); ++e) {
+                int valid = 0;
+                for (int f = 0; f < frames; ++f) {
+                    if (std::isnan(scores.values[e][0][f])) {
+                        ++skipped[e];
+                        continue;
+                    }
+                    for (size_t m = 0; m < metric_count; ++m) {
+                        averages[e][m] += scores.values[e][m][f];
+                    }
+                    ++valid;
+                }
+                for (size_t m = 0; m < metric_count; ++m) {
+                    averages[e][m] = valid > 0 ? averages[e][m] / valid : std::numeric_limits<double>::quiet_NaN();
+                }
+            }
+
+            const std::string sequence = sweep_sequence.empty() ? fs::path(sweep_ref).stem().string() : sweep_sequence;
+            const bool frame_data = sweep_bootstrap_options.mode == rdmeter::BootstrapMode::Frames;
+            nlohmann::json bd_json;
+            for (size_t m = 0; m < metric_count; ++m) {
+                rdmeter::BdSequence curves{sequence, {}, {}};
+                for (size_t e = 0; e < encodes.size(); ++e) {
+                    rdmeter::BdPoint point;
+                    point.bitrate = encodes[e].bitrate_kbps;
+                    point.quality = averages[e][m];
+                    if (frame_data) {
+                        for (int f : common_frames) {
+                            point.frame_quality.push_back(scores.values[e][m][f]);
+                            if (!encodes[e].frame_bits.empty()) {
+                                point.frame_bits.push_back(encodes[e].frame_bits[f]);
+                            }
+                        }
+                    }
+                    (encodes[e].config == anchor_name ? curves.ref : curves.test).push_back(std::move(point));
+                }
+                auto summary = rdmeter::bd_rate_summary({curves}, interpolation, sweep_bootstrap_options, &pool);
+                nlohmann::json metric_json = {
+                    {"bd_rate", summary.mean.bd_rate},
+                    {"bd_quality", summary.mean.bd_quality}
+                };
+                if (frame_data) {
+                    metric_json["bootstrap"] = bootstrap_json(sweep_bootstrap, sweep_bootstrap_options, summary);
+                }
+                bd_json[frame_metrics[m].key] = metric_json;
+
+                std::cout << frame_metrics[m].label << ": BD-Rate " << summary.mean.bd_rate << " %, BD-quality "
+                          << summary.mean.bd_quality << frame_metrics[m].unit;
+                if (frame_data) {
+                    std::cout << " (" << sweep_bootstrap_options.confidence * 100.0 << "% CI "
+                              << summary.bd_rate_interval.low << " to " << summary.bd_rate_interval.high << " %)";
+                }
+                std::cout << std::endl;
+            }
+
+            nlohmann::json encodes_json;
+            for (size_t e = 0; e < encodes.size(); ++e) {
+                nlohmann::json encode_json = {
+                    {"dist", encodes[e].path},
+                    {"bitrate_kbps", encodes[e].bitrate_kbps},
+                    {"frames_skipped", skipped[e]}
+                };
+                if (!encodes[e].bitstream.empty()) {
+                    encode_json["bitstream"] = encodes[e].bitstream;
+                }
+                for (size_t m = 0; m < metric_count; ++m) {
+                    encode_json[frame_metrics[m].key] = averages[e][m];
+                }
+                encodes_json[encodes[e].config].push_back(encode_json);
+            }
+            nlohmann::json sweep_results = {
+                {"reference", sweep_ref},
+                {"sequence", sequence},
+                {"frames", frames},
+                {"interpolation", sweep_interpolation},
+                {"encodes", encodes_json},
+                {"bd", bd_json}
+            };
+
+            // Long-format rows, so sweeps of several sequences build up a bdrate --matrix table
+            if (!sweep_rd_csv.empty()) {
+                std::string header = "config,sequence,name,bitrate_kbps";
+                for (const auto& metric : frame_metrics) {
+                    header += "," + metric.key;
+                }
+                auto rd_stream = open_rd_csv(sweep_rd_csv, header);
+                for (size_t e = 0; e < encodes.size(); ++e) {
+                    rd_stream << csv_field(encodes[e].config) << ',' << csv_field(sequence) << ','
+                              << csv_field(fs::path(encodes[e].path).stem().string()) << ',' << encodes[e].bitrate_kbps;
+                    for (size_t m = 0; m < metric_count; ++m) {
+                        rd_stream << ',' << averages[e][m];
+                    }
+                    rd_stream << '\n';
+                }
+            }
+
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+            std::cout << "Scored " << frames << " frames of " << encodes.size() << " encodes" << std::endl;
+            std::cout << "Processing time: " << duration.count() << " ms" << std::endl;
+
+            fs::path sweep_path(sweep_output);
+            if (sweep_path.has_parent_path()) {
+                fs::create_directories(sweep_path.parent_path());
+            }
+            std::ofstream out_stream(sweep_output);
+            if (!out_stream) {
+                throw std::runtime_error("Failed to open output file: " + sweep_output);
+            }
+            out_stream << sweep_results.dump(4);
+            if (verbose) {
+                std::cout << "Sweep report written to " << sweep_output << std::endl;
+            }
+
+        } else if (*gen_cmd) {
+            if (gen_ref.empty() && gen_dist.empty()) {
+                throw std::runtime_error("gen needs --ref, --dist or both");
+            }
+            if (gen_frames < 1) {
+                throw std::runtime_error("--frames must be positive");
+            }
+            auto start_time = std::chrono::high_resolution_clock::now();
+            rdmeter::SyntheticVideo video(gen_width, gen_height, rdmeter::parse_pixel_format(gen_pix_fmt), gen_seed);
+            rdmeter::ThreadPool pool(static_cast<unsigned>(std::max(gen_threads, 0)));
+
+            auto open_output = [](const std::string& path) {
+                fs::path output_path(path);
+                if (output_path.has_parent_path()) {
+                    fs::create_directories(output_path.parent_path());
+                }
+                std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+                if (!stream) {
+                    throw std::runtime_error("Failed to open output file: " + path);
+                }
+                return stream;
+            };
+            std::ofstream ref_out, dist_out;
+            if (!gen_ref.empty()) {
+                ref_out = open_output(gen_ref);
+            }
+            if (!gen_dist.empty()) {
+                dist_out = open_output(gen_dist);
+            }
+
+            // A dropped frame repeats the previous distorted frame, so its buffer is written again
+            std::vector<uint8_t> ref_frame(video.frame_bytes());
+            std::vector<uint8_t> dist_frame(video.frame_bytes());
+            int dropped = 0;
+            for (int f = 0; f < gen_frames; ++f) {
+                if (ref_out.is_open()) {
+                    video.render(f, ref_frame.data(), pool);
+                    ref_out.write(reinterpret_cast<const char*>(ref_frame.data()), ref_frame.size());
+                }
+                if (dist_out.is_open()) {
+                    if (video.shown_frame(f, gen_distortion.drop_rate) == f) {
+                        video.render(f, gen_distortion, dist_frame.data(), pool);
+                    } else {
+                        ++dropped;
+                        if (verbose) {
+                            std::cout << "Dropped frame " << f << std::endl;
+                        }
+                    }
+                    dist_out.write(reinterpret_cast<const char*>(dist_frame.data()), dist_frame.size());
+                }
+            }
+            for (auto* stream : {&ref_out, &dist_out}) {
+                if (stream->is_open()) {
+                    stream->close();
+                    if (stream->fail()) {
+                        throw std::runtime_error("Failed to write generated frames");
+                    }
+                }
+            }
+
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+            std::cout << "Generated " << gen_frames << " frames of " << gen_width << "x" << gen_height << " " << gen_pix_fmt
+                      << " (" << ((video.frame_bytes() * gen_frames) >> 20) << " MiB per sequence)" << std::endl;
+            if (!gen_dist.empty() && gen_distortion.drop_rate > 0.0) {
+                std::cout << "Dropped " << dropped << " distorted frames" << std::endl;
+            }
+            std::cout << "Processing time: " << duration.count() << " ms" << std::endl;
+
         } else {
             std::cout << app.help() << std::endl;
         }
@@ -0,0 +1,111 @@
+#include "memory_budget.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <limits>
+
+#include <sys/resource.h>
+
+namespace rdmeter {
+
+size_t parse_memory_size(const std::string& text) {
+    size_t pos = 0;
+    double value = 0.0;
+    try {
+        value = std::stod(text, &pos);
+    } catch (const std::exception&) {
+        throw std::invalid_argument("Invalid memory size: " + text);
+    }
+    if (!(value >= 0.0)) {
+        throw std::invalid_argument("Memory size must be non-negative: " + text);
+    }
+
+    std::string suffix;
+    for (size_t i = pos; i < text.size(); ++i) {
+        suffix += static_cast<char>(std::toupper(static_cast<unsigned char>(text[i])));
+    }
+    // Accept "G", "GB" and "GIB" alike
+    if (suffix.size() > 1 && suffix.back() == 'B') suffix.pop_back();
+    if (suffix.size() > 1 && suffix.back() == 'I') suffix.pop_back();
+
+    double multiplier = 1.0;
+    if (suffix.empty() || suffix == "B") {
+        multiplier = 1.0;
+    } else if (suffix == "K") {
+        multiplier = 1024.0;
+    } else if (suffix == "M") {
+        multiplier = 1024.0 * 1024.0;
+    } else if (suffix == "G") {
+        multiplier = 1024.0 * 1024.0 * 1024.0;
+    } else if (suffix == "T") {
+        multiplier = 1024.0 * 1024.0 * 1024.0 * 1024.0;
+    } else {
+        throw std::invalid_argument("Unknown memory size suffix: " + text);
+    }
+
+    // Checked in floating point before rounding, which overflows for values such as "inf" or "1e30G"
+    double bytes = std::round(value * multiplier);
+    if (!std::isfinite(bytes) || bytes >= static_cast<double>(std::numeric_limits<size_t>::max())) {
+        throw std::invalid_argument("Memory size is too large: " + text);
+    }
+    return static_cast<size_t>(bytes);
+}
+
+MemoryPlan plan_memory(size_t budget_bytes, size_t frame_pair_bytes, size_t scratch_bytes, int max_threads) {
+    if (frame_pair_bytes == 0) {
+        throw std::invalid_argument("Frame size must be positive");
+    }
+    max_threads = std::max(1, max_threads);
+
+    MemoryPlan plan;
+    plan.frame_pair_bytes = frame_pair_bytes;
+    plan.scratch_bytes = scratch_bytes;
+
+    auto total = [&](int threads, int ring) {
+        return kBaseOverheadBytes + static_cast<size_t>(threads) * scratch_bytes +
+               static_cast<size_t>(ring) * frame_pair_bytes;
+    };
+
+    if (budget_bytes == 0) {
+        plan.threads = max_threads;
+        plan.ring_frames = 2 * max_threads;
+        plan.estimated_bytes = total(plan.threads, plan.ring_frames);
+        return plan;
+    }
+
+    int threads = max_threads;
+    while (threads > 0 && total(threads, threads) > budget_bytes) {
+        --threads;
+    }
+    if (threads == 0) {
+        throw std::runtime_error("Memory budget of " + std::to_string(budget_bytes) +
+                                 " bytes is too small; at least " + std::to_string(total(1, 1)) +
+                                 " bytes are needed for one thread and one frame pair");
+    }
+
+    size_t remaining = budget_bytes - total(threads, threads);
+    size_t extra = remaining / frame_pair_bytes;
+    int ring = threads + static_cast<int>(std::min<size_t>(extra, static_cast<size_t>(3 * threads)));
+
+    plan.threads = threads;
+    plan.ring_frames = ring;
+    plan.estimated_bytes = total(threads, ring);
+    return plan;
+}
+
+size_t peak_rss_bytes() {
+    struct rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    // macOS reports ru_maxrss in bytes
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    // Linux reports ru_maxrss in kilobytes
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+} // namespace rdmeter
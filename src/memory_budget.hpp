@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace rdmeter {
+
+// Parse a human-readable memory size such as "512M", "4G", "1.5GiB" or "1048576"
+// Suffixes are binary (K = 1024). Throws std::invalid_argument on malformed input
+size_t parse_memory_size(const std::string& text);
+
+// Resources chosen for a compute run so that the working set stays within a budget
+struct MemoryPlan {
+    int threads = 1;               // Worker threads scoring frames concurrently
+    int ring_frames = 1;           // Ref/dist frame pairs held in the read ring
+    size_t frame_pair_bytes = 0;   // Bytes for one ref + dist frame pair
+    size_t scratch_bytes = 0;      // Per-thread scratch (filter planes, pyramid levels)
+    size_t estimated_bytes = 0;    // Total planned working set including fixed overhead
+};
+
+// Bytes reserved for the executable, allocator and I/O buffers before any frame is read
+constexpr size_t kBaseOverheadBytes = 16u << 20;
+
+// Size the frame ring and thread count for a budget_bytes working set.
+// budget_bytes == 0 means unlimited: use max_threads and a ring of two frames per thread.
+// The highest thread count (up to max_threads) whose scratch plus one frame pair per
+// thread fits is chosen; leftover budget deepens the ring up to four pairs per thread.
+// Throws std::runtime_error if even a single thread does not fit.
+MemoryPlan plan_memory(size_t budget_bytes, size_t frame_pair_bytes, size_t scratch_bytes, int max_threads);
+
+// Peak resident set size of this process in bytes, or 0 if unavailable
+size_t peak_rss_bytes();
+
+} // namespace rdmeter
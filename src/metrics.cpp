@@ -1,6 +1,7 @@
 #include "metrics.hpp"
 #include <stdexcept>
 #include <algorithm>
+#include <type_traits>
 
 namespace rdmeter {
 
@@ -30,6 +31,27 @@ double psnr_y(const std::vector<uint8_t>& ref_y, const std::vector<uint8_t>& dis
     return psnr;
 }
 
+double psnr_y16(const std::vector<uint16_t>& ref_y, const std::vector<uint16_t>& dist_y, int width, int height, int bit_depth) {
+    if (ref_y.size() != dist_y.size() || ref_y.size() != static_cast<size_t>(width * height)) {
+        throw std::invalid_argument("Frame sizes do not match or invalid dimensions");
+    }
+
+    // Integer SSE is exact for any frame size up to 16-bit samples
+    uint64_t sse = 0;
+    for (size_t i = 0; i < ref_y.size(); ++i) {
+        int64_t diff = static_cast<int64_t>(ref_y[i]) - static_cast<int64_t>(dist_y[i]);
+        sse += static_cast<uint64_t>(diff * diff);
+    }
+
+    double mse = static_cast<double>(sse) / ref_y.size();
+    if (mse == 0.0) {
+        return 100.0;
+    }
+
+    double max_val = static_cast<double>((1 << bit_depth) - 1);
+    return 20.0 * std::log10(max_val / std::sqrt(mse));
+}
+
 std::vector<double> generate_gaussian_kernel(int size, double sigma) {
     std::vector<double> kernel(size);
     double sum = 0.0;
@@ -90,131 +112,351 @@ std::vector<double> apply_gaussian_filter(const std::vector<uint8_t>& image, int
     return filtered;
 }
 
-double ssim_y(const std::vector<uint8_t>& ref_y, const std::vector<uint8_t>& dist_y, int width, int height) {
-    if (ref_y.size() != dist_y.size() || ref_y.size() != static_cast<size_t>(width * height)) {
-        throw std::invalid_argument("Frame sizes do not match or invalid dimensions");
+std::vector<float> apply_gaussian_filter(const std::vector<float>& image, int width, int height, const std::vector<double>& kernel) {
+    int kernel_size = static_cast<int>(kernel.size());
+    int half = kernel_size / 2;
+    std::vector<float> weights(kernel.begin(), kernel.end());
+    std::vector<float> filtered(static_cast<size_t>(width) * height);
+
+    // Vertical pass into a row padded by half on each side, then horizontal pass from that row.
+    // Both inner loops run over x, so each tap is one vector multiply-add
+    std::vector<float> padded(width + 2 * half);
+    for (int y = 0; y < height; ++y) {
+        float* row = padded.data() + half;
+        std::fill(row, row + width, 0.0f);
+        for (int k = 0; k < kernel_size; ++k) {
+            int yi = y + k - half;
+            // Symmetric padding, clamped for planes shorter than the kernel's half width
+            if (yi < 0) yi = -yi;
+            if (yi >= height) yi = 2 * height - yi - 1;
+            yi = std::clamp(yi, 0, height - 1);
+            const float* src = image.data() + static_cast<size_t>(yi) * width;
+            const float w = weights[k];
+            for (int x = 0; x < width; ++x) {
+                row[x] += w * src[x];
+            }
+        }
+        for (int i = 1; i <= half; ++i) {
+            row[-i] = row[std::min(i, width - 1)];
+            row[width - 1 + i] = row[std::max(width - i, 0)];
+        }
+
+        float* out = filtered.data() + static_cast<size_t>(y) * width;
+        std::fill(out, out + width, 0.0f);
+        for (int k = 0; k < kernel_size; ++k) {
+            const float* src = padded.data() + k;
+            const float w = weights[k];
+            for (int x = 0; x < width; ++x) {
+                out[x] += w * src[x];
+            }
+        }
     }
+    return filtered;
+}
 
-    // SSIM constants
-    const double L = 255.0;  // Dynamic range for 8-bit images
-    const double K1 = 0.01;
-    const double K2 = 0.03;
-    const double C1 = (K1 * L) * (K1 * L);
-    const double C2 = (K2 * L) * (K2 * L);
-    
-    // Generate 11x11 Gaussian kernel with sigma = 1.5
-    auto kernel = generate_gaussian_kernel(11, 1.5);
-    
-    // Apply Gaussian filtering to compute local means
-    auto mu1 = apply_gaussian_filter(ref_y, width, height, kernel);
-    auto mu2 = apply_gaussian_filter(dist_y, width, height, kernel);
-    
-    // Compute mu1^2, mu2^2, and mu1*mu2
-    std::vector<double> mu1_sq(width * height);
-    std::vector<double> mu2_sq(width * height);
-    std::vector<double> mu1_mu2(width * height);
-    
-    for (int i = 0; i < width * height; ++i) {
-        mu1_sq[i] = mu1[i] * mu1[i];
-        mu2_sq[i] = mu2[i] * mu2[i];
-        mu1_mu2[i] = mu1[i] * mu2[i];
+namespace {
+
+// Bytes per row and chunk of the fused kernel: two rows of ref and dist stay in L1 while the
+// moments and the downsampled row are produced, and 8-bit lane sums cannot overflow 32 bits
+constexpr int kMomentChunkBytes = 4096;
+
+// Moments of one row segment; 8-bit samples accumulate in 32-bit lanes and 16-bit pyramid
+// samples in 64-bit lanes. Straight-line so every sum vectorises
+template <typename Sample>
+inline void accumulate_moments(const Sample* __restrict ref, const Sample* __restrict dist, int n,
+                               LumaMoments& moments) {
+    using Acc = typename std::conditional<sizeof(Sample) == 1, uint32_t, uint64_t>::type;
+    using Diff = typename std::make_signed<Acc>::type;
+    Acc s1 = 0, s2 = 0, s11 = 0, s22 = 0, s12 = 0, sse = 0;
+    for (int i = 0; i < n; ++i) {
+        Acc a = ref[i];
+        Acc b = dist[i];
+        Diff diff = static_cast<Diff>(a) - static_cast<Diff>(b);
+        s1 += a;
+        s2 += b;
+        s11 += a * a;
+        s22 += b * b;
+        s12 += a * b;
+        sse += static_cast<Acc>(diff * diff);
     }
-    
-    // Create ref_y^2 and dist_y^2 as double vectors
-    std::vector<uint8_t> ref_sq(width * height);
-    std::vector<uint8_t> dist_sq(width * height);
-    std::vector<uint8_t> ref_dist(width * height);
-    
-    for (int i = 0; i < width * height; ++i) {
-        // For variance calculation, we need (pixel * pixel)
-        // But since we're dealing with uint8_t, we need to be careful about overflow
-        // We'll compute this in the filtering step instead
-        ref_sq[i] = ref_y[i];
-        dist_sq[i] = dist_y[i];
-        ref_dist[i] = ref_y[i];
+    moments.count += static_cast<uint64_t>(n);
+    moments.sse += sse;
+    moments.sum_ref += s1;
+    moments.sum_dist += s2;
+    moments.sum_ref_sq += s11;
+    moments.sum_dist_sq += s22;
+    moments.sum_cross += s12;
+}
+
+// 2x2 sums of two rows into n output pixels: the average with two more fractional bits
+template <typename Sample>
+inline void downsample_rows(const Sample* __restrict row0, const Sample* __restrict row1, int n,
+                            uint16_t* __restrict out) {
+    for (int x = 0; x < n; ++x) {
+        uint32_t sum = static_cast<uint32_t>(row0[2 * x]) + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1];
+        out[x] = static_cast<uint16_t>(sum);
     }
-    
-    // We need to compute sigma1^2, sigma2^2, and sigma12
-    // sigma1^2 = E[X^2] - E[X]^2, where E[X^2] is filtered(X^2) and E[X]^2 is filtered(X)^2
-    
-    // Create squared images for variance computation
-    std::vector<uint8_t> ref_y_squared(width * height);
-    std::vector<uint8_t> dist_y_squared(width * height);
-    std::vector<uint8_t> ref_dist_prod(width * height);
-    
-    // Convert to double for calculations to avoid overflow
-    std::vector<double> ref_double(width * height);
-    std::vector<double> dist_double(width * height);
-    
-    for (int i = 0; i < width * height; ++i) {
-        ref_double[i] = static_cast<double>(ref_y[i]);
-        dist_double[i] = static_cast<double>(dist_y[i]);
+}
+
+template <typename Sample>
+LumaMoments fused_moments(const Sample* ref, const Sample* dist, int width, int height,
+                          uint16_t* ref_half, uint16_t* dist_half) {
+    constexpr int chunk = kMomentChunkBytes / static_cast<int>(sizeof(Sample));
+    LumaMoments moments;
+    const bool downsample = ref_half != nullptr && dist_half != nullptr;
+    const int half_width = width / 2;
+    const int half_height = height / 2;
+
+    for (int y = 0; y < height; y += 2) {
+        const Sample* ref0 = ref + static_cast<size_t>(y) * width;
+        const Sample* dist0 = dist + static_cast<size_t>(y) * width;
+        // An odd last row only contributes to the moments
+        const bool pair = y + 1 < height;
+        const Sample* ref1 = ref0 + width;
+        const Sample* dist1 = dist0 + width;
+
+        for (int x0 = 0; x0 < width; x0 += chunk) {
+            int n = std::min(chunk, width - x0);
+            accumulate_moments(ref0 + x0, dist0 + x0, n, moments);
+            if (pair) {
+                accumulate_moments(ref1 + x0, dist1 + x0, n, moments);
+            }
+            // The chunk is still in L1, so the next level costs no extra memory traffic
+            if (downsample && pair && y / 2 < half_height) {
+                int cx0 = x0 / 2;
+                int cn = std::min(chunk / 2, half_width - cx0);
+                size_t out = static_cast<size_t>(y / 2) * half_width + cx0;
+                downsample_rows(ref0 + x0, ref1 + x0, cn, ref_half + out);
+                downsample_rows(dist0 + x0, dist1 + x0, cn, dist_half + out);
+            }
+        }
     }
-    
-    // Create products for covariance calculation
-    std::vector<double> ref_sq_d(width * height);
-    std::vector<double> dist_sq_d(width * height);
-    std::vector<double> ref_dist_d(width * height);
-    
-    for (int i = 0; i < width * height; ++i) {
-        ref_sq_d[i] = ref_double[i] * ref_double[i];
-        dist_sq_d[i] = dist_double[i] * dist_double[i];
-        ref_dist_d[i] = ref_double[i] * dist_double[i];
+    return moments;
+}
+
+template <typename Sample>
+std::vector<uint16_t> downsample_sum(const std::vector<Sample>& image, int width, int height, int& new_width,
+                                     int& new_height) {
+    new_width = width / 2;
+    new_height = height / 2;
+    if (new_width == 0 || new_height == 0) {
+        throw std::invalid_argument("Image too small for downsampling");
     }
-    
-    // Convert back to uint8_t for filtering (clamping to 255)
-    for (int i = 0; i < width * height; ++i) {
-        ref_y_squared[i] = static_cast<uint8_t>(std::min(255.0, ref_sq_d[i] / 255.0));  // Scale down to fit in uint8_t
-        dist_y_squared[i] = static_cast<uint8_t>(std::min(255.0, dist_sq_d[i] / 255.0));
-        ref_dist_prod[i] = static_cast<uint8_t>(std::min(255.0, ref_dist_d[i] / 255.0));
+
+    std::vector<uint16_t> downsampled(static_cast<size_t>(new_width) * new_height);
+    for (int y = 0; y < new_height; ++y) {
+        const Sample* row0 = image.data() + static_cast<size_t>(2 * y) * width;
+        downsample_rows(row0, row0 + width, new_width, downsampled.data() + static_cast<size_t>(y) * new_width);
     }
-    
-    // Apply Gaussian filtering to squared terms
-    auto sigma1_sq_raw = apply_gaussian_filter(ref_y_squared, width, height, kernel);
-    auto sigma2_sq_raw = apply_gaussian_filter(dist_y_squared, width, height, kernel);
-    auto sigma12_raw = apply_gaussian_filter(ref_dist_prod, width, height, kernel);
-    
-    // Compute actual variances and covariance
-    // We need to scale back and compute properly
-    // Let's use a different approach - compute everything in double precision
-    
-    double ssim_sum = 0.0;
-    int valid_pixels = 0;
-    
-    // For now, let's implement a simpler version using global statistics for testing
-    // Compute global means
-    double mean1 = 0.0, mean2 = 0.0;
-    for (int i = 0; i < width * height; ++i) {
-        mean1 += ref_double[i];
-        mean2 += dist_double[i];
-    }
-    mean1 /= (width * height);
-    mean2 /= (width * height);
-    
-    // Compute global variances and covariance
-    double var1 = 0.0, var2 = 0.0, covar = 0.0;
-    for (int i = 0; i < width * height; ++i) {
-        double diff1 = ref_double[i] - mean1;
-        double diff2 = dist_double[i] - mean2;
-        var1 += diff1 * diff1;
-        var2 += diff2 * diff2;
-        covar += diff1 * diff2;
-    }
-    var1 /= (width * height - 1);
-    var2 /= (width * height - 1);
-    covar /= (width * height - 1);
-    
-    // Compute SSIM
+    return downsampled;
+}
+
+} // namespace
+
+LumaMoments luma_moments(const uint8_t* ref, const uint8_t* dist, int width, int height,
+                         uint16_t* ref_half, uint16_t* dist_half) {
+    return fused_moments(ref, dist, width, height, ref_half, dist_half);
+}
+
+LumaMoments luma_moments(const uint16_t* ref, const uint16_t* dist, int width, int height,
+                         uint16_t* ref_half, uint16_t* dist_half) {
+    return fused_moments(ref, dist, width, height, ref_half, dist_half);
+}
+
+std::vector<uint16_t> downsample_2x2_sum(const std::vector<uint8_t>& image, int width, int height, int& new_width,
+                                         int& new_height) {
+    return downsample_sum(image, width, height, new_width, new_height);
+}
+
+std::vector<uint16_t> downsample_2x2_sum(const std::vector<uint16_t>& image, int width, int height, int& new_width,
+                                         int& new_height) {
+    return downsample_sum(image, width, height, new_width, new_height);
+}
+
+double psnr_from_moments(const LumaMoments& moments) {
+    double mse = static_cast<double>(moments.sse) / static_cast<double>(moments.count);
+    if (mse == 0.0) {
+        // Frames are identical, return a high value
+        return 100.0;
+    }
+    return 20.0 * std::log10(255.0 / std::sqrt(mse));
+}
+
+double ssim_from_moments(const LumaMoments& moments, int frac_bits) {
+    // SSIM constants for 8-bit luma, on the scale of the fixed-point samples
+    const double L = 255.0 * static_cast<double>(1 << frac_bits);
+    const double C1 = (0.01 * L) * (0.01 * L);
+    const double C2 = (0.03 * L) * (0.03 * L);
+
+    double n = static_cast<double>(moments.count);
+    double mean1 = static_cast<double>(moments.sum_ref) / n;
+    double mean2 = static_cast<double>(moments.sum_dist) / n;
+    double var1 = n > 1.0 ? (static_cast<double>(moments.sum_ref_sq) - n * mean1 * mean1) / (n - 1.0) : 0.0;
+    double var2 = n > 1.0 ? (static_cast<double>(moments.sum_dist_sq) - n * mean2 * mean2) / (n - 1.0) : 0.0;
+    double covar = n > 1.0 ? (static_cast<double>(moments.sum_cross) - n * mean1 * mean2) / (n - 1.0) : 0.0;
+
     double numerator = (2 * mean1 * mean2 + C1) * (2 * covar + C2);
     double denominator = (mean1 * mean1 + mean2 * mean2 + C1) * (var1 + var2 + C2);
-    
+
     if (denominator == 0.0) {
         return 1.0;  // Identical images
     }
-    
     return numerator / denominator;
 }
 
+double ssim_y(const std::vector<uint8_t>& ref_y, const std::vector<uint8_t>& dist_y, int width, int height) {
+    if (ref_y.size() != dist_y.size() || ref_y.size() != static_cast<size_t>(width * height)) {
+        throw std::invalid_argument("Frame sizes do not match or invalid dimensions");
+    }
+    return ssim_from_moments(luma_moments(ref_y.data(), dist_y.data(), width, height, nullptr, nullptr));
+}
+
+namespace {
+
+// Integer SSIM of one 8x8 window from its sums, in Q30 fixed point.
+// With N = 64 pixels, means are s/N and sample (co)variances are (N*s12 - s1*s2) / (N*(N-1)), so
+// scaling the luminance term by N^2 and the contrast-structure term by N*(N-1) keeps everything
+// integral. Constants are C1 = (0.01*255)^2 * N^2 and C2 = (0.03*255)^2 * N*(N-1), rounded.
+// Magnitudes stay below 2^57, so every product fits in int64.
+int64_t window_ssim_fixed(int64_t s1, int64_t s2, int64_t ss, int64_t s12) {
+    const int64_t c1 = 26634;
+    const int64_t c2 = 235963;
+    int64_t vars = ss * 64 - s1 * s1 - s2 * s2;
+    int64_t covar = s12 * 64 - s1 * s2;
+    int64_t numerator = (2 * s1 * s2 + c1) * (2 * covar + c2);
+    int64_t denominator = (s1 * s1 + s2 * s2 + c1) * (vars + c2);
+
+    // Drop low bits of both terms until the denominator fits in 32 bits so the Q30 shift cannot overflow.
+    // |numerator| <= denominator, and integer division truncates toward zero.
+    while (denominator >= (int64_t{1} << 32)) {
+        numerator /= 2;
+        denominator /= 2;
+    }
+    return numerator * (int64_t{1} << kSsimFixedBits) / denominator;
+}
+
+} // namespace
+
+SsimFixedRows::SsimFixedRows(int width, int height)
+    : width_(width), blocks_x_(width / 4), blocks_y_(height / 4) {
+    if (width < 8 || height < 8) {
+        throw std::invalid_argument("Image too small for SSIM calculation (minimum 8x8 required)");
+    }
+    // Windows are 2x2 groups of 4x4 blocks, so each block row's sums are kept for the next row
+    const size_t columns = static_cast<size_t>(blocks_x_) * 4;
+    col_s1_.assign(columns, 0);
+    col_s2_.assign(columns, 0);
+    col_ss_.assign(columns, 0);
+    col_s12_.assign(columns, 0);
+    prev_.assign(4 * static_cast<size_t>(blocks_x_), 0);
+    curr_.assign(4 * static_cast<size_t>(blocks_x_), 0);
+}
+
+void SsimFixedRows::add_rows(const uint8_t* ref, const uint8_t* dist, int rows) {
+    const int columns = blocks_x_ * 4;
+    for (int r = 0; r < rows; ++r, ref += width_, dist += width_) {
+        // Rows below the last whole block row are not part of any window
+        if (block_row_ >= blocks_y_) {
+            continue;
+        }
+
+        // Column sums over the 4 rows of a block row: 16-bit lanes for pixel sums, 32-bit for products
+        uint16_t* s1 = col_s1_.data();
+        uint16_t* s2 = col_s2_.data();
+        uint32_t* ss = col_ss_.data();
+        uint32_t* s12 = col_s12_.data();
+        for (int x = 0; x < columns; ++x) {
+            uint32_t pa = ref[x];
+            uint32_t pb = dist[x];
+            s1[x] = static_cast<uint16_t>(s1[x] + pa);
+            s2[x] = static_cast<uint16_t>(s2[x] + pb);
+            ss[x] += pa * pa + pb * pb;
+            s12[x] += pa * pb;
+        }
+        if (++row_in_block_ == 4) {
+            finish_block_row();
+        }
+    }
+}
+
+void SsimFixedRows::finish_block_row() {
+    const int blocks_x = blocks_x_;
+    const uint16_t* s1 = col_s1_.data();
+    const uint16_t* s2 = col_s2_.data();
+    const uint32_t* ss = col_ss_.data();
+    const uint32_t* s12 = col_s12_.data();
+
+    // Reduce columns to blocks, stored as [s1, s2, ss, s12] planes of blocks_x entries
+    uint32_t* bs1 = curr_.data();
+    uint32_t* bs2 = bs1 + blocks_x;
+    uint32_t* bss = bs2 + blocks_x;
+    uint32_t* bs12 = bss + blocks_x;
+    for (int bx = 0; bx < blocks_x; ++bx) {
+        int x = bx * 4;
+        bs1[bx] = s1[x] + s1[x + 1] + s1[x + 2] + s1[x + 3];
+        bs2[bx] = s2[x] + s2[x + 1] + s2[x + 2] + s2[x + 3];
+        bss[bx] = ss[x] + ss[x + 1] + ss[x + 2] + ss[x + 3];
+        bs12[bx] = s12[x] + s12[x + 1] + s12[x + 2] + s12[x + 3];
+    }
+
+    if (block_row_ > 0) {
+        const uint32_t* ps1 = prev_.data();
+        const uint32_t* ps2 = ps1 + blocks_x;
+        const uint32_t* pss = ps2 + blocks_x;
+        const uint32_t* ps12 = pss + blocks_x;
+        for (int bx = 0; bx + 1 < blocks_x; ++bx) {
+            total_ += window_ssim_fixed(
+                int64_t{ps1[bx]} + ps1[bx + 1] + bs1[bx] + bs1[bx + 1],
+                int64_t{ps2[bx]} + ps2[bx + 1] + bs2[bx] + bs2[bx + 1],
+                int64_t{pss[bx]} + pss[bx + 1] + bss[bx] + bss[bx + 1],
+                int64_t{ps12[bx]} + ps12[bx + 1] + bs12[bx] + bs12[bx + 1]);
+        }
+    }
+    std::swap(prev_, curr_);
+
+    std::fill(col_s1_.begin(), col_s1_.end(), 0);
+    std::fill(col_s2_.begin(), col_s2_.end(), 0);
+    std::fill(col_ss_.begin(), col_ss_.end(), 0);
+    std::fill(col_s12_.begin(), col_s12_.end(), 0);
+    row_in_block_ = 0;
+    ++block_row_;
+}
+
+int64_t SsimFixedRows::finish() {
+    if (block_row_ < blocks_y_) {
+        reset();
+        throw std::invalid_argument("SSIM frame finished before all rows were added");
+    }
+    // Mean over windows, rounded half away from zero
+    int64_t total = total_;
+    int64_t windows = static_cast<int64_t>(blocks_x_ - 1) * (blocks_y_ - 1);
+    reset();
+    return total >= 0 ? (total + windows / 2) / windows : -((-total + windows / 2) / windows);
+}
+
+void SsimFixedRows::reset() {
+    std::fill(col_s1_.begin(), col_s1_.end(), 0);
+    std::fill(col_s2_.begin(), col_s2_.end(), 0);
+    std::fill(col_ss_.begin(), col_ss_.end(), 0);
+    std::fill(col_s12_.begin(), col_s12_.end(), 0);
+    row_in_block_ = 0;
+    block_row_ = 0;
+    total_ = 0;
+}
+
+int64_t ssim_y_fixed(const std::vector<uint8_t>& ref_y, const std::vector<uint8_t>& dist_y, int width, int height) {
+    if (ref_y.size() != dist_y.size() || ref_y.size() != static_cast<size_t>(width * height)) {
+        throw std::invalid_argument("Frame sizes do not match or invalid dimensions");
+    }
+    SsimFixedRows rows(width, height);
+    rows.add_rows(ref_y.data(), dist_y.data(), height);
+    return rows.finish();
+}
+
+double ssim_y_int(const std::vector<uint8_t>& ref_y, const std::vector<uint8_t>& dist_y, int width, int height) {
+    return static_cast<double>(ssim_y_fixed(ref_y, dist_y, width, height)) / static_cast<double>(int64_t{1} << kSsimFixedBits);
+}
+
 std::vector<uint8_t> downsample_2x2(const std::vector<uint8_t>& image, int width, int height, int& new_width, int& new_height) {
     new_width = width / 2;
     new_height = height / 2;
@@ -244,54 +486,176 @@ std::vector<uint8_t> downsample_2x2(const std::vector<uint8_t>& image, int width
     return downsampled;
 }
 
-double msssim_y(const std::vector<uint8_t>& ref_y, const std::vector<uint8_t>& dist_y, int width, int height) {
+std::vector<float> downsample_2x2(const std::vector<float>& image, int width, int height, int& new_width, int& new_height) {
+    new_width = width / 2;
+    new_height = height / 2;
+
+    if (new_width == 0 || new_height == 0) {
+        throw std::invalid_argument("Image too small for downsampling");
+    }
+
+    std::vector<float> downsampled(static_cast<size_t>(new_width) * new_height);
+    for (int y = 0; y < new_height; ++y) {
+        const float* row0 = image.data() + static_cast<size_t>(2 * y) * width;
+        const float* row1 = row0 + width;
+        float* out = downsampled.data() + static_cast<size_t>(y) * new_width;
+        for (int x = 0; x < new_width; ++x) {
+            out[x] = 0.25f * (row0[2 * x] + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1]);
+        }
+    }
+    return downsampled;
+}
+
+namespace {
+
+// MS-SSIM weights from Wang et al. paper
+const double kMsssimWeights[5] = {0.0448, 0.2856, 0.3001, 0.2363, 0.1333};
+
+} // namespace
+
+double msssim_y(const std::vector<uint8_t>& ref_y, const std::vector<uint8_t>& dist_y, int width, int height,
+                LumaMoments* full_res) {
     if (ref_y.size() != dist_y.size() || ref_y.size() != static_cast<size_t>(width * height)) {
         throw std::invalid_argument("Frame sizes do not match or invalid dimensions");
     }
     
-    // MS-SSIM weights from Wang et al. paper
-    const std::vector<double> weights = {0.0448, 0.2856, 0.3001, 0.2363, 0.1333};
     const int num_scales = 5;
     
     if (width < (1 << num_scales) || height < (1 << num_scales)) {
         throw std::invalid_argument("Image too small for MS-SSIM calculation with 5 scales");
     }
     
-    std::vector<std::vector<uint8_t>> ref_pyramid, dist_pyramid;
-    std::vector<int> widths, heights;
-    
-    // Build image pyramid
-    ref_pyramid.push_back(ref_y);
-    dist_pyramid.push_back(dist_y);
-    widths.push_back(width);
-    heights.push_back(height);
-    
-    for (int scale = 1; scale < num_scales; ++scale) {
-        int new_width, new_height;
-        auto ref_down = downsample_2x2(ref_pyramid[scale-1], widths[scale-1], heights[scale-1], new_width, new_height);
-        auto dist_down = downsample_2x2(dist_pyramid[scale-1], widths[scale-1], heights[scale-1], new_width, new_height);
-        
-        ref_pyramid.push_back(std::move(ref_down));
-        dist_pyramid.push_back(std::move(dist_down));
-        widths.push_back(new_width);
-        heights.push_back(new_height);
+    // Scales are scored fine to coarse as the pyramid is built: each sweep scores one scale and
+    // writes the next, so a level is only produced once every finer scale has been scored, and
+    // a non-positive SSIM returns before the next sweep. Levels keep the 2x2 sums, so scale k
+    // holds Q(2k) fixed point: nothing is rounded away and level 4 still fits 16 bits (255 * 4^4)
+    //
+    // Odd levels share one region of the thread's arena and even levels another, so a frame
+    // needs (w/2)(h/2) + (w/4)(h/4) samples per image and steady-state scoring does not allocate
+    const size_t odd_size = static_cast<size_t>(width / 2) * (height / 2);
+    const size_t even_size = static_cast<size_t>(width / 4) * (height / 4);
+    thread_local std::vector<uint16_t> arena;
+    if (arena.size() < 2 * (odd_size + even_size)) {
+        arena.resize(2 * (odd_size + even_size));
     }
-    
-    // For MS-SSIM, we need to compute contrast and structure components separately
-    // For now, use full SSIM at each scale and combine with product method
+    uint16_t* const ref_levels[2] = {arena.data() + 2 * odd_size, arena.data()};
+    uint16_t* const dist_levels[2] = {arena.data() + 2 * odd_size + even_size, arena.data() + odd_size};
+
+    int w = width;
+    int h = height;
     double ms_ssim = 1.0;
     
     for (int scale = 0; scale < num_scales; ++scale) {
-        double ssim_val = ssim_y(ref_pyramid[scale], dist_pyramid[scale], widths[scale], heights[scale]);
+        bool last = scale + 1 == num_scales;
+        uint16_t* ref_out = last ? nullptr : ref_levels[(scale + 1) % 2];
+        uint16_t* dist_out = last ? nullptr : dist_levels[(scale + 1) % 2];
+        auto moments = scale == 0 ? luma_moments(ref_y.data(), dist_y.data(), w, h, ref_out, dist_out)
+                                  : luma_moments(ref_levels[scale % 2], dist_levels[scale % 2], w, h, ref_out, dist_out);
+        if (scale == 0 && full_res) {
+            *full_res = moments;
+        }
+        
+        double ssim_val = ssim_from_moments(moments, 2 * scale);
         
         if (ssim_val <= 0.0) {
             return 0.0;  // Avoid negative values in power calculation
         }
         
-        ms_ssim *= std::pow(ssim_val, weights[scale]);
+        ms_ssim *= std::pow(ssim_val, kMsssimWeights[scale]);
+        w /= 2;
+        h /= 2;
     }
     
     return ms_ssim;
 }
 
+MsssimRows::MsssimRows(int width, int height) : height_(height) {
+    if (width < (1 << kScales) || height < (1 << kScales)) {
+        throw std::invalid_argument("Image too small for MS-SSIM calculation with 5 scales");
+    }
+    for (int k = 0; k < kScales; ++k) {
+        levels_[k].width = width >> k;
+        levels_[k].pending_ref.resize(levels_[k].width);
+        levels_[k].pending_dist.resize(levels_[k].width);
+        levels_[k].next_ref.resize(levels_[k].width / 2);
+        levels_[k].next_dist.resize(levels_[k].width / 2);
+    }
+}
+
+void MsssimRows::add_rows(const uint8_t* ref, const uint8_t* dist, int rows) {
+    const int width = levels_[0].width;
+    for (int r = 0; r < rows; ++r) {
+        add_row(0, ref + static_cast<size_t>(r) * width, dist + static_cast<size_t>(r) * width);
+    }
+}
+
+template <typename Sample>
+void MsssimRows::add_row(int scale, const Sample* ref, const Sample* dist) {
+    Level& level = levels_[scale];
+    LumaMoments row = luma_moments(ref, dist, level.width, 1, nullptr, nullptr);
+    level.moments.count += row.count;
+    level.moments.sse += row.sse;
+    level.moments.sum_ref += row.sum_ref;
+    level.moments.sum_dist += row.sum_dist;
+    level.moments.sum_ref_sq += row.sum_ref_sq;
+    level.moments.sum_dist_sq += row.sum_dist_sq;
+    level.moments.sum_cross += row.sum_cross;
+    if (scale + 1 == kScales) {
+        return;
+    }
+
+    // Rows pair up into the next level as they complete, exactly as the whole-frame sweep does
+    if (!level.has_pending) {
+        std::copy(ref, ref + level.width, level.pending_ref.begin());
+        std::copy(dist, dist + level.width, level.pending_dist.begin());
+        level.has_pending = true;
+        return;
+    }
+    level.has_pending = false;
+    int half = level.width / 2;
+    for (int x = 0; x < half; ++x) {
+        level.next_ref[x] = static_cast<uint16_t>(level.pending_ref[2 * x] + level.pending_ref[2 * x + 1] +
+                                                  static_cast<uint32_t>(ref[2 * x]) + ref[2 * x + 1]);
+        level.next_dist[x] = static_cast<uint16_t>(level.pending_dist[2 * x] + level.pending_dist[2 * x + 1] +
+                                                   static_cast<uint32_t>(dist[2 * x]) + dist[2 * x + 1]);
+    }
+    add_row(scale + 1, level.next_ref.data(), level.next_dist.data());
+}
+
+double MsssimRows::finish(LumaMoments* full_res) {
+    if (levels_[0].moments.count != static_cast<uint64_t>(levels_[0].width) * height_) {
+        reset();
+        throw std::invalid_argument("MS-SSIM frame finished before all rows were added");
+    }
+    if (full_res) {
+        *full_res = levels_[0].moments;
+    }
+    double ms_ssim = 1.0;
+    for (int scale = 0; scale < kScales; ++scale) {
+        double ssim_val = ssim_from_moments(levels_[scale].moments, 2 * scale);
+        if (ssim_val <= 0.0) {
+            ms_ssim = 0.0;  // Avoid negative values in power calculation
+            break;
+        }
+        ms_ssim *= std::pow(ssim_val, kMsssimWeights[scale]);
+    }
+    reset();
+    return ms_ssim;
+}
+
+void MsssimRows::reset() {
+    for (auto& level : levels_) {
+        level.moments = LumaMoments();
+        level.has_pending = false;
+    }
+}
+
+size_t msssim_scratch_bytes(int width, int height) {
+    size_t pixels = static_cast<size_t>(width) * static_cast<size_t>(height);
+
+    // The fused kernel needs no full-resolution planes; each thread keeps one 16-bit arena
+    // holding an odd and an even pyramid level for both ref and dist
+    return 2 * sizeof(uint16_t) * (pixels / 4 + pixels / 16);
+}
+
 } // namespace rdmeter
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <cmath>
 #include <limits>
@@ -10,21 +12,148 @@ namespace rdmeter {
 // Returns PSNR in dB, or a large value if frames are identical
 double psnr_y(const std::vector<uint8_t>& ref_y, const std::vector<uint8_t>& dist_y, int width, int height);
 
+// PSNR for high bit depth luma with MAX_VAL = 2^bit_depth - 1
+double psnr_y16(const std::vector<uint16_t>& ref_y, const std::vector<uint16_t>& dist_y, int width, int height, int bit_depth);
+
 // Generate 1D Gaussian kernel for SSIM calculation
 std::vector<double> generate_gaussian_kernel(int size, double sigma);
 
 // Apply 2D Gaussian filter to image for SSIM local statistics
 std::vector<double> apply_gaussian_filter(const std::vector<uint8_t>& image, int width, int height, const std::vector<double>& kernel);
 
+// Float-plane variant for metrics working on continuous values (e.g. SSIMULACRA2's XYB planes)
+// Same symmetric padding; the passes are written lane-parallel over x so they vectorise
+std::vector<float> apply_gaussian_filter(const std::vector<float>& image, int width, int height, const std::vector<double>& kernel);
+
 // Calculate single-scale SSIM for the luma (Y) component between two frames
 // Returns SSIM value between 0 and 1, where 1 indicates perfect similarity
 double ssim_y(const std::vector<uint8_t>& ref_y, const std::vector<uint8_t>& dist_y, int width, int height);
 
+// Fractional bits of ssim_y_fixed results
+constexpr int kSsimFixedBits = 30;
+
+// Integer-only SSIM over 8x8 windows on a 4-pixel grid, bit-identical on every platform
+// Each window's SSIM is computed exactly in 64-bit integers and truncated to Q30; the result is
+// the mean over all windows rounded half away from zero. Requires at least 8x8 pixels.
+int64_t ssim_y_fixed(const std::vector<uint8_t>& ref_y, const std::vector<uint8_t>& dist_y, int width, int height);
+
+// ssim_y_fixed fed rows top to bottom, for streaming; finish() gives the same result as
+// ssim_y_fixed over the whole frame once every row has been added
+class SsimFixedRows {
+public:
+    // Throws std::invalid_argument for frames under 8x8
+    SsimFixedRows(int width, int height);
+
+    // Add the next `rows` rows of width pixels each (contiguous)
+    void add_rows(const uint8_t* ref, const uint8_t* dist, int rows);
+
+    // Q30 SSIM of the frame; resets for the next frame. Throws if rows are missing
+    int64_t finish();
+
+    // Drop a partly added frame
+    void reset();
+
+private:
+    void finish_block_row();
+
+    int width_;
+    int blocks_x_;
+    int blocks_y_;
+    int row_in_block_ = 0;
+    int block_row_ = 0;
+    int64_t total_ = 0;
+    std::vector<uint16_t> col_s1_, col_s2_;
+    std::vector<uint32_t> col_ss_, col_s12_;
+    std::vector<uint32_t> prev_, curr_;  // Block sums of the previous and current block row
+};
+
+// ssim_y_fixed as a double (exact conversion, so still deterministic)
+double ssim_y_int(const std::vector<uint8_t>& ref_y, const std::vector<uint8_t>& dist_y, int width, int height);
+
 // Downsample image by factor of 2 using 2x2 average pooling
 std::vector<uint8_t> downsample_2x2(const std::vector<uint8_t>& image, int width, int height, int& new_width, int& new_height);
 
+// Float-plane variant of downsample_2x2 (same output size, no rounding)
+std::vector<float> downsample_2x2(const std::vector<float>& image, int width, int height, int& new_width, int& new_height);
+
+// Frame-wide luma statistics: the squared error for PSNR and the moments of global SSIM
+struct LumaMoments {
+    uint64_t count = 0;
+    uint64_t sse = 0;
+    uint64_t sum_ref = 0;
+    uint64_t sum_dist = 0;
+    uint64_t sum_ref_sq = 0;
+    uint64_t sum_dist_sq = 0;
+    uint64_t sum_cross = 0;
+};
+
+// Fused luma kernel: one sweep over ref and dist that accumulates LumaMoments and, when
+// ref_half/dist_half are not null, writes the next pyramid level ((width/2) x (height/2)) as
+// 2x2 sums, i.e. the average with two more fractional bits. Rows are processed in pairs and
+// L1-sized column chunks, so each pixel is read from memory once
+LumaMoments luma_moments(const uint8_t* ref, const uint8_t* dist, int width, int height,
+                         uint16_t* ref_half, uint16_t* dist_half);
+
+// The same over a 16-bit fixed-point pyramid level; samples must be below 2^14 when the
+// next level is written so its sums fit 16 bits
+LumaMoments luma_moments(const uint16_t* ref, const uint16_t* dist, int width, int height,
+                         uint16_t* ref_half, uint16_t* dist_half);
+
+// 2x2 sums as written by luma_moments, for callers that build a pyramid without moments
+std::vector<uint16_t> downsample_2x2_sum(const std::vector<uint8_t>& image, int width, int height, int& new_width, int& new_height);
+std::vector<uint16_t> downsample_2x2_sum(const std::vector<uint16_t>& image, int width, int height, int& new_width, int& new_height);
+
+// PSNR of 8-bit luma from its moments (same result as psnr_y)
+double psnr_from_moments(const LumaMoments& moments);
+
+// Global-statistics SSIM from moments of 8-bit luma held with frac_bits fractional bits
+// (0 for 8-bit samples, as ssim_y; 2k for MS-SSIM pyramid level k)
+double ssim_from_moments(const LumaMoments& moments, int frac_bits = 0);
+
 // Calculate Multi-Scale SSIM for the luma (Y) component between two frames
 // Returns MS-SSIM value between 0 and 1, where 1 indicates perfect similarity
-double msssim_y(const std::vector<uint8_t>& ref_y, const std::vector<uint8_t>& dist_y, int width, int height);
+// full_res, if given, receives the full-resolution moments, so PSNR comes from the same sweep
+double msssim_y(const std::vector<uint8_t>& ref_y, const std::vector<uint8_t>& dist_y, int width, int height,
+                LumaMoments* full_res = nullptr);
+
+// msssim_y fed rows top to bottom, for streaming. Each pyramid level accumulates its moments
+// and forms the next level's rows from row pairs as they complete, so only the coarse tail of
+// the pyramid is left when the last row arrives; finish() equals msssim_y on the whole frame
+class MsssimRows {
+public:
+    // Throws std::invalid_argument for frames under 32x32
+    MsssimRows(int width, int height);
+
+    // Add the next `rows` rows of width pixels each (contiguous)
+    void add_rows(const uint8_t* ref, const uint8_t* dist, int rows);
+
+    // MS-SSIM of the frame (full_res as in msssim_y); resets for the next frame.
+    // Throws if rows are missing
+    double finish(LumaMoments* full_res = nullptr);
+
+    // Drop a partly added frame
+    void reset();
+
+private:
+    static constexpr int kScales = 5;
+
+    struct Level {
+        int width = 0;
+        LumaMoments moments;
+        bool has_pending = false;  // An unpaired row waits in pending_*
+        std::vector<uint16_t> pending_ref, pending_dist;
+        std::vector<uint16_t> next_ref, next_dist;  // Row handed to the next level
+    };
+
+    template <typename Sample>
+    void add_row(int scale, const Sample* ref, const Sample* dist);
+
+    int height_;
+    Level levels_[kScales];
+};
+
+// Heap bytes msssim_y keeps per thread for its pyramid (reused by later calls on that thread)
+// Used to size per-thread scratch when planning a memory budget
+size_t msssim_scratch_bytes(int width, int height);
 
 } // namespace rdmeter
\ No newline at end of file
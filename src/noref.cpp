@@ -0,0 +1,180 @@
+#include "noref.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cstdlib>
+#include <type_traits>
+#include <vector>
+
+namespace rdmeter {
+
+namespace {
+
+// Thresholds are given for 8-bit samples and scaled by 2^shift for deeper input
+constexpr int kBlurEdgeThreshold = 32;  // Minimum central difference of an edge
+constexpr int kBandMaxStep = 2;         // Largest step that still reads as a band edge
+constexpr int kBandMinRun = 8;          // Flat run needed either side of a band edge
+
+template <typename Sample>
+double blockiness_plane(const Sample* plane, int width, int height, int block_size, int shift) {
+    // Row sums fit 32 bits for 8-bit samples, which keeps the inner loops vectorisable
+    using Acc = typename std::conditional<sizeof(Sample) == 1, uint32_t, uint64_t>::type;
+    uint64_t boundary = 0, all = 0;
+    uint64_t boundary_count = 0, all_count = 0;
+
+    // Horizontal steps: every step of the row, then the ones that cross a vertical grid line
+    for (int y = 0; y < height; ++y) {
+        const Sample* row = plane + static_cast<size_t>(y) * width;
+        Acc row_sum = 0;
+        for (int x = 1; x < width; ++x) {
+            row_sum += static_cast<Acc>(std::abs(static_cast<int>(row[x]) - static_cast<int>(row[x - 1])));
+        }
+        Acc grid_sum = 0;
+        for (int x = block_size; x < width; x += block_size) {
+            grid_sum += static_cast<Acc>(std::abs(static_cast<int>(row[x]) - static_cast<int>(row[x - 1])));
+        }
+        all += row_sum;
+        boundary += grid_sum;
+        all_count += width - 1;
+        boundary_count += (width - 1) / block_size;
+    }
+
+    // Vertical steps between rows y - 1 and y; the whole row pair lies on or off a horizontal grid line
+    for (int y = 1; y < height; ++y) {
+        const Sample* prev = plane + static_cast<size_t>(y - 1) * width;
+        const Sample* row = prev + width;
+        Acc row_sum = 0;
+        for (int x = 0; x < width; ++x) {
+            row_sum += static_cast<Acc>(std::abs(static_cast<int>(row[x]) - static_cast<int>(prev[x])));
+        }
+        all += row_sum;
+        all_count += width;
+        if (y % block_size == 0) {
+            boundary += row_sum;
+            boundary_count += width;
+        }
+    }
+
+    uint64_t interior = all - boundary;
+    uint64_t interior_count = all_count - boundary_count;
+    // One code value of slack keeps flat frames at 1 instead of 0/0
+    double epsilon = static_cast<double>(1 << shift);
+    double boundary_mean = static_cast<double>(boundary) / static_cast<double>(boundary_count);
+    double interior_mean = interior_count > 0 ? static_cast<double>(interior) / static_cast<double>(interior_count) : 0.0;
+    return (boundary_mean + epsilon) / (interior_mean + epsilon);
+}
+
+template <typename Sample>
+double blur_plane(const Sample* plane, int width, int height, int shift) {
+    const int threshold = kBlurEdgeThreshold << shift;
+    std::vector<int32_t> gradient(width, 0);
+    uint64_t width_sum = 0, edges = 0;
+
+    for (int y = 0; y < height; ++y) {
+        const Sample* row = plane + static_cast<size_t>(y) * width;
+        for (int x = 1; x + 1 < width; ++x) {
+            gradient[x] = static_cast<int32_t>(row[x + 1]) - static_cast<int32_t>(row[x - 1]);
+        }
+
+        for (int x = 1; x + 1 < width; ++x) {
+            // An edge is the last pixel of a local maximum of gradient magnitude
+            int32_t magnitude = std::abs(gradient[x]);
+            if (magnitude < threshold || magnitude < std::abs(gradient[x - 1]) || magnitude <= std::abs(gradient[x + 1])) {
+                continue;
+            }
+            // Walk out to the intensity extrema on both sides of the edge
+            int direction = gradient[x] > 0 ? 1 : -1;
+            int left = x, right = x;
+            while (left > 0 && direction * (static_cast<int>(row[left]) - static_cast<int>(row[left - 1])) > 0) {
+                --left;
+            }
+            while (right + 1 < width && direction * (static_cast<int>(row[right + 1]) - static_cast<int>(row[right])) > 0) {
+                ++right;
+            }
+            width_sum += static_cast<uint64_t>(right - left);
+            ++edges;
+        }
+    }
+    return edges > 0 ? static_cast<double>(width_sum) / static_cast<double>(edges) : 0.0;
+}
+
+template <typename Sample>
+double banding_plane(const Sample* plane, int width, int height, int shift) {
+    const int max_step = kBandMaxStep << shift;
+    uint64_t contours = 0;
+
+    // Along rows: a small step after a long flat run is pending until the next run is long too
+    for (int y = 0; y < height; ++y) {
+        const Sample* row = plane + static_cast<size_t>(y) * width;
+        int run = 1;
+        bool pending = false;
+        for (int x = 1; x < width; ++x) {
+            int step = static_cast<int>(row[x]) - static_cast<int>(row[x - 1]);
+            if (step == 0) {
+                ++run;
+                if (pending && run == kBandMinRun) {
+                    ++contours;
+                    pending = false;
+                }
+            } else {
+                pending = run >= kBandMinRun && std::abs(step) <= max_step;
+                run = 1;
+            }
+        }
+    }
+
+    // Along columns, one row at a time with per-column state so rows are read in order
+    std::vector<int32_t> run(width, 1);
+    std::vector<uint8_t> pending(width, 0);
+    for (int y = 1; y < height; ++y) {
+        const Sample* prev = plane + static_cast<size_t>(y - 1) * width;
+        const Sample* row = prev + width;
+        uint32_t row_contours = 0;
+        for (int x = 0; x < width; ++x) {
+            int step = static_cast<int>(row[x]) - static_cast<int>(prev[x]);
+            bool flat = step == 0;
+            int32_t length = flat ? run[x] + 1 : 1;
+            bool hit = flat && pending[x] && length == kBandMinRun;
+            bool starts = !flat && run[x] >= kBandMinRun && std::abs(step) <= max_step;
+            pending[x] = static_cast<uint8_t>(flat ? pending[x] && !hit : starts);
+            run[x] = length;
+            row_contours += hit;
+        }
+        contours += row_contours;
+    }
+
+    return 100.0 * static_cast<double>(contours) / (static_cast<double>(width) * height);
+}
+
+} // namespace
+
+double blockiness_y(const YUVFrame& frame, int block_size) {
+    if (block_size < 2) {
+        throw std::invalid_argument("Block size must be at least 2");
+    }
+    if (frame.width < 2 * block_size || frame.height < 2 * block_size) {
+        throw std::invalid_argument("Image too small for blockiness calculation (minimum two blocks in each direction)");
+    }
+    if (frame.bit_depth > 8) {
+        return blockiness_plane(frame.y16.data(), frame.width, frame.height, block_size, frame.bit_depth - 8);
+    }
+    return blockiness_plane(frame.y.data(), frame.width, frame.height, block_size, 0);
+}
+
+double blur_y(const YUVFrame& frame) {
+    if (frame.bit_depth > 8) {
+        return blur_plane(frame.y16.data(), frame.width, frame.height, frame.bit_depth - 8);
+    }
+    return blur_plane(frame.y.data(), frame.width, frame.height, 0);
+}
+
+double banding_y(const YUVFrame& frame) {
+    if (frame.width <= 0 || frame.height <= 0) {
+        throw std::invalid_argument("Invalid dimensions");
+    }
+    if (frame.bit_depth > 8) {
+        return banding_plane(frame.y16.data(), frame.width, frame.height, frame.bit_depth - 8);
+    }
+    return banding_plane(frame.y.data(), frame.width, frame.height, 0);
+}
+
+} // namespace rdmeter
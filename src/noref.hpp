@@ -0,0 +1,23 @@
+#pragma once
+
+#include "yuv_reader.hpp"
+
+namespace rdmeter {
+
+// No-reference artifact detectors. Each scores the luma plane of a single frame, at its
+// native bit depth, so they can run on the distorted stream alone
+
+// Mean absolute luma step across block_size grid lines divided by the mean step inside blocks
+// About 1 for unblocked content and higher for visible block edges; 8 for DCT blocks, 64 for CTUs
+// Throws std::invalid_argument for frames smaller than two blocks in either direction
+double blockiness_y(const YUVFrame& frame, int block_size);
+
+// Mean width in pixels of horizontal-gradient edges, measured between the intensity extrema
+// either side of each edge (Marziliano et al.). Wider means blurrier; 0 when there are no edges
+double blur_y(const YUVFrame& frame);
+
+// Percentage of pixels on a false contour: a step of at most two 8-bit code values between
+// two flat runs of at least 8 pixels, counted along both rows and columns
+double banding_y(const YUVFrame& frame);
+
+} // namespace rdmeter
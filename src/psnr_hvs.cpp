@@ -0,0 +1,203 @@
+#include "psnr_hvs.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace rdmeter {
+
+namespace {
+
+// JPEG luminance quantisation table (ITU-T T.81 Annex K), row = vertical frequency.
+// Ponomarenko et al. derive both PSNR-HVS-M tables from it: CSF = 25.73509 / Q and MaskCof = (10 / Q)^2
+constexpr int kJpegLuma[64] = {
+    16, 11, 10, 16, 24, 40, 51, 61,
+    12, 12, 14, 19, 26, 58, 60, 55,
+    14, 13, 16, 24, 40, 57, 69, 56,
+    14, 17, 22, 29, 51, 87, 80, 62,
+    18, 22, 37, 56, 68, 109, 103, 77,
+    24, 35, 55, 64, 81, 104, 113, 92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103, 99
+};
+
+struct HvsTables {
+    std::array<int32_t, 64> dct;       // Orthonormal DCT-II basis in Q12, [frequency][sample]
+    std::array<double, 64> csf_sq;     // Squared CSF weights
+    std::array<double, 64> mask_cof;   // Masking weights
+    std::array<double, 64> inv_mask;   // 1 / mask_cof, so thresholds cost a multiply
+};
+
+const HvsTables& hvs_tables() {
+    static const HvsTables tables = [] {
+        HvsTables t{};
+        const double pi = 3.14159265358979323846;
+        for (int u = 0; u < 8; ++u) {
+            double scale = u == 0 ? std::sqrt(0.125) : 0.5;
+            for (int x = 0; x < 8; ++x) {
+                t.dct[u * 8 + x] = static_cast<int32_t>(std::lround(4096.0 * scale * std::cos((2 * x + 1) * u * pi / 16.0)));
+            }
+        }
+        for (int i = 0; i < 64; ++i) {
+            double csf = 25.73509 / kJpegLuma[i];
+            t.csf_sq[i] = csf * csf;
+            t.mask_cof[i] = (10.0 / kJpegLuma[i]) * (10.0 / kJpegLuma[i]);
+            t.inv_mask[i] = 1.0 / t.mask_cof[i];
+        }
+        return t;
+    }();
+    return tables;
+}
+
+// Sum of squared deviations scaled by n / (n - 1), i.e. MATLAB's var(z(:)) * numel(z)
+double block_variance(const uint8_t* src, ptrdiff_t stride, int x0, int y0, int size) {
+    int64_t sum = 0;
+    int64_t sum_sq = 0;
+    for (int y = y0; y < y0 + size; ++y) {
+        for (int x = x0; x < x0 + size; ++x) {
+            int v = src[y * stride + x];
+            sum += v;
+            sum_sq += v * v;
+        }
+    }
+    double n = static_cast<double>(size * size);
+    double ssd = static_cast<double>(sum_sq) - static_cast<double>(sum) * static_cast<double>(sum) / n;
+    return ssd * n / (n - 1.0);
+}
+
+// Masking strength of a block: AC energy weighted by MaskCof, scaled by how much of the
+// block's variance survives splitting it into quadrants (low for edges, high for texture)
+double block_masking(const uint8_t* src, ptrdiff_t stride, const double* coefficients, const HvsTables& t) {
+    double energy = 0.0;
+    for (int i = 1; i < 64; ++i) {
+        energy += coefficients[i] * coefficients[i] * t.mask_cof[i];
+    }
+    double whole = block_variance(src, stride, 0, 0, 8);
+    double ratio = 0.0;
+    if (whole != 0.0) {
+        ratio = (block_variance(src, stride, 0, 0, 4) + block_variance(src, stride, 4, 0, 4) +
+                 block_variance(src, stride, 0, 4, 4) + block_variance(src, stride, 4, 4, 4)) / whole;
+    }
+    return std::sqrt(energy * ratio) / 32.0;
+}
+
+} // namespace
+
+void dct8x8_int(const uint8_t* src, ptrdiff_t stride, int32_t out[64]) {
+    const int32_t* basis = hvs_tables().dct.data();
+
+    // Vertical pass, eight columns per lane group: tmp[u][x] = sum_y basis[u][y] * src[y][x], kept in Q3
+    int32_t tmp[64];
+    for (int u = 0; u < 8; ++u) {
+        int32_t acc[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        for (int y = 0; y < 8; ++y) {
+            const int32_t c = basis[u * 8 + y];
+            const uint8_t* row = src + y * stride;
+            for (int x = 0; x < 8; ++x) {
+                acc[x] += c * row[x];
+            }
+        }
+        for (int x = 0; x < 8; ++x) {
+            tmp[x * 8 + u] = (acc[x] + (1 << 8)) >> 9;  // stored transposed for the second pass
+        }
+    }
+
+    // Horizontal pass on the transposed block: out[u][v] = sum_x basis[v][x] * tmp[x][u]
+    for (int v = 0; v < 8; ++v) {
+        int32_t acc[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        for (int x = 0; x < 8; ++x) {
+            const int32_t c = basis[v * 8 + x];
+            for (int u = 0; u < 8; ++u) {
+                acc[u] += c * tmp[x * 8 + u];
+            }
+        }
+        for (int u = 0; u < 8; ++u) {
+            out[u * 8 + v] = (acc[u] + (1 << 11)) >> 12;
+        }
+    }
+}
+
+HvsError hvs_plane_error(const uint8_t* ref, const uint8_t* dist, int width, int height, ptrdiff_t stride) {
+    if (width < 8 || height < 8) {
+        throw std::invalid_argument("Plane too small for PSNR-HVS (minimum 8x8 required)");
+    }
+
+    const HvsTables& t = hvs_tables();
+    const double q3 = 1.0 / 8.0;
+    double sum_hvs = 0.0;
+    double sum_hvs_m = 0.0;
+    size_t coefficients = 0;
+
+    int32_t ref_dct[64];
+    int32_t dist_dct[64];
+    double ref_coef[64];
+    double dist_coef[64];
+    for (int by = 0; by + 8 <= height; by += 8) {
+        for (int bx = 0; bx + 8 <= width; bx += 8) {
+            const uint8_t* a = ref + by * stride + bx;
+            const uint8_t* b = dist + by * stride + bx;
+            dct8x8_int(a, stride, ref_dct);
+            dct8x8_int(b, stride, dist_dct);
+            for (int i = 0; i < 64; ++i) {
+                ref_coef[i] = ref_dct[i] * q3;
+                dist_coef[i] = dist_dct[i] * q3;
+            }
+
+            // Errors below the stronger block's masking threshold are invisible
+            double mask = std::max(block_masking(a, stride, ref_coef, t), block_masking(b, stride, dist_coef, t));
+            for (int i = 0; i < 64; ++i) {
+                double diff = std::abs(ref_coef[i] - dist_coef[i]);
+                sum_hvs += diff * diff * t.csf_sq[i];
+                if (i > 0) {
+                    double threshold = mask * t.inv_mask[i];
+                    diff = diff < threshold ? 0.0 : diff - threshold;
+                }
+                sum_hvs_m += diff * diff * t.csf_sq[i];
+            }
+            coefficients += 64;
+        }
+    }
+
+    HvsError error;
+    error.hvs = sum_hvs / coefficients;
+    error.hvs_m = sum_hvs_m / coefficients;
+    return error;
+}
+
+HvsError hvs_frame_error(const YUVFrame& ref, const YUVFrame& dist) {
+    if (ref.width != dist.width || ref.height != dist.height || ref.bit_depth != 8 || dist.bit_depth != 8) {
+        throw std::invalid_argument("PSNR-HVS needs two 8-bit frames of the same size");
+    }
+
+    HvsError luma = hvs_plane_error(ref.y.data(), dist.y.data(), ref.width, ref.height, ref.width);
+    HvsError error = {0.8 * luma.hvs, 0.8 * luma.hvs_m};
+    double weight = 0.8;
+    int chroma_width = ref.width / 2;
+    int chroma_height = ref.height / 2;
+    if (chroma_width >= 8 && chroma_height >= 8) {
+        for (auto plane : {&YUVFrame::u, &YUVFrame::v}) {
+            HvsError chroma = hvs_plane_error((ref.*plane).data(), (dist.*plane).data(), chroma_width, chroma_height, chroma_width);
+            error.hvs += 0.1 * chroma.hvs;
+            error.hvs_m += 0.1 * chroma.hvs_m;
+        }
+        weight = 1.0;
+    }
+    error.hvs /= weight;
+    error.hvs_m /= weight;
+    return error;
+}
+
+double psnr_hvs_from_error(double mse) {
+    if (mse == 0.0) {
+        // Frames are identical, return a high value
+        return 100.0;
+    }
+    return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+double psnr_hvs_yuv(const YUVFrame& ref, const YUVFrame& dist, bool masked) {
+    HvsError error = hvs_frame_error(ref, dist);
+    return psnr_hvs_from_error(masked ? error.hvs_m : error.hvs);
+}
+
+} // namespace rdmeter
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "yuv_reader.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace rdmeter {
+
+// Forward 8x8 DCT-II (orthonormal) of an 8-bit block in integer arithmetic
+// Coefficients are written row-major with vertical frequency as the row, in Q3 (8x the true value)
+void dct8x8_int(const uint8_t* src, ptrdiff_t stride, int32_t out[64]);
+
+// CSF-weighted DCT error of one plane over non-overlapping 8x8 blocks
+// Both values are mean squared errors per coefficient; partial blocks at the edges are skipped
+struct HvsError {
+    double hvs = 0.0;    // PSNR-HVS: contrast sensitivity weighting only
+    double hvs_m = 0.0;  // PSNR-HVS-M: with between-coefficient contrast masking
+};
+
+// Throws std::invalid_argument for planes smaller than one block
+HvsError hvs_plane_error(const uint8_t* ref, const uint8_t* dist, int width, int height, ptrdiff_t stride);
+
+// Both errors of an 8-bit 4:2:0 frame from one DCT pass, plane errors combined as
+// 0.8 Y + 0.1 Cb + 0.1 Cr. Chroma planes smaller than one block are left out and luma
+// weighs alone. Throws std::invalid_argument for luma smaller than one block
+HvsError hvs_frame_error(const YUVFrame& ref, const YUVFrame& dist);
+
+// A frame error from hvs_frame_error in dB; 100 for identical frames
+double psnr_hvs_from_error(double mse);
+
+// PSNR-HVS (masked = false) or PSNR-HVS-M (masked = true) of an 8-bit 4:2:0 frame
+double psnr_hvs_yuv(const YUVFrame& ref, const YUVFrame& dist, bool masked);
+
+} // namespace rdmeter
@@ -0,0 +1,209 @@
+#include "results_cache.hpp"
+#include "build_id.hpp"
+#include "third_party/json.hpp"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace rdmeter {
+
+namespace {
+
+constexpr int kCacheVersion = 2;
+
+constexpr uint64_t kPrime1 = 11400714785074694791ull;
+constexpr uint64_t kPrime2 = 14029467366897019727ull;
+constexpr uint64_t kPrime3 = 1609587929392839161ull;
+constexpr uint64_t kPrime4 = 9650029242287828579ull;
+constexpr uint64_t kPrime5 = 2870177450012600261ull;
+
+uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint64_t round64(uint64_t acc, uint64_t input) {
+    acc += input * kPrime2;
+    return rotl(acc, 31) * kPrime1;
+}
+
+uint64_t merge64(uint64_t acc, uint64_t lane) {
+    acc ^= round64(0, lane);
+    return acc * kPrime1 + kPrime4;
+}
+
+std::string hex64(uint64_t value) {
+    static const char digits[] = "0123456789abcdef";
+    std::string text(16, '0');
+    for (int i = 15; i >= 0; --i, value >>= 4) {
+        text[i] = digits[value & 15];
+    }
+    return text;
+}
+
+} // namespace
+
+uint64_t xxh64(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint8_t* end = p + size;
+    uint64_t h;
+
+    // Four independent lanes over 32-byte stripes
+    if (size >= 32) {
+        uint64_t v1 = seed + kPrime1 + kPrime2;
+        uint64_t v2 = seed + kPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - kPrime1;
+        const uint8_t* limit = end - 32;
+        do {
+            v1 = round64(v1, read64(p));
+            v2 = round64(v2, read64(p + 8));
+            v3 = round64(v3, read64(p + 16));
+            v4 = round64(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge64(h, v1);
+        h = merge64(h, v2);
+        h = merge64(h, v3);
+        h = merge64(h, v4);
+    } else {
+        h = seed + kPrime5;
+    }
+    h += static_cast<uint64_t>(size);
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= round64(0, read64(p));
+        h = rotl(h, 27) * kPrime1 + kPrime4;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<uint64_t>(read32(p)) * kPrime1;
+        h = rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= *p * kPrime5;
+        h = rotl(h, 11) * kPrime1;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t hash_file(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open file for hashing: " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Failed to stat file for hashing: " + path);
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+        ::close(fd);
+        return xxh64(nullptr, 0);
+    }
+    void* base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        throw std::runtime_error("Failed to map file " + path + ": " + std::strerror(errno));
+    }
+    madvise(base, size, MADV_SEQUENTIAL);
+    uint64_t hash = xxh64(base, size);
+    munmap(base, size);
+    return hash;
+}
+
+std::string file_fingerprint(const std::string& path, CacheTrust trust) {
+    std::string size = std::to_string(fs::file_size(path));
+    if (trust == CacheTrust::SizeMtime) {
+        auto mtime = fs::last_write_time(path).time_since_epoch().count();
+        return fs::absolute(path).lexically_normal().string() + ":" + size + ":" + std::to_string(mtime);
+    }
+    return size + ":" + hex64(hash_file(path));
+}
+
+ResultsCache::ResultsCache(std::string directory) : directory_(std::move(directory)) {}
+
+std::string ResultsCache::entry_path(const std::string& key) const {
+    std::string built = key + "\n" + RDMETER_BUILD_ID;
+    std::string digest = hex64(xxh64(built.data(), built.size()));
+    // Entries are spread over subdirectories so none grows too large
+    return (fs::path(directory_) / digest.substr(0, 2) / (digest + ".json")).string();
+}
+
+bool ResultsCache::load(const std::string& key, CachedResults& results) const {
+    std::ifstream in(entry_path(key));
+    if (!in) {
+        return false;
+    }
+    try {
+        auto j = nlohmann::json::parse(in);
+        if (j.at("version").get<int>() != kCacheVersion ||
+            j.at("build").get<std::string>() != RDMETER_BUILD_ID ||
+            j.at("key").get<std::string>() != key) {
+            return false;
+        }
+        results.results = j.at("results").dump(4);
+        results.per_frame = j.at("per_frame").get<std::string>();
+    } catch (const nlohmann::json::exception&) {
+        return false;
+    }
+    return true;
+}
+
+void ResultsCache::store(const std::string& key, const CachedResults& results) const {
+    nlohmann::json j = {
+        {"version", kCacheVersion},
+        {"build", RDMETER_BUILD_ID},
+        {"key", key},
+        {"results", nlohmann::json::parse(results.results)},
+        {"per_frame", results.per_frame}
+    };
+
+    fs::path target(entry_path(key));
+    fs::create_directories(target.parent_path());
+
+    // Runs sharing the cache may store the same entry at once, so each writes its own temporary
+    std::string temp_path = target.string() + ".tmp" + std::to_string(::getpid());
+    {
+        std::ofstream out(temp_path, std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Failed to open cache file: " + temp_path);
+        }
+        out << j.dump(4);
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("Failed to write cache file: " + temp_path);
+        }
+    }
+    fs::rename(temp_path, target);
+}
+
+} // namespace rdmeter
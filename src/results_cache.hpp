@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace rdmeter {
+
+// XXH64 of a buffer
+uint64_t xxh64(const void* data, size_t size, uint64_t seed = 0);
+
+// XXH64 of a whole file, read through a memory map. Throws std::runtime_error if it cannot be read
+uint64_t hash_file(const std::string& path);
+
+// How a cache key identifies an input file
+enum class CacheTrust {
+    Content,   // Size and hash of the contents; reads the whole file
+    SizeMtime  // Absolute path, size and modification time; trusts that files are not rewritten in place
+};
+
+// Identity of an input file within a cache key
+std::string file_fingerprint(const std::string& path, CacheTrust trust);
+
+// What a cached compute run produced
+struct CachedResults {
+    std::string results;    // The results JSON
+    std::string per_frame;  // Per-frame JSON lines, empty if the run wrote none
+};
+
+// A directory of compute results, one file per key. A key is the text of everything the
+// results depend on: input fingerprints and metric settings. Entries are also tied to a
+// digest of the sources and toolchain of the build, so an rdmeter built from changed code
+// never returns results of an older one
+class ResultsCache {
+public:
+    explicit ResultsCache(std::string directory);
+
+    // File holding the entry of key
+    std::string entry_path(const std::string& key) const;
+
+    // The results stored under key, or false if there are none. An unreadable entry, or
+    // one whose stored key differs (a digest collision), is a miss
+    bool load(const std::string& key, CachedResults& results) const;
+
+    // Write an entry atomically (temporary file then rename), so runs sharing the
+    // directory never read a partial entry
+    void store(const std::string& key, const CachedResults& results) const;
+
+private:
+    std::string directory_;
+};
+
+} // namespace rdmeter
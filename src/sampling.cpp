@@ -0,0 +1,193 @@
+#include "sampling.hpp"
+#include "metrics.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace rdmeter {
+
+StratifiedSampler::StratifiedSampler(int total_frames, uint64_t seed)
+    : used_(static_cast<size_t>(std::max(0, total_frames)), false), rng_(seed) {}
+
+std::vector<int> StratifiedSampler::next_batch(int count) {
+    std::vector<int> batch;
+    int total_frames = total();
+    count = std::min(count, total_frames - drawn_);
+    if (count <= 0) {
+        return batch;
+    }
+
+    for (int s = 0; s < count; ++s) {
+        int begin = static_cast<int>(static_cast<int64_t>(s) * total_frames / count);
+        int end = static_cast<int>(static_cast<int64_t>(s + 1) * total_frames / count);
+
+        // A random start within the stratum, then the next unused frame (wrapping inside the stratum)
+        int span = end - begin;
+        int start = begin + static_cast<int>(rng_.below(static_cast<uint64_t>(span)));
+        for (int k = 0; k < span; ++k) {
+            int frame = begin + (start - begin + k) % span;
+            if (!used_[frame]) {
+                used_[frame] = true;
+                batch.push_back(frame);
+                ++drawn_;
+                break;
+            }
+        }
+    }
+
+    std::sort(batch.begin(), batch.end());
+    return batch;
+}
+
+void RunningEstimate::add(double value) {
+    ++count;
+    double delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+}
+
+double RunningEstimate::variance() const {
+    return count > 1 ? m2 / (count - 1) : 0.0;
+}
+
+double RunningEstimate::ci_half_width(double confidence, int population_size) const {
+    if (count < 2) {
+        return std::numeric_limits<double>::infinity();
+    }
+    double fpc = population_size > 0 ? std::max(0.0, 1.0 - static_cast<double>(count) / population_size) : 1.0;
+    double standard_error = std::sqrt(variance() / count * fpc);
+    return student_t_quantile(confidence, count - 1) * standard_error;
+}
+
+double student_t_quantile(double confidence, int degrees_of_freedom) {
+    if (!(confidence > 0.0 && confidence < 1.0)) {
+        throw std::invalid_argument("Confidence must be in (0, 1)");
+    }
+    if (degrees_of_freedom < 1) {
+        throw std::invalid_argument("Degrees of freedom must be positive");
+    }
+
+    // Normal quantile for p = 1 - (1 - confidence) / 2 (Acklam's rational approximation, upper region)
+    double p = 1.0 - (1.0 - confidence) / 2.0;
+    double z;
+    if (p > 0.97575) {
+        double q = std::sqrt(-2.0 * std::log(1.0 - p));
+        z = -(((((-7.784894002430293e-03 * q - 3.223964580411365e-01) * q - 2.400758277161838e+00) * q -
+                2.549732539343734e+00) * q + 4.374664141464968e+00) * q + 2.938163982698783e+00) /
+            ((((7.784695709041462e-03 * q + 3.224671290700398e-01) * q + 2.445134137142996e+00) * q +
+              3.754408661907416e+00) * q + 1.0);
+    } else {
+        double q = p - 0.5;
+        double r = q * q;
+        z = (((((-3.969683028665376e+01 * r + 2.209460984245205e+02) * r - 2.759285104469687e+02) * r +
+               1.383577518672690e+02) * r - 3.066479806614716e+01) * r + 2.506628277459239e+00) * q /
+            (((((-5.447609879822406e+01 * r + 1.615858368580409e+02) * r - 1.556989798598866e+02) * r +
+               6.680131188771972e+01) * r - 1.328068155288572e+01) * r + 1.0);
+    }
+
+    double n = degrees_of_freedom;
+    double z3 = z * z * z;
+    double z5 = z3 * z * z;
+    double z7 = z5 * z * z;
+    return z + (z3 + z) / (4.0 * n) + (5.0 * z5 + 16.0 * z3 + 3.0 * z) / (96.0 * n * n) +
+           (3.0 * z7 + 19.0 * z5 + 17.0 * z3 - 15.0 * z) / (384.0 * n * n * n);
+}
+
+namespace {
+
+// Global-statistics SSIM (as in ssim_y) accumulated over a random subset of 8x8 windows
+// Samples are 8-bit luma with frac_bits fractional bits, as in the MS-SSIM pyramid
+template <typename Sample>
+double ssim_y_windows(const std::vector<Sample>& ref, const std::vector<Sample>& dist, int width, int height,
+                      int frac_bits, double fraction, SplitMix64& rng) {
+    const double L = 255.0 * static_cast<double>(1 << frac_bits);
+    const double C1 = (0.01 * L) * (0.01 * L);
+    const double C2 = (0.03 * L) * (0.03 * L);
+    const int block = 8;
+
+    int blocks_x = (width + block - 1) / block;
+    int blocks_y = (height + block - 1) / block;
+    int total_blocks = blocks_x * blocks_y;
+    int wanted = std::max(1, static_cast<int>(std::lround(fraction * total_blocks)));
+
+    // Stratify windows over the frame in raster order so coverage stays spatially even
+    StratifiedSampler windows(total_blocks, rng.next());
+    auto chosen = windows.next_batch(wanted);
+
+    double n = 0.0, s1 = 0.0, s2 = 0.0, s11 = 0.0, s22 = 0.0, s12 = 0.0;
+    for (int b : chosen) {
+        int x0 = (b % blocks_x) * block;
+        int y0 = (b / blocks_x) * block;
+        for (int y = y0; y < std::min(y0 + block, height); ++y) {
+            for (int x = x0; x < std::min(x0 + block, width); ++x) {
+                double a = ref[y * width + x];
+                double d = dist[y * width + x];
+                n += 1.0;
+                s1 += a;
+                s2 += d;
+                s11 += a * a;
+                s22 += d * d;
+                s12 += a * d;
+            }
+        }
+    }
+
+    double mean1 = s1 / n;
+    double mean2 = s2 / n;
+    double var1 = n > 1.0 ? (s11 - n * mean1 * mean1) / (n - 1.0) : 0.0;
+    double var2 = n > 1.0 ? (s22 - n * mean2 * mean2) / (n - 1.0) : 0.0;
+    double covar = n > 1.0 ? (s12 - n * mean1 * mean2) / (n - 1.0) : 0.0;
+
+    double numerator = (2 * mean1 * mean2 + C1) * (2 * covar + C2);
+    double denominator = (mean1 * mean1 + mean2 * mean2 + C1) * (var1 + var2 + C2);
+    return denominator == 0.0 ? 1.0 : numerator / denominator;
+}
+
+} // namespace
+
+double msssim_y_sampled(const std::vector<uint8_t>& ref_y, const std::vector<uint8_t>& dist_y, int width, int height,
+                        double fraction, uint64_t seed) {
+    if (ref_y.size() != dist_y.size() || ref_y.size() != static_cast<size_t>(width * height)) {
+        throw std::invalid_argument("Frame sizes do not match or invalid dimensions");
+    }
+    if (!(fraction > 0.0 && fraction <= 1.0)) {
+        throw std::invalid_argument("Window fraction must be in (0, 1]");
+    }
+
+    const std::vector<double> weights = {0.0448, 0.2856, 0.3001, 0.2363, 0.1333};
+    const int num_scales = 5;
+    if (width < (1 << num_scales) || height < (1 << num_scales)) {
+        throw std::invalid_argument("Image too small for MS-SSIM calculation with 5 scales");
+    }
+
+    SplitMix64 rng(seed);
+    // The same exact 16-bit fixed-point pyramid as msssim_y; scale k is Q(2k)
+    std::vector<uint16_t> ref, dist;
+    int w = width;
+    int h = height;
+    double ms_ssim = 1.0;
+
+    for (int scale = 0; scale < num_scales; ++scale) {
+        if (scale > 0) {
+            int new_width, new_height;
+            ref = scale == 1 ? downsample_2x2_sum(ref_y, w, h, new_width, new_height)
+                             : downsample_2x2_sum(ref, w, h, new_width, new_height);
+            dist = scale == 1 ? downsample_2x2_sum(dist_y, w, h, new_width, new_height)
+                              : downsample_2x2_sum(dist, w, h, new_width, new_height);
+            w = new_width;
+            h = new_height;
+        }
+
+        double ssim_val = scale == 0 ? ssim_y_windows(ref_y, dist_y, w, h, 0, fraction, rng)
+                                     : ssim_y_windows(ref, dist, w, h, 2 * scale, fraction, rng);
+        if (ssim_val <= 0.0) {
+            return 0.0;
+        }
+        ms_ssim *= std::pow(ssim_val, weights[scale]);
+    }
+
+    return ms_ssim;
+}
+
+} // namespace rdmeter
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace rdmeter {
+
+// Small deterministic PRNG (SplitMix64). Unlike std::uniform_int_distribution its
+// output is identical across standard libraries, so seeded runs are reproducible
+class SplitMix64 {
+public:
+    explicit SplitMix64(uint64_t seed) : state_(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform integer in [0, bound)
+    uint64_t below(uint64_t bound) { return bound == 0 ? 0 : next() % bound; }
+
+    // Uniform double in [0, 1)
+    double uniform() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+    uint64_t state_;
+};
+
+// Draws frame indices without replacement, one per equal-width stratum of the sequence,
+// so every batch covers the whole timeline rather than clustering in one scene
+class StratifiedSampler {
+public:
+    StratifiedSampler(int total_frames, uint64_t seed);
+
+    // Up to count new frame indices in ascending order (fewer once strata run out)
+    std::vector<int> next_batch(int count);
+
+    int drawn() const { return drawn_; }
+    int total() const { return static_cast<int>(used_.size()); }
+    bool exhausted() const { return drawn_ >= total(); }
+
+private:
+    std::vector<bool> used_;
+    int drawn_ = 0;
+    SplitMix64 rng_;
+};
+
+// Running mean and variance (Welford) of per-frame scores drawn from a finite population
+struct RunningEstimate {
+    int count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+
+    void add(double value);
+
+    // Sample variance, 0 for fewer than two values
+    double variance() const;
+
+    // Half-width of the two-sided confidence interval for the population mean,
+    // using Student's t and the finite population correction for population_size frames.
+    // Treats the stratified draw as a simple random sample, which is conservative
+    double ci_half_width(double confidence, int population_size) const;
+};
+
+// Quantile of Student's t distribution for a two-sided interval at the given confidence
+// (Cornish-Fisher expansion around the normal quantile; accurate to ~1e-3 for dof >= 3)
+double student_t_quantile(double confidence, int degrees_of_freedom);
+
+// MS-SSIM where the SSIM statistics at every scale are gathered from a random subset
+// of 8x8 windows covering roughly `fraction` of each level. fraction = 1 uses every pixel
+double msssim_y_sampled(const std::vector<uint8_t>& ref_y, const std::vector<uint8_t>& dist_y, int width, int height,
+                        double fraction, uint64_t seed);
+
+} // namespace rdmeter
@@ -0,0 +1,272 @@
+#include "shm_ring.hpp"
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+namespace rdmeter {
+
+namespace {
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "Futex words must be plain 32-bit integers");
+
+// Interval between checks where there is no futex, and while waiting for the segment to appear
+constexpr std::chrono::milliseconds kPollInterval{1};
+
+// POSIX shared-memory names are a single leading slash followed by the name
+std::string segment_name(const std::string& name) {
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+size_t round_up(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+std::runtime_error system_error(const std::string& what, const std::string& name) {
+    return std::runtime_error(what + " " + name + ": " + std::strerror(errno));
+}
+
+// Sleep while word still holds expected, until woken or timeout elapses. The futex is not
+// FUTEX_PRIVATE, since the other side is another process
+void futex_wait(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::nanoseconds timeout) {
+#ifdef __linux__
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+    ts.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+#else
+    if (word.load() == expected) {
+        std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(timeout, kPollInterval));
+    }
+#endif
+}
+
+void futex_wake(std::atomic<uint32_t>& word) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+// Block until ready() holds or timeout elapses. The event word is read before ready() is
+// checked, so a signal between the check and the futex call makes the wait return at once.
+// Announcing the waiter lets signal() skip the system call when nobody sleeps
+template <typename Ready>
+bool wait_for(std::atomic<uint32_t>& event, std::atomic<uint32_t>& waiting, Ready ready,
+              std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+        uint32_t generation = event.load();
+        if (ready()) {
+            return true;
+        }
+        waiting.fetch_add(1);
+        bool done = ready();
+        auto remaining = deadline - std::chrono::steady_clock::now();
+        if (!done && remaining > std::chrono::steady_clock::duration::zero()) {
+            futex_wait(event, generation, remaining);
+        }
+        waiting.fetch_sub(1);
+        if (done) {
+            return true;
+        }
+        if (remaining <= std::chrono::steady_clock::duration::zero()) {
+            return ready();
+        }
+    }
+}
+
+void signal(std::atomic<uint32_t>& event, std::atomic<uint32_t>& waiting) {
+    event.fetch_add(1);
+    if (waiting.load() != 0) {
+        futex_wake(event);
+    }
+}
+
+} // namespace
+
+ShmFrameRing::ShmFrameRing(std::string name, void* base, size_t mapped_bytes, bool owner)
+    : name_(std::move(name)), base_(base), mapped_bytes_(mapped_bytes), owner_(owner),
+      header_(static_cast<ShmRingHeader*>(base)) {}
+
+ShmFrameRing::~ShmFrameRing() {
+    munmap(base_, mapped_bytes_);
+    if (owner_) {
+        shm_unlink(name_.c_str());
+    }
+}
+
+std::unique_ptr<ShmFrameRing> ShmFrameRing::create(const std::string& name, int width, int height, int bit_depth,
+                                                   int slots) {
+    if (width <= 0 || height <= 0) {
+        throw std::invalid_argument("Shared-memory ring dimensions must be positive");
+    }
+    if (bit_depth != 8 && bit_depth != 10 && bit_depth != 12) {
+        throw std::invalid_argument("Shared-memory ring bit depth must be 8, 10 or 12");
+    }
+    if (slots <= 0) {
+        throw std::invalid_argument("Shared-memory ring needs at least one slot");
+    }
+
+    std::string path = segment_name(name);
+    size_t slot_bytes = yuv420_storage_bytes(width, height, bit_depth);
+    size_t slot_stride = round_up(slot_bytes, 64);
+    size_t data_offset = round_up(sizeof(ShmRingHeader), 4096);
+    size_t total = data_offset + slot_stride * static_cast<size_t>(slots);
+
+    // Replace any segment left behind by a producer that crashed
+    shm_unlink(path.c_str());
+    int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        throw system_error("Failed to create shared memory", path);
+    }
+    if (ftruncate(fd, static_cast<off_t>(total)) != 0) {
+        ::close(fd);
+        shm_unlink(path.c_str());
+        throw system_error("Failed to size shared memory", path);
+    }
+    void* base = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        shm_unlink(path.c_str());
+        throw system_error("Failed to map shared memory", path);
+    }
+
+    // The segment starts zeroed; magic is published last so a consumer never sees a partial header
+    auto* header = new (base) ShmRingHeader();
+    header->version = ShmRingHeader::kVersion;
+    header->width = static_cast<uint32_t>(width);
+    header->height = static_cast<uint32_t>(height);
+    header->bit_depth = static_cast<uint32_t>(bit_depth);
+    header->slot_count = static_cast<uint32_t>(slots);
+    header->slot_bytes = slot_bytes;
+    header->slot_stride = slot_stride;
+    header->data_offset = data_offset;
+    header->magic.store(ShmRingHeader::kMagic);
+
+    return std::unique_ptr<ShmFrameRing>(new ShmFrameRing(path, base, total, true));
+}
+
+std::unique_ptr<ShmFrameRing> ShmFrameRing::open(const std::string& name, std::chrono::milliseconds timeout) {
+    std::string path = segment_name(name);
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+        int fd = shm_open(path.c_str(), O_RDWR, 0);
+        if (fd < 0 && errno != ENOENT) {
+            throw system_error("Failed to open shared memory", path);
+        }
+        if (fd >= 0) {
+            // The producer sizes the segment in one step, so it is either empty or complete
+            struct stat st;
+            if (fstat(fd, &st) != 0) {
+                ::close(fd);
+                throw system_error("Failed to inspect shared memory", path);
+            }
+            size_t size = static_cast<size_t>(st.st_size);
+            void* base = size >= sizeof(ShmRingHeader)
+                             ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                             : MAP_FAILED;
+            ::close(fd);
+            if (base != MAP_FAILED) {
+                auto* header = static_cast<ShmRingHeader*>(base);
+                if (header->magic.load() == ShmRingHeader::kMagic) {
+                    std::unique_ptr<ShmFrameRing> ring(new ShmFrameRing(path, base, size, false));
+                    if (header->version != ShmRingHeader::kVersion) {
+                        throw std::runtime_error("Unsupported shared-memory ring version in " + path);
+                    }
+                    if (header->slot_count == 0 || header->slot_stride < header->slot_bytes ||
+                        header->slot_bytes != yuv420_storage_bytes(ring->width(), ring->height(), ring->bit_depth()) ||
+                        header->data_offset + header->slot_stride * header->slot_count > size) {
+                        throw std::runtime_error("Malformed shared-memory ring header in " + path);
+                    }
+                    return ring;
+                }
+                munmap(base, size);
+            }
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            throw std::runtime_error("Timed out waiting for shared-memory ring " + path);
+        }
+        std::this_thread::sleep_for(kPollInterval);
+    }
+}
+
+uint8_t* ShmFrameRing::slot(uint32_t frame) const {
+    return static_cast<uint8_t*>(base_) + header_->data_offset + header_->slot_stride * (frame % header_->slot_count);
+}
+
+uint8_t* ShmFrameRing::acquire(std::chrono::milliseconds timeout) {
+    auto has_free_slot = [&]() {
+        return header_->frames_written.load() - header_->frames_read.load() < header_->slot_count;
+    };
+    if (!wait_for(header_->read_event, header_->producer_waiting, has_free_slot, timeout)) {
+        return nullptr;
+    }
+    return slot(header_->frames_written.load());
+}
+
+void ShmFrameRing::publish() {
+    header_->frames_written.fetch_add(1);
+    signal(header_->write_event, header_->consumer_waiting);
+}
+
+void ShmFrameRing::close() {
+    header_->closed.store(1);
+    signal(header_->write_event, header_->consumer_waiting);
+}
+
+const uint8_t* ShmFrameRing::wait_frame(std::chrono::milliseconds timeout) {
+    auto has_frame = [&]() { return header_->frames_written.load() != header_->frames_read.load(); };
+    // Frames published before close() are still delivered
+    auto ready = [&]() { return has_frame() || closed(); };
+    if (!wait_for(header_->write_event, header_->consumer_waiting, ready, timeout) || !has_frame()) {
+        return nullptr;
+    }
+    return slot(header_->frames_read.load());
+}
+
+void ShmFrameRing::release() {
+    header_->frames_read.fetch_add(1);
+    signal(header_->read_event, header_->producer_waiting);
+}
+
+bool ShmFrameRing::read(YUVFrame& frame, std::chrono::milliseconds timeout) {
+    if (frame.width != width() || frame.height != height() || frame.bit_depth != bit_depth()) {
+        throw std::invalid_argument("Frame does not match the shared-memory ring geometry");
+    }
+    const uint8_t* data = wait_frame(timeout);
+    if (!data) {
+        return false;
+    }
+    // Little-endian 16-bit samples are copied straight into the planes on little-endian hosts
+    if (frame.bit_depth > 8) {
+        for (auto* plane : {&frame.y16, &frame.u16, &frame.v16}) {
+            std::memcpy(plane->data(), data, plane->size() * 2);
+            data += plane->size() * 2;
+        }
+    } else {
+        for (auto* plane : {&frame.y, &frame.u, &frame.v}) {
+            std::memcpy(plane->data(), data, plane->size());
+            data += plane->size();
+        }
+    }
+    release();
+    return true;
+}
+
+} // namespace rdmeter
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "yuv_reader.hpp"
+
+namespace rdmeter {
+
+// Layout of the start of a shared-memory frame ring. A producer process (e.g. a decoder)
+// creates the segment with shm_open, fills in the geometry and writes planes straight into
+// slots; the consumer maps the same segment. Slots hold Y, U then V with the layout of a
+// yuv420p file (samples of more than 8 bits are 16-bit little-endian words).
+//
+// frames_written and frames_read count frames modulo 2^32; frame n lives in slot
+// n % slot_count. The event words change on every publish/release (and on close) and are
+// what the other side sleeps on with a futex, so a wake-up can never be lost
+struct ShmRingHeader {
+    std::atomic<uint32_t> magic;  // kMagic once the producer has initialised the header
+    uint32_t version;      // kVersion
+    uint32_t width;
+    uint32_t height;
+    uint32_t bit_depth;    // 8, 10 or 12
+    uint32_t slot_count;
+    uint64_t slot_bytes;   // Bytes of one frame
+    uint64_t slot_stride;  // Distance between slots, a multiple of 64
+    uint64_t data_offset;  // Offset of slot 0 from the start of the segment
+
+    // Producer side, on its own cache line
+    alignas(64) std::atomic<uint32_t> frames_written;
+    std::atomic<uint32_t> write_event;
+    std::atomic<uint32_t> consumer_waiting;
+    std::atomic<uint32_t> closed;  // Non-zero once the producer will publish no more frames
+
+    // Consumer side
+    alignas(64) std::atomic<uint32_t> frames_read;
+    std::atomic<uint32_t> read_event;
+    std::atomic<uint32_t> producer_waiting;
+
+    static constexpr uint32_t kMagic = 0x524d4452;  // "RDMR"
+    static constexpr uint32_t kVersion = 1;
+};
+
+// One end of a shared-memory frame ring, with futex signalling between the processes
+// (polling elsewhere than Linux). There is one producer and one consumer per ring
+class ShmFrameRing {
+public:
+    // Create (or replace) the segment /name as its producer. The segment is unlinked again
+    // when the producer's ring is destroyed; a consumer that has it mapped keeps working
+    static std::unique_ptr<ShmFrameRing> create(const std::string& name, int width, int height, int bit_depth,
+                                                int slots);
+
+    // Map an existing segment as its consumer, waiting up to timeout for the producer to
+    // create and initialise it
+    static std::unique_ptr<ShmFrameRing> open(const std::string& name, std::chrono::milliseconds timeout);
+
+    ~ShmFrameRing();
+
+    ShmFrameRing(const ShmFrameRing&) = delete;
+    ShmFrameRing& operator=(const ShmFrameRing&) = delete;
+
+    int width() const { return static_cast<int>(header_->width); }
+    int height() const { return static_cast<int>(header_->height); }
+    int bit_depth() const { return static_cast<int>(header_->bit_depth); }
+    int slots() const { return static_cast<int>(header_->slot_count); }
+    size_t frame_bytes() const { return static_cast<size_t>(header_->slot_bytes); }
+
+    // Producer: wait until the next slot is free and return it, or nullptr on timeout
+    uint8_t* acquire(std::chrono::milliseconds timeout);
+    // Producer: make the acquired slot visible to the consumer
+    void publish();
+    // Producer: mark the end of the stream once published frames have been written
+    void close();
+
+    // Consumer: wait for the next frame and return its slot, in place, or nullptr once the
+    // producer has closed the ring and every frame was read, or on timeout
+    const uint8_t* wait_frame(std::chrono::milliseconds timeout);
+    // Consumer: hand the slot returned by wait_frame back to the producer
+    void release();
+    // Consumer: copy the next frame into frame and release its slot. Returns false at the
+    // end of the stream or on timeout
+    bool read(YUVFrame& frame, std::chrono::milliseconds timeout);
+
+    // True once the producer has closed the ring
+    bool closed() const { return header_->closed.load() != 0; }
+
+private:
+    ShmFrameRing(std::string name, void* base, size_t mapped_bytes, bool owner);
+
+    uint8_t* slot(uint32_t frame) const;
+
+    std::string name_;
+    void* base_;
+    size_t mapped_bytes_;
+    bool owner_;
+    ShmRingHeader* header_;
+};
+
+} // namespace rdmeter
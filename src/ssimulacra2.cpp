@@ -0,0 +1,242 @@
+#include "ssimulacra2.hpp"
+#include "metrics.hpp"
+#include "threading.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace rdmeter {
+
+namespace {
+
+constexpr int kScales = 6;
+constexpr int kChannels = 3;
+
+// Score weights, one triple (SSIM, ringing, blurring) per channel x scale x norm (L1, L4)
+constexpr double kWeights[108] = {
+    0.0, 0.0007376606707406586, 0.0, 0.0, 0.0007793481682867309, 0.0, 0.0, 0.0004371155730107379, 0.0,
+    1.1041726426657346, 0.00066284834129271, 0.00015231632783718752, 0.0, 0.0016406437456599754, 0.0,
+    1.8422455520539298, 11.441172603757666, 0.0, 0.0007989109436015163, 0.000176816438078653, 0.0,
+    1.8787594979546387, 10.94906990605142, 0.0, 0.0007289346991508072, 0.9677937080626833, 0.0,
+    0.00014003424285435884, 0.9981766977854967, 0.00031949755934435053, 0.0004550992113792063, 0.0, 0.0,
+    0.0013648766163243398, 0.0, 0.0, 0.0, 0.0, 0.0, 7.466890328078848, 0.0, 17.445833984131262,
+    0.0006235601634041466, 0.0, 0.0, 6.683678146179332, 0.00037724407979611296, 1.027889937768264,
+    225.20515300849274, 0.0, 0.0, 19.213238186143016, 0.0011401524586618361, 0.001237755635509985,
+    176.39317598450694, 0.0, 0.0, 24.43300999870476, 0.28520802612117757, 0.0004485436923833408, 0.0, 0.0,
+    0.0, 34.77906344483772, 44.835625328877896, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0,
+    0.0008680556573291698, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0005313191874358747, 0.0, 0.00016533814161379112,
+    0.0, 0.0, 0.0, 0.0, 0.0, 0.0004179171803251336, 0.0017290828234722833, 0.0, 0.0020827005846636437,
+    0.0, 0.0, 8.826982764996862, 23.19243343998926, 0.0, 95.1080498811086, 0.9863978034400682,
+    0.9834382792465353, 0.0012286405048278493, 171.2667255897307, 0.9807858872435379, 0.0, 0.0, 0.0,
+    0.0005130064588990679, 0.0, 0.00010854057858411537};
+
+// Three planes of equal size
+struct Planes {
+    int width = 0;
+    int height = 0;
+    std::array<std::vector<float>, kChannels> c;
+};
+
+// Per-channel statistics of one scale: SSIM error (L1, L4) and edge ringing/blurring (L1, L4 each)
+struct ChannelScores {
+    double ssim[2] = {0.0, 0.0};
+    double edge[4] = {0.0, 0.0, 0.0, 0.0};
+};
+
+Planes linear_rgb(const Image& image) {
+    static const std::array<float, 256> eotf = [] {
+        std::array<float, 256> table{};
+        for (int i = 0; i < 256; ++i) {
+            double x = i / 255.0;
+            table[i] = static_cast<float>(x <= 0.04045 ? x / 12.92 : std::pow((x + 0.055) / 1.055, 2.4));
+        }
+        return table;
+    }();
+
+    Planes planes;
+    planes.width = image.width;
+    planes.height = image.height;
+    size_t pixels = static_cast<size_t>(image.width) * image.height;
+    for (int ch = 0; ch < kChannels; ++ch) {
+        planes.c[ch].resize(pixels);
+        int source = image.channels == 1 ? 0 : ch;
+        for (size_t i = 0; i < pixels; ++i) {
+            planes.c[ch][i] = eotf[image.pixels[i * image.channels + source]];
+        }
+    }
+    return planes;
+}
+
+// 2x2 box average as libjxl's: odd sizes round up and repeat the last row or column
+Planes downsample(const Planes& planes) {
+    Planes out;
+    out.width = (planes.width + 1) / 2;
+    out.height = (planes.height + 1) / 2;
+    for (int ch = 0; ch < kChannels; ++ch) {
+        const std::vector<float>& in = planes.c[ch];
+        std::vector<float>& plane = out.c[ch];
+        plane.resize(static_cast<size_t>(out.width) * out.height);
+        for (int y = 0; y < out.height; ++y) {
+            const float* row0 = in.data() + static_cast<size_t>(2 * y) * planes.width;
+            const float* row1 = in.data() + static_cast<size_t>(std::min(2 * y + 1, planes.height - 1)) * planes.width;
+            float* row = plane.data() + static_cast<size_t>(y) * out.width;
+            for (int x = 0; x < out.width; ++x) {
+                int x1 = std::min(2 * x + 1, planes.width - 1);
+                row[x] = (row0[2 * x] + row0[x1] + row1[2 * x] + row1[x1]) * 0.25f;
+            }
+        }
+    }
+    return out;
+}
+
+// Linear RGB to the JPEG XL opsin XYB space, shifted so every channel is positive
+Planes positive_xyb(const Planes& rgb) {
+    const float m[9] = {0.30f, 0.622f, 0.078f,
+                        0.23f, 0.692f, 0.078f,
+                        0.24342268924547819f, 0.20476744424496821f, 0.55180986650955360f};
+    const float bias = 0.0037930732552754493f;
+    const float bias_cbrt = std::cbrt(bias);
+
+    Planes xyb;
+    xyb.width = rgb.width;
+    xyb.height = rgb.height;
+    size_t pixels = static_cast<size_t>(rgb.width) * rgb.height;
+    for (auto& plane : xyb.c) {
+        plane.resize(pixels);
+    }
+    const float* r = rgb.c[0].data();
+    const float* g = rgb.c[1].data();
+    const float* b = rgb.c[2].data();
+    for (size_t i = 0; i < pixels; ++i) {
+        float l = std::cbrt(m[0] * r[i] + m[1] * g[i] + m[2] * b[i] + bias) - bias_cbrt;
+        float mm = std::cbrt(m[3] * r[i] + m[4] * g[i] + m[5] * b[i] + bias) - bias_cbrt;
+        float s = std::cbrt(m[6] * r[i] + m[7] * g[i] + m[8] * b[i] + bias) - bias_cbrt;
+        float x = 0.5f * (l - mm);
+        float y = 0.5f * (l + mm);
+        xyb.c[0][i] = x * 14.0f + 0.42f;
+        xyb.c[1][i] = y + 0.01f;
+        xyb.c[2][i] = (s - y) + 0.55f;
+    }
+    return xyb;
+}
+
+ChannelScores score_channel(const std::vector<float>& a, const std::vector<float>& b, int width, int height,
+                            const std::vector<double>& kernel) {
+    size_t pixels = static_cast<size_t>(width) * height;
+    std::vector<float> product(pixels);
+
+    auto mu1 = apply_gaussian_filter(a, width, height, kernel);
+    auto mu2 = apply_gaussian_filter(b, width, height, kernel);
+    for (size_t i = 0; i < pixels; ++i) product[i] = a[i] * a[i];
+    auto s11 = apply_gaussian_filter(product, width, height, kernel);
+    for (size_t i = 0; i < pixels; ++i) product[i] = b[i] * b[i];
+    auto s22 = apply_gaussian_filter(product, width, height, kernel);
+    for (size_t i = 0; i < pixels; ++i) product[i] = a[i] * b[i];
+    auto s12 = apply_gaussian_filter(product, width, height, kernel);
+
+    // SSIM without the luminance denominator (values are already perceptually uniform),
+    // as an error 1 - SSIM'. Edge maps compare each image's deviation from its local mean:
+    // positive d means the distorted image has new edges (ringing, banding, blocking),
+    // negative d means edges were lost (blur, smearing)
+    const float c2 = 0.0009f;
+    double sum_ssim = 0.0, sum_ssim4 = 0.0;
+    double sum_ring = 0.0, sum_ring4 = 0.0, sum_blur = 0.0, sum_blur4 = 0.0;
+    for (size_t i = 0; i < pixels; ++i) {
+        float m1 = mu1[i];
+        float m2 = mu2[i];
+        float num_m = 1.0f - (m1 - m2) * (m1 - m2);
+        float num_s = 2.0f * (s12[i] - m1 * m2) + c2;
+        float denom_s = (s11[i] - m1 * m1) + (s22[i] - m2 * m2) + c2;
+        double d = std::max(1.0 - static_cast<double>(num_m * num_s / denom_s), 0.0);
+        double d2 = d * d;
+        sum_ssim += d;
+        sum_ssim4 += d2 * d2;
+
+        double edge = (1.0 + std::abs(b[i] - m2)) / (1.0 + std::abs(a[i] - m1)) - 1.0;
+        double ring = std::max(edge, 0.0);
+        double blur = std::max(-edge, 0.0);
+        sum_ring += ring;
+        sum_ring4 += ring * ring * ring * ring;
+        sum_blur += blur;
+        sum_blur4 += blur * blur * blur * blur;
+    }
+
+    double inv = 1.0 / static_cast<double>(pixels);
+    ChannelScores scores;
+    scores.ssim[0] = sum_ssim * inv;
+    scores.ssim[1] = std::sqrt(std::sqrt(sum_ssim4 * inv));
+    scores.edge[0] = sum_ring * inv;
+    scores.edge[1] = std::sqrt(std::sqrt(sum_ring4 * inv));
+    scores.edge[2] = sum_blur * inv;
+    scores.edge[3] = std::sqrt(std::sqrt(sum_blur4 * inv));
+    return scores;
+}
+
+} // namespace
+
+double ssimulacra2(const Image& ref, const Image& dist, ThreadPool* pool) {
+    if (ref.width != dist.width || ref.height != dist.height) {
+        throw std::invalid_argument("Image dimensions do not match");
+    }
+    if (ref.width < 8 || ref.height < 8) {
+        throw std::invalid_argument("Image too small for SSIMULACRA2 calculation (minimum 8x8 required)");
+    }
+
+    // Linear RGB pyramids; as in libjxl, a scale is added while the one before it is at
+    // least 8x8, so the coarsest may be as small as 4x4
+    std::vector<Planes> ref_rgb{linear_rgb(ref)};
+    std::vector<Planes> dist_rgb{linear_rgb(dist)};
+    while (static_cast<int>(ref_rgb.size()) < kScales && ref_rgb.back().width >= 8 && ref_rgb.back().height >= 8) {
+        ref_rgb.push_back(downsample(ref_rgb.back()));
+        dist_rgb.push_back(downsample(dist_rgb.back()));
+    }
+    const size_t scales = ref_rgb.size();
+
+    auto run = [&](size_t count, const std::function<void(size_t, unsigned)>& fn) {
+        if (pool) {
+            pool->parallel_for(count, fn);
+        } else {
+            for (size_t i = 0; i < count; ++i) fn(i, 0);
+        }
+    };
+
+    // XYB per scale, then every (scale, channel) pair independently
+    std::vector<Planes> ref_xyb(scales), dist_xyb(scales);
+    run(2 * scales, [&](size_t task, unsigned) {
+        size_t scale = task / 2;
+        if (task % 2 == 0) {
+            ref_xyb[scale] = positive_xyb(ref_rgb[scale]);
+        } else {
+            dist_xyb[scale] = positive_xyb(dist_rgb[scale]);
+        }
+    });
+
+    const auto kernel = generate_gaussian_kernel(11, 1.5);
+    std::vector<ChannelScores> scores(scales * kChannels);
+    run(scores.size(), [&](size_t task, unsigned) {
+        size_t scale = task / kChannels;
+        size_t ch = task % kChannels;
+        scores[task] = score_channel(ref_xyb[scale].c[ch], dist_xyb[scale].c[ch], ref_xyb[scale].width,
+                                     ref_xyb[scale].height, kernel);
+    });
+
+    // Weighted sum in channel, scale, norm order, then the fitted mapping to a 0-100 scale
+    double sum = 0.0;
+    size_t w = 0;
+    for (size_t ch = 0; ch < kChannels; ++ch) {
+        for (size_t scale = 0; scale < scales; ++scale) {
+            const auto& s = scores[scale * kChannels + ch];
+            for (int norm = 0; norm < 2; ++norm) {
+                sum += kWeights[w++] * std::abs(s.ssim[norm]);
+                sum += kWeights[w++] * std::abs(s.edge[norm]);
+                sum += kWeights[w++] * std::abs(s.edge[norm + 2]);
+            }
+        }
+    }
+    sum *= 0.9562382616834844;
+    sum = 2.326765642916932 * sum - 0.020884521182843837 * sum * sum + 6.248496625763138e-05 * sum * sum * sum;
+    return sum > 0.0 ? 100.0 - 10.0 * std::pow(sum, 0.6276336467831387) : 100.0;
+}
+
+} // namespace rdmeter
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "image_io.hpp"
+
+namespace rdmeter {
+
+class ThreadPool;
+
+// SSIMULACRA2 (Cloudinary/libjxl, version 2.1) between two sRGB images of the same size
+// Returns a score up to 100 (identical); around 90 is visually lossless, 70 high and 50 medium quality.
+// Gray images are treated as R = G = B. With a pool, the 6 scales x 3 XYB channels are scored in
+// parallel; pass nullptr when the caller already parallelises across images.
+// Throws std::invalid_argument for mismatched or smaller than 8x8 images
+//
+// Follows libjxl's pyramid (a scale is added while the previous one is at least 8x8, odd
+// sizes rounding up), XYB, error maps and weights, with one intended deviation: local
+// statistics use a truncated 11-tap Gaussian (sigma 1.5, symmetric padding), as SSIM and
+// MS-SSIM here do, instead of libjxl's recursive Gaussian. Scores therefore track
+// libjxl's tool closely but are not bit-identical to it, and have not been checked
+// against it on a golden image pair
+double ssimulacra2(const Image& ref, const Image& dist, ThreadPool* pool = nullptr);
+
+} // namespace rdmeter
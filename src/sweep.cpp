@@ -0,0 +1,61 @@
+#include "sweep.hpp"
+#include "threading.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace rdmeter {
+
+SweepScores score_sweep(FrameReader& ref, const std::vector<FrameReader*>& encodes,
+                        const std::vector<FrameMetric>& metrics, int frames, int batch_frames, ThreadPool& pool) {
+    if (batch_frames < 1) {
+        throw std::invalid_argument("Sweep batches need at least one frame");
+    }
+    const size_t encode_count = encodes.size();
+    const size_t metric_count = metrics.size();
+    SweepScores scores;
+    scores.frames = std::max(frames, 0);
+    scores.values.assign(encode_count, std::vector<std::vector<double>>(
+                                           metric_count, std::vector<double>(scores.frames, 0.0)));
+    if (encode_count == 0 || scores.frames == 0) {
+        return scores;
+    }
+
+    // One reference frame and one frame per encode for every slot of a batch
+    const int width = ref.width();
+    const int height = ref.height();
+    const int depth = ref.bit_depth();
+    const size_t batch = static_cast<size_t>(std::min(batch_frames, scores.frames));
+    std::vector<YUVFrame> ref_frames(batch, YUVFrame(width, height, depth));
+    std::vector<YUVFrame> dist_frames(batch * encode_count, YUVFrame(width, height, depth));
+
+    for (int first = 0; first < scores.frames; first += static_cast<int>(batch)) {
+        const size_t count = std::min(batch, static_cast<size_t>(scores.frames - first));
+        for (size_t i = 0; i < count; ++i) {
+            ref.read(ref_frames[i]);
+            for (size_t e = 0; e < encode_count; ++e) {
+                encodes[e]->read(dist_frames[i * encode_count + e]);
+            }
+        }
+
+        pool.parallel_for(count * encode_count, [&](size_t job, unsigned) {
+            size_t i = job / encode_count;
+            size_t e = job % encode_count;
+            int frame = first + static_cast<int>(i);
+            try {
+                std::vector<double> scored;
+                score_frame(metrics, ref_frames[i], dist_frames[job], frame, scored);
+                for (size_t m = 0; m < metric_count; ++m) {
+                    scores.values[e][m][frame] = scored[m];
+                }
+            } catch (const std::invalid_argument&) {
+                for (size_t m = 0; m < metric_count; ++m) {
+                    scores.values[e][m][frame] = std::numeric_limits<double>::quiet_NaN();
+                }
+            }
+        });
+    }
+    return scores;
+}
+
+} // namespace rdmeter
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "frame_metrics.hpp"
+#include "yuv_reader.hpp"
+#include <vector>
+
+namespace rdmeter {
+
+class ThreadPool;
+
+// Per-frame scores of every encode of a sweep against one reference
+struct SweepScores {
+    int frames = 0;
+    // values[e][m][f] is metric m of frame f of encode e, NaN where the frame was skipped
+    std::vector<std::vector<std::vector<double>>> values;
+};
+
+// Scores frames [0, frames) of every encode against the reference, reading each reference
+// frame once. Frames are read in batches of up to batch_frames, and the (encode, frame)
+// pairs of a batch are scored across pool. A frame that a metric cannot score (it throws
+// std::invalid_argument) is skipped for that encode, as compute skips it
+SweepScores score_sweep(FrameReader& ref, const std::vector<FrameReader*>& encodes,
+                        const std::vector<FrameMetric>& metrics, int frames, int batch_frames, ThreadPool& pool);
+
+} // namespace rdmeter
@@ -0,0 +1,344 @@
+#include "synthetic.hpp"
+#include "sampling.hpp"
+#include "threading.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace rdmeter {
+
+namespace {
+
+constexpr int kTileSize = 256;
+constexpr int kTileMask = kTileSize - 1;
+constexpr int kLattice = 16;  // Spacing of the smooth noise lattice in tile pixels
+constexpr int kStrip = 64;    // Columns per task of the vertical blur pass
+
+// Separate random streams for each use of the seed
+constexpr uint64_t kBlockSalt = 0x626C6F636B696E65ull;
+constexpr uint64_t kNoiseSalt = 0x6E6F697365000000ull;
+constexpr uint64_t kDropSalt = 0x64726F7000000000ull;
+
+uint64_t mix(uint64_t a, uint64_t b) {
+    return SplitMix64(a ^ (b * 0xD6E8FEB86659FD93ull)).next();
+}
+
+// Smooth value noise of amplitude smooth plus per-pixel detail of amplitude detail, both
+// in code values, stored in 1/16 code values. The tile wraps seamlessly
+std::vector<int16_t> make_tile(uint64_t seed, double smooth, double detail) {
+    const int cells = kTileSize / kLattice;
+    SplitMix64 rng(seed);
+    std::vector<double> lattice(cells * cells);
+    for (auto& value : lattice) {
+        value = rng.uniform() * 2.0 - 1.0;
+    }
+    auto smoothstep = [](double t) { return t * t * (3.0 - 2.0 * t); };
+
+    std::vector<int16_t> tile(kTileSize * kTileSize);
+    for (int y = 0; y < kTileSize; ++y) {
+        int cy = y / kLattice;
+        double fy = smoothstep(static_cast<double>(y % kLattice) / kLattice);
+        const double* row0 = &lattice[cy * cells];
+        const double* row1 = &lattice[((cy + 1) % cells) * cells];
+        for (int x = 0; x < kTileSize; ++x) {
+            int cx = x / kLattice;
+            int nx = (cx + 1) % cells;
+            double fx = smoothstep(static_cast<double>(x % kLattice) / kLattice);
+            double top = row0[cx] + (row0[nx] - row0[cx]) * fx;
+            double bottom = row1[cx] + (row1[nx] - row1[cx]) * fx;
+            double value = smooth * (top + (bottom - top) * fy) + detail * (rng.uniform() * 2.0 - 1.0);
+            tile[y * kTileSize + x] = static_cast<int16_t>(std::lround(16.0 * value));
+        }
+    }
+    return tile;
+}
+
+// Box blur with edge samples repeated: a horizontal pass by rows into scratch, then a
+// vertical pass by strips of columns back into samples, each a running sum
+void box_blur(std::vector<uint16_t>& samples, std::vector<uint16_t>& scratch, int width, int height, int radius,
+              int max_value, ThreadPool& pool) {
+    const int taps = 2 * radius + 1;
+    // Sums are divided by taps as a multiply by its 8.24 fixed-point reciprocal, which can
+    // round one above the largest sample
+    const int64_t reciprocal = ((int64_t{1} << 24) + taps / 2) / taps;
+    auto average = [reciprocal, max_value](int64_t sum) {
+        return static_cast<uint16_t>(std::min<int64_t>((sum * reciprocal + (int64_t{1} << 23)) >> 24, max_value));
+    };
+    scratch.resize(samples.size());
+    pool.parallel_for(height, [&](size_t y, unsigned) {
+        const uint16_t* src = &samples[y * width];
+        uint16_t* dst = &scratch[y * width];
+        auto at = [&](int x) { return static_cast<int>(src[std::clamp(x, 0, width - 1)]); };
+        int sum = 0;
+        for (int k = -radius; k <= radius; ++k) {
+            sum += at(k);
+        }
+        // Only the ends of the row need clamped reads
+        const int inner_begin = std::min(radius, width);
+        const int inner_end = std::max(inner_begin, width - radius - 1);
+        int x = 0;
+        for (; x < inner_begin; ++x) {
+            dst[x] = average(sum);
+            sum += at(x + radius + 1) - at(x - radius);
+        }
+        for (; x < inner_end; ++x) {
+            dst[x] = average(sum);
+            sum += src[x + radius + 1] - src[x - radius];
+        }
+        for (; x < width; ++x) {
+            dst[x] = average(sum);
+            sum += at(x + radius + 1) - at(x - radius);
+        }
+    });
+
+    const size_t strips = (width + kStrip - 1) / kStrip;
+    pool.parallel_for(strips, [&](size_t strip, unsigned) {
+        const int x0 = static_cast<int>(strip) * kStrip;
+        const int count = std::min(kStrip, width - x0);
+        auto row = [&](int y) { return &scratch[static_cast<size_t>(std::clamp(y, 0, height - 1)) * width + x0]; };
+        int sums[kStrip] = {};
+        for (int k = -radius; k <= radius; ++k) {
+            const uint16_t* src = row(k);
+            for (int i = 0; i < count; ++i) {
+                sums[i] += src[i];
+            }
+        }
+        for (int y = 0; y < height; ++y) {
+            uint16_t* dst = &samples[static_cast<size_t>(y) * width + x0];
+            const uint16_t* add = row(y + radius + 1);
+            const uint16_t* drop = row(y - radius);
+            for (int i = 0; i < count; ++i) {
+                dst[i] = average(sums[i]);
+                sums[i] += add[i] - drop[i];
+            }
+        }
+    });
+}
+
+} // namespace
+
+SyntheticVideo::SyntheticVideo(int width, int height, PixelFormat format, uint64_t seed)
+    : width_(width), height_(height), format_(format), seed_(seed) {
+    if (width < 2 || height < 2) {
+        throw std::invalid_argument("Synthetic video must be at least 2x2 pixels");
+    }
+    const bool rgb = format == PixelFormat::RGB24 || format == PixelFormat::RGB48LE;
+    bit_depth_ = format == PixelFormat::RGB48LE ? 16 : pixel_format_bit_depth(format);
+
+    // Gradient centre and range, and texture amplitudes, of each plane. Luma and green
+    // carry most of the detail, as in camera content
+    struct Look {
+        int level;
+        int span;
+        double smooth;
+        double detail;
+    };
+    const Look yuv_looks[3] = {{128, 96, 24.0, 6.0}, {128, 32, 10.0, 2.0}, {128, 32, 10.0, 2.0}};
+    const Look rgb_looks[3] = {{120, 80, 20.0, 5.0}, {128, 96, 24.0, 6.0}, {136, 64, 16.0, 4.0}};
+    for (int p = 0; p < 3; ++p) {
+        const Look& look = rgb ? rgb_looks[p] : yuv_looks[p];
+        Plane plane;
+        plane.scale = !rgb && p > 0 ? 2 : 1;
+        plane.width = width / plane.scale;
+        plane.height = height / plane.scale;
+        plane.level = look.level;
+        plane.span = look.span;
+        plane.tile = make_tile(mix(seed, static_cast<uint64_t>(p) + 1), look.smooth, look.detail);
+        plane.samples.resize(static_cast<size_t>(plane.width) * plane.height);
+        planes_.push_back(std::move(plane));
+    }
+}
+
+int SyntheticVideo::shown_frame(int index, double drop_rate) const {
+    if (drop_rate <= 0.0) {
+        return index;
+    }
+    while (index > 0 && SplitMix64(mix(seed_ ^ kDropSalt, static_cast<uint64_t>(index))).uniform() < drop_rate) {
+        --index;
+    }
+    return index;
+}
+
+void SyntheticVideo::render_planes(int index, ThreadPool& pool) {
+    if (index < 0) {
+        throw std::invalid_argument("Frame index must not be negative");
+    }
+    const int scale = 1 << (bit_depth_ - 8);
+    const int max_value = (1 << bit_depth_) - 1;
+    for (auto& plane : planes_) {
+        const int w = plane.width;
+        const int h = plane.height;
+        // The gradient drifts right two pixels a frame and wraps, so its hard edge moves;
+        // the texture pans diagonally
+        const int drift = static_cast<int>((static_cast<int64_t>(index) * 2 / plane.scale) % w);
+        std::vector<int> columns(w);
+        for (int x = 0; x < w; ++x) {
+            int position = x - drift < 0 ? x - drift + w : x - drift;
+            columns[x] = 16 * (plane.level - plane.span / 2) +
+                         static_cast<int>(static_cast<int64_t>(16 * plane.span) * position / w);
+        }
+        const int pan_x = static_cast<int>((static_cast<int64_t>(index) * 3) & kTileMask);
+        const int pan_y = index & kTileMask;
+
+        pool.parallel_for(h, [&](size_t y, unsigned) {
+            // A vertical gradient of half the range, centred on the plane's level
+            const int row_term = static_cast<int>(static_cast<int64_t>(8 * plane.span) * y / h) - 4 * plane.span;
+            // The texture row starting at the pan offset, so each 256-pixel run reads it in order
+            const int16_t* tile_row = &plane.tile[((static_cast<int>(y) + pan_y) & kTileMask) * kTileSize];
+            int texture[kTileSize];
+            for (int i = 0; i < kTileSize; ++i) {
+                texture[i] = tile_row[(i + pan_x) & kTileMask] + row_term;
+            }
+            uint16_t* dst = &plane.samples[y * w];
+            for (int x0 = 0; x0 < w; x0 += kTileSize) {
+                const int count = std::min(kTileSize, w - x0);
+                const int* column = &columns[x0];
+                for (int i = 0; i < count; ++i) {
+                    int value = ((column[i] + texture[i]) * scale + 8) >> 4;
+                    dst[x0 + i] = static_cast<uint16_t>(std::clamp(value, 0, max_value));
+                }
+            }
+        });
+    }
+}
+
+void SyntheticVideo::distort_planes(int index, const SynthDistortion& distortion, ThreadPool& pool) {
+    const double unit = static_cast<double>(1 << (bit_depth_ - 8));
+    const int max_value = (1 << bit_depth_) - 1;
+    for (size_t p = 0; p < planes_.size(); ++p) {
+        Plane& plane = planes_[p];
+        const int w = plane.width;
+
+        const int radius = distortion.blur_radius / plane.scale;
+        if (radius > 0) {
+            box_blur(plane.samples, scratch_, w, plane.height, radius, max_value, pool);
+        }
+
+        // Every block is offset by its own DC error, leaving steps along the block grid
+        if (distortion.blockiness > 0.0) {
+            const int block = std::max(1, distortion.block_size / plane.scale);
+            const int blocks_x = (w + block - 1) / block;
+            const int blocks_y = (plane.height + block - 1) / block;
+            const double strength = distortion.blockiness * unit;
+            const uint64_t plane_seed = mix(mix(seed_ ^ kBlockSalt, static_cast<uint64_t>(index)), p);
+            offsets_.resize(static_cast<size_t>(blocks_x) * blocks_y);
+            for (size_t b = 0; b < offsets_.size(); ++b) {
+                double u = SplitMix64(mix(plane_seed, b)).uniform();
+                offsets_[b] = static_cast<int>(std::lround((2.0 * u - 1.0) * strength));
+            }
+            pool.parallel_for(plane.height, [&](size_t y, unsigned) {
+                const int* row_offsets = &offsets_[(y / block) * blocks_x];
+                uint16_t* row = &plane.samples[y * w];
+                for (int x0 = 0, b = 0; x0 < w; x0 += block, ++b) {
+                    const int end = std::min(w, x0 + block);
+                    const int offset = row_offsets[b];
+                    for (int x = x0; x < end; ++x) {
+                        row[x] = static_cast<uint16_t>(std::clamp(row[x] + offset, 0, max_value));
+                    }
+                }
+            });
+        }
+
+        // Four uniform bytes summed are close to Gaussian, and one draw covers two samples.
+        // The sum is scaled in 32.32 fixed point
+        if (distortion.noise > 0.0) {
+            const double gain = distortion.noise * unit / (256.0 * std::sqrt(4.0 / 12.0));
+            const int64_t fixed_gain = std::llround(gain * 4294967296.0);
+            const uint64_t plane_seed = mix(mix(seed_ ^ kNoiseSalt, static_cast<uint64_t>(index)), p);
+            pool.parallel_for(plane.height, [&](size_t y, unsigned) {
+                SplitMix64 rng(mix(plane_seed, y));
+                uint16_t* row = &plane.samples[y * w];
+                uint64_t bits = 0;
+                for (int x = 0; x < w; ++x) {
+                    if ((x & 1) == 0) {
+                        bits = rng.next();
+                    } else {
+                        bits >>= 32;
+                    }
+                    int64_t sum = static_cast<int64_t>((bits & 0xFF) + ((bits >> 8) & 0xFF) + ((bits >> 16) & 0xFF) +
+                                                       ((bits >> 24) & 0xFF));
+                    int offset = static_cast<int>(((sum - 2 * 255) * fixed_gain + (int64_t{1} << 31)) >> 32);
+                    row[x] = static_cast<uint16_t>(std::clamp(row[x] + offset, 0, max_value));
+                }
+            });
+        }
+    }
+}
+
+void SyntheticVideo::pack(uint8_t* out, ThreadPool& pool) const {
+    const bool wide = bit_depth_ > 8;
+    if (format_ == PixelFormat::RGB24 || format_ == PixelFormat::RGB48LE) {
+        const int w = width_;
+        const size_t pixel_bytes = wide ? 6 : 3;
+        pool.parallel_for(height_, [&](size_t y, unsigned) {
+            const uint16_t* r = &planes_[0].samples[y * w];
+            const uint16_t* g = &planes_[1].samples[y * w];
+            const uint16_t* b = &planes_[2].samples[y * w];
+            uint8_t* dst = out + y * w * pixel_bytes;
+            if (wide) {
+                for (int x = 0; x < w; ++x) {
+                    const uint16_t pixel[3] = {r[x], g[x], b[x]};
+                    std::memcpy(dst + 6 * x, pixel, 6);
+                }
+            } else {
+                for (int x = 0; x < w; ++x) {
+                    dst[3 * x] = static_cast<uint8_t>(r[x]);
+                    dst[3 * x + 1] = static_cast<uint8_t>(g[x]);
+                    dst[3 * x + 2] = static_cast<uint8_t>(b[x]);
+                }
+            }
+        });
+        return;
+    }
+
+    // Planar: Y, U then V. 16-bit samples are copied as they are, little-endian on the
+    // little-endian hosts FrameReader reads them on
+    for (const auto& plane : planes_) {
+        const int w = plane.width;
+        const size_t row_bytes = static_cast<size_t>(w) * (wide ? 2 : 1);
+        pool.parallel_for(plane.height, [&](size_t y, unsigned) {
+            const uint16_t* src = &plane.samples[y * w];
+            uint8_t* dst = out + y * row_bytes;
+            if (wide) {
+                std::memcpy(dst, src, row_bytes);
+            } else {
+                for (int x = 0; x < w; ++x) {
+                    dst[x] = static_cast<uint8_t>(src[x]);
+                }
+            }
+        });
+        out += row_bytes * plane.height;
+    }
+}
+
+void SyntheticVideo::render(int index, uint8_t* out, ThreadPool& pool) {
+    render_planes(index, pool);
+    pack(out, pool);
+}
+
+void SyntheticVideo::render(int index, const SynthDistortion& distortion, uint8_t* out, ThreadPool& pool) {
+    if (distortion.blur_radius < 0 || distortion.blockiness < 0.0 || distortion.noise < 0.0) {
+        throw std::invalid_argument("Distortion strengths must not be negative");
+    }
+    // A strength past the whole 8-bit code range only saturates samples, and unbounded noise
+    // would overflow its fixed-point gain
+    const double max_strength = 255.0;
+    if (distortion.blur_radius > max_strength || !(distortion.blockiness <= max_strength) ||
+        !(distortion.noise <= max_strength)) {
+        throw std::invalid_argument("Distortion strengths must be at most 255");
+    }
+    if (distortion.block_size < 1) {
+        throw std::invalid_argument("Block size must be at least 1");
+    }
+    if (!(distortion.drop_rate >= 0.0 && distortion.drop_rate < 1.0)) {
+        throw std::invalid_argument("Drop rate must be in [0, 1)");
+    }
+    int shown = shown_frame(index, distortion.drop_rate);
+    render_planes(shown, pool);
+    distort_planes(shown, distortion, pool);
+    pack(out, pool);
+}
+
+} // namespace rdmeter
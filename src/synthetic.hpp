@@ -0,0 +1,69 @@
+#pragma once
+
+#include "yuv_reader.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rdmeter {
+
+class ThreadPool;
+
+// Distortions of a synthetic distorted sequence, applied in this order. Strengths are in
+// 8-bit code values, at most 255, and scale with bit depth
+struct SynthDistortion {
+    int blur_radius = 0;      // Box blur radius in pixels of a full-resolution plane
+    double blockiness = 0.0;  // Largest DC offset added to each block
+    int block_size = 8;       // Block grid of a full-resolution plane
+    double noise = 0.0;       // Standard deviation of added noise
+    double drop_rate = 0.0;   // Probability that a frame repeats the one before it
+};
+
+// A reproducible test sequence of any size and pixel format: a texture panning over a
+// drifting gradient with a hard edge, so frames have detail, motion and flat areas. Every
+// frame is a function of its index and the seed alone, so frames can be rendered in any
+// order and the same seed gives the same bytes on any machine and thread count
+class SyntheticVideo {
+public:
+    SyntheticVideo(int width, int height, PixelFormat format, uint64_t seed = 1);
+
+    // Bytes of one frame, as FrameReader reads the format
+    size_t frame_bytes() const { return rdmeter::frame_bytes(format_, width_, height_); }
+
+    // Write frame index of the reference to out, frame_bytes() long
+    void render(int index, uint8_t* out, ThreadPool& pool);
+
+    // Write frame index of the distorted sequence to out. A dropped frame is a copy of
+    // the distorted frame before it, as a decoder repeating frames would output
+    void render(int index, const SynthDistortion& distortion, uint8_t* out, ThreadPool& pool);
+
+    // Frame of the reference that distorted frame index shows: index itself unless dropped
+    int shown_frame(int index, double drop_rate) const;
+
+private:
+    // A sample plane: luma or chroma of YCbCr input, or one RGB channel
+    struct Plane {
+        int width;
+        int height;
+        int scale;                  // 1 for full resolution, 2 for subsampled chroma
+        int level;                  // Centre of the gradient, in 8-bit code values
+        int span;                   // Gradient range, in 8-bit code values
+        std::vector<int16_t> tile;  // 256x256 texture, in 1/16 code values
+        std::vector<uint16_t> samples;
+    };
+
+    void render_planes(int index, ThreadPool& pool);
+    void distort_planes(int index, const SynthDistortion& distortion, ThreadPool& pool);
+    void pack(uint8_t* out, ThreadPool& pool) const;
+
+    int width_;
+    int height_;
+    PixelFormat format_;
+    uint64_t seed_;
+    int bit_depth_;
+    std::vector<Plane> planes_;
+    std::vector<uint16_t> scratch_;  // Blur intermediate
+    std::vector<int> offsets_;       // Block offsets of one plane
+};
+
+} // namespace rdmeter
@@ -1,4 +1,138 @@
 #pragma once
 
-// Placeholder for threading utilities
-// To be implemented later
\ No newline at end of file
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rdmeter {
+
+// Number of hardware threads, never less than 1
+inline unsigned hardware_threads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+// Fixed-size worker pool for data-parallel loops over frames, images or refits.
+// The calling thread participates as worker 0, so a pool of size 1 spawns no threads.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned num_threads = 0)
+        : size_(num_threads == 0 ? hardware_threads() : num_threads) {
+        for (unsigned id = 1; id < size_; ++id) {
+            workers_.emplace_back([this, id] { worker_loop(id); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return size_; }
+
+    // Run fn(index, worker_id) for every index in [0, count). worker_id is in
+    // [0, size()) and is stable for the duration of one call, so it can be used
+    // to select per-thread scratch buffers. Blocks until all indices are done;
+    // the first exception thrown by fn is rethrown here.
+    void parallel_for(size_t count, const std::function<void(size_t, unsigned)>& fn) {
+        if (count == 0) {
+            return;
+        }
+        if (size_ == 1 || count == 1) {
+            for (size_t i = 0; i < count; ++i) {
+                fn(i, 0);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = &fn;
+            job_count_ = count;
+            next_index_ = 0;
+            active_workers_ = static_cast<unsigned>(workers_.size());
+            error_ = nullptr;
+            ++generation_;
+        }
+        wake_.notify_all();
+
+        run_job(0);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return active_workers_ == 0; });
+        job_ = nullptr;
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+    }
+
+private:
+    void worker_loop(unsigned id) {
+        size_t seen_generation = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&] { return stopping_ || generation_ != seen_generation; });
+                if (stopping_) {
+                    return;
+                }
+                seen_generation = generation_;
+            }
+
+            run_job(id);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--active_workers_ == 0) {
+                done_.notify_one();
+            }
+        }
+    }
+
+    void run_job(unsigned id) {
+        while (true) {
+            size_t i = next_index_.fetch_add(1);
+            if (i >= job_count_) {
+                return;
+            }
+            try {
+                (*job_)(i, id);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!error_) {
+                    error_ = std::current_exception();
+                }
+                // Drain the remaining indices so every worker finishes promptly
+                next_index_ = job_count_;
+            }
+        }
+    }
+
+    unsigned size_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const std::function<void(size_t, unsigned)>* job_ = nullptr;
+    size_t job_count_ = 0;
+    std::atomic<size_t> next_index_{0};
+    unsigned active_workers_ = 0;
+    size_t generation_ = 0;
+    bool stopping_ = false;
+    std::exception_ptr error_;
+};
+
+} // namespace rdmeter
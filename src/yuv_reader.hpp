@@ -1,30 +1,65 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <fstream>
 #include <stdexcept>
 #include <string>
+#include <algorithm>
+#include "color.hpp"
 
 namespace rdmeter {
 
 // Structure to hold a YUV420p frame
+// 8-bit frames use y/u/v; deeper frames (bit_depth > 8) use y16/u16/v16 instead
 struct YUVFrame {
     std::vector<uint8_t> y;  // Luma plane
     std::vector<uint8_t> u;  // Chroma U plane
     std::vector<uint8_t> v;  // Chroma V plane
+    std::vector<uint16_t> y16;  // High bit depth luma plane
+    std::vector<uint16_t> u16;  // High bit depth chroma U plane
+    std::vector<uint16_t> v16;  // High bit depth chroma V plane
     int width;
     int height;
+    int bit_depth;
 
-    YUVFrame(int w, int h) : width(w), height(h) {
-        y.resize(width * height);
-        u.resize((width / 2) * (height / 2));
-        v.resize((width / 2) * (height / 2));
+    YUVFrame(int w, int h, int depth = 8) : width(w), height(h), bit_depth(depth) {
+        size_t luma = static_cast<size_t>(width) * height;
+        size_t chroma = static_cast<size_t>(width / 2) * (height / 2);
+        if (bit_depth > 8) {
+            y16.resize(luma);
+            u16.resize(chroma);
+            v16.resize(chroma);
+        } else {
+            y.resize(luma);
+            u.resize(chroma);
+            v.resize(chroma);
+        }
     }
 };
 
-// Function to read a single YUV420p frame from a file stream
-YUVFrame read_yuv420p_frame(std::ifstream& file, int width, int height) {
-    YUVFrame frame(width, height);
+// Size in bytes of one YUV420p frame on disk
+inline size_t yuv420p_frame_bytes(int width, int height) {
+    return static_cast<size_t>(width) * height + 2 * static_cast<size_t>(width / 2) * (height / 2);
+}
+
+// Bytes a YUVFrame of the given depth occupies in memory
+inline size_t yuv420_storage_bytes(int width, int height, int bit_depth) {
+    return yuv420p_frame_bytes(width, height) * (bit_depth > 8 ? 2 : 1);
+}
+
+// Read a single YUV420p frame from a file stream into an existing frame's buffers
+inline void read_yuv420p_frame(std::ifstream& file, YUVFrame& frame) {
+    if (frame.bit_depth > 8) {
+        // Little-endian 16-bit samples are read straight into the planes on little-endian hosts
+        for (auto* plane : {&frame.y16, &frame.u16, &frame.v16}) {
+            file.read(reinterpret_cast<char*>(plane->data()), static_cast<std::streamsize>(plane->size() * 2));
+            if (!file) {
+                throw std::runtime_error("Failed to read plane from YUV file");
+            }
+        }
+        return;
+    }
 
     // Read Y plane
     file.read(reinterpret_cast<char*>(frame.y.data()), frame.y.size());
@@ -43,8 +78,216 @@ YUVFrame read_yuv420p_frame(std::ifstream& file, int width, int height) {
     if (!file) {
         throw std::runtime_error("Failed to read V plane from YUV file");
     }
+}
 
+// Function to read a single YUV420p frame from a file stream
+inline YUVFrame read_yuv420p_frame(std::ifstream& file, int width, int height) {
+    YUVFrame frame(width, height);
+    read_yuv420p_frame(file, frame);
     return frame;
 }
 
+// Raw input layouts that can be read into a YUV420p frame
+enum class PixelFormat {
+    YUV420P,  // Planar 8-bit 4:2:0
+    YUV420P10LE,  // Planar 10-bit 4:2:0 in little-endian 16-bit words
+    YUV420P12LE,  // Planar 12-bit 4:2:0 in little-endian 16-bit words
+    RGB24,    // Interleaved 8-bit R, G, B
+    RGB48LE   // Interleaved 16-bit little-endian R, G, B
+};
+
+inline PixelFormat parse_pixel_format(const std::string& name) {
+    if (name == "yuv420p") return PixelFormat::YUV420P;
+    if (name == "yuv420p10le") return PixelFormat::YUV420P10LE;
+    if (name == "yuv420p12le") return PixelFormat::YUV420P12LE;
+    if (name == "rgb24") return PixelFormat::RGB24;
+    if (name == "rgb48le" || name == "rgb48") return PixelFormat::RGB48LE;
+    throw std::invalid_argument("Unknown pixel format: " + name + " (expected yuv420p, yuv420p10le, yuv420p12le, rgb24 or rgb48le)");
+}
+
+// Bit depth of the YUV frames a format is read into (RGB is converted to 8-bit YCbCr)
+inline int pixel_format_bit_depth(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::YUV420P10LE: return 10;
+        case PixelFormat::YUV420P12LE: return 12;
+        default: return 8;
+    }
+}
+
+// Size in bytes of one frame of the given format on disk
+inline size_t frame_bytes(PixelFormat format, int width, int height) {
+    size_t pixels = static_cast<size_t>(width) * height;
+    switch (format) {
+        case PixelFormat::RGB24: return pixels * 3;
+        case PixelFormat::RGB48LE: return pixels * 6;
+        case PixelFormat::YUV420P10LE:
+        case PixelFormat::YUV420P12LE: return yuv420p_frame_bytes(width, height) * 2;
+        default: return yuv420p_frame_bytes(width, height);
+    }
+}
+
+// Reads frames of any PixelFormat into YUV420p frames
+// RGB input is converted to YCbCr one row pair at a time while reading, so only a
+// two-row staging buffer exists besides the destination frame
+class FrameReader {
+public:
+    FrameReader(std::ifstream& file, int width, int height, PixelFormat format,
+                ColorMatrix matrix = ColorMatrix::BT709, ColorRange range = ColorRange::Limited)
+        : file_(file), width_(width), height_(height), format_(format) {
+        if (format_ == PixelFormat::RGB24 || format_ == PixelFormat::RGB48LE) {
+            int bits = format_ == PixelFormat::RGB48LE ? 16 : 8;
+            coefficients_ = make_rgb_to_yuv(matrix, range, bits);
+            rows_.resize(2 * static_cast<size_t>(width_) * 3 * (bits / 8));
+        }
+    }
+
+    size_t frame_bytes() const { return rdmeter::frame_bytes(format_, width_, height_); }
+
+    // Seek to the start of frame index
+    void seek(int index) {
+        file_.clear();
+        file_.seekg(static_cast<std::streamoff>(index) * static_cast<std::streamoff>(frame_bytes()));
+        next_row_ = 0;
+    }
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int bit_depth() const { return pixel_format_bit_depth(format_); }
+
+    // Luma rows of a frame that are complete once its first `bytes` bytes are on disk
+    // RGB is converted in row pairs, so only whole pairs count until the last row
+    int rows_available(size_t bytes) const {
+        int rows = static_cast<int>(std::min(bytes / luma_row_bytes(), static_cast<size_t>(height_)));
+        if (is_rgb() && rows < height_) {
+            rows &= ~1;
+        }
+        return rows;
+    }
+
+    // Read the next frame; throws std::runtime_error on a short read like read_yuv420p_frame
+    // frame must have been created with bit_depth()
+    void read(YUVFrame& frame) {
+        if (!is_rgb() && next_row_ == 0) {
+            check_depth(frame);
+            read_yuv420p_frame(file_, frame);
+            return;
+        }
+        finish_frame(frame);
+    }
+
+    // Row-band reading for streaming: read up to `rows` more luma rows of the current frame
+    // (RGB also converts their chroma, and reads whole row pairs until the last row).
+    // Returns the number of luma rows of the frame read so far
+    int read_rows(YUVFrame& frame, int rows) {
+        check_depth(frame);
+        int end = std::min(height_, next_row_ + std::max(rows, 0));
+        if (is_rgb() && end < height_) {
+            end = next_row_ + ((end - next_row_) & ~1);
+        }
+        if (end <= next_row_) {
+            return next_row_;
+        }
+
+        if (!is_rgb()) {
+            size_t offset = static_cast<size_t>(next_row_) * width_;
+            size_t count = static_cast<size_t>(end - next_row_) * width_;
+            char* dest = frame.bit_depth > 8 ? reinterpret_cast<char*>(frame.y16.data() + offset)
+                                             : reinterpret_cast<char*>(frame.y.data() + offset);
+            file_.read(dest, static_cast<std::streamsize>(count * (frame.bit_depth > 8 ? 2 : 1)));
+            if (!file_) {
+                throw std::runtime_error("Failed to read Y plane from YUV file");
+            }
+            next_row_ = end;
+            return next_row_;
+        }
+
+        size_t row_bytes = luma_row_bytes();
+        int chroma_width = width_ / 2;
+        int chroma_height = height_ / 2;
+        for (int y = next_row_; y < end; y += 2) {
+            int pair_rows = std::min(2, height_ - y);
+            file_.read(reinterpret_cast<char*>(rows_.data()), static_cast<std::streamsize>(pair_rows * row_bytes));
+            if (!file_) {
+                throw std::runtime_error("Failed to read RGB rows from input file");
+            }
+
+            // The chroma row of an odd last luma row is dropped, matching the YUV420p plane size
+            uint8_t* u = y / 2 < chroma_height ? &frame.u[static_cast<size_t>(y / 2) * chroma_width] : scratch_chroma(chroma_width);
+            uint8_t* v = y / 2 < chroma_height ? &frame.v[static_cast<size_t>(y / 2) * chroma_width] : scratch_chroma(chroma_width) + chroma_width;
+            uint8_t* y0 = &frame.y[static_cast<size_t>(y) * width_];
+            uint8_t* y1 = pair_rows == 2 ? y0 + width_ : nullptr;
+
+            if (format_ == PixelFormat::RGB24) {
+                const uint8_t* row0 = rows_.data();
+                rgb24_rows_to_yuv420p(row0, pair_rows == 2 ? row0 + row_bytes : nullptr, width_, coefficients_, y0, y1, u, v);
+            } else {
+                // Samples are little-endian on disk; the staging buffer is reinterpreted on little-endian hosts
+                const uint16_t* row0 = reinterpret_cast<const uint16_t*>(rows_.data());
+                rgb48_rows_to_yuv420p(row0, pair_rows == 2 ? row0 + 3 * width_ : nullptr, width_, coefficients_, y0, y1, u, v);
+            }
+        }
+        next_row_ = end;
+        return next_row_;
+    }
+
+    // Read the rest of the current frame: remaining luma rows, then the chroma planes of planar input
+    void finish_frame(YUVFrame& frame) {
+        read_rows(frame, height_);
+        next_row_ = 0;
+        if (is_rgb()) {
+            return;
+        }
+        if (frame.bit_depth > 8) {
+            for (auto* plane : {&frame.u16, &frame.v16}) {
+                file_.read(reinterpret_cast<char*>(plane->data()), static_cast<std::streamsize>(plane->size() * 2));
+                if (!file_) {
+                    throw std::runtime_error("Failed to read plane from YUV file");
+                }
+            }
+            return;
+        }
+        for (auto* plane : {&frame.u, &frame.v}) {
+            file_.read(reinterpret_cast<char*>(plane->data()), static_cast<std::streamsize>(plane->size()));
+            if (!file_) {
+                throw std::runtime_error(plane == &frame.u ? "Failed to read U plane from YUV file"
+                                                           : "Failed to read V plane from YUV file");
+            }
+        }
+    }
+
+private:
+    bool is_rgb() const { return format_ == PixelFormat::RGB24 || format_ == PixelFormat::RGB48LE; }
+
+    // Bytes on disk per luma row: one planar Y row, or one interleaved RGB row
+    size_t luma_row_bytes() const {
+        switch (format_) {
+            case PixelFormat::RGB24: return static_cast<size_t>(width_) * 3;
+            case PixelFormat::RGB48LE: return static_cast<size_t>(width_) * 6;
+            case PixelFormat::YUV420P10LE:
+            case PixelFormat::YUV420P12LE: return static_cast<size_t>(width_) * 2;
+            default: return static_cast<size_t>(width_);
+        }
+    }
+
+    void check_depth(const YUVFrame& frame) const {
+        if (frame.bit_depth != bit_depth()) {
+            throw std::invalid_argument("Frame bit depth does not match the input format");
+        }
+    }
+
+    uint8_t* scratch_chroma(int chroma_width) {
+        chroma_scratch_.resize(2 * static_cast<size_t>(chroma_width));
+        return chroma_scratch_.data();
+    }
+
+    std::ifstream& file_;
+    int width_;
+    int height_;
+    PixelFormat format_;
+    RgbToYuv coefficients_{};
+    std::vector<uint8_t> rows_;
+    std::vector<uint8_t> chroma_scratch_;
+    int next_row_ = 0;  // Luma rows of the current frame already read by read_rows
+};
+
 } // namespace rdmeter
\ No newline at end of file
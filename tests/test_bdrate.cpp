@@ -1,2 +1,192 @@
-// Placeholder for BD-Rate tests
-// To be implemented later
\ No newline at end of file
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include "src/bdrate.hpp"
+#include "src/threading.hpp"
+#include <cmath>
+#include <random>
+
+using namespace rdmeter;
+using Catch::Approx;
+
+namespace {
+
+// Four encodes along PSNR = 10 log10(bitrate) + offset
+std::vector<BdPoint> log_curve(double rate_scale, double offset = 0.0) {
+    std::vector<BdPoint> points;
+    for (double rate : {250.0, 500.0, 1000.0, 2000.0}) {
+        BdPoint point;
+        point.bitrate = rate * rate_scale;
+        point.quality = 10.0 * std::log10(rate) + offset;
+        points.push_back(point);
+    }
+    return points;
+}
+
+// A curve whose points carry noisy per-frame bits and quality
+std::vector<BdPoint> frame_curve(double rate_scale, std::mt19937& rng) {
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::vector<BdPoint> points;
+    for (double rate : {250.0, 500.0, 1000.0, 2000.0}) {
+        BdPoint point;
+        point.bitrate = rate * rate_scale;
+        for (int f = 0; f < 30; ++f) {
+            point.frame_quality.push_back(10.0 * std::log10(rate) + noise(rng));
+            point.frame_bits.push_back(point.bitrate * (1.0 + 0.1 * noise(rng)));
+        }
+        double sum = 0.0;
+        for (double q : point.frame_quality) {
+            sum += q;
+        }
+        point.quality = sum / point.frame_quality.size();
+        points.push_back(point);
+    }
+    return points;
+}
+
+} // namespace
+
+TEST_CASE("BD-rate", "[bdrate]") {
+    for (auto interpolation : {BdInterpolation::Pchip, BdInterpolation::Cubic}) {
+        auto ref = log_curve(1.0);
+        auto same = bd_rate(ref, ref, interpolation);
+        REQUIRE(same.bd_rate == Approx(0.0).margin(1e-9));
+        REQUIRE(same.bd_quality == Approx(0.0).margin(1e-9));
+
+        // 10% fewer bits for the same quality everywhere; quality rises 10 log10(1/0.9) dB
+        auto cheaper = bd_rate(ref, log_curve(0.9), interpolation);
+        REQUIRE(cheaper.bd_rate == Approx(-10.0).epsilon(1e-9));
+        REQUIRE(cheaper.bd_quality == Approx(-10.0 * std::log10(0.9)).epsilon(1e-9));
+
+        // A constant 0.5 dB gain at equal bitrate
+        REQUIRE(bd_rate(ref, log_curve(1.0, 0.5), interpolation).bd_quality == Approx(0.5).epsilon(1e-9));
+
+        // Curves that share no quality range
+        REQUIRE_THROWS_AS(bd_rate(ref, log_curve(1.0, 50.0), interpolation), std::invalid_argument);
+    }
+
+    auto three = log_curve(1.0);
+    three.pop_back();
+    REQUIRE_THROWS_AS(bd_rate(three, three, BdInterpolation::Cubic), std::invalid_argument);
+    REQUIRE_NOTHROW(bd_rate(three, three, BdInterpolation::Pchip));
+    auto duplicate = log_curve(1.0);
+    duplicate[1].quality = duplicate[0].quality;
+    REQUIRE_THROWS_AS(bd_rate(duplicate, log_curve(1.0)), std::invalid_argument);
+
+    REQUIRE(parse_bd_interpolation("cubic") == BdInterpolation::Cubic);
+    REQUIRE_THROWS_AS(parse_bd_interpolation("linear"), std::invalid_argument);
+    REQUIRE(parse_bootstrap_mode("both") == BootstrapMode::Both);
+    REQUIRE_THROWS_AS(parse_bootstrap_mode("jackknife"), std::invalid_argument);
+}
+
+TEST_CASE("BD-rate bootstrap", "[bdrate]") {
+    std::mt19937 rng(5);
+    std::vector<BdSequence> sequences;
+    for (int s = 0; s < 5; ++s) {
+        double scale = 0.85 + 0.02 * s;
+        sequences.push_back({"seq" + std::to_string(s), frame_curve(1.0, rng), frame_curve(scale, rng)});
+    }
+
+    BootstrapOptions options;
+    options.samples = 200;
+    options.seed = 42;
+    auto plain = bd_rate_summary(sequences, BdInterpolation::Pchip, options);
+    REQUIRE(plain.sequences.size() == 5);
+    REQUIRE(plain.replicates == 0);
+
+    for (auto mode : {BootstrapMode::Sequences, BootstrapMode::Frames, BootstrapMode::Both}) {
+        options.mode = mode;
+        ThreadPool one(1), four(4);
+        auto serial = bd_rate_summary(sequences, BdInterpolation::Pchip, options);
+        auto single = bd_rate_summary(sequences, BdInterpolation::Pchip, options, &one);
+        auto parallel = bd_rate_summary(sequences, BdInterpolation::Pchip, options, &four);
+
+        // Every replicate has its own generator, so threads do not change the result
+        REQUIRE(parallel.replicates == serial.replicates);
+        REQUIRE(parallel.bd_rate_interval.low == serial.bd_rate_interval.low);
+        REQUIRE(parallel.bd_rate_interval.high == serial.bd_rate_interval.high);
+        REQUIRE(single.bd_quality_interval.std_dev == serial.bd_quality_interval.std_dev);
+
+        REQUIRE(serial.mean.bd_rate == plain.mean.bd_rate);
+        REQUIRE(serial.bd_rate_interval.low < serial.mean.bd_rate);
+        REQUIRE(serial.bd_rate_interval.high > serial.mean.bd_rate);
+        REQUIRE(serial.bd_rate_interval.std_dev > 0.0);
+
+        // Another seed draws other samples
+        BootstrapOptions reseeded = options;
+        reseeded.seed = 43;
+        REQUIRE(bd_rate_summary(sequences, BdInterpolation::Pchip, reseeded).bd_rate_interval.low !=
+                serial.bd_rate_interval.low);
+    }
+
+    // Frame resampling needs per-frame data of equal length
+    options.mode = BootstrapMode::Frames;
+    auto uneven = sequences;
+    uneven[2].test[1].frame_quality.pop_back();
+    REQUIRE_THROWS_AS(bd_rate_summary(uneven, BdInterpolation::Pchip, options), std::invalid_argument);
+    options.mode = BootstrapMode::Sequences;
+    REQUIRE_THROWS_AS(bd_rate_summary({sequences[0]}, BdInterpolation::Pchip, options), std::invalid_argument);
+}
+
+TEST_CASE("Percentile interval", "[bdrate]") {
+    std::vector<double> values;
+    for (int i = 100; i >= 0; --i) {
+        values.push_back(i);
+    }
+    auto interval = percentile_interval(values, 0.9);
+    REQUIRE(interval.low == Approx(5.0));
+    REQUIRE(interval.high == Approx(95.0));
+    REQUIRE(interval.std_dev == Approx(std::sqrt(101.0 * 102.0 / 12.0)));
+
+    std::vector<double> empty;
+    REQUIRE_THROWS_AS(percentile_interval(empty, 0.95), std::runtime_error);
+}
+
+TEST_CASE("BD matrix", "[bdrate]") {
+    // Config x fits every sequence with 10% fewer bits; config y lacks sequence b and
+    // has an unusable curve for c
+    BdTable table;
+    table.metrics = {"psnr_y", "twice"};
+    table.qualities.resize(2);
+    auto add = [&](const std::string& config, const std::string& sequence, const std::vector<BdPoint>& curve) {
+        for (const auto& point : curve) {
+            table.configs.push_back(config);
+            table.sequences.push_back(sequence);
+            table.bitrates.push_back(point.bitrate);
+            table.qualities[0].push_back(point.quality);
+            table.qualities[1].push_back(2.0 * point.quality);
+        }
+    };
+    for (const std::string sequence : {"a", "b", "c"}) {
+        add("x", sequence, log_curve(0.9));
+        add("anchor", sequence, log_curve(1.0));
+    }
+    add("y", "a", log_curve(1.1));
+    add("y", "c", {log_curve(1.0)[0]});
+
+    ThreadPool pool(3);
+    auto matrix = bd_matrix(table, "anchor", BdInterpolation::Pchip, &pool);
+    REQUIRE(matrix.configs == std::vector<std::string>{"x", "y"});
+    REQUIRE(matrix.sequences == std::vector<std::string>{"a", "b", "c"});
+    REQUIRE(matrix.cells.size() == 12);
+
+    for (size_t s = 0; s < 3; ++s) {
+        REQUIRE(matrix.cells[matrix.cell_index(0, s, 0)].bd_rate == Approx(-10.0));
+        REQUIRE(matrix.cells[matrix.cell_index(0, s, 1)].bd_quality ==
+                Approx(2.0 * matrix.cells[matrix.cell_index(0, s, 0)].bd_quality));
+    }
+    REQUIRE(matrix.averages[0].bd_rate == Approx(-10.0));
+    REQUIRE(matrix.counts[0] == 3);
+
+    REQUIRE(matrix.cells[matrix.cell_index(1, 0, 0)].bd_rate == Approx(10.0));
+    REQUIRE(matrix.errors[matrix.cell_index(1, 1, 0)] == "Not in this config");
+    REQUIRE(std::isnan(matrix.cells[matrix.cell_index(1, 1, 0)].bd_rate));
+    REQUIRE(!matrix.errors[matrix.cell_index(1, 2, 1)].empty());
+    REQUIRE(matrix.counts[2] == 1);
+    REQUIRE(matrix.averages[2].bd_rate == Approx(10.0));
+
+    // The same cells without a pool
+    auto serial = bd_matrix(table, "anchor", BdInterpolation::Pchip);
+    REQUIRE(serial.cells[matrix.cell_index(0, 1, 1)].bd_rate == matrix.cells[matrix.cell_index(0, 1, 1)].bd_rate);
+
+    REQUIRE_THROWS_AS(bd_matrix(table, "missing", BdInterpolation::Pchip), std::invalid_argument);
+}
@@ -0,0 +1,308 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include "src/bitstream.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+using namespace rdmeter;
+using Catch::Approx;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Builds NAL payloads bit by bit, then adds emulation prevention the way an encoder does
+class BitWriter {
+public:
+    BitWriter& bits(uint32_t value, int count) {
+        for (int i = count - 1; i >= 0; --i) {
+            bit((value >> i) & 1);
+        }
+        return *this;
+    }
+    BitWriter& bit(uint32_t value) {
+        current_ = static_cast<uint8_t>(current_ << 1 | value);
+        if (++used_ == 8) {
+            bytes_.push_back(current_);
+            used_ = 0;
+        }
+        return *this;
+    }
+    BitWriter& ue(uint32_t value) {
+        int length = 0;
+        while ((value + 1) >> (length + 1)) {
+            ++length;
+        }
+        bits(0, length);
+        return bits(value + 1, length + 1);
+    }
+    BitWriter& se(int32_t value) {
+        return ue(value > 0 ? 2 * value - 1 : -2 * value);
+    }
+    // rbsp_trailing_bits plus filler, so NAL sizes differ between pictures
+    std::vector<uint8_t> finish(size_t filler = 0) {
+        bit(1);
+        while (used_ != 0) {
+            bit(0);
+        }
+        bytes_.insert(bytes_.end(), filler, 0xa5);
+        std::vector<uint8_t> escaped;
+        int zeros = 0;
+        for (uint8_t byte : bytes_) {
+            if (zeros >= 2 && byte <= 3) {
+                escaped.push_back(3);
+                zeros = 0;
+            }
+            escaped.push_back(byte);
+            zeros = byte == 0 ? zeros + 1 : 0;
+        }
+        return escaped;
+    }
+
+private:
+    std::vector<uint8_t> bytes_;
+    uint8_t current_ = 0;
+    int used_ = 0;
+};
+
+struct AnnexB {
+    std::vector<uint8_t> data;
+    // Appends a NAL unit; returns its size in the stream, start code included
+    size_t add(const std::vector<uint8_t>& header, const std::vector<uint8_t>& payload, bool long_start = true) {
+        size_t before = data.size();
+        if (long_start) {
+            data.push_back(0);
+        }
+        data.insert(data.end(), {0, 0, 1});
+        data.insert(data.end(), header.begin(), header.end());
+        data.insert(data.end(), payload.begin(), payload.end());
+        return data.size() - before;
+    }
+};
+
+BitstreamSummary parse(const std::vector<uint8_t>& data, BitstreamFormat format) {
+    return parse_bitstream(data.data(), data.size(), format);
+}
+
+} // namespace
+
+TEST_CASE("H.264 Annex-B parsing", "[bitstream]") {
+    AnnexB stream;
+    std::vector<uint64_t> picture_bytes;
+
+    // Baseline SPS with a 16-bit frame_num (whose zero bytes force emulation prevention)
+    // and a 4-bit order count LSB, so the count wraps within the test
+    size_t leading = stream.add({0x67}, BitWriter().bits(66, 8).bits(0, 8).bits(30, 8).ue(0)
+                                            .ue(12).ue(0).ue(0).ue(1).bit(0).ue(10).ue(8).bit(1).finish());
+    leading += stream.add({0x68}, BitWriter().ue(0).ue(0).finish());
+
+    // slice_type: 7 = I, 5 = P, 6 = B
+    auto slice = [&](int nal_type, int ref_idc, uint32_t first_mb, uint32_t slice_type, uint32_t poc_lsb, size_t filler) {
+        BitWriter writer;
+        writer.ue(first_mb).ue(slice_type).ue(0).bits(0, 16);
+        if (nal_type == 5) {
+            writer.ue(0);
+        }
+        writer.bits(poc_lsb, 4);
+        return stream.add({static_cast<uint8_t>(ref_idc << 5 | nal_type)}, writer.finish(filler), first_mb == 0);
+    };
+    auto picture = [&](int nal_type, int ref_idc, uint32_t slice_type, uint32_t poc_lsb, size_t filler) {
+        size_t bytes = stream.add({0x09}, {0x10});  // Access unit delimiter
+        bytes += slice(nal_type, ref_idc, 0, slice_type, poc_lsb, filler);
+        picture_bytes.push_back(bytes);
+    };
+
+    // Decode order I0 P6 B2 B4 | P12 P18 (LSB 2 after wrapping) | IDR I0 P2
+    picture(5, 3, 7, 0, 100);
+    picture_bytes[0] += leading;
+    picture(1, 2, 5, 6, 50);
+    picture(1, 0, 6, 2, 10);
+    picture_bytes.back() += slice(1, 0, 40, 7, 2, 5);  // Second slice, on a 3-byte start code
+    picture(1, 0, 6, 4, 11);
+    picture(1, 2, 5, 12, 40);
+    picture(1, 2, 5, 2, 41);
+    picture(5, 3, 7, 0, 90);
+    picture(1, 2, 5, 2, 30);
+
+    auto summary = parse(stream.data, BitstreamFormat::H264);
+    REQUIRE(summary.codec == "h264");
+    REQUIRE(summary.total_bytes == stream.data.size());
+    REQUIRE(summary.frame_rate == 0.0);
+    const std::vector<size_t> display = {0, 2, 3, 1, 4, 5, 6, 7};
+    const std::vector<PictureType> types = {PictureType::I, PictureType::B, PictureType::B, PictureType::P,
+                                            PictureType::P, PictureType::P, PictureType::I, PictureType::P};
+    REQUIRE(summary.pictures.size() == display.size());
+    uint64_t sum = 0;
+    for (size_t i = 0; i < display.size(); ++i) {
+        REQUIRE(summary.pictures[i].bytes == picture_bytes[display[i]]);
+        REQUIRE(summary.pictures[i].type == types[i]);
+        sum += summary.pictures[i].bytes;
+    }
+    REQUIRE(sum == summary.total_bytes);
+
+    REQUIRE_THROWS_AS(parse(std::vector<uint8_t>(64, 0xff), BitstreamFormat::H264), std::runtime_error);
+}
+
+TEST_CASE("HEVC Annex-B parsing", "[bitstream]") {
+    AnnexB stream;
+    std::vector<uint64_t> picture_bytes;
+
+    size_t leading = stream.add({0x40, 0x01}, BitWriter().bits(0, 16).finish());  // VPS, not parsed
+    BitWriter sps;
+    sps.bits(0, 4).bits(0, 3).bit(1).bits(0, 32).bits(0, 32).bits(0, 24).bits(93, 8);  // One layer, profile tier level
+    sps.ue(0).ue(1).ue(64).ue(64).bit(0).ue(0).ue(0).ue(4);  // 8-bit order count LSB
+    leading += stream.add({0x42, 0x01}, sps.finish());
+    // One extra slice header bit, which the parser must skip
+    leading += stream.add({0x44, 0x01}, BitWriter().ue(0).ue(0).bit(0).bit(0).bits(1, 3).finish());
+
+    // slice_type: 0 = B, 1 = P, 2 = I
+    auto picture = [&](int nal_type, uint32_t slice_type, uint32_t poc_lsb, size_t filler, bool second_segment = false) {
+        size_t bytes = stream.add({0x46, 0x01}, {0x50});  // Access unit delimiter
+        BitWriter writer;
+        writer.bit(1);
+        if (nal_type >= 16 && nal_type <= 23) {
+            writer.bit(0);
+        }
+        writer.ue(0).bit(0).ue(slice_type);
+        if (nal_type != 19 && nal_type != 20) {
+            writer.bits(poc_lsb, 8);
+        }
+        bytes += stream.add({static_cast<uint8_t>(nal_type << 1), 0x01}, writer.finish(filler));
+        if (second_segment) {
+            bytes += stream.add({static_cast<uint8_t>(nal_type << 1), 0x01}, BitWriter().bit(0).ue(0).finish(7));
+        }
+        picture_bytes.push_back(bytes);
+    };
+
+    // Decode order IDR0 P4 B2 (non-reference) | CRA8 B6 (RASL) P12
+    picture(19, 2, 0, 200);
+    picture_bytes[0] += leading;
+    picture(1, 1, 4, 80, true);
+    picture(0, 0, 2, 20);
+    picture(21, 2, 8, 150);
+    picture(8, 0, 6, 15);
+    picture(1, 1, 12, 60);
+    size_t trailing = stream.add({0x4a, 0x01}, {});  // End of sequence
+
+    auto summary = parse(stream.data, BitstreamFormat::HEVC);
+    REQUIRE(summary.codec == "hevc");
+    picture_bytes.back() += trailing;
+    const std::vector<size_t> display = {0, 2, 1, 4, 3, 5};
+    const std::vector<PictureType> types = {PictureType::I, PictureType::B, PictureType::P,
+                                            PictureType::B, PictureType::I, PictureType::P};
+    REQUIRE(summary.pictures.size() == display.size());
+    for (size_t i = 0; i < display.size(); ++i) {
+        REQUIRE(summary.pictures[i].bytes == picture_bytes[display[i]]);
+        REQUIRE(summary.pictures[i].type == types[i]);
+    }
+    REQUIRE(summary.total_bytes == stream.data.size());
+}
+
+TEST_CASE("IVF and OBU parsing", "[bitstream]") {
+    auto le = [](std::vector<uint8_t>& out, uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i) {
+            out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    };
+    auto ivf = [&](const char* fourcc, uint32_t rate, uint32_t scale, const std::vector<std::vector<uint8_t>>& frames,
+                   uint64_t pts_step) {
+        std::vector<uint8_t> out = {'D', 'K', 'I', 'F', 0, 0, 32, 0};
+        out.insert(out.end(), fourcc, fourcc + 4);
+        le(out, 64, 2);
+        le(out, 64, 2);
+        le(out, rate, 4);
+        le(out, scale, 4);
+        le(out, frames.size(), 4);
+        le(out, 0, 4);
+        for (size_t i = 0; i < frames.size(); ++i) {
+            le(out, frames[i].size(), 4);
+            le(out, i * pts_step, 8);
+            out.insert(out.end(), frames[i].begin(), frames[i].end());
+        }
+        return out;
+    };
+
+    SECTION("VP9 key and inter frames, rate from timestamps") {
+        // frame_marker 2, profile 0, show_existing_frame 0, then frame_type (0 = key)
+        std::vector<std::vector<uint8_t>> frames = {std::vector<uint8_t>(300, 0x80), std::vector<uint8_t>(40, 0x84),
+                                                    std::vector<uint8_t>(45, 0x84)};
+        auto summary = parse(ivf("VP90", 1000, 1, frames, 40), BitstreamFormat::IVF);
+        REQUIRE(summary.codec == "vp9");
+        REQUIRE(summary.frame_rate == Approx(25.0));
+        REQUIRE(summary.total_bytes == 385);
+        REQUIRE(summary.pictures.size() == 3);
+        REQUIRE(summary.pictures[0].type == PictureType::I);
+        REQUIRE(summary.pictures[1].type == PictureType::P);
+        REQUIRE(summary.pictures[2].bytes == 45);
+    }
+
+    SECTION("VP8 frames, rate from the time base of a single frame") {
+        auto summary = parse(ivf("VP80", 30, 1, {std::vector<uint8_t>(10, 0x10)}, 1), BitstreamFormat::IVF);
+        REQUIRE(summary.codec == "vp8");
+        REQUIRE(summary.frame_rate == Approx(30.0));
+        REQUIRE(summary.pictures[0].type == PictureType::I);
+    }
+
+    // Temporal units: delimiter, optional sequence header, then frames
+    const std::vector<uint8_t> delimiter = {0x12, 0x00};
+    const std::vector<uint8_t> sequence_header = {0x0a, 0x01, 0x00};
+    auto frame_obu = [](uint8_t first_byte, size_t size) {
+        std::vector<uint8_t> obu = {0x32, static_cast<uint8_t>(size), first_byte};
+        obu.resize(2 + size, 0x55);
+        return obu;
+    };
+    auto unit = [&](std::vector<std::vector<uint8_t>> parts) {
+        std::vector<uint8_t> out;
+        for (const auto& part : parts) {
+            out.insert(out.end(), part.begin(), part.end());
+        }
+        return out;
+    };
+    // Key frame; hidden inter frame then a shown one; a repeated frame (show_existing_frame)
+    std::vector<std::vector<uint8_t>> units = {
+        unit({delimiter, sequence_header, frame_obu(0x10, 90)}),
+        unit({delimiter, frame_obu(0x20, 60), frame_obu(0x30, 20)}),
+        unit({delimiter, {0x1a, 0x01, 0x80}}),
+        unit({delimiter, frame_obu(0x50, 30)}),  // Intra-only
+    };
+    const std::vector<PictureType> types = {PictureType::I, PictureType::P, PictureType::P, PictureType::I};
+
+    SECTION("AV1 OBU stream") {
+        std::vector<uint8_t> stream;
+        for (const auto& u : units) {
+            stream.insert(stream.end(), u.begin(), u.end());
+        }
+        auto summary = parse(stream, BitstreamFormat::OBU);
+        REQUIRE(summary.codec == "av1");
+        REQUIRE(summary.pictures.size() == units.size());
+        for (size_t i = 0; i < units.size(); ++i) {
+            REQUIRE(summary.pictures[i].bytes == units[i].size());
+            REQUIRE(summary.pictures[i].type == types[i]);
+        }
+        stream.resize(stream.size() - 5);
+        REQUIRE_THROWS_AS(parse(stream, BitstreamFormat::OBU), std::runtime_error);
+    }
+
+    SECTION("AV1 in IVF") {
+        auto summary = parse(ivf("AV01", 30000, 1001, units, 1), BitstreamFormat::IVF);
+        REQUIRE(summary.codec == "av1");
+        REQUIRE(summary.frame_rate == Approx(29.97).epsilon(1e-3));
+        for (size_t i = 0; i < units.size(); ++i) {
+            REQUIRE(summary.pictures[i].type == types[i]);
+        }
+    }
+
+    SECTION("Format names and detection") {
+        REQUIRE(parse_bitstream_format("hevc") == BitstreamFormat::HEVC);
+        REQUIRE_THROWS_AS(parse_bitstream_format("mpeg2"), std::invalid_argument);
+        REQUIRE(detect_bitstream_format("enc/q30.264") == BitstreamFormat::H264);
+        REQUIRE(detect_bitstream_format("enc/q30.HEVC") == BitstreamFormat::HEVC);
+
+        fs::path path = fs::temp_directory_path() / "rdmeter_test_stream.webm_dump";
+        auto data = ivf("VP90", 30, 1, {{0x80}}, 1);
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(data.data()), data.size());
+        REQUIRE(detect_bitstream_format(path.string()) == BitstreamFormat::IVF);
+        REQUIRE(parse_bitstream_file(path.string(), BitstreamFormat::IVF).pictures.size() == 1);
+        fs::remove(path);
+    }
+}
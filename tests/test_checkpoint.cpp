@@ -0,0 +1,72 @@
+#include <catch2/catch_test_macros.hpp>
+#include "src/checkpoint.hpp"
+#include <filesystem>
+#include <stdexcept>
+
+using namespace rdmeter;
+namespace fs = std::filesystem;
+
+namespace {
+
+ComputeCheckpoint sample_checkpoint() {
+    ComputeCheckpoint checkpoint;
+    checkpoint.ref_file = "/data/ref.yuv";
+    checkpoint.dist_file = "/data/dist.yuv";
+    checkpoint.ref_size = 1234567;
+    checkpoint.dist_size = 1234567;
+    checkpoint.width = 3840;
+    checkpoint.height = 2160;
+    checkpoint.metrics = {"psnr", "msssim"};
+    checkpoint.frame_index = 4096;
+    checkpoint.valid_frames = 4095;
+    checkpoint.sums["psnr_y"] = 160123.45678901234;
+    checkpoint.sums["msssim_y"] = 4094.1 / 3.0;
+    checkpoint.per_frame_offset = 524288;
+    return checkpoint;
+}
+
+} // namespace
+
+TEST_CASE("Checkpoint round trip", "[checkpoint]") {
+    fs::path path = fs::temp_directory_path() / "rdmeter_test_checkpoint.json";
+    auto original = sample_checkpoint();
+
+    SECTION("Sums are restored bit-exactly") {
+        save_checkpoint(path.string(), original);
+        auto loaded = load_checkpoint(path.string());
+
+        REQUIRE(loaded.frame_index == original.frame_index);
+        REQUIRE(loaded.valid_frames == original.valid_frames);
+        REQUIRE(loaded.sums == original.sums);
+        REQUIRE(loaded.metrics == original.metrics);
+        REQUIRE(loaded.per_frame_offset == original.per_frame_offset);
+        REQUIRE_NOTHROW(check_resumable(loaded, original));
+        REQUIRE_FALSE(fs::exists(path.string() + ".tmp"));
+    }
+
+    SECTION("Different run is refused") {
+        auto other = original;
+        other.dist_size += 1;
+        REQUIRE_THROWS_AS(check_resumable(original, other), std::runtime_error);
+
+        other = original;
+        other.metrics = {"psnr"};
+        REQUIRE_THROWS_AS(check_resumable(original, other), std::runtime_error);
+
+        // The per-frame file may have grown past the checkpoint, but not shrunk below it
+        other = original;
+        other.per_frame_offset += 100;
+        REQUIRE_NOTHROW(check_resumable(original, other));
+        other.per_frame_offset = original.per_frame_offset - 1;
+        REQUIRE_THROWS_AS(check_resumable(original, other), std::runtime_error);
+        other.per_frame_offset = -1;
+        REQUIRE_THROWS_AS(check_resumable(original, other), std::runtime_error);
+    }
+
+    SECTION("Missing file throws") {
+        REQUIRE_THROWS_AS(load_checkpoint((fs::temp_directory_path() / "rdmeter_no_such_checkpoint.json").string()),
+                          std::runtime_error);
+    }
+
+    fs::remove(path);
+}
@@ -0,0 +1,108 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include "src/ciede.hpp"
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using namespace rdmeter;
+using Catch::Approx;
+
+TEST_CASE("CIEDE2000 reference formula", "[ciede]") {
+    // Test pairs from Sharma, Wu and Dalal (2005), Table 1
+    struct Pair { Lab x, y; double expected; };
+    const Pair pairs[] = {
+        {{50.0, 2.6772, -79.7751}, {50.0, 0.0, -82.7485}, 2.0425},
+        {{50.0, 0.0, 0.0}, {50.0, -1.0, 2.0}, 2.3669},
+        {{50.0, 2.5, 0.0}, {73.0, 25.0, -18.0}, 27.1492},
+        {{50.0, 2.5, 0.0}, {61.0, -5.0, 29.0}, 22.8977},
+        {{60.2574, -34.0099, 36.2677}, {60.4626, -34.1751, 39.4387}, 1.2644},
+    };
+    for (const auto& pair : pairs) {
+        REQUIRE(ciede2000(pair.x, pair.y) == Approx(pair.expected).margin(1e-4));
+        REQUIRE(ciede2000(pair.y, pair.x) == Approx(pair.expected).margin(1e-4));
+    }
+    REQUIRE(ciede2000({40.0, 10.0, -20.0}, {40.0, 10.0, -20.0}) == 0.0);
+}
+
+TEST_CASE("Vectorised CIEDE2000 kernel", "[ciede]") {
+    // Deterministic spread of colours over the Lab gamut, including neutral and opposite hues
+    const int count = 2000;
+    std::vector<float> L1(count), a1(count), b1(count), L2(count), a2(count), b2(count), out(count);
+    uint32_t state = 12345;
+    auto next = [&](float lo, float hi) {
+        state = state * 1664525u + 1013904223u;
+        return lo + (hi - lo) * static_cast<float>(state >> 8) / 16777216.0f;
+    };
+    for (int i = 0; i < count; ++i) {
+        L1[i] = next(0, 100);
+        a1[i] = i % 10 == 0 ? 0.0f : next(-100, 100);
+        b1[i] = i % 10 == 0 ? 0.0f : next(-100, 100);
+        // Half of the pairs are near each other, as in real distortions
+        float spread = i % 2 ? 5.0f : 100.0f;
+        L2[i] = std::min(100.0f, std::max(0.0f, L1[i] + next(-spread, spread)));
+        a2[i] = a1[i] + next(-spread, spread);
+        b2[i] = b1[i] + next(-spread, spread);
+    }
+    ciede2000_block(L1.data(), a1.data(), b1.data(), L2.data(), a2.data(), b2.data(), count, out.data());
+    for (int i = 0; i < count; ++i) {
+        double expected = ciede2000({L1[i], a1[i], b1[i]}, {L2[i], a2[i], b2[i]});
+        REQUIRE(out[i] == Approx(expected).margin(2e-3).epsilon(1e-3));
+    }
+}
+
+TEST_CASE("YCbCr to Lab", "[ciede]") {
+    auto k = make_yuv_to_lab(ColorMatrix::BT709, ColorRange::Limited, 8);
+    const uint8_t y[] = {235, 16, 126};
+    const uint8_t u[] = {128};
+    const uint8_t v[] = {128};
+    float L[3], a[3], b[3];
+    yuv_row_to_lab(y, u, v, 2, k, L, a, b);
+    REQUIRE(L[0] == Approx(100.0).margin(1e-3));
+    REQUIRE(a[0] == Approx(0.0).margin(1e-3));
+    REQUIRE(b[0] == Approx(0.0).margin(1e-3));
+    REQUIRE(L[1] == Approx(0.0).margin(1e-3));
+
+    SECTION("Matches double-precision Lab of sRGB red") {
+        // BT.709 limited-range red: Y 63, Cb 102, Cr 240 (8-bit)
+        const uint8_t ry[] = {63, 63};
+        const uint8_t ru[] = {102};
+        const uint8_t rv[] = {240};
+        yuv_row_to_lab(ry, ru, rv, 2, k, L, a, b);
+        REQUIRE(L[0] == Approx(53.24).margin(0.3));
+        REQUIRE(a[0] == Approx(80.09).margin(0.5));
+        REQUIRE(b[0] == Approx(67.20).margin(0.5));
+    }
+
+    SECTION("High bit depth uses the same scale") {
+        auto k10 = make_yuv_to_lab(ColorMatrix::BT709, ColorRange::Limited, 10);
+        const uint16_t y10[] = {940, 64};
+        const uint16_t u10[] = {512};
+        const uint16_t v10[] = {512};
+        yuv_row_to_lab(y10, u10, v10, 2, k10, L, a, b);
+        REQUIRE(L[0] == Approx(100.0).margin(1e-3));
+        REQUIRE(L[1] == Approx(0.0).margin(1e-3));
+    }
+}
+
+TEST_CASE("CIEDE2000 of frames", "[ciede]") {
+    YUVFrame ref(32, 16);
+    for (size_t i = 0; i < ref.y.size(); ++i) {
+        ref.y[i] = static_cast<uint8_t>(16 + i % 200);
+    }
+    std::fill(ref.u.begin(), ref.u.end(), 110);
+    std::fill(ref.v.begin(), ref.v.end(), 150);
+    auto k = make_yuv_to_lab(ColorMatrix::BT709, ColorRange::Limited, 8);
+
+    REQUIRE(ciede2000_frame(ref, ref, k) == 0.0);
+
+    // A chroma-only shift is invisible to luma metrics but not to dE00
+    YUVFrame dist = ref;
+    std::fill(dist.v.begin(), dist.v.end(), 154);
+    double delta = ciede2000_frame(ref, dist, k);
+    REQUIRE(delta > 0.5);
+    REQUIRE(delta < 10.0);
+
+    YUVFrame deep(32, 16, 10);
+    REQUIRE_THROWS_AS(ciede2000_frame(ref, deep, k), std::invalid_argument);
+}
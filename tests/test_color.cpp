@@ -0,0 +1,177 @@
+#include <catch2/catch_test_macros.hpp>
+#include "src/color.hpp"
+#include "src/yuv_reader.hpp"
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+using namespace rdmeter;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Floating-point reference for one pixel, 8-bit output
+void reference_yuv(double r, double g, double b, double in_max, double kr, double kb, bool full,
+                   double& y, double& cb, double& cr) {
+    double kg = 1.0 - kr - kb;
+    r /= in_max;
+    g /= in_max;
+    b /= in_max;
+    double luma = kr * r + kg * g + kb * b;
+    double pb = (b - luma) / (2.0 * (1.0 - kb));
+    double pr = (r - luma) / (2.0 * (1.0 - kr));
+    y = full ? 255.0 * luma : 16.0 + 219.0 * luma;
+    cb = 128.0 + (full ? 255.0 : 224.0) * pb;
+    cr = 128.0 + (full ? 255.0 : 224.0) * pr;
+}
+
+} // namespace
+
+TEST_CASE("RGB to YCbCr conversion", "[color]") {
+    SECTION("BT.709 limited range primaries") {
+        auto k = make_rgb_to_yuv(ColorMatrix::BT709, ColorRange::Limited, 8);
+        // Two rows of two pixels: white, black / red, red
+        const uint8_t row0[] = {255, 255, 255, 0, 0, 0};
+        const uint8_t row1[] = {255, 0, 0, 255, 0, 0};
+        uint8_t y0[2], y1[2], u[1], v[1];
+        rgb24_rows_to_yuv420p(row0, row1, 2, k, y0, y1, u, v);
+        REQUIRE(y0[0] == 235);
+        REQUIRE(y0[1] == 16);
+        REQUIRE(y1[0] == 63);  // 16 + 219 * 0.2126
+        REQUIRE(y1[1] == 63);
+    }
+
+    SECTION("Gray maps to neutral chroma in every matrix and range") {
+        for (auto matrix : {ColorMatrix::BT601, ColorMatrix::BT709, ColorMatrix::BT2020}) {
+            for (auto range : {ColorRange::Limited, ColorRange::Full}) {
+                auto k = make_rgb_to_yuv(matrix, range, 8);
+                const uint8_t row[] = {77, 77, 77, 200, 200, 200};
+                uint8_t y0[2], y1[2], u[1], v[1];
+                rgb24_rows_to_yuv420p(row, row, 2, k, y0, y1, u, v);
+                REQUIRE(u[0] == 128);
+                REQUIRE(v[0] == 128);
+            }
+        }
+    }
+
+    SECTION("Fixed point stays within one code value of floating point") {
+        const double kr[] = {0.299, 0.2126, 0.2627};
+        const double kb[] = {0.114, 0.0722, 0.0593};
+        const ColorMatrix matrices[] = {ColorMatrix::BT601, ColorMatrix::BT709, ColorMatrix::BT2020};
+        for (int m = 0; m < 3; ++m) {
+            for (bool full : {false, true}) {
+                for (int bits : {8, 16}) {
+                    auto k = make_rgb_to_yuv(matrices[m], full ? ColorRange::Full : ColorRange::Limited, bits);
+                    double in_max = bits == 8 ? 255.0 : 65535.0;
+                    for (int i = 0; i < 500; ++i) {
+                        // One 2x2 block of identical pixels so chroma equals the per-pixel value
+                        uint32_t r = (i * 7919u) % (static_cast<uint32_t>(in_max) + 1);
+                        uint32_t g = (i * 104729u + 17) % (static_cast<uint32_t>(in_max) + 1);
+                        uint32_t b = (i * 1299709u + 5) % (static_cast<uint32_t>(in_max) + 1);
+                        uint8_t y0[2], y1[2], u[1], v[1];
+                        if (bits == 8) {
+                            const uint8_t row[] = {uint8_t(r), uint8_t(g), uint8_t(b), uint8_t(r), uint8_t(g), uint8_t(b)};
+                            rgb24_rows_to_yuv420p(row, row, 2, k, y0, y1, u, v);
+                        } else {
+                            const uint16_t row[] = {uint16_t(r), uint16_t(g), uint16_t(b), uint16_t(r), uint16_t(g), uint16_t(b)};
+                            rgb48_rows_to_yuv420p(row, row, 2, k, y0, y1, u, v);
+                        }
+                        double y, cb, cr;
+                        reference_yuv(r, g, b, in_max, kr[m], kb[m], full, y, cb, cr);
+                        REQUIRE(std::abs(y0[0] - std::min(255.0, y)) <= 1.0);
+                        REQUIRE(std::abs(u[0] - std::min(255.0, cb)) <= 1.0);
+                        REQUIRE(std::abs(v[0] - std::min(255.0, cr)) <= 1.0);
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("Unknown names throw") {
+        REQUIRE_THROWS_AS(parse_color_matrix("bt999"), std::invalid_argument);
+        REQUIRE_THROWS_AS(parse_color_range("studio"), std::invalid_argument);
+        REQUIRE_THROWS_AS(parse_pixel_format("nv12"), std::invalid_argument);
+    }
+}
+
+TEST_CASE("RGB frame reader", "[color]") {
+    fs::path path = fs::temp_directory_path() / "rdmeter_test_rgb24.rgb";
+    const int width = 4, height = 3;  // odd height: last row has luma only
+    {
+        std::ofstream out(path, std::ios::binary);
+        for (int i = 0; i < 2 * width * height; ++i) {
+            uint8_t value = static_cast<uint8_t>(i < width * height ? 255 : 0);
+            out.put(static_cast<char>(value)).put(static_cast<char>(value)).put(static_cast<char>(value));
+        }
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    FrameReader reader(in, width, height, PixelFormat::RGB24, ColorMatrix::BT709, ColorRange::Full);
+    REQUIRE(reader.frame_bytes() == static_cast<size_t>(width * height * 3));
+
+    YUVFrame frame(width, height);
+    reader.read(frame);
+    for (uint8_t y : frame.y) REQUIRE(y == 255);
+    for (uint8_t u : frame.u) REQUIRE(u == 128);
+
+    reader.read(frame);
+    for (uint8_t y : frame.y) REQUIRE(y == 0);
+
+    reader.seek(0);
+    reader.read(frame);
+    REQUIRE(frame.y[0] == 255);
+
+    reader.read(frame);
+    REQUIRE_THROWS_AS(reader.read(frame), std::runtime_error);
+    in.close();
+    fs::remove(path);
+}
+
+TEST_CASE("Row-band frame reading", "[color]") {
+    const int width = 6, height = 5;
+    for (auto format : {PixelFormat::YUV420P, PixelFormat::YUV420P10LE, PixelFormat::RGB24}) {
+        fs::path path = fs::temp_directory_path() / "rdmeter_test_bands.raw";
+        size_t bytes = frame_bytes(format, width, height);
+        {
+            std::ofstream out(path, std::ios::binary);
+            for (size_t i = 0; i < 2 * bytes; ++i) {
+                // Keep 10-bit samples in range: every high byte is 0-3
+                out.put(static_cast<char>(format == PixelFormat::YUV420P10LE && i % 2 ? i % 4 : (i * 29) % 256));
+            }
+        }
+
+        std::ifstream whole_in(path, std::ios::binary), band_in(path, std::ios::binary);
+        FrameReader whole(whole_in, width, height, format);
+        FrameReader bands(band_in, width, height, format);
+        int depth = whole.bit_depth();
+        for (int frame_index = 0; frame_index < 2; ++frame_index) {
+            YUVFrame expected(width, height, depth), frame(width, height, depth);
+            whole.read(expected);
+
+            // RGB is read in row pairs, so odd requests round down until the last row
+            int rows = bands.read_rows(frame, 3);
+            REQUIRE(rows == (format == PixelFormat::RGB24 ? 2 : 3));
+            REQUIRE(bands.read_rows(frame, 10) == height);
+            bands.finish_frame(frame);
+            REQUIRE(frame.y == expected.y);
+            REQUIRE(frame.u == expected.u);
+            REQUIRE(frame.v == expected.v);
+            REQUIRE(frame.y16 == expected.y16);
+            REQUIRE(frame.u16 == expected.u16);
+        }
+
+        size_t row_bytes = bytes / (format == PixelFormat::RGB24 ? height : 1);
+        if (format == PixelFormat::YUV420P) {
+            REQUIRE(bands.rows_available(0) == 0);
+            REQUIRE(bands.rows_available(3 * width + 1) == 3);
+            REQUIRE(bands.rows_available(bytes) == height);
+        } else if (format == PixelFormat::RGB24) {
+            REQUIRE(bands.rows_available(3 * row_bytes) == 2);
+            REQUIRE(bands.rows_available(bytes) == height);
+        }
+        whole_in.close();
+        band_in.close();
+        fs::remove(path);
+    }
+}
@@ -0,0 +1,152 @@
+#include <catch2/catch_test_macros.hpp>
+#include "src/csv.hpp"
+#include "src/threading.hpp"
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+using namespace rdmeter;
+namespace fs = std::filesystem;
+
+TEST_CASE("CSV tables", "[csv]") {
+    fs::path path = fs::temp_directory_path() / "rdmeter_test_table.csv";
+    fs::path other = fs::temp_directory_path() / "rdmeter_test_table.tsv";
+
+    SECTION("Quoted fields, blank lines and missing values") {
+        std::ofstream(path) << "name,bitrate_kbps,psnr_y\r\n\"bus, 1080p\",1500.5,38.25\r\n\n clip ,2000,\n";
+        auto table = read_csv(path.string());
+        REQUIRE(table.header.size() == 3);
+        REQUIRE(table.rows.size() == 2);
+        REQUIRE(table.rows[0][0] == "bus, 1080p");
+        REQUIRE(table.rows[1][0] == "clip");
+        REQUIRE(table.column("psnr_y") == 2);
+        REQUIRE(table.column("vmaf") == -1);
+        REQUIRE_THROWS_AS(table.require_column("vmaf"), std::runtime_error);
+
+        auto psnr = table.numbers(2);
+        REQUIRE(psnr[0] == 38.25);
+        REQUIRE(std::isnan(psnr[1]));
+        REQUIRE(table.numbers(1)[0] == 1500.5);
+        REQUIRE_THROWS_AS(table.numbers(0), std::runtime_error);
+
+        // Picked rows match the table's, blank lines skipped the same way
+        auto picked = read_csv_rows(path.string(), {1});
+        REQUIRE(picked.size() == 1);
+        REQUIRE(picked[0] == table.rows[1]);
+        REQUIRE(read_csv_rows(path.string(), {0, 1}) == table.rows);
+        REQUIRE_THROWS_AS(read_csv_rows(path.string(), {2}), std::runtime_error);
+    }
+
+    SECTION("Tab-separated files and appending") {
+        std::ofstream(path) << "name,bitrate_kbps\na,1\n";
+        std::ofstream(other) << "name\tbitrate_kbps\nb\t2\nc\t3\n";
+        auto table = read_csv(path.string());
+        append_rows(table, read_csv(other.string()), other.string());
+        REQUIRE(table.rows.size() == 3);
+        REQUIRE(table.rows[2][0] == "c");
+
+        std::ofstream(other) << "name,psnr_y\nd,40\n";
+        REQUIRE_THROWS_AS(append_rows(table, read_csv(other.string()), other.string()), std::runtime_error);
+    }
+
+    fs::remove(path);
+    fs::remove(other);
+}
+
+TEST_CASE("CSV tokenizer", "[csv]") {
+    std::string text = "a,\"b \"\"quoted\"\"\",c\r\n\n  \n\"multi\nline\", x ,\n";
+    CsvTokenizer tokenizer(text.data(), text.data() + text.size());
+    std::vector<std::string_view> fields;
+    REQUIRE(tokenizer.next(fields));
+    REQUIRE(fields.size() == 3);
+    REQUIRE(fields[1] == "b \"quoted\"");
+    REQUIRE(fields[2] == "c");
+    REQUIRE(tokenizer.next(fields));
+    REQUIRE(tokenizer.line() == 4);
+    REQUIRE(fields.size() == 3);
+    REQUIRE(fields[0] == "multi\nline");
+    REQUIRE(fields[1] == "x");
+    REQUIRE(fields[2].empty());
+    REQUIRE_FALSE(tokenizer.next(fields));
+
+    double value = 0.0;
+    REQUIRE(parse_csv_number("+1.5e3", value));
+    REQUIRE(value == 1500.0);
+    REQUIRE(parse_csv_number("", value));
+    REQUIRE(std::isnan(value));
+    REQUIRE(parse_csv_number("1e-320", value));
+    REQUIRE(value > 0.0);
+    REQUIRE_FALSE(parse_csv_number("12 kbps", value));
+}
+
+TEST_CASE("CSV schema columns", "[csv]") {
+    fs::path path = fs::temp_directory_path() / "rdmeter_test_columns.csv";
+    CsvSchema schema;
+    schema.numeric = {"bitrate_kbps", "psnr_y", "vmaf"};
+    schema.text = {"config", "sequence"};
+    schema.optional = {"vmaf"};
+
+    SECTION("Selected columns") {
+        std::ofstream(path) << "config\tqp\tsequence\tbitrate_kbps\tpsnr_y\n"
+                               "x264\t22\tbus\t1500\t38.5\nx264\t27\tbus\t900\t\nx265\t22\tbus\t1200\t39\n";
+        auto columns = read_csv_columns(path.string(), schema);
+        REQUIRE(columns.rows == 3);
+        REQUIRE(columns.has_column("qp"));
+        REQUIRE(columns.numeric[0] == std::vector<double>{1500, 900, 1200});
+        REQUIRE(std::isnan(columns.numeric[1][1]));
+        REQUIRE(columns.numeric[2].empty());
+        REQUIRE(columns.text[0].values == std::vector<std::string>{"x264", "x265"});
+        REQUIRE(columns.text[0].codes == std::vector<uint32_t>{0, 0, 1});
+        REQUIRE(columns.text[1][2] == "bus");
+
+        schema.optional.clear();
+        REQUIRE_THROWS_AS(read_csv_columns(path.string(), schema), std::runtime_error);
+    }
+
+    SECTION("Errors name the line") {
+        std::ofstream(path) << "config,sequence,bitrate_kbps,psnr_y\n\na,s,100,30\na,s,n/a,31\n";
+        try {
+            read_csv_columns(path.string(), schema);
+            FAIL("Expected an error");
+        } catch (const std::runtime_error& e) {
+            REQUIRE(std::string(e.what()).find("line 4") != std::string::npos);
+        }
+    }
+
+    SECTION("Parallel stretches match a serial read") {
+        {
+            std::ofstream out(path);
+            out << "config,sequence,bitrate_kbps,psnr_y,vmaf\n";
+            for (int r = 0; r < 200000; ++r) {
+                out << "cfg" << r / 1000 << ",seq" << r % 7 << ',' << 100 + r << ',' << 30 + r % 13 * 0.25 << ','
+                    << (r % 5 ? std::to_string(r % 100) : "") << '\n';
+            }
+        }
+        ThreadPool pool(4);
+        auto serial = read_csv_columns(path.string(), schema);
+        auto parallel = read_csv_columns(path.string(), schema, &pool);
+        REQUIRE(parallel.rows == 200000);
+        REQUIRE(parallel.numeric[0] == serial.numeric[0]);
+        REQUIRE(parallel.numeric[1] == serial.numeric[1]);
+        for (size_t r = 0; r < parallel.rows; r += 997) {
+            REQUIRE(parallel.text[0][r] == serial.text[0][r]);
+            REQUIRE(parallel.text[1][r] == serial.text[1][r]);
+            REQUIRE(std::isnan(parallel.numeric[2][r]) == std::isnan(serial.numeric[2][r]));
+        }
+        REQUIRE(parallel.text[0].values == serial.text[0].values);
+
+        // A bad field deep in a later stretch still reports its own line
+        {
+            std::ofstream out(path, std::ios::app);
+            out << "cfg,seq,oops,1,1\n";
+        }
+        try {
+            read_csv_columns(path.string(), schema, &pool);
+            FAIL("Expected an error");
+        } catch (const std::runtime_error& e) {
+            REQUIRE(std::string(e.what()).find("line 200002") != std::string::npos);
+        }
+    }
+
+    fs::remove(path);
+}
@@ -0,0 +1,55 @@
+#include <catch2/catch_test_macros.hpp>
+#include "src/follow.hpp"
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+using namespace rdmeter;
+namespace fs = std::filesystem;
+
+TEST_CASE("File watcher", "[follow]") {
+    fs::path path = fs::temp_directory_path() / "rdmeter_test_follow.yuv";
+    std::ofstream(path, std::ios::trunc) << "abc";
+
+    for (bool force_polling : {false, true}) {
+        FileWatcher watcher({path.string()}, force_polling);
+
+        SECTION(force_polling ? "Polling times out on an idle file" : "Inotify times out on an idle file") {
+            REQUIRE(watcher.wait(std::chrono::milliseconds(30)) == FileWatcher::Event::Timeout);
+        }
+
+        SECTION(force_polling ? "Polling sees appended data" : "Inotify sees appended data") {
+            std::thread writer([&] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                std::ofstream out(path, std::ios::app);
+                out << "more";
+                out.flush();
+            });
+            auto event = watcher.wait(std::chrono::seconds(5));
+            writer.join();
+            REQUIRE(event != FileWatcher::Event::Timeout);
+        }
+    }
+
+    SECTION("Closes are tracked per file until written again") {
+        fs::path other = fs::temp_directory_path() / "rdmeter_test_follow_ref.yuv";
+        std::ofstream(other, std::ios::trunc) << "abc";
+        FileWatcher watcher({path.string(), other.string()});
+        if (watcher.using_inotify()) {
+            std::ofstream(other, std::ios::app) << "more";
+            REQUIRE(watcher.wait(std::chrono::seconds(5)) == FileWatcher::Event::Closed);
+            REQUIRE_FALSE(watcher.closed(0));
+            REQUIRE(watcher.closed(1));
+
+            // A writer reopening the file makes it open again
+            std::ofstream out(other, std::ios::app);
+            out << "again";
+            out.flush();
+            REQUIRE(watcher.wait(std::chrono::seconds(5)) == FileWatcher::Event::Modified);
+            REQUIRE_FALSE(watcher.closed(1));
+        }
+        fs::remove(other);
+    }
+
+    fs::remove(path);
+}
@@ -0,0 +1,138 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include "src/hdr.hpp"
+#include "src/frame_metrics.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+using namespace rdmeter;
+
+TEST_CASE("PQ and HLG transfer functions", "[hdr]") {
+    SECTION("PQ round trip") {
+        for (double light : {0.0, 0.0001, 0.01, 0.1, 0.5, 1.0}) {
+            REQUIRE(pq_eotf(pq_inverse_eotf(light)) == Catch::Approx(light).margin(1e-9));
+        }
+        // 100 cd/m2 is close to PQ signal 0.508
+        REQUIRE(pq_inverse_eotf(0.01) == Catch::Approx(0.508).margin(0.001));
+    }
+
+    SECTION("HLG peaks at 1000 cd/m2") {
+        REQUIRE(hlg_to_display(0.0) == 0.0);
+        REQUIRE(hlg_to_display(1.0) == Catch::Approx(0.1).margin(1e-6));
+    }
+
+    SECTION("Tables are monotonic") {
+        for (auto transfer : {TransferFunction::PQ, TransferFunction::HLG}) {
+            auto tables = make_hdr_tables(transfer, 10);
+            REQUIRE(tables.linear.size() == 1024);
+            for (size_t code = 1; code < 1024; ++code) {
+                REQUIRE(tables.linear[code] >= tables.linear[code - 1]);
+                REQUIRE(tables.pq_code[code] >= tables.pq_code[code - 1]);
+            }
+        }
+        // PQ input maps to itself inside the limited range
+        auto pq = make_hdr_tables(TransferFunction::PQ, 10);
+        REQUIRE(pq.pq_code[64] == 64);
+        REQUIRE(pq.pq_code[500] == 500);
+        REQUIRE(pq.pq_code[940] == 940);
+    }
+
+    SECTION("Invalid arguments") {
+        REQUIRE_THROWS_AS(parse_transfer_function("srgb"), std::invalid_argument);
+        REQUIRE_THROWS_AS(make_hdr_tables(TransferFunction::PQ, 7), std::invalid_argument);
+    }
+}
+
+TEST_CASE("HDR metrics", "[hdr]") {
+    const int width = 32;
+    const int height = 16;
+    std::vector<uint16_t> ref(width * height);
+    for (size_t i = 0; i < ref.size(); ++i) {
+        ref[i] = static_cast<uint16_t>(64 + (i * 7) % 876);
+    }
+    auto tables = make_hdr_tables(TransferFunction::PQ, 10);
+
+    SECTION("Identical frames") {
+        REQUIRE(wpsnr_y(ref, ref, width, height, tables) == 100.0);
+        REQUIRE(psnr_linear_y(ref, ref, width, height, tables) == 100.0);
+        REQUIRE(psnr_pq_y(ref, ref, width, height, tables) == 100.0);
+        REQUIRE(ssim_pq_y(ref, ref, width, height, tables) == Catch::Approx(1.0));
+    }
+
+    SECTION("wPSNR weights a uniform error by reference code") {
+        // Every reference pixel at code 700: weight 2^((0.015 * 700 - 7.5) / 3) = 2
+        std::vector<uint16_t> flat(width * height, 700);
+        std::vector<uint16_t> dist(width * height, 702);
+        double expected = 10.0 * std::log10(1023.0 * 1023.0 / (4.0 * 2.0));
+        REQUIRE(wpsnr_y(flat, dist, width, height, tables) == Catch::Approx(expected));
+
+        // Dark codes clip at -3 dB, i.e. half weight
+        std::fill(flat.begin(), flat.end(), 100);
+        std::fill(dist.begin(), dist.end(), 102);
+        expected = 10.0 * std::log10(1023.0 * 1023.0 / (4.0 * 0.5));
+        REQUIRE(wpsnr_y(flat, dist, width, height, tables) == Catch::Approx(expected));
+    }
+
+    SECTION("PQ domain PSNR equals plain PSNR for PQ input") {
+        std::vector<uint16_t> dist = ref;
+        for (size_t i = 0; i < dist.size(); i += 3) {
+            dist[i] = static_cast<uint16_t>(dist[i] + 4);
+        }
+        double sse = 0.0;
+        for (size_t i = 0; i < ref.size(); ++i) {
+            double d = static_cast<double>(ref[i]) - dist[i];
+            sse += d * d;
+        }
+        double expected = 10.0 * std::log10(1023.0 * 1023.0 / (sse / ref.size()));
+        REQUIRE(psnr_pq_y(ref, dist, width, height, tables) == Catch::Approx(expected));
+        REQUIRE(ssim_pq_y(ref, dist, width, height, tables) < 1.0);
+        REQUIRE(psnr_linear_y(ref, dist, width, height, tables) < 100.0);
+    }
+
+    SECTION("Mismatched sizes") {
+        std::vector<uint16_t> small(width * height / 2, 64);
+        REQUIRE_THROWS_AS(wpsnr_y(ref, small, width, height, tables), std::invalid_argument);
+        REQUIRE_THROWS_AS(psnr_linear_y(ref, ref, width, height, HdrTables{}), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Frame metric registry", "[hdr]") {
+    FrameMetricOptions options;
+    options.width = 32;
+    options.height = 32;
+
+    SECTION("Canonical order and keys") {
+        options.bit_depth = 10;
+        auto metrics = make_frame_metrics({"ssim_pq", "psnr", "wpsnr"}, options);
+        REQUIRE(metrics.size() == 3);
+        REQUIRE(metrics[0].key == "psnr_y");
+        REQUIRE(metrics[1].key == "wpsnr_y");
+        REQUIRE(metrics[2].key == "ssim_pq_y");
+
+        YUVFrame ref(32, 32, 10);
+        std::fill(ref.y16.begin(), ref.y16.end(), 512);
+        YUVFrame dist = ref;
+        dist.y16[0] = 513;
+        REQUIRE(metrics[0].compute(ref, ref, 0) == 100.0);
+        REQUIRE(metrics[0].compute(ref, dist, 0) < 100.0);
+    }
+
+    SECTION("High bit depth MS-SSIM") {
+        options.bit_depth = 10;
+        auto metrics = make_frame_metrics({"msssim"}, options);
+        YUVFrame ref(32, 32, 10);
+        for (size_t i = 0; i < ref.y16.size(); ++i) {
+            ref.y16[i] = static_cast<uint16_t>((i * 37) % 1024);
+        }
+        REQUIRE(metrics[0].compute(ref, ref, 0) == Catch::Approx(1.0));
+    }
+
+    SECTION("Invalid requests") {
+        REQUIRE_THROWS_AS(make_frame_metrics({"vmaf"}, options), std::invalid_argument);
+        // HDR metrics need high bit depth input
+        REQUIRE_THROWS_AS(make_frame_metrics({"wpsnr"}, options), std::invalid_argument);
+        options.width = 16;
+        REQUIRE_THROWS_AS(make_frame_metrics({"msssim"}, options), std::invalid_argument);
+    }
+}
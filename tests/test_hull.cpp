@@ -0,0 +1,117 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include "src/hull.hpp"
+#include <cmath>
+#include <limits>
+#include <random>
+
+using namespace rdmeter;
+using Catch::Approx;
+
+TEST_CASE("RD convex hull", "[hull]") {
+    SECTION("Small sweep") {
+        // Two resolutions: 540p wins at low rates, 1080p at high ones
+        std::vector<RdPoint> points = {
+            {500, 33.0, 0}, {1000, 36.0, 1}, {2000, 37.5, 2},   // 540p
+            {1000, 34.0, 3}, {2000, 38.0, 4}, {4000, 41.0, 5},  // 1080p
+            {3000, 38.5, 6},  // Below the chord from 2000 to 4000
+            {5000, 40.0, 7},  // Past the best quality
+            {2000, 35.0, 8},  // Same bitrate as a better point
+        };
+        auto hull = upper_convex_hull(points);
+        REQUIRE(hull.size() == 4);
+        std::vector<size_t> rows = {0, 1, 4, 5};
+        for (size_t i = 0; i < hull.size(); ++i) {
+            REQUIRE(hull[i].row == rows[i]);
+        }
+
+        auto front = pareto_front(points);
+        REQUIRE(front.size() == 5);  // The hull plus 3000 kbps at 38.5
+        REQUIRE(front[3].row == 6);
+    }
+
+    SECTION("Collinear, unusable and log-axis points") {
+        double nan = std::numeric_limits<double>::quiet_NaN();
+        std::vector<RdPoint> points = {{100, 30, 0}, {200, 31, 1}, {300, 32, 2}, {400, nan, 3},
+                                       {0, 20, 4}, {800, 40, 5}};
+        auto hull = upper_convex_hull(points);
+        // The NaN is ignored; 200 kbps lies on the line from 100 to 300, which falls
+        // below the chord to 800 kbps
+        REQUIRE(hull.size() == 3);
+        REQUIRE(hull[0].row == 4);
+        REQUIRE(hull[1].row == 0);
+        REQUIRE(hull[2].row == 5);
+
+        // On the log axis the zero bitrate is dropped, and 200 kbps falls just short of the
+        // 1 dB per doubling from 100 to 400 kbps. On a linear axis it would be on the hull
+        auto log_hull = upper_convex_hull({{100, 30, 0}, {200, 30.9, 1}, {400, 32, 2}, {0, 20, 3}}, true);
+        REQUIRE(log_hull.size() == 2);
+        REQUIRE(log_hull[0].row == 0);
+        REQUIRE(log_hull[1].row == 2);
+        REQUIRE(upper_convex_hull({{100, 30, 0}, {200, 30.9, 1}, {400, 32, 2}}).size() == 3);
+
+        REQUIRE(upper_convex_hull({}).empty());
+        REQUIRE(upper_convex_hull({{1, 1, 0}}).size() == 1);
+    }
+
+    SECTION("Random sweeps agree with a brute-force check") {
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<double> rate(100.0, 10000.0);
+        std::normal_distribution<double> noise(0.0, 1.5);
+        for (int trial = 0; trial < 20; ++trial) {
+            std::vector<RdPoint> points;
+            for (size_t i = 0; i < 500; ++i) {
+                double r = rate(rng);
+                points.push_back({r, 10.0 * std::log10(r) + noise(rng), i});
+            }
+            auto hull = upper_convex_hull(points);
+            REQUIRE(hull.size() >= 2);
+            for (size_t i = 1; i < hull.size(); ++i) {
+                REQUIRE(hull[i].bitrate > hull[i - 1].bitrate);
+                REQUIRE(hull[i].quality > hull[i - 1].quality);
+            }
+            // Slopes fall along the hull
+            for (size_t i = 2; i < hull.size(); ++i) {
+                double s1 = (hull[i - 1].quality - hull[i - 2].quality) / (hull[i - 1].bitrate - hull[i - 2].bitrate);
+                double s2 = (hull[i].quality - hull[i - 1].quality) / (hull[i].bitrate - hull[i - 1].bitrate);
+                REQUIRE(s2 < s1);
+            }
+            // No point lies above the hull between its ends
+            for (const auto& p : points) {
+                if (p.bitrate < hull.front().bitrate || p.bitrate > hull.back().bitrate) {
+                    continue;
+                }
+                size_t k = 1;
+                while (hull[k].bitrate < p.bitrate) {
+                    ++k;
+                }
+                const auto& a = hull[k - 1];
+                const auto& b = hull[k];
+                double line = a.quality + (b.quality - a.quality) * (p.bitrate - a.bitrate) / (b.bitrate - a.bitrate);
+                REQUIRE(p.quality <= line + 1e-9);
+            }
+        }
+    }
+}
+
+TEST_CASE("Ladder selection", "[hull]") {
+    std::vector<RdPoint> hull = {{235, 30, 0}, {560, 34, 1}, {1050, 37, 2}, {3000, 40, 3}, {5800, 42, 4}};
+
+    auto ladder = select_ladder(hull, {4000, 200, 600, 1000, 10000});
+    // 200 is below every point; 600 and 1000 both land on 560
+    REQUIRE(ladder.size() == 3);
+    REQUIRE(ladder[0].row == 1);
+    REQUIRE(ladder[1].row == 3);
+    REQUIRE(ladder[2].row == 4);
+    REQUIRE(select_ladder(hull, {1050})[0].row == 2);
+
+    auto targets = log_spaced_bitrates(235, 5800, 4);
+    REQUIRE(targets.size() == 4);
+    REQUIRE(targets.front() == 235);
+    REQUIRE(targets.back() == 5800);
+    REQUIRE(targets[2] / targets[1] == Approx(targets[1] / targets[0]));
+    REQUIRE(select_ladder(hull, targets).back().row == 4);
+
+    REQUIRE_THROWS_AS(log_spaced_bitrates(0, 100, 3), std::invalid_argument);
+    REQUIRE_THROWS_AS(log_spaced_bitrates(100, 50, 3), std::invalid_argument);
+}
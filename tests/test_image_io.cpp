@@ -0,0 +1,189 @@
+#include <catch2/catch_test_macros.hpp>
+#include "src/image_io.hpp"
+#include <string>
+#include <vector>
+
+using namespace rdmeter;
+
+namespace {
+
+// Fixtures generated with Python's zlib; every scanline filter type (0-4) is used in turn
+const std::vector<uint8_t> kRgb8 = {
+    0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x08, 0x08, 0x02, 0x00, 0x00, 0x00, 0x7f, 0x14, 0xe8,
+    0xc0, 0x00, 0x00, 0x01, 0x64, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x63, 0x60, 0x30, 0x4a, 0x91,
+    0xaa, 0x7b, 0xe4, 0xf7, 0xa4, 0x6a, 0x4e, 0x8a, 0x0e, 0xcb, 0xbf, 0x1f, 0x6d, 0x9b, 0xee, 0x29,
+    0x35, 0xdc, 0xbb, 0x91, 0xf1, 0x63, 0x45, 0x96, 0xce, 0xa4, 0xb6, 0xaa, 0x69, 0x7b, 0x1e, 0x6d,
+    0xe1, 0x49, 0x79, 0x53, 0xc6, 0x60, 0xf7, 0x6b, 0xdb, 0xaa, 0x19, 0x6d, 0x06, 0x01, 0x05, 0x8c,
+    0xec, 0x96, 0xd9, 0x8a, 0xc1, 0xad, 0xd6, 0xb9, 0xf3, 0x43, 0xdb, 0x77, 0xe6, 0x2f, 0xbc, 0xdc,
+    0xb9, 0xfb, 0xed, 0xe2, 0xab, 0xec, 0x7b, 0xdf, 0x2b, 0x5e, 0xe7, 0xb4, 0xfe, 0xa8, 0x1c, 0xca,
+    0x6d, 0x9b, 0xaf, 0x1a, 0xde, 0x69, 0x5f, 0xb8, 0x38, 0xb2, 0x7b, 0x6f, 0xf1, 0xd2, 0xeb, 0xbd,
+    0xfb, 0x3f, 0x32, 0xb1, 0xb3, 0xb3, 0xf3, 0xf1, 0xf1, 0x89, 0x8a, 0x8a, 0xca, 0xc8, 0xc8, 0x28,
+    0x2b, 0x2b, 0x6b, 0x69, 0x69, 0x19, 0x1a, 0x1a, 0x5a, 0x58, 0x58, 0xd8, 0xdb, 0xdb, 0xbb, 0xb9,
+    0xb9, 0xf9, 0xfa, 0xfa, 0x86, 0x84, 0x84, 0x44, 0x47, 0x47, 0x27, 0x25, 0x25, 0x65, 0x66, 0x66,
+    0x16, 0x14, 0x14, 0x30, 0xf3, 0xa9, 0x3b, 0xc8, 0x5b, 0x04, 0xea, 0x9f, 0x48, 0x74, 0x88, 0xfc,
+    0x74, 0xe1, 0x25, 0x53, 0xe2, 0x2f, 0xe1, 0xc2, 0x2e, 0x65, 0xa6, 0xd9, 0x26, 0x42, 0xab, 0x5d,
+    0x94, 0x6d, 0xae, 0x1a, 0xfb, 0xa4, 0xba, 0xc4, 0x7e, 0x0b, 0xc9, 0x6d, 0x7b, 0x5a, 0x37, 0xbd,
+    0xb4, 0x4f, 0x9d, 0x4d, 0xde, 0x82, 0x05, 0xd9, 0x86, 0x16, 0x65, 0x16, 0xad, 0xcf, 0x4c, 0x86,
+    0x22, 0x32, 0xcc, 0x2c, 0x66, 0x6f, 0xe4, 0xec, 0xd9, 0x2c, 0xb2, 0x14, 0x7c, 0x7d, 0xad, 0x42,
+    0xe6, 0x85, 0x44, 0xf3, 0xe4, 0xfd, 0x06, 0xda, 0xf0, 0x66, 0xd1, 0x15, 0x36, 0x06, 0xe5, 0xd0,
+    0xf6, 0x84, 0x23, 0x1a, 0xdb, 0x7d, 0x1f, 0x6b, 0x7c, 0xd8, 0xb1, 0x79, 0xed, 0xf2, 0x88, 0x96,
+    0x0d, 0xe2, 0xa5, 0x97, 0x3f, 0x34, 0x08, 0x3c, 0x5e, 0x9a, 0xfe, 0xe1, 0xc9, 0x0d, 0x71, 0xdb,
+    0xe4, 0x88, 0x0d, 0x1c, 0x9b, 0x6d, 0x8f, 0x6b, 0x3c, 0x59, 0xb0, 0x7d, 0xe9, 0xe4, 0x84, 0x86,
+    0x05, 0x8c, 0x5a, 0x31, 0x7d, 0x2e, 0x65, 0x2b, 0xe2, 0x26, 0x1c, 0xaa, 0x58, 0x75, 0x67, 0xd2,
+    0x91, 0x6f, 0x6b, 0xee, 0x09, 0x1c, 0xfb, 0xa1, 0xf5, 0x40, 0xc8, 0xe5, 0x97, 0x4e, 0x9c, 0x88,
+    0x5b, 0x85, 0x5e, 0xc2, 0x24, 0x8f, 0xaa, 0x35, 0x49, 0x53, 0x8e, 0xd5, 0xac, 0x7b, 0x30, 0xed,
+    0xc4, 0xaf, 0x0d, 0x8f, 0x44, 0x48, 0xf6, 0x34, 0x00, 0x65, 0x2e, 0x99, 0x57, 0x02, 0xff, 0xa8,
+    0xad, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82
+};
+
+const std::vector<uint8_t> kGray16Stored = {
+    0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x08, 0x10, 0x00, 0x00, 0x00, 0x00, 0x85, 0x8d, 0xfc,
+    0x08, 0x00, 0x00, 0x01, 0x13, 0x49, 0x44, 0x41, 0x54, 0x78, 0x01, 0x01, 0x08, 0x01, 0xf7, 0xfe,
+    0x00, 0x00, 0x00, 0x10, 0x03, 0x20, 0x06, 0x30, 0x09, 0x40, 0x0c, 0x50, 0x0f, 0x60, 0x12, 0x70,
+    0x15, 0x80, 0x18, 0x90, 0x1b, 0xa0, 0x1e, 0xb0, 0x21, 0xc0, 0x24, 0xd0, 0x27, 0xe0, 0x2a, 0xf0,
+    0x2d, 0x01, 0x01, 0x01, 0x10, 0x03, 0x10, 0x03, 0x10, 0x03, 0x10, 0x03, 0x10, 0x03, 0x10, 0x03,
+    0x10, 0x03, 0x10, 0x03, 0x10, 0x03, 0x10, 0x03, 0x10, 0x03, 0x10, 0x03, 0x10, 0x03, 0x10, 0x03,
+    0x10, 0x03, 0x02, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x03, 0x02, 0x02, 0x09, 0x02, 0x09, 0x02, 0x09, 0x02, 0x09, 0x02, 0x09, 0x02,
+    0x09, 0x02, 0x09, 0x02, 0x09, 0x02, 0x09, 0x02, 0x09, 0x02, 0x09, 0x02, 0x09, 0x02, 0x09, 0x02,
+    0x09, 0x02, 0x09, 0x02, 0x04, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x05, 0x05, 0x15, 0x08, 0x25, 0x0b, 0x35, 0x0e, 0x45, 0x11,
+    0x55, 0x14, 0x65, 0x17, 0x75, 0x1a, 0x85, 0x1d, 0x95, 0x20, 0xa5, 0x23, 0xb5, 0x26, 0xc5, 0x29,
+    0xd5, 0x2c, 0xe5, 0x2f, 0xf5, 0x32, 0x01, 0x06, 0x06, 0x10, 0x03, 0x10, 0x03, 0x10, 0x03, 0x10,
+    0x03, 0x10, 0x03, 0x10, 0x03, 0x10, 0x03, 0x10, 0x03, 0x10, 0x03, 0x10, 0x03, 0x10, 0x03, 0x10,
+    0x03, 0x10, 0x03, 0x10, 0x03, 0x10, 0x03, 0x02, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x0a, 0xcf, 0x15, 0xcf, 0xf6, 0x89, 0x7a, 0xb0,
+    0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82
+};
+
+const std::vector<uint8_t> kPalette2 = {
+    0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x08, 0x02, 0x03, 0x00, 0x00, 0x00, 0x8d, 0x18, 0x97,
+    0x04, 0x00, 0x00, 0x00, 0x0c, 0x50, 0x4c, 0x54, 0x45, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00,
+    0xff, 0x00, 0x00, 0x00, 0xff, 0x9b, 0xc0, 0x13, 0xdc, 0x00, 0x00, 0x00, 0x26, 0x49, 0x44, 0x41,
+    0x54, 0x78, 0x9c, 0x63, 0x90, 0x06, 0x02, 0xc6, 0x1c, 0x06, 0x06, 0x06, 0x26, 0x57, 0x20, 0x60,
+    0xce, 0xe3, 0xe6, 0xe6, 0x66, 0x09, 0x05, 0x72, 0x19, 0x72, 0x80, 0x80, 0x71, 0x23, 0x48, 0x42,
+    0x14, 0x08, 0x00, 0x6c, 0x9e, 0x05, 0x93, 0x8f, 0xf5, 0xb5, 0x37, 0x00, 0x00, 0x00, 0x00, 0x49,
+    0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82
+};
+
+const std::vector<uint8_t> kDynamicZlib = {
+    0x78, 0xda, 0xed, 0x8e, 0x5d, 0x0a, 0xc0, 0x30, 0x08, 0x83, 0xaf, 0xd2, 0xab, 0x65, 0xd4, 0xfd,
+    0x40, 0x1d, 0xc5, 0xf6, 0xfe, 0x14, 0x74, 0xf6, 0x0e, 0x83, 0xbc, 0x84, 0x24, 0x18, 0xf9, 0xd0,
+    0xfa, 0x8d, 0x72, 0x1a, 0x54, 0x8a, 0x55, 0x95, 0x29, 0x56, 0xe0, 0xdd, 0x21, 0x13, 0x9f, 0x1d,
+    0xe3, 0xd1, 0xc8, 0x17, 0x54, 0x53, 0x63, 0x14, 0x3e, 0xa7, 0x55, 0xda, 0x5e, 0x65, 0xd7, 0xc7,
+    0x6b, 0x3b, 0xc4, 0xb9, 0x57, 0xfe, 0xd5, 0x25, 0x56, 0x6e, 0x41, 0x1e, 0xf2, 0x90, 0x87, 0x3c,
+    0xe4, 0x21, 0x0f, 0x79, 0xc8, 0xf3, 0x7b, 0x9e, 0x05, 0xc0, 0x65, 0x70, 0x9c
+};
+
+std::vector<uint8_t> bytes_of(const std::string& text) {
+    return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+} // namespace
+
+TEST_CASE("PNM decoding", "[image_io]") {
+    SECTION("Binary PGM with comment") {
+        std::string data = "P5\n# comment\n3 2\n255\n";
+        data += std::string("\x00\x10\x20\x30\x40\xff", 6);
+        auto image = decode_pnm(bytes_of(data));
+        REQUIRE(image.width == 3);
+        REQUIRE(image.height == 2);
+        REQUIRE(image.channels == 1);
+        REQUIRE(image.pixels == std::vector<uint8_t>{0x00, 0x10, 0x20, 0x30, 0x40, 0xff});
+    }
+
+    SECTION("ASCII PPM with small maxval is scaled to 8 bits") {
+        auto image = decode_pnm(bytes_of("P3 1 1 15\n15 0 5\n"));
+        REQUIRE(image.channels == 3);
+        REQUIRE(image.pixels == std::vector<uint8_t>{255, 0, 85});
+    }
+
+    SECTION("16-bit PGM is rounded to 8 bits") {
+        std::string data = "P5 2 1 65535\n";
+        data += std::string("\xff\xff\x80\x00", 4);
+        auto image = decode_pnm(bytes_of(data));
+        REQUIRE(image.pixels == std::vector<uint8_t>{255, 128});
+    }
+
+    SECTION("Truncated raster throws") {
+        REQUIRE_THROWS_AS(decode_pnm(bytes_of("P5 4 4 255\nabc")), std::runtime_error);
+    }
+}
+
+TEST_CASE("PNG decoding", "[image_io]") {
+    const int W = 16, H = 8;
+
+    SECTION("8-bit RGB with all filter types") {
+        auto image = decode_png(kRgb8);
+        REQUIRE(image.width == W);
+        REQUIRE(image.height == H);
+        REQUIRE(image.channels == 3);
+        for (int y = 0; y < H; ++y) {
+            for (int x = 0; x < W; ++x) {
+                for (int c = 0; c < 3; ++c) {
+                    REQUIRE(image.pixels[(y * W + x) * 3 + c] == ((x * 13 + y * 7 + c * 50) * (x + 1)) % 256);
+                }
+            }
+        }
+    }
+
+    SECTION("16-bit gray in stored deflate blocks") {
+        auto image = decode_png(kGray16Stored);
+        REQUIRE(image.channels == 1);
+        for (int y = 0; y < H; ++y) {
+            for (int x = 0; x < W; ++x) {
+                unsigned v = (x * 4099 + y * 257) % 65536;
+                REQUIRE(image.pixels[y * W + x] == (v * 255 + 32767) / 65535);
+            }
+        }
+    }
+
+    SECTION("2-bit palette") {
+        auto image = decode_png(kPalette2);
+        REQUIRE(image.channels == 3);
+        const uint8_t palette[4][3] = {{0, 0, 0}, {255, 0, 0}, {0, 255, 0}, {0, 0, 255}};
+        for (int y = 0; y < H; ++y) {
+            for (int x = 0; x < W; ++x) {
+                int entry = (x + y) % 4;
+                for (int c = 0; c < 3; ++c) {
+                    REQUIRE(image.pixels[(y * W + x) * 3 + c] == palette[entry][c]);
+                }
+            }
+        }
+    }
+
+    SECTION("Corrupt data throws") {
+        auto corrupt = kRgb8;
+        corrupt.resize(corrupt.size() / 2);
+        REQUIRE_THROWS_AS(decode_png(corrupt), std::runtime_error);
+    }
+}
+
+TEST_CASE("Inflate with dynamic Huffman tables", "[image_io]") {
+    const std::vector<std::string> words = {"alpha", "beta", "gamma", "delta", "rdmeter", "psnr", "ssim", "frame"};
+    std::string expected;
+    for (int i = 0; i < 400; ++i) {
+        if (i > 0) expected += ' ';
+        expected += words[(i * i * 7 + i / 3) % 8];
+    }
+
+    auto out = inflate_zlib(kDynamicZlib.data(), kDynamicZlib.size());
+    REQUIRE(std::string(out.begin(), out.end()) == expected);
+}
+
+TEST_CASE("Image luma", "[image_io]") {
+    Image image;
+    image.width = 2;
+    image.height = 1;
+    image.channels = 3;
+    image.pixels = {255, 255, 255, 255, 0, 0};
+    auto luma = image_luma(image);
+    REQUIRE(luma[0] == 255);
+    REQUIRE(luma[1] == 76);  // 0.299 * 255
+}
@@ -0,0 +1,83 @@
+#include <catch2/catch_test_macros.hpp>
+#include "src/memory_budget.hpp"
+#include "src/threading.hpp"
+#include <vector>
+#include <atomic>
+#include <stdexcept>
+
+using namespace rdmeter;
+
+TEST_CASE("Memory size parsing", "[memory]") {
+    SECTION("Plain bytes and binary suffixes") {
+        REQUIRE(parse_memory_size("1048576") == 1048576);
+        REQUIRE(parse_memory_size("512K") == 512u * 1024);
+        REQUIRE(parse_memory_size("512M") == 512u * 1024 * 1024);
+        REQUIRE(parse_memory_size("4G") == 4ull * 1024 * 1024 * 1024);
+        REQUIRE(parse_memory_size("1.5GiB") == 3ull * 512 * 1024 * 1024);
+        REQUIRE(parse_memory_size("2gb") == 2ull * 1024 * 1024 * 1024);
+    }
+
+    SECTION("Malformed sizes throw") {
+        REQUIRE_THROWS_AS(parse_memory_size("lots"), std::invalid_argument);
+        REQUIRE_THROWS_AS(parse_memory_size("4Q"), std::invalid_argument);
+        REQUIRE_THROWS_AS(parse_memory_size("-1M"), std::invalid_argument);
+        REQUIRE_THROWS_AS(parse_memory_size("inf"), std::invalid_argument);
+        REQUIRE_THROWS_AS(parse_memory_size("1e30G"), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Memory planning", "[memory]") {
+    const size_t pair = 6u << 20;      // ~1080p frame pair
+    const size_t scratch = 100u << 20; // per-thread scratch
+
+    SECTION("Unlimited budget uses every thread") {
+        auto plan = plan_memory(0, pair, scratch, 8);
+        REQUIRE(plan.threads == 8);
+        REQUIRE(plan.ring_frames == 16);
+    }
+
+    SECTION("Budget limits parallelism and stays within bounds") {
+        size_t budget = kBaseOverheadBytes + 3 * (scratch + pair) + pair / 2;
+        auto plan = plan_memory(budget, pair, scratch, 16);
+        REQUIRE(plan.threads == 3);
+        REQUIRE(plan.ring_frames >= plan.threads);
+        REQUIRE(plan.estimated_bytes <= budget);
+    }
+
+    SECTION("Spare budget deepens the ring up to four pairs per thread") {
+        auto plan = plan_memory(kBaseOverheadBytes + 2 * scratch + 100 * pair, pair, scratch, 2);
+        REQUIRE(plan.threads == 2);
+        REQUIRE(plan.ring_frames == 8);
+    }
+
+    SECTION("Budget below one thread throws") {
+        REQUIRE_THROWS_AS(plan_memory(kBaseOverheadBytes, pair, scratch, 4), std::runtime_error);
+    }
+}
+
+TEST_CASE("Thread pool", "[threading]") {
+    SECTION("Every index runs exactly once") {
+        ThreadPool pool(4);
+        std::vector<std::atomic<int>> hits(1000);
+        std::atomic<bool> bad_worker{false};
+        pool.parallel_for(hits.size(), [&](size_t i, unsigned worker) {
+            if (worker >= pool.size()) bad_worker = true;
+            hits[i].fetch_add(1);
+        });
+        REQUIRE_FALSE(bad_worker.load());
+        for (auto& h : hits) {
+            REQUIRE(h.load() == 1);
+        }
+    }
+
+    SECTION("Exceptions propagate to the caller") {
+        ThreadPool pool(3);
+        REQUIRE_THROWS_AS(pool.parallel_for(64, [](size_t i, unsigned) {
+            if (i == 17) throw std::runtime_error("boom");
+        }), std::runtime_error);
+        // Pool remains usable afterwards
+        std::atomic<int> count{0};
+        pool.parallel_for(10, [&](size_t, unsigned) { count.fetch_add(1); });
+        REQUIRE(count.load() == 10);
+    }
+}
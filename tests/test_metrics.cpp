@@ -1,6 +1,7 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
 #include "src/metrics.hpp"
+#include "src/frame_metrics.hpp"
 #include <vector>
 #include <algorithm>
 
@@ -120,6 +121,69 @@ TEST_CASE("SSIM calculation", "[metrics]") {
     }
 }
 
+TEST_CASE("Integer SSIM", "[metrics]") {
+    // Deterministic textured frame and a distorted copy
+    const int width = 37;
+    const int height = 29;
+    std::vector<uint8_t> ref(width * height), dist(width * height);
+    for (int i = 0; i < width * height; ++i) {
+        ref[i] = static_cast<uint8_t>((i * 73 + (i / width) * 31) % 256);
+        dist[i] = static_cast<uint8_t>(std::clamp(ref[i] + (i % 7) - 3, 0, 255));
+    }
+
+    SECTION("Identical images return exactly 1.0") {
+        REQUIRE(ssim_y_fixed(ref, ref, width, height) == (int64_t{1} << kSsimFixedBits));
+        REQUIRE(ssim_y_int(ref, ref, width, height) == 1.0);
+    }
+
+    SECTION("Matches a floating-point reference of the same windows") {
+        const double c1 = 0.0001 * 255 * 255;
+        const double c2 = 0.0009 * 255 * 255;
+        double sum = 0.0;
+        int windows = 0;
+        for (int y = 0; y + 8 <= height / 4 * 4; y += 4) {
+            for (int x = 0; x + 8 <= width / 4 * 4; x += 4) {
+                double m1 = 0, m2 = 0, v1 = 0, v2 = 0, cov = 0;
+                for (int j = 0; j < 8; ++j) {
+                    for (int i = 0; i < 8; ++i) {
+                        m1 += ref[(y + j) * width + x + i] / 64.0;
+                        m2 += dist[(y + j) * width + x + i] / 64.0;
+                    }
+                }
+                for (int j = 0; j < 8; ++j) {
+                    for (int i = 0; i < 8; ++i) {
+                        double a = ref[(y + j) * width + x + i] - m1;
+                        double b = dist[(y + j) * width + x + i] - m2;
+                        v1 += a * a / 63.0;
+                        v2 += b * b / 63.0;
+                        cov += a * b / 63.0;
+                    }
+                }
+                sum += (2 * m1 * m2 + c1) * (2 * cov + c2) / ((m1 * m1 + m2 * m2 + c1) * (v1 + v2 + c2));
+                ++windows;
+            }
+        }
+        REQUIRE(ssim_y_int(ref, dist, width, height) == Approx(sum / windows).margin(1e-6));
+    }
+
+    SECTION("Golden value") {
+        // Any change to this value changes results in golden files
+        REQUIRE(ssim_y_fixed(ref, dist, width, height) == 1073354339);
+    }
+
+    SECTION("Opposite images give a low score") {
+        std::vector<uint8_t> black(64 * 64, 0);
+        std::vector<uint8_t> white(64 * 64, 255);
+        REQUIRE(ssim_y_int(black, white, 64, 64) < 0.01);
+    }
+
+    SECTION("Invalid input throws exception") {
+        std::vector<uint8_t> small(7 * 7, 0);
+        REQUIRE_THROWS_AS(ssim_y_fixed(small, small, 7, 7), std::invalid_argument);
+        REQUIRE_THROWS_AS(ssim_y_fixed(ref, small, width, height), std::invalid_argument);
+    }
+}
+
 TEST_CASE("MS-SSIM calculation", "[metrics]") {
     SECTION("Identical images return 1.0") {
         // Use minimum size for 5 scales (32x32)
@@ -151,6 +215,34 @@ TEST_CASE("MS-SSIM calculation", "[metrics]") {
         REQUIRE(msssim < 1.0);  // But not perfect
     }
     
+    SECTION("Negative SSIM at a scale returns 0") {
+        // An inverted image has negative covariance at full resolution
+        std::vector<uint8_t> ref(64 * 64);
+        std::vector<uint8_t> dist(64 * 64);
+        for (int i = 0; i < 64 * 64; ++i) {
+            ref[i] = static_cast<uint8_t>((i * 37) % 256);
+            dist[i] = static_cast<uint8_t>(255 - ref[i]);
+        }
+        REQUIRE(ssim_y(ref, dist, 64, 64) < 0.0);
+        REQUIRE(msssim_y(ref, dist, 64, 64) == 0.0);
+    }
+
+    SECTION("Pyramid buffers are reused across frame sizes") {
+        auto make = [](int width, int height, int seed) {
+            std::vector<uint8_t> image(static_cast<size_t>(width) * height);
+            for (size_t i = 0; i < image.size(); ++i) {
+                image[i] = static_cast<uint8_t>((i * seed + i / width) % 200 + 20);
+            }
+            return image;
+        };
+        auto large_ref = make(96, 80, 3), large_dist = make(96, 80, 5);
+        auto small_ref = make(33, 35, 3), small_dist = make(33, 35, 7);
+        double large = msssim_y(large_ref, large_dist, 96, 80);
+        double small = msssim_y(small_ref, small_dist, 33, 35);
+        REQUIRE(msssim_y(large_ref, large_dist, 96, 80) == large);
+        REQUIRE(msssim_y(small_ref, small_dist, 33, 35) == small);
+    }
+    
     SECTION("MS-SSIM is in valid range [0,1]") {
         // Create random-like pattern
         std::vector<uint8_t> ref(64 * 64);
@@ -167,6 +259,227 @@ TEST_CASE("MS-SSIM calculation", "[metrics]") {
     }
 }
 
+TEST_CASE("Fused luma kernel", "[metrics]") {
+    auto pattern = [](int width, int height, int seed) {
+        std::vector<uint8_t> image(static_cast<size_t>(width) * height);
+        for (int i = 0; i < width * height; ++i) {
+            image[i] = static_cast<uint8_t>((i * 37 + (i / width) * seed + (i * i) % 11) % 256);
+        }
+        return image;
+    };
+
+    SECTION("Moments and next level match the separate passes") {
+        // Odd sizes, and a width spanning several column chunks
+        for (auto size : {std::pair<int, int>{37, 29}, std::pair<int, int>{8195, 5}}) {
+            int width = size.first;
+            int height = size.second;
+            auto ref = pattern(width, height, 3);
+            auto dist = pattern(width, height, 5);
+
+            std::vector<uint16_t> ref_half(static_cast<size_t>(width / 2) * (height / 2));
+            std::vector<uint16_t> dist_half(ref_half.size());
+            auto moments = luma_moments(ref.data(), dist.data(), width, height, ref_half.data(), dist_half.data());
+
+            uint64_t sse = 0;
+            for (size_t i = 0; i < ref.size(); ++i) {
+                int diff = ref[i] - dist[i];
+                sse += static_cast<uint64_t>(diff * diff);
+            }
+            REQUIRE(moments.count == ref.size());
+            REQUIRE(moments.sse == sse);
+            REQUIRE(psnr_from_moments(moments) == psnr_y(ref, dist, width, height));
+            REQUIRE(ssim_from_moments(moments) == ssim_y(ref, dist, width, height));
+
+            // The next level keeps the 2x2 sums; dropping the two fractional bits gives downsample_2x2
+            int new_width, new_height;
+            REQUIRE(ref_half == downsample_2x2_sum(ref, width, height, new_width, new_height));
+            REQUIRE(dist_half == downsample_2x2_sum(dist, width, height, new_width, new_height));
+            auto truncated = downsample_2x2(ref, width, height, new_width, new_height);
+            for (size_t i = 0; i < truncated.size(); ++i) {
+                REQUIRE(truncated[i] == ref_half[i] >> 2);
+            }
+        }
+    }
+
+    SECTION("Fixed-point pyramid levels are exact") {
+        auto image = pattern(64, 64, 3);
+        int w = 64, h = 64;
+        auto level = downsample_2x2_sum(image, w, h, w, h);
+        for (int scale = 2; scale < 5; ++scale) {
+            level = downsample_2x2_sum(level, w, h, w, h);
+        }
+        // Level 4 holds each 16x16 block sum exactly (Q8)
+        REQUIRE(w == 4);
+        REQUIRE(h == 4);
+        for (int by = 0; by < 4; ++by) {
+            for (int bx = 0; bx < 4; ++bx) {
+                uint32_t sum = 0;
+                for (int y = 0; y < 16; ++y) {
+                    for (int x = 0; x < 16; ++x) {
+                        sum += image[(by * 16 + y) * 64 + bx * 16 + x];
+                    }
+                }
+                REQUIRE(level[by * 4 + bx] == sum);
+            }
+        }
+
+        // Scaling samples by 2^frac_bits leaves SSIM unchanged
+        auto ref = pattern(40, 33, 3);
+        auto dist = pattern(40, 33, 4);
+        std::vector<uint16_t> ref_q4(ref.begin(), ref.end()), dist_q4(dist.begin(), dist.end());
+        for (size_t i = 0; i < ref.size(); ++i) {
+            ref_q4[i] <<= 4;
+            dist_q4[i] <<= 4;
+        }
+        auto moments = luma_moments(ref_q4.data(), dist_q4.data(), 40, 33, nullptr, nullptr);
+        REQUIRE(ssim_from_moments(moments, 4) == Approx(ssim_y(ref, dist, 40, 33)).epsilon(1e-12));
+    }
+
+    SECTION("Global SSIM matches a two-pass reference") {
+        auto ref = pattern(40, 33, 3);
+        auto dist = pattern(40, 33, 4);
+        double n = static_cast<double>(ref.size());
+        double mean1 = 0.0, mean2 = 0.0;
+        for (size_t i = 0; i < ref.size(); ++i) {
+            mean1 += ref[i] / n;
+            mean2 += dist[i] / n;
+        }
+        double var1 = 0.0, var2 = 0.0, covar = 0.0;
+        for (size_t i = 0; i < ref.size(); ++i) {
+            var1 += (ref[i] - mean1) * (ref[i] - mean1) / (n - 1);
+            var2 += (dist[i] - mean2) * (dist[i] - mean2) / (n - 1);
+            covar += (ref[i] - mean1) * (dist[i] - mean2) / (n - 1);
+        }
+        const double C1 = 6.5025, C2 = 58.5225;
+        double expected = (2 * mean1 * mean2 + C1) * (2 * covar + C2) /
+                          ((mean1 * mean1 + mean2 * mean2 + C1) * (var1 + var2 + C2));
+        REQUIRE(ssim_y(ref, dist, 40, 33) == Approx(expected).epsilon(1e-12));
+    }
+
+    SECTION("PSNR shares MS-SSIM's sweep") {
+        auto ref = pattern(64, 48, 3);
+        auto dist = pattern(64, 48, 4);
+        LumaMoments moments;
+        double msssim = msssim_y(ref, dist, 64, 48, &moments);
+        REQUIRE(msssim == msssim_y(ref, dist, 64, 48));
+        REQUIRE(psnr_from_moments(moments) == psnr_y(ref, dist, 64, 48));
+
+        // score_frame shares the sweep between psnr and msssim without changing either value
+        FrameMetricOptions options;
+        options.width = 64;
+        options.height = 48;
+        auto fused = make_frame_metrics({"psnr", "msssim"}, options);
+        REQUIRE(fused[1].sweep_luma);
+        YUVFrame ref_frame(64, 48), dist_frame(64, 48);
+        ref_frame.y = ref;
+        dist_frame.y = dist;
+        std::vector<double> values;
+        score_frame(fused, ref_frame, dist_frame, 0, values);
+        REQUIRE(values[0] == psnr_y(ref, dist, 64, 48));
+        REQUIRE(values[1] == msssim);
+        // Each metric alone still scores the frame itself
+        REQUIRE(fused[0].compute(ref_frame, dist_frame, 0) == values[0]);
+        REQUIRE(fused[1].compute(ref_frame, dist_frame, 0) == msssim);
+
+        // Sampled windows sweep other samples, so nothing is shared
+        options.window_fraction = 0.5;
+        REQUIRE_FALSE(make_frame_metrics({"psnr", "msssim"}, options)[1].sweep_luma);
+    }
+
+    SECTION("PSNR-HVS and PSNR-HVS-M share one DCT pass") {
+        FrameMetricOptions options;
+        options.width = 32;
+        options.height = 16;
+        auto hvs = make_frame_metrics({"psnr_hvs", "psnr_hvs_m"}, options);
+        REQUIRE(hvs[0].hvs_error);
+        YUVFrame ref_frame(32, 16), dist_frame(32, 16);
+        ref_frame.y = pattern(32, 16, 3);
+        dist_frame.y = pattern(32, 16, 4);
+        std::vector<double> values;
+        score_frame(hvs, ref_frame, dist_frame, 0, values);
+        REQUIRE(values[0] == hvs[0].compute(ref_frame, dist_frame, 0));
+        REQUIRE(values[1] == hvs[1].compute(ref_frame, dist_frame, 0));
+        REQUIRE(values[1] != values[0]);
+    }
+}
+
+TEST_CASE("Row-band scoring", "[metrics]") {
+    auto pattern = [](int width, int height, int seed) {
+        std::vector<uint8_t> image(static_cast<size_t>(width) * height);
+        for (int i = 0; i < width * height; ++i) {
+            image[i] = static_cast<uint8_t>((i * 37 + (i / width) * seed + (i * i) % 11) % 256);
+        }
+        return image;
+    };
+    const int width = 69;
+    const int height = 45;  // Odd, and not a multiple of the 4-row SSIM blocks
+    auto ref = pattern(width, height, 3);
+    auto dist = pattern(width, height, 4);
+
+    SECTION("Bands of any height give the whole-frame results") {
+        SsimFixedRows ssim(width, height);
+        MsssimRows msssim(width, height);
+        LumaMoments whole_moments;
+        double whole_msssim = msssim_y(ref, dist, width, height, &whole_moments);
+        for (int band : {1, 3, 16, height}) {
+            for (int y = 0; y < height; y += band) {
+                int rows = std::min(band, height - y);
+                ssim.add_rows(ref.data() + y * width, dist.data() + y * width, rows);
+                msssim.add_rows(ref.data() + y * width, dist.data() + y * width, rows);
+            }
+            REQUIRE(ssim.finish() == ssim_y_fixed(ref, dist, width, height));
+            LumaMoments moments;
+            REQUIRE(msssim.finish(&moments) == whole_msssim);
+            REQUIRE(moments.sse == whole_moments.sse);
+        }
+    }
+
+    SECTION("Missing rows and reset") {
+        SsimFixedRows ssim(width, height);
+        MsssimRows msssim(width, height);
+        ssim.add_rows(ref.data(), dist.data(), 20);
+        msssim.add_rows(ref.data(), dist.data(), 20);
+        REQUIRE_THROWS_AS(ssim.finish(), std::invalid_argument);
+        REQUIRE_THROWS_AS(msssim.finish(), std::invalid_argument);
+
+        // A dropped partial frame does not leak into the next one
+        msssim.add_rows(dist.data(), ref.data(), 20);
+        msssim.reset();
+        msssim.add_rows(ref.data(), dist.data(), height);
+        REQUIRE(msssim.finish() == msssim_y(ref, dist, width, height));
+    }
+
+    SECTION("Registry band scorers match compute at 8 and 10 bits") {
+        for (int bit_depth : {8, 10}) {
+            FrameMetricOptions options;
+            options.width = width;
+            options.height = height;
+            options.bit_depth = bit_depth;
+            auto metrics = make_frame_metrics({"psnr", "ssim", "msssim", "blur"}, options);
+            REQUIRE(metrics[3].name == "blur");
+            REQUIRE_FALSE(metrics[3].make_band_scorer);
+
+            YUVFrame ref_frame(width, height, bit_depth), dist_frame(width, height, bit_depth);
+            for (size_t i = 0; i < ref.size(); ++i) {
+                if (bit_depth > 8) {
+                    ref_frame.y16[i] = static_cast<uint16_t>(ref[i] * 4 + i % 4);
+                    dist_frame.y16[i] = static_cast<uint16_t>(dist[i] * 4 + i % 3);
+                } else {
+                    ref_frame.y[i] = ref[i];
+                    dist_frame.y[i] = dist[i];
+                }
+            }
+            for (size_t m = 0; m < 3; ++m) {
+                auto scorer = metrics[m].make_band_scorer();
+                for (int y = 0; y < height; y += 10) {
+                    scorer->add_rows(ref_frame, dist_frame, y, std::min(10, height - y));
+                }
+                REQUIRE(scorer->finish() == metrics[m].compute(ref_frame, dist_frame, 0));
+            }
+        }
+    }
+}
+
 TEST_CASE("Gaussian filter application", "[metrics]") {
     SECTION("Filtering preserves image dimensions") {
         std::vector<uint8_t> image(32 * 32, 128);
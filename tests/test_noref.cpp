@@ -0,0 +1,138 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include "src/noref.hpp"
+#include "src/frame_metrics.hpp"
+#include <cmath>
+#include <stdexcept>
+
+using namespace rdmeter;
+using Catch::Approx;
+
+namespace {
+
+// Fill the luma plane (8-bit or deeper) from a function of position
+template <typename Fn>
+YUVFrame make_frame(int width, int height, int bit_depth, Fn value) {
+    YUVFrame frame(width, height, bit_depth);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            int v = value(x, y);
+            if (bit_depth > 8) {
+                frame.y16[y * width + x] = static_cast<uint16_t>(v << (bit_depth - 8));
+            } else {
+                frame.y[y * width + x] = static_cast<uint8_t>(v);
+            }
+        }
+    }
+    return frame;
+}
+
+// Smooth texture without any structure on an 8-pixel grid
+int texture(int x, int y) {
+    return 128 + static_cast<int>(40.0 * std::sin(x * 0.37) * std::cos(y * 0.23));
+}
+
+} // namespace
+
+TEST_CASE("Blockiness", "[noref]") {
+    SECTION("Unblocked content scores about 1") {
+        auto frame = make_frame(64, 64, 8, texture);
+        REQUIRE(blockiness_y(frame, 8) == Approx(1.0).margin(0.2));
+    }
+
+    SECTION("Block edges raise the score") {
+        // Each 8x8 block holds the texture value of its corner, as after coarse quantisation
+        auto blocked = make_frame(64, 64, 8, [](int x, int y) { return texture(x & ~7, y & ~7); });
+        REQUIRE(blockiness_y(blocked, 8) > 5.0);
+        // The same frame shows no structure on a grid it was not built on
+        REQUIRE(blockiness_y(blocked, 8) > 2.0 * blockiness_y(blocked, 12));
+    }
+
+    SECTION("Bit depth does not change the score") {
+        auto blocked8 = make_frame(64, 64, 8, [](int x, int y) { return texture(x & ~7, y & ~7); });
+        auto blocked10 = make_frame(64, 64, 10, [](int x, int y) { return texture(x & ~7, y & ~7); });
+        REQUIRE(blockiness_y(blocked10, 8) == Approx(blockiness_y(blocked8, 8)).epsilon(0.01));
+    }
+
+    SECTION("Invalid input") {
+        auto frame = make_frame(16, 16, 8, texture);
+        REQUIRE_THROWS_AS(blockiness_y(frame, 1), std::invalid_argument);
+        REQUIRE_THROWS_AS(blockiness_y(frame, 16), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Blur", "[noref]") {
+    auto step = make_frame(64, 16, 8, [](int x, int) { return x < 32 ? 20 : 220; });
+    auto ramp = make_frame(64, 16, 8, [](int x, int) { return std::min(220, std::max(20, 20 + (x - 28) * 25)); });
+
+    REQUIRE(blur_y(step) == Approx(1.0));
+    REQUIRE(blur_y(ramp) == Approx(8.0));
+
+    // Flat frames have no edges
+    auto flat = make_frame(32, 32, 8, [](int, int) { return 100; });
+    REQUIRE(blur_y(flat) == 0.0);
+
+    // Widths are in pixels at every bit depth
+    auto ramp10 = make_frame(64, 16, 10, [](int x, int) { return std::min(220, std::max(20, 20 + (x - 28) * 25)); });
+    REQUIRE(blur_y(ramp10) == Approx(blur_y(ramp)));
+}
+
+TEST_CASE("Banding", "[noref]") {
+    SECTION("Quantised gradient bands along both axes") {
+        // One code value every 16 columns: 3 interior band edges per row
+        auto horizontal = make_frame(64, 32, 8, [](int x, int) { return 60 + x / 16; });
+        REQUIRE(banding_y(horizontal) == Approx(100.0 * 3 / 64));
+
+        auto vertical = make_frame(32, 64, 8, [](int, int y) { return 60 + y / 16; });
+        REQUIRE(banding_y(vertical) == Approx(100.0 * 3 / 64));
+    }
+
+    SECTION("Flat, dithered and high-contrast content does not band") {
+        auto flat = make_frame(64, 64, 8, [](int, int) { return 90; });
+        REQUIRE(banding_y(flat) == 0.0);
+
+        auto dithered = make_frame(64, 64, 8, [](int x, int y) { return 60 + x / 16 + ((x * 7 + y * 13) % 3 == 0); });
+        REQUIRE(banding_y(dithered) < banding_y(make_frame(64, 64, 8, [](int x, int) { return 60 + x / 16; })) / 4);
+
+        auto edges = make_frame(64, 64, 8, [](int x, int) { return x < 32 ? 20 : 220; });
+        REQUIRE(banding_y(edges) == 0.0);
+    }
+
+    SECTION("Steps are scaled to the bit depth") {
+        // A 10-bit gradient with one-code steps is smooth; four-code steps band like 8-bit ones
+        auto smooth = make_frame(64, 32, 10, [](int, int) { return 0; });
+        for (int y = 0; y < 32; ++y) {
+            for (int x = 0; x < 64; ++x) {
+                smooth.y16[y * 64 + x] = static_cast<uint16_t>(240 + x);
+            }
+        }
+        REQUIRE(banding_y(smooth) == 0.0);
+        auto banded = make_frame(64, 32, 10, [](int x, int) { return 60 + x / 16; });
+        REQUIRE(banding_y(banded) == Approx(100.0 * 3 / 64));
+    }
+}
+
+TEST_CASE("No-reference metrics in the registry", "[noref]") {
+    FrameMetricOptions options;
+    options.width = 64;
+    options.height = 64;
+    options.block_size = 16;
+
+    auto metrics = make_frame_metrics({"banding", "psnr", "blockiness", "blur"}, options);
+    REQUIRE(metrics.size() == 4);
+    REQUIRE(metrics[0].name == "psnr");
+    REQUIRE_FALSE(metrics[0].reference_free);
+    REQUIRE(metrics[1].name == "blockiness");
+    REQUIRE(metrics[1].label == "Blockiness (16x16 grid)");
+    for (size_t m = 1; m < metrics.size(); ++m) {
+        REQUIRE(metrics[m].reference_free);
+    }
+
+    // Only the distorted frame is scored
+    auto dist = make_frame(64, 64, 8, [](int x, int) { return 60 + x / 16; });
+    auto other = make_frame(64, 64, 8, texture);
+    REQUIRE(metrics[3].compute(other, dist, 0) == metrics[3].compute(dist, dist, 0));
+
+    options.block_size = 40;
+    REQUIRE_THROWS_AS(make_frame_metrics({"blockiness"}, options), std::invalid_argument);
+}
@@ -0,0 +1,115 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include "src/psnr_hvs.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+using namespace rdmeter;
+using Catch::Approx;
+
+namespace {
+
+YUVFrame textured_frame(int width, int height, int seed) {
+    YUVFrame frame(width, height);
+    for (size_t i = 0; i < frame.y.size(); ++i) {
+        frame.y[i] = static_cast<uint8_t>((i * 37 + (i / width) * 11 + seed) % 200 + 20);
+    }
+    for (size_t i = 0; i < frame.u.size(); ++i) {
+        frame.u[i] = static_cast<uint8_t>((i * 13 + seed) % 100 + 80);
+        frame.v[i] = static_cast<uint8_t>((i * 29 + seed) % 100 + 80);
+    }
+    return frame;
+}
+
+} // namespace
+
+TEST_CASE("Integer 8x8 DCT", "[psnr_hvs]") {
+    std::vector<uint8_t> block(64);
+    for (int i = 0; i < 64; ++i) {
+        block[i] = static_cast<uint8_t>((i * 97 + 13) % 256);
+    }
+    int32_t out[64];
+    dct8x8_int(block.data(), 8, out);
+
+    const double pi = 3.14159265358979323846;
+    for (int u = 0; u < 8; ++u) {
+        for (int v = 0; v < 8; ++v) {
+            double sum = 0.0;
+            for (int y = 0; y < 8; ++y) {
+                for (int x = 0; x < 8; ++x) {
+                    sum += block[y * 8 + x] * std::cos((2 * y + 1) * u * pi / 16.0) * std::cos((2 * x + 1) * v * pi / 16.0);
+                }
+            }
+            double expected = sum * (u == 0 ? std::sqrt(0.125) : 0.5) * (v == 0 ? std::sqrt(0.125) : 0.5);
+            REQUIRE(out[u * 8 + v] / 8.0 == Approx(expected).margin(0.5));
+        }
+    }
+
+    SECTION("Flat block has only a DC term") {
+        std::vector<uint8_t> flat(64, 100);
+        dct8x8_int(flat.data(), 8, out);
+        REQUIRE(out[0] == 8 * 800);
+        for (int i = 1; i < 64; ++i) {
+            REQUIRE(out[i] == 0);
+        }
+    }
+}
+
+TEST_CASE("PSNR-HVS and PSNR-HVS-M", "[psnr_hvs]") {
+    const int width = 64;
+    const int height = 48;
+    YUVFrame ref = textured_frame(width, height, 0);
+
+    SECTION("Identical frames") {
+        REQUIRE(psnr_hvs_yuv(ref, ref, false) == 100.0);
+        REQUIRE(psnr_hvs_yuv(ref, ref, true) == 100.0);
+    }
+
+    SECTION("Uniform offset only changes the unmasked DC term") {
+        YUVFrame dist = ref;
+        for (auto* plane : {&dist.y, &dist.u, &dist.v}) {
+            for (auto& sample : *plane) {
+                sample = static_cast<uint8_t>(sample + 2);
+            }
+        }
+        double csf_dc = 25.73509 / 16.0;
+        double expected = 10.0 * std::log10(255.0 * 255.0 / (4.0 * csf_dc * csf_dc));
+        REQUIRE(psnr_hvs_yuv(ref, dist, false) == Approx(expected).epsilon(1e-3));
+        REQUIRE(psnr_hvs_yuv(ref, dist, true) == Approx(expected).epsilon(1e-3));
+    }
+
+    SECTION("Masking hides noise in texture") {
+        YUVFrame dist = ref;
+        for (size_t i = 0; i < dist.y.size(); ++i) {
+            dist.y[i] = static_cast<uint8_t>(dist.y[i] + (i % 5) - 2);
+        }
+        double hvs = psnr_hvs_yuv(ref, dist, false);
+        double hvs_m = psnr_hvs_yuv(ref, dist, true);
+        REQUIRE(hvs < 100.0);
+        REQUIRE(hvs_m > hvs);
+    }
+
+    SECTION("One pass yields both errors") {
+        YUVFrame dist = textured_frame(width, height, 3);
+        HvsError error = hvs_frame_error(ref, dist);
+        REQUIRE(psnr_hvs_from_error(error.hvs) == psnr_hvs_yuv(ref, dist, false));
+        REQUIRE(psnr_hvs_from_error(error.hvs_m) == psnr_hvs_yuv(ref, dist, true));
+    }
+
+    SECTION("Chroma under one block is left out") {
+        YUVFrame small = textured_frame(8, 12, 0);
+        YUVFrame dist = textured_frame(8, 12, 5);
+        HvsError luma = hvs_plane_error(small.y.data(), dist.y.data(), 8, 12, 8);
+        HvsError error = hvs_frame_error(small, dist);
+        REQUIRE(error.hvs == Approx(luma.hvs).epsilon(1e-12));
+        REQUIRE(error.hvs_m == Approx(luma.hvs_m).epsilon(1e-12));
+    }
+
+    SECTION("Invalid input") {
+        YUVFrame small(8, 4);
+        REQUIRE_THROWS_AS(psnr_hvs_yuv(small, small, false), std::invalid_argument);
+        YUVFrame deep(width, height, 10);
+        REQUIRE_THROWS_AS(psnr_hvs_yuv(ref, deep, false), std::invalid_argument);
+    }
+}
@@ -0,0 +1,78 @@
+#include <catch2/catch_test_macros.hpp>
+#include "src/results_cache.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace rdmeter;
+namespace fs = std::filesystem;
+
+TEST_CASE("XXH64", "[results_cache]") {
+    // Reference values of the XXH64 specification, seed 0
+    REQUIRE(xxh64("", 0) == 0xEF46DB3751D8E999ull);
+    REQUIRE(xxh64("a", 1) == 0xD24EC4F1A98C6E5Bull);
+    REQUIRE(xxh64("abc", 3) == 0x44BC2CF5AD770999ull);
+    const std::string long_input = "Nobody inspects the spammish repetition";
+    REQUIRE(xxh64(long_input.data(), long_input.size()) == 0xFBCEA83C8A378BF1ull);
+    REQUIRE(xxh64("abc", 3, 1) != xxh64("abc", 3));
+
+    fs::path path = fs::temp_directory_path() / "rdmeter_test_hash.bin";
+    std::string contents(100003, '\0');
+    for (size_t i = 0; i < contents.size(); ++i) {
+        contents[i] = static_cast<char>(i * 31 + (i >> 7));
+    }
+    std::ofstream(path, std::ios::binary) << contents;
+    REQUIRE(hash_file(path.string()) == xxh64(contents.data(), contents.size()));
+    std::ofstream(path, std::ios::binary | std::ios::trunc);
+    REQUIRE(hash_file(path.string()) == xxh64("", 0));
+    fs::remove(path);
+    REQUIRE_THROWS_AS(hash_file(path.string()), std::runtime_error);
+}
+
+TEST_CASE("Results cache", "[results_cache]") {
+    fs::path dir = fs::temp_directory_path() / "rdmeter_test_results_cache";
+    fs::remove_all(dir);
+    fs::path input = fs::temp_directory_path() / "rdmeter_test_cache_input.yuv";
+    std::ofstream(input, std::ios::binary) << "frame data";
+
+    ResultsCache cache(dir.string());
+    const std::string key = "dist=" + file_fingerprint(input.string(), CacheTrust::Content) + " metrics=psnr";
+    CachedResults stored;
+    stored.results = R"({"frame_count": 2, "metrics": {"psnr_y": 0.30000000000000004}})";
+    stored.per_frame = "{\"frame\":0}\n{\"frame\":1}\n";
+
+    CachedResults loaded;
+    REQUIRE_FALSE(cache.load(key, loaded));
+    cache.store(key, stored);
+    REQUIRE(cache.load(key, loaded));
+    REQUIRE(loaded.per_frame == stored.per_frame);
+    REQUIRE(loaded.results.find("0.30000000000000004") != std::string::npos);
+    // Only the entry itself is left behind
+    fs::path entry_dir = fs::path(cache.entry_path(key)).parent_path();
+    REQUIRE(std::distance(fs::directory_iterator(entry_dir), fs::directory_iterator()) == 1);
+
+    SECTION("Another key misses") {
+        REQUIRE_FALSE(cache.load(key + " metrics=ssim", loaded));
+    }
+
+    SECTION("Changed content changes the fingerprint") {
+        auto size_mtime = file_fingerprint(input.string(), CacheTrust::SizeMtime);
+        std::ofstream(input, std::ios::binary | std::ios::trunc) << "frame date";
+        REQUIRE(file_fingerprint(input.string(), CacheTrust::Content) + " metrics=psnr" != key.substr(5));
+        // Same size; only the modification time can tell, and may not within its resolution
+        fs::last_write_time(input, fs::last_write_time(input) + std::chrono::seconds(1));
+        REQUIRE(file_fingerprint(input.string(), CacheTrust::SizeMtime) != size_mtime);
+    }
+
+    SECTION("A corrupt entry is a miss") {
+        std::ofstream(cache.entry_path(key), std::ios::trunc) << "{\"version\": ";
+        REQUIRE_FALSE(cache.load(key, loaded));
+        cache.store(key, stored);
+        REQUIRE(cache.load(key, loaded));
+    }
+
+    fs::remove_all(dir);
+    fs::remove(input);
+}
@@ -0,0 +1,84 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include "src/sampling.hpp"
+#include "src/metrics.hpp"
+#include <algorithm>
+#include <set>
+#include <vector>
+
+using namespace rdmeter;
+using Catch::Approx;
+
+TEST_CASE("Stratified frame sampling", "[sampling]") {
+    SECTION("Each batch covers every stratum") {
+        StratifiedSampler sampler(1000, 42);
+        auto batch = sampler.next_batch(10);
+        REQUIRE(batch.size() == 10);
+        for (int s = 0; s < 10; ++s) {
+            REQUIRE(batch[s] >= s * 100);
+            REQUIRE(batch[s] < (s + 1) * 100);
+        }
+    }
+
+    SECTION("Frames are drawn without replacement until exhausted") {
+        StratifiedSampler sampler(37, 7);
+        std::set<int> seen;
+        while (!sampler.exhausted()) {
+            auto batch = sampler.next_batch(8);
+            REQUIRE_FALSE(batch.empty());
+            for (int frame : batch) {
+                REQUIRE(seen.insert(frame).second);
+            }
+        }
+        REQUIRE(seen.size() == 37);
+        REQUIRE(sampler.next_batch(8).empty());
+    }
+
+    SECTION("Same seed gives the same frames") {
+        StratifiedSampler a(500, 99);
+        StratifiedSampler b(500, 99);
+        REQUIRE(a.next_batch(16) == b.next_batch(16));
+    }
+}
+
+TEST_CASE("Confidence intervals", "[sampling]") {
+    SECTION("Student t quantiles") {
+        REQUIRE(student_t_quantile(0.95, 1000) == Approx(1.962).epsilon(1e-3));
+        REQUIRE(student_t_quantile(0.95, 10) == Approx(2.228).epsilon(5e-3));
+        REQUIRE(student_t_quantile(0.99, 30) == Approx(2.750).epsilon(5e-3));
+    }
+
+    SECTION("Running estimate matches direct mean and variance") {
+        RunningEstimate estimate;
+        std::vector<double> values = {30.0, 32.0, 31.0, 35.0, 29.0};
+        for (double v : values) estimate.add(v);
+        REQUIRE(estimate.mean == Approx(31.4));
+        REQUIRE(estimate.variance() == Approx(5.3));
+    }
+
+    SECTION("Interval vanishes when the whole population is sampled") {
+        RunningEstimate estimate;
+        for (double v : {1.0, 2.0, 3.0, 4.0}) estimate.add(v);
+        REQUIRE(estimate.ci_half_width(0.95, 4) == Approx(0.0));
+        REQUIRE(estimate.ci_half_width(0.95, 1000) > 0.0);
+    }
+}
+
+TEST_CASE("Window-sampled MS-SSIM", "[sampling]") {
+    std::vector<uint8_t> ref(64 * 64);
+    std::vector<uint8_t> dist(64 * 64);
+    for (int i = 0; i < 64 * 64; ++i) {
+        ref[i] = static_cast<uint8_t>((i * 37) % 251);
+        dist[i] = static_cast<uint8_t>(std::min(255, ref[i] + (i % 5)));
+    }
+
+    SECTION("Full window fraction matches msssim_y") {
+        REQUIRE(msssim_y_sampled(ref, dist, 64, 64, 1.0, 1) == Approx(msssim_y(ref, dist, 64, 64)).epsilon(1e-9));
+    }
+
+    SECTION("Partial window fraction stays close") {
+        double full = msssim_y(ref, dist, 64, 64);
+        double partial = msssim_y_sampled(ref, dist, 64, 64, 0.5, 3);
+        REQUIRE(partial == Approx(full).margin(0.05));
+    }
+}
@@ -0,0 +1,129 @@
+#include <catch2/catch_test_macros.hpp>
+#include "src/shm_ring.hpp"
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace rdmeter;
+using namespace std::chrono_literals;
+
+namespace {
+
+std::string ring_name(const char* test) {
+    return "/rdmeter_test_" + std::string(test) + "_" + std::to_string(getpid());
+}
+
+// Stand-in for a decoder process: writes frames with a known pattern straight into the
+// slots through its own mapping of the segment
+void produce(ShmFrameRing& ring, int frames) {
+    for (int n = 0; n < frames; ++n) {
+        // Catch2 assertions are not thread-safe; a stalled producer shows up as missing frames
+        uint8_t* slot = ring.acquire(5s);
+        if (!slot) {
+            break;
+        }
+        if (ring.bit_depth() > 8) {
+            auto* samples = reinterpret_cast<uint16_t*>(slot);
+            for (size_t i = 0; i < ring.frame_bytes() / 2; ++i) {
+                samples[i] = static_cast<uint16_t>((i * 7 + n * 13) % 1024);
+            }
+        } else {
+            for (size_t i = 0; i < ring.frame_bytes(); ++i) {
+                slot[i] = static_cast<uint8_t>(i * 7 + n * 13);
+            }
+        }
+        ring.publish();
+    }
+    ring.close();
+}
+
+} // namespace
+
+TEST_CASE("Shared-memory frame ring", "[shm]") {
+    const int width = 34, height = 18;
+
+    SECTION("Frames arrive in order through a ring smaller than the stream") {
+        for (int bit_depth : {8, 10}) {
+            auto producer = ShmFrameRing::create(ring_name("order"), width, height, bit_depth, 3);
+            auto consumer = ShmFrameRing::open(ring_name("order"), 1s);
+            REQUIRE(consumer->width() == width);
+            REQUIRE(consumer->height() == height);
+            REQUIRE(consumer->bit_depth() == bit_depth);
+            REQUIRE(consumer->slots() == 3);
+
+            const int frames = 20;
+            std::thread decoder([&] { produce(*producer, frames); });
+            YUVFrame frame(width, height, bit_depth);
+            int received = 0;
+            while (consumer->read(frame, 5s)) {
+                if (bit_depth > 8) {
+                    REQUIRE(frame.y16[5] == (5 * 7 + received * 13) % 1024);
+                    size_t v0 = frame.y16.size() + frame.u16.size();
+                    REQUIRE(frame.v16[0] == (v0 * 7 + received * 13) % 1024);
+                } else {
+                    REQUIRE(frame.y[5] == static_cast<uint8_t>(5 * 7 + received * 13));
+                    size_t v0 = frame.y.size() + frame.u.size();
+                    REQUIRE(frame.v[0] == static_cast<uint8_t>(v0 * 7 + received * 13));
+                }
+                ++received;
+            }
+            decoder.join();
+            REQUIRE(received == frames);
+            REQUIRE(consumer->closed());
+        }
+    }
+
+    SECTION("Slots are read in place and handed back") {
+        auto producer = ShmFrameRing::create(ring_name("inplace"), width, height, 8, 1);
+        auto consumer = ShmFrameRing::open(ring_name("inplace"), 1s);
+        uint8_t* slot = producer->acquire(1s);
+        REQUIRE(slot != nullptr);
+        slot[0] = 42;
+        producer->publish();
+
+        // The only slot is taken until the consumer releases it
+        REQUIRE(producer->acquire(20ms) == nullptr);
+        const uint8_t* frame = consumer->wait_frame(1s);
+        REQUIRE(frame != nullptr);
+        REQUIRE(frame[0] == 42);
+        consumer->release();
+        REQUIRE(producer->acquire(1s) == slot);
+    }
+
+    SECTION("An idle producer times out and a closed one ends the stream") {
+        auto producer = ShmFrameRing::create(ring_name("idle"), width, height, 8, 2);
+        auto consumer = ShmFrameRing::open(ring_name("idle"), 1s);
+        YUVFrame frame(width, height);
+        auto start = std::chrono::steady_clock::now();
+        REQUIRE_FALSE(consumer->read(frame, 30ms));
+        REQUIRE(std::chrono::steady_clock::now() - start >= 30ms);
+        REQUIRE_FALSE(consumer->closed());
+
+        // A consumer sleeping on the futex is woken by close()
+        std::thread closer([&] {
+            std::this_thread::sleep_for(20ms);
+            producer->close();
+        });
+        REQUIRE(consumer->wait_frame(10s) == nullptr);
+        closer.join();
+        REQUIRE(std::chrono::steady_clock::now() - start < 5s);
+    }
+
+    SECTION("Opening waits for the producer and checks the frames") {
+        REQUIRE_THROWS_AS(ShmFrameRing::open(ring_name("missing"), 10ms), std::runtime_error);
+
+        std::unique_ptr<ShmFrameRing> producer;
+        std::thread late([&] {
+            std::this_thread::sleep_for(20ms);
+            producer = ShmFrameRing::create(ring_name("late"), width, height, 12, 2);
+        });
+        auto consumer = ShmFrameRing::open(ring_name("late"), 5s);
+        late.join();
+        REQUIRE(consumer->bit_depth() == 12);
+
+        YUVFrame wrong_depth(width, height, 8);
+        REQUIRE_THROWS_AS(consumer->read(wrong_depth, 10ms), std::invalid_argument);
+        REQUIRE_THROWS_AS(ShmFrameRing::create(ring_name("bad"), width, height, 9, 2), std::invalid_argument);
+    }
+}
@@ -0,0 +1,127 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include "src/ssimulacra2.hpp"
+#include "src/metrics.hpp"
+#include "src/threading.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace rdmeter;
+using Catch::Approx;
+
+namespace {
+
+Image test_image(int width, int height, int channels) {
+    Image image;
+    image.width = width;
+    image.height = height;
+    image.channels = channels;
+    image.pixels.resize(static_cast<size_t>(width) * height * channels);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            for (int c = 0; c < channels; ++c) {
+                // Smooth gradients with some texture, different per channel
+                int value = (x * 3 + y * 2 + c * 40) % 200 + ((x / 4 + y / 4) % 2) * 30 + 10;
+                image.pixels[(static_cast<size_t>(y) * width + x) * channels + c] = static_cast<uint8_t>(value);
+            }
+        }
+    }
+    return image;
+}
+
+Image add_noise(const Image& image, int amplitude) {
+    Image out = image;
+    uint32_t state = 7;
+    for (auto& p : out.pixels) {
+        state = state * 1664525u + 1013904223u;
+        int noise = static_cast<int>((state >> 16) % (2 * amplitude + 1)) - amplitude;
+        p = static_cast<uint8_t>(std::min(255, std::max(0, p + noise)));
+    }
+    return out;
+}
+
+} // namespace
+
+TEST_CASE("Float Gaussian filter and downsampling", "[ssimulacra2]") {
+    const int width = 23;
+    const int height = 17;
+    std::vector<uint8_t> image(width * height);
+    std::vector<float> image_f(width * height);
+    for (int i = 0; i < width * height; ++i) {
+        image[i] = static_cast<uint8_t>((i * 31) % 256);
+        image_f[i] = image[i];
+    }
+    auto kernel = generate_gaussian_kernel(11, 1.5);
+    auto expected = apply_gaussian_filter(image, width, height, kernel);
+    auto filtered = apply_gaussian_filter(image_f, width, height, kernel);
+    for (int i = 0; i < width * height; ++i) {
+        REQUIRE(filtered[i] == Approx(expected[i]).margin(1e-3));
+    }
+
+    int new_width = 0, new_height = 0;
+    auto half = downsample_2x2(image_f, width, height, new_width, new_height);
+    REQUIRE(new_width == 11);
+    REQUIRE(new_height == 8);
+    REQUIRE(half[0] == Approx((image_f[0] + image_f[1] + image_f[width] + image_f[width + 1]) / 4.0));
+}
+
+TEST_CASE("SSIMULACRA2", "[ssimulacra2]") {
+    Image ref = test_image(96, 64, 3);
+
+    SECTION("Identical images score 100") {
+        REQUIRE(ssimulacra2(ref, ref) == Approx(100.0));
+    }
+
+    SECTION("Score falls as distortion grows") {
+        double light = ssimulacra2(ref, add_noise(ref, 2));
+        double heavy = ssimulacra2(ref, add_noise(ref, 20));
+        REQUIRE(light < 100.0);
+        REQUIRE(heavy < light);
+    }
+
+    SECTION("Parallel scoring matches serial scoring") {
+        Image dist = add_noise(ref, 6);
+        ThreadPool pool(4);
+        REQUIRE(ssimulacra2(ref, dist, &pool) == ssimulacra2(ref, dist));
+    }
+
+    SECTION("Gray images match RGB with equal channels") {
+        Image gray = test_image(40, 40, 1);
+        Image rgb = gray;
+        rgb.channels = 3;
+        rgb.pixels.clear();
+        for (uint8_t p : gray.pixels) {
+            rgb.pixels.insert(rgb.pixels.end(), {p, p, p});
+        }
+        Image gray_dist = add_noise(gray, 5);
+        Image rgb_dist = rgb;
+        for (size_t i = 0; i < gray_dist.pixels.size(); ++i) {
+            for (int c = 0; c < 3; ++c) rgb_dist.pixels[i * 3 + c] = gray_dist.pixels[i];
+        }
+        REQUIRE(ssimulacra2(gray, gray_dist) == Approx(ssimulacra2(rgb, rgb_dist)));
+    }
+
+    SECTION("Pinned score") {
+        // This implementation's own score on a fixed pair, pinned so the pyramid, filter
+        // and weights cannot drift unnoticed. It is not a libjxl value (see the header)
+        Image large = test_image(128, 128, 3);
+        REQUIRE(ssimulacra2(large, add_noise(large, 8)) == Approx(85.745786197586).epsilon(1e-9));
+    }
+
+    SECTION("Pyramids down to 4x4") {
+        for (auto [width, height] : {std::pair{8, 8}, std::pair{13, 9}}) {
+            Image small = test_image(width, height, 3);
+            double score = ssimulacra2(small, add_noise(small, 8));
+            REQUIRE(score < 100.0);
+            REQUIRE(std::isfinite(score));
+        }
+    }
+
+    SECTION("Invalid input") {
+        Image small = test_image(7, 7, 3);
+        REQUIRE_THROWS_AS(ssimulacra2(small, small), std::invalid_argument);
+        REQUIRE_THROWS_AS(ssimulacra2(ref, test_image(64, 96, 3)), std::invalid_argument);
+    }
+}
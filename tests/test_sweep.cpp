@@ -0,0 +1,123 @@
+#include <catch2/catch_test_macros.hpp>
+#include "src/sweep.hpp"
+#include "src/threading.hpp"
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+using namespace rdmeter;
+namespace fs = std::filesystem;
+
+namespace {
+
+// frames YUV420P frames; noise 0 writes the reference content itself
+void write_video(const fs::path& path, int width, int height, int frames, int noise, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> delta(-noise, noise);
+    std::ofstream out(path, std::ios::binary);
+    for (int f = 0; f < frames; ++f) {
+        YUVFrame frame(width, height);
+        for (size_t i = 0; i < frame.y.size(); ++i) {
+            int base = static_cast<int>((i * 7 + f * 13) % 200) + 20;
+            frame.y[i] = static_cast<uint8_t>(base + (noise ? delta(rng) : 0));
+        }
+        std::fill(frame.u.begin(), frame.u.end(), 128);
+        std::fill(frame.v.begin(), frame.v.end(), 128);
+        out.write(reinterpret_cast<const char*>(frame.y.data()), frame.y.size());
+        out.write(reinterpret_cast<const char*>(frame.u.data()), frame.u.size());
+        out.write(reinterpret_cast<const char*>(frame.v.data()), frame.v.size());
+    }
+}
+
+} // namespace
+
+TEST_CASE("Sweep scoring", "[sweep]") {
+    const int width = 32, height = 16, frames = 5;
+    fs::path dir = fs::temp_directory_path();
+    fs::path ref_path = dir / "rdmeter_test_sweep_ref.yuv";
+    std::vector<fs::path> encode_paths = {dir / "rdmeter_test_sweep_a.yuv", dir / "rdmeter_test_sweep_b.yuv",
+                                          dir / "rdmeter_test_sweep_c.yuv"};
+    write_video(ref_path, width, height, frames, 0, 1);
+    for (size_t e = 0; e < encode_paths.size(); ++e) {
+        write_video(encode_paths[e], width, height, frames, 2 + 3 * static_cast<int>(e), 10 + static_cast<unsigned>(e));
+    }
+
+    FrameMetricOptions options;
+    options.width = width;
+    options.height = height;
+    auto metrics = make_frame_metrics({"psnr", "ssim"}, options);
+
+    // Each encode scored on its own, frame by frame
+    std::vector<std::vector<std::vector<double>>> expected(encode_paths.size(), std::vector<std::vector<double>>(2));
+    for (size_t e = 0; e < encode_paths.size(); ++e) {
+        std::ifstream ref_file(ref_path, std::ios::binary), dist_file(encode_paths[e], std::ios::binary);
+        for (int f = 0; f < frames; ++f) {
+            YUVFrame ref(width, height), dist(width, height);
+            read_yuv420p_frame(ref_file, ref);
+            read_yuv420p_frame(dist_file, dist);
+            for (size_t m = 0; m < 2; ++m) {
+                expected[e][m].push_back(metrics[m].compute(ref, dist, f));
+            }
+        }
+    }
+
+    auto sweep = [&](int batch, unsigned threads, int count, const std::vector<FrameMetric>& sweep_metrics) {
+        std::ifstream ref_file(ref_path, std::ios::binary);
+        FrameReader ref(ref_file, width, height, PixelFormat::YUV420P);
+        std::vector<std::unique_ptr<std::ifstream>> files;
+        std::vector<std::unique_ptr<FrameReader>> owned;
+        std::vector<FrameReader*> readers;
+        for (const auto& path : encode_paths) {
+            files.push_back(std::make_unique<std::ifstream>(path, std::ios::binary));
+            owned.push_back(std::make_unique<FrameReader>(*files.back(), width, height, PixelFormat::YUV420P));
+            readers.push_back(owned.back().get());
+        }
+        ThreadPool pool(threads);
+        return score_sweep(ref, readers, sweep_metrics, count, batch, pool);
+    };
+
+    SECTION("Matches per-encode scoring for any batch and thread count") {
+        for (int batch : {1, 2, 8}) {
+            for (unsigned threads : {1u, 3u}) {
+                auto scores = sweep(batch, threads, frames, metrics);
+                REQUIRE(scores.frames == frames);
+                REQUIRE(scores.values == expected);
+            }
+        }
+        // Noisier encodes score lower
+        REQUIRE(expected[0][0][0] > expected[1][0][0]);
+        REQUIRE(expected[1][0][0] > expected[2][0][0]);
+
+        auto prefix = sweep(2, 2, 3, metrics);
+        REQUIRE(prefix.values[2][1].size() == 3);
+        REQUIRE(prefix.values[2][1][2] == expected[2][1][2]);
+    }
+
+    SECTION("Frames a metric cannot score are NaN for that encode") {
+        auto picky = metrics;
+        auto psnr = picky[0].compute;
+        picky[0].compute = [psnr](const YUVFrame& ref, const YUVFrame& dist, int frame) {
+            if (frame == 3 && dist.y[0] == 0) {
+                throw std::invalid_argument("unscorable");
+            }
+            return psnr(ref, dist, frame);
+        };
+        {
+            // Frame 3 of encode b starts with a black pixel
+            std::fstream file(encode_paths[1], std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(static_cast<std::streamoff>(3 * yuv420p_frame_bytes(width, height)));
+            file.put(0);
+        }
+        auto scores = sweep(2, 3, frames, picky);
+        REQUIRE(std::isnan(scores.values[1][0][3]));
+        REQUIRE(std::isnan(scores.values[1][1][3]));
+        REQUIRE(scores.values[0][0][3] == expected[0][0][3]);
+        REQUIRE(scores.values[1][0][4] == expected[1][0][4]);
+    }
+
+    fs::remove(ref_path);
+    for (const auto& path : encode_paths) {
+        fs::remove(path);
+    }
+}
@@ -0,0 +1,128 @@
+#include <catch2/catch_test_macros.hpp>
+#include "src/synthetic.hpp"
+#include "src/frame_metrics.hpp"
+#include "src/threading.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+using namespace rdmeter;
+namespace fs = std::filesystem;
+
+namespace {
+
+std::vector<uint8_t> render(SyntheticVideo& video, int index, const SynthDistortion* distortion, unsigned threads) {
+    ThreadPool pool(threads);
+    std::vector<uint8_t> bytes(video.frame_bytes());
+    if (distortion) {
+        video.render(index, *distortion, bytes.data(), pool);
+    } else {
+        video.render(index, bytes.data(), pool);
+    }
+    return bytes;
+}
+
+// Reads rendered bytes back as compute would
+YUVFrame read_back(const std::vector<uint8_t>& bytes, int width, int height, PixelFormat format) {
+    fs::path path = fs::temp_directory_path() / "rdmeter_test_synthetic.bin";
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    std::ifstream file(path, std::ios::binary);
+    FrameReader reader(file, width, height, format);
+    YUVFrame frame(width, height, reader.bit_depth());
+    reader.read(frame);
+    fs::remove(path);
+    return frame;
+}
+
+} // namespace
+
+TEST_CASE("Synthetic video", "[synthetic]") {
+    const int width = 64, height = 48;
+    SyntheticVideo video(width, height, PixelFormat::YUV420P, 7);
+    REQUIRE(video.frame_bytes() == yuv420p_frame_bytes(width, height));
+
+    SECTION("Frames depend only on seed and index") {
+        auto first = render(video, 3, nullptr, 1);
+        render(video, 9, nullptr, 1);
+        REQUIRE(render(video, 3, nullptr, 3) == first);
+        SyntheticVideo same(width, height, PixelFormat::YUV420P, 7);
+        REQUIRE(render(same, 3, nullptr, 2) == first);
+        SyntheticVideo other(width, height, PixelFormat::YUV420P, 8);
+        REQUIRE(render(other, 3, nullptr, 1) != first);
+        // Consecutive frames move
+        REQUIRE(render(video, 4, nullptr, 1) != first);
+    }
+
+    SECTION("Stronger distortions lower quality more") {
+        FrameMetricOptions options;
+        options.width = width;
+        options.height = height;
+        auto psnr = make_frame_metrics({"psnr"}, options)[0];
+        auto ref = read_back(render(video, 5, nullptr, 1), width, height, PixelFormat::YUV420P);
+        auto score = [&](const SynthDistortion& distortion) {
+            auto dist = read_back(render(video, 5, &distortion, 2), width, height, PixelFormat::YUV420P);
+            return psnr.compute(ref, dist, 5);
+        };
+
+        SynthDistortion none;
+        REQUIRE(render(video, 5, &none, 1) == render(video, 5, nullptr, 1));
+        for (auto strength : {&SynthDistortion::noise, &SynthDistortion::blockiness}) {
+            SynthDistortion light, heavy;
+            light.*strength = 1.0;
+            heavy.*strength = 6.0;
+            REQUIRE(score(light) > score(heavy));
+            REQUIRE(score(heavy) < 100.0);
+        }
+        SynthDistortion blurred;
+        blurred.blur_radius = 2;
+        REQUIRE(score(blurred) < 100.0);
+        REQUIRE(render(video, 5, &blurred, 1) == render(video, 5, &blurred, 3));
+
+        SynthDistortion bad;
+        bad.drop_rate = 1.0;
+        REQUIRE_THROWS_AS(render(video, 5, &bad, 1), std::invalid_argument);
+        SynthDistortion loud;
+        loud.noise = 1e12;
+        REQUIRE_THROWS_AS(render(video, 5, &loud, 1), std::invalid_argument);
+        loud.noise = 255.0;
+        loud.blockiness = 255.0;
+        loud.blur_radius = 255;
+        REQUIRE_NOTHROW(render(video, 5, &loud, 1));
+        loud.blur_radius = 256;
+        REQUIRE_THROWS_AS(render(video, 5, &loud, 1), std::invalid_argument);
+    }
+
+    SECTION("Dropped frames repeat the frame before") {
+        SynthDistortion drops;
+        drops.drop_rate = 0.5;
+        drops.noise = 2.0;
+        int dropped = 0;
+        for (int f = 1; f < 40; ++f) {
+            if (video.shown_frame(f, drops.drop_rate) != f) {
+                ++dropped;
+                REQUIRE(render(video, f, &drops, 1) == render(video, f - 1, &drops, 1));
+            }
+        }
+        REQUIRE(dropped > 5);
+        REQUIRE(dropped < 35);
+        REQUIRE(video.shown_frame(0, 0.99) == 0);
+    }
+}
+
+TEST_CASE("Synthetic video formats", "[synthetic]") {
+    const int width = 32, height = 16;
+    for (auto format : {PixelFormat::YUV420P10LE, PixelFormat::YUV420P12LE, PixelFormat::RGB24, PixelFormat::RGB48LE}) {
+        SyntheticVideo video(width, height, format);
+        REQUIRE(video.frame_bytes() == frame_bytes(format, width, height));
+        auto frame = read_back(render(video, 0, nullptr, 1), width, height, format);
+        REQUIRE(frame.bit_depth == pixel_format_bit_depth(format));
+    }
+
+    // High bit depth samples use the whole range, not 8-bit values in 16-bit words
+    SyntheticVideo deep(width, height, PixelFormat::YUV420P10LE);
+    auto frame = read_back(render(deep, 0, nullptr, 1), width, height, PixelFormat::YUV420P10LE);
+    REQUIRE(*std::max_element(frame.y16.begin(), frame.y16.end()) > 255);
+    REQUIRE(*std::max_element(frame.y16.begin(), frame.y16.end()) <= 1023);
+
+    REQUIRE_THROWS_AS(SyntheticVideo(1, 16, PixelFormat::YUV420P), std::invalid_argument);
+}